@@ -4,13 +4,61 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
-../classes/sdr/SDR_Device_Wrapper.cpp 
+../classes/sdr/Burst_Correlator.cpp \
+../classes/sdr/Burst_Trace_Recorder.cpp \
+../classes/sdr/Channel_Buffers.cpp \
+../classes/sdr/Clock_Tracker.cpp \
+../classes/sdr/Continuous_Streamer.cpp \
+../classes/sdr/Frame_Scheduler.cpp \
+../classes/sdr/Live_Reconfigurator.cpp \
+../classes/sdr/RX_Burst_Stats.cpp \
+../classes/sdr/RX_Capture.cpp \
+../classes/sdr/SDR_Device_Group.cpp \
+../classes/sdr/SDR_Init_Cache.cpp \
+../classes/sdr/SDR_Metrics.cpp \
+../classes/sdr/SDR_Device_Wrapper.cpp \
+../classes/sdr/Sample_Format.cpp \
+../classes/sdr/TX_Pipeline.cpp \
+../classes/sdr/TX_Playback.cpp \
+../classes/sdr/Waveform_Library.cpp 
 
 OBJS += \
-./classes/sdr/SDR_Device_Wrapper.o 
+./classes/sdr/Burst_Correlator.o \
+./classes/sdr/Burst_Trace_Recorder.o \
+./classes/sdr/Channel_Buffers.o \
+./classes/sdr/Clock_Tracker.o \
+./classes/sdr/Continuous_Streamer.o \
+./classes/sdr/Frame_Scheduler.o \
+./classes/sdr/Live_Reconfigurator.o \
+./classes/sdr/RX_Burst_Stats.o \
+./classes/sdr/RX_Capture.o \
+./classes/sdr/SDR_Device_Group.o \
+./classes/sdr/SDR_Init_Cache.o \
+./classes/sdr/SDR_Metrics.o \
+./classes/sdr/SDR_Device_Wrapper.o \
+./classes/sdr/Sample_Format.o \
+./classes/sdr/TX_Pipeline.o \
+./classes/sdr/TX_Playback.o \
+./classes/sdr/Waveform_Library.o 
 
 CPP_DEPS += \
-./classes/sdr/SDR_Device_Wrapper.d 
+./classes/sdr/Burst_Correlator.d \
+./classes/sdr/Burst_Trace_Recorder.d \
+./classes/sdr/Channel_Buffers.d \
+./classes/sdr/Clock_Tracker.d \
+./classes/sdr/Continuous_Streamer.d \
+./classes/sdr/Frame_Scheduler.d \
+./classes/sdr/Live_Reconfigurator.d \
+./classes/sdr/RX_Burst_Stats.d \
+./classes/sdr/RX_Capture.d \
+./classes/sdr/SDR_Device_Group.d \
+./classes/sdr/SDR_Init_Cache.d \
+./classes/sdr/SDR_Metrics.d \
+./classes/sdr/SDR_Device_Wrapper.d \
+./classes/sdr/Sample_Format.d \
+./classes/sdr/TX_Pipeline.d \
+./classes/sdr/TX_Playback.d \
+./classes/sdr/Waveform_Library.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -0,0 +1,24 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../classes/sim/Burst_Sim_Device.cpp 
+
+OBJS += \
+./classes/sim/Burst_Sim_Device.o 
+
+CPP_DEPS += \
+./classes/sim/Burst_Sim_Device.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+classes/sim/%.o: ../classes/sim/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: GCC C++ Compiler'
+	g++ -D__GXX_EXPETIMENTAL_CXX0X__ -D__cplusplus=201103L -O3 -Wall -c -fmessage-length=0 -std=c++0x -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
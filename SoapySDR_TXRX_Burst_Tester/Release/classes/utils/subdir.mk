@@ -4,12 +4,30 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
+../classes/utils/Async_Logger.cpp \
+../classes/utils/Control_Socket.cpp \
+../classes/utils/FFT.cpp \
+../classes/utils/Metrics_Endpoint.cpp \
+../classes/utils/Metrics_Registry.cpp \
+../classes/utils/RT_Config.cpp \
 ../classes/utils/utils.cpp 
 
 OBJS += \
+./classes/utils/Async_Logger.o \
+./classes/utils/Control_Socket.o \
+./classes/utils/FFT.o \
+./classes/utils/Metrics_Endpoint.o \
+./classes/utils/Metrics_Registry.o \
+./classes/utils/RT_Config.o \
 ./classes/utils/utils.o 
 
 CPP_DEPS += \
+./classes/utils/Async_Logger.d \
+./classes/utils/Control_Socket.d \
+./classes/utils/FFT.d \
+./classes/utils/Metrics_Endpoint.d \
+./classes/utils/Metrics_Registry.d \
+./classes/utils/RT_Config.d \
 ./classes/utils/utils.d 
 
 
@@ -0,0 +1,751 @@
+/*
+ * Burst_Bench
+ *
+ * Drives TX and RX burst loops of SDR_Device_Wrapper against a given device (by default in-process burst_sim one)
+ * for a sweep of burst lengths, burst periods, RX modes and buffer access modes and writes the results as JSON, so they can be
+ * compared between builds.
+ *
+ * For every call of send_samples/receive_samples following is measured:
+ *	host_latency	- duration of the call minus the time it had to wait for the hardware clock to reach the end
+ *					  of the burst, i.e. the overhead added by the host on top of the burst itself
+ *	cpu time		- thread CPU time spent in the burst loop, reported per sample in [ns] and in TSC cycles
+ *	allocations		- number of operator new calls made by the burst loop threads
+ *	chunks			- number of writeStream/readStream calls a burst has been split into (bursts longer than the MTU)
+ *	bandwidth		- CF32 bytes of bursts moved per second of CPU time of the burst loop
+ *
+ * Received samples are consumed (power of every burst is summed up) through receive_samples_in_place in both buffer
+ * access modes - the copy path hands the consumer a wrapper buffer the burst has been copied into, direct one hands
+ * it driver buffers (SDR.direct_buffers), so the difference between both is the cost of the copies.
+ *
+ * Build with 'make bench' in Release directory, run e.g.:
+ *	./SoapySDR_TXRX_Burst_Bench --burst_lengths 100e-6,1e-3 --burst_periods 10e-3,2e-3,1e-3 --output bench.json
+ *
+ * or for throughput of multi-millisecond bursts split into MTU sized chunks at full sample rate (back-to-back bursts):
+ *	./SoapySDR_TXRX_Burst_Bench --args driver=burst_sim,mtu=2048 --master_clock_rate 30.72e6 --burst_lengths 1e-3,5e-3
+ *		--burst_periods 20e-3,10e-3,5e-3 --rx_modes burst --output bench_mtu.json
+ *
+ * or for a comparison of copy and direct buffer access paths:
+ *	./SoapySDR_TXRX_Burst_Bench --burst_lengths 100e-6,1e-3 --rx_modes burst --access_modes copy,direct --output bench_dma.json
+ *
+ * With --check_allocations the benchmark exits with 1 once any send_samples/receive_samples call after warm-up has
+ * allocated, listing the offending sweep points ('make alloc_check' runs it for all RX modes and access modes).
+ *
+ * With --check_failures the benchmark exits with 1 once any burst after warm-up has failed for a reason not listed
+ * in --allowed_failures ('make continuous_check' runs it for RX windows of a sampling rate that is not a whole number
+ * of nanoseconds per sample).
+ */
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <algorithm>
+#include <new>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <boost/thread.hpp>
+#include <boost/program_options.hpp>
+
+#include "../classes/utils/utils.h"
+#include "../classes/utils/Async_Logger.h"
+#include "../classes/sdr/SDR_Device_Wrapper.h"
+
+#include <SoapySDR/Errors.hpp>
+#include <SoapySDR/Time.hpp>
+
+namespace po = boost::program_options;
+
+using namespace std;
+using namespace utils;
+using namespace sdr;
+
+//allocations are counted only on threads running a burst loop and only within send_samples/receive_samples
+static thread_local bool count_allocations = false;
+static thread_local uint64_t no_of_allocations = 0;
+
+//kept out of line, so GCC does not pair inlined malloc/free with new/delete expressions of the callers
+__attribute__((noinline)) void* operator new(size_t size)
+{
+	if (count_allocations)
+		no_of_allocations++;
+
+	void* ptr = malloc(size ? size : 1);
+
+	if (ptr == nullptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+namespace utils
+{
+	void cleanup()
+	{
+		msg("bench: Cleaning up...");
+	}
+}
+
+//measurements gathered by a single burst loop
+struct Loop_Result
+{
+	vector<int64_t> host_latencies;
+	int64_t cpu_time = 0;
+	uint64_t no_of_samples = 0;
+	uint64_t no_of_chunks = 0;
+	uint64_t no_of_allocations = 0;
+	uint64_t no_of_allocating_bursts = 0;
+	uint64_t no_of_bursts = 0;
+	uint64_t no_of_failed_bursts = 0;
+	uint64_t no_of_time_errors = 0;
+	uint64_t no_of_underflows = 0;
+	uint64_t no_of_overflows = 0;
+	uint64_t no_of_timeouts = 0;
+	bool direct = false;
+
+	//failed bursts whose status is not among the allowed ones
+	uint64_t no_of_unexpected_failures(const vector<int>& allowed_codes) const
+	{
+		uint64_t no_of_allowed_failures = 0;
+
+		for (int code : allowed_codes)
+		{
+			if (code == SOAPY_SDR_TIME_ERROR)
+				no_of_allowed_failures += no_of_time_errors;
+			else if (code == SOAPY_SDR_UNDERFLOW)
+				no_of_allowed_failures += no_of_underflows;
+			else if (code == SOAPY_SDR_OVERFLOW)
+				no_of_allowed_failures += no_of_overflows;
+			else if (code == SOAPY_SDR_TIMEOUT)
+				no_of_allowed_failures += no_of_timeouts;
+		}
+
+		return no_of_failed_bursts - min(no_of_allowed_failures, no_of_failed_bursts);
+	}
+};
+
+//single point of the sweep
+struct Bench_Point
+{
+	double burst_length = 0;
+	double burst_period = 0;
+	bool rx_continuous = false;
+	bool direct = false;
+	Loop_Result tx;
+	Loop_Result rx;
+
+	bool clean() const
+	{
+		return (tx.no_of_failed_bursts == 0) && (rx.no_of_failed_bursts == 0);
+	}
+};
+
+static int64_t thread_cpu_time_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+	return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//returns TSC frequency in [Hz] (0 when there is no TSC to read)
+static double calibrate_tsc()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	int64_t t0 = monotonic_time_ns();
+	uint64_t c0 = __rdtsc();
+
+	usleep(50000);
+
+	int64_t t1 = monotonic_time_ns();
+	uint64_t c1 = __rdtsc();
+
+	return (c1 - c0) * 1e9 / (double)(t1 - t0);
+#else
+	return 0;
+#endif
+}
+
+static void count_status(Loop_Result& result, const int code)
+{
+	if (code == SOAPY_SDR_TIME_ERROR)
+		result.no_of_time_errors++;
+	else if (code == SOAPY_SDR_UNDERFLOW)
+		result.no_of_underflows++;
+	else if (code == SOAPY_SDR_OVERFLOW)
+		result.no_of_overflows++;
+	else if (code == SOAPY_SDR_TIMEOUT)
+		result.no_of_timeouts++;
+}
+
+//host time spent in a call on top of waiting for the end of its burst
+static int64_t host_latency(const int64_t call_time, const SDR_Burst_Status& status, const int64_t burst_duration)
+{
+	int64_t wait_time = max((int64_t)0, (int64_t)(status.burst_time + burst_duration - status.current_time));
+
+	return max((int64_t)0, call_time - wait_time);
+}
+
+void tx_loop
+(
+	SDR_Device_Wrapper::sptr_t sdr_device_wrapper,
+	Loop_Result& result,
+	int64_t tick,
+	const int64_t no_of_ticks_per_bursts_period,
+	const size_t no_of_samples,
+	const size_t no_of_bursts,
+	const size_t no_of_warmup_bursts
+)
+{
+	SDR_Device_Config::sptr_t device_cfg = sdr_device_wrapper->get_device_config();
+
+	vector<complex<float>> tx_buffer(no_of_samples, complex<float>(1.0f, 0.0f));
+	int64_t burst_duration = SoapySDR::ticksToTimeNs(no_of_samples * device_cfg->D_tx, device_cfg->f_clk);
+
+	int64_t cpu_time = 0;
+
+	for (size_t i = 0; (i < no_of_warmup_bursts + no_of_bursts) && !utils::stop; i++)
+	{
+		bool measured = (i >= no_of_warmup_bursts);
+
+		if (measured && (cpu_time == 0))
+			cpu_time = thread_cpu_time_ns();
+
+		uint64_t no_of_allocations_before = no_of_allocations;
+
+		count_allocations = measured;
+		int64_t t0 = monotonic_time_ns();
+
+		bool res = sdr_device_wrapper->send_samples(tick, &tx_buffer[0], tx_buffer.size());
+
+		int64_t t1 = monotonic_time_ns();
+		count_allocations = false;
+
+		if (no_of_allocations > no_of_allocations_before)
+			result.no_of_allocating_bursts++;
+
+		tick += no_of_ticks_per_bursts_period;
+
+		if (!measured)
+			continue;
+
+		const SDR_Burst_Status& tx_status = sdr_device_wrapper->get_tx_status();
+
+		result.host_latencies.push_back(host_latency(t1 - t0, tx_status, burst_duration));
+		result.no_of_bursts++;
+		result.no_of_samples += no_of_samples;
+		result.no_of_chunks += tx_status.no_of_chunks;
+
+		if (!res)
+		{
+			result.no_of_failed_bursts++;
+			count_status(result, tx_status.stream_status);
+		}
+	}
+
+	result.cpu_time = (cpu_time > 0) ? thread_cpu_time_ns() - cpu_time : 0;
+	result.no_of_allocations = no_of_allocations;
+	result.direct = sdr_device_wrapper->is_direct(SOAPY_SDR_TX);
+}
+
+void rx_loop
+(
+	SDR_Device_Wrapper::sptr_t sdr_device_wrapper,
+	Loop_Result& result,
+	int64_t tick,
+	const int64_t no_of_ticks_per_bursts_period,
+	const size_t no_of_samples,
+	const size_t no_of_bursts,
+	const size_t no_of_warmup_bursts
+)
+{
+	SDR_Device_Config::sptr_t device_cfg = sdr_device_wrapper->get_device_config();
+
+	int64_t burst_duration = SoapySDR::ticksToTimeNs(no_of_samples * device_cfg->D_rx, device_cfg->f_clk);
+
+	//the same consumer runs on both buffer access paths, it is set up once, so the burst loop does not allocate
+	float power = 0;
+	rx_chunk_handler_t consumer = [&power](const std::complex<float>* const* samples, const int offset, const int no_of_chunk_samples)
+	{
+		for (int i = 0; i < no_of_chunk_samples; i++)
+			power += norm(samples[0][i]);
+	};
+
+	int64_t cpu_time = 0;
+
+	for (size_t i = 0; (i < no_of_warmup_bursts + no_of_bursts) && !utils::stop; i++)
+	{
+		bool measured = (i >= no_of_warmup_bursts);
+
+		if (measured && (cpu_time == 0))
+			cpu_time = thread_cpu_time_ns();
+
+		uint64_t no_of_allocations_before = no_of_allocations;
+
+		count_allocations = measured;
+		int64_t t0 = monotonic_time_ns();
+
+		bool res = sdr_device_wrapper->receive_samples_in_place(tick, no_of_samples, consumer);
+
+		int64_t t1 = monotonic_time_ns();
+		count_allocations = false;
+
+		if (no_of_allocations > no_of_allocations_before)
+			result.no_of_allocating_bursts++;
+
+		tick += no_of_ticks_per_bursts_period;
+
+		if (!measured)
+			continue;
+
+		const SDR_Burst_Status& rx_status = sdr_device_wrapper->get_rx_status();
+
+		result.host_latencies.push_back(host_latency(t1 - t0, rx_status, burst_duration));
+		result.no_of_bursts++;
+		result.no_of_samples += no_of_samples;
+		result.no_of_chunks += rx_status.no_of_chunks;
+
+		if (!res)
+		{
+			result.no_of_failed_bursts++;
+			count_status(result, rx_status.stream_status);
+		}
+	}
+
+	result.cpu_time = (cpu_time > 0) ? thread_cpu_time_ns() - cpu_time : 0;
+	result.no_of_allocations = no_of_allocations;
+	result.direct = sdr_device_wrapper->is_direct(SOAPY_SDR_RX);
+
+	//keeps the consumer from being optimized out
+	if (power < 0)
+		msg("bench: negative power");
+}
+
+void run_point
+(
+	Bench_Point& point,
+	const string& args,
+	const string& stream_format,
+	const double f_clk,
+	const uint16_t D,
+	const double timeout,
+	const double time_in_future,
+	const double rx_tx_separation,
+	const size_t no_of_bursts,
+	const size_t no_of_warmup_bursts
+)
+{
+	SDR_Device_Config::sptr_t device_cfg(new SDR_Device_Config);
+
+	device_cfg->args = args;
+	device_cfg->f_clk = f_clk;
+	device_cfg->D_tx = D;
+	device_cfg->D_rx = D;
+	device_cfg->B_tx = 0;
+	device_cfg->B_rx = 0;
+	device_cfg->T_timeout = timeout;
+	device_cfg->debug_settings = false;
+	device_cfg->rx_continuous = point.rx_continuous;
+	device_cfg->stream_format = stream_format;
+	device_cfg->direct_buffers = point.direct;
+
+	double sampling_rate = f_clk / (double)D;
+	size_t no_of_samples = point.burst_length * sampling_rate;
+
+	device_cfg->buffer_size_tx = no_of_samples;
+	device_cfg->buffer_size_rx = no_of_samples;
+
+	SDR_Device_Wrapper::sptr_t sdr_device_wrapper(new SDR_Device_Wrapper(device_cfg));
+
+	if (utils::stop)
+		return;
+
+	int64_t no_of_ticks_per_bursts_period = D * point.burst_period * sampling_rate;
+
+	int64_t now_tick = SoapySDR::timeNsToTicks(sdr_device_wrapper->get_device()->getHardwareTime(), f_clk);
+
+	//same relation between first RX and TX bursts as in the tester itself
+	int64_t rx_start_tick = now_tick + SoapySDR::timeNsToTicks((time_in_future + point.burst_period + rx_tx_separation) * 1e9, f_clk);
+	int64_t tx_start_tick = now_tick + SoapySDR::timeNsToTicks((time_in_future + 2 * point.burst_period) * 1e9, f_clk);
+
+	point.tx.host_latencies.reserve(no_of_bursts);
+	point.rx.host_latencies.reserve(no_of_bursts);
+
+	boost::thread rx_thread(&rx_loop, sdr_device_wrapper, boost::ref(point.rx), rx_start_tick, no_of_ticks_per_bursts_period, no_of_samples, no_of_bursts, no_of_warmup_bursts);
+	boost::thread tx_thread(&tx_loop, sdr_device_wrapper, boost::ref(point.tx), tx_start_tick, no_of_ticks_per_bursts_period, no_of_samples, no_of_bursts, no_of_warmup_bursts);
+
+	while (!(tx_thread.timed_join(boost::posix_time::milliseconds(100)) || utils::stop))
+		signal_handler.get_io_service().poll();
+
+	tx_thread.join();
+	rx_thread.join();
+}
+
+static int64_t percentile(const vector<int64_t>& sorted, const double p)
+{
+	if (sorted.empty())
+		return 0;
+
+	//nearest-rank percentile
+	size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.999999);
+	rank = min(max(rank, (size_t)1), sorted.size());
+
+	return sorted[rank - 1];
+}
+
+static void write_loop_json(FILE* f, const char* name, const Loop_Result& result, const double tsc_hz, const bool last)
+{
+	vector<int64_t> sorted(result.host_latencies);
+	sort(sorted.begin(), sorted.end());
+
+	double cpu_ns_per_sample = (result.no_of_samples > 0) ? result.cpu_time / (double)result.no_of_samples : 0;
+	double bytes_per_cpu_ns = (result.cpu_time > 0) ? result.no_of_samples * sizeof(complex<float>) / (double)result.cpu_time : 0;
+
+	fprintf(f, "\t\t\t\"%s\": {\n", name);
+	fprintf(f, "\t\t\t\t\"access\": \"%s\",\n", result.direct ? "direct" : "copy");
+	fprintf(f, "\t\t\t\t\"bursts\": %llu,\n", (unsigned long long)result.no_of_bursts);
+	fprintf(f, "\t\t\t\t\"failed_bursts\": %llu,\n", (unsigned long long)result.no_of_failed_bursts);
+	fprintf(f, "\t\t\t\t\"time_errors\": %llu,\n", (unsigned long long)result.no_of_time_errors);
+	fprintf(f, "\t\t\t\t\"underflows\": %llu,\n", (unsigned long long)result.no_of_underflows);
+	fprintf(f, "\t\t\t\t\"overflows\": %llu,\n", (unsigned long long)result.no_of_overflows);
+	fprintf(f, "\t\t\t\t\"timeouts\": %llu,\n", (unsigned long long)result.no_of_timeouts);
+	fprintf
+	(
+		f,
+		"\t\t\t\t\"host_latency_ns\": {\"p50\": %lld, \"p99\": %lld, \"p99.9\": %lld, \"max\": %lld},\n",
+		(long long)percentile(sorted, 50),
+		(long long)percentile(sorted, 99),
+		(long long)percentile(sorted, 99.9),
+		(long long)(sorted.empty() ? 0 : sorted.back())
+	);
+	fprintf(f, "\t\t\t\t\"chunks_per_burst\": %.3f,\n", (result.no_of_bursts > 0) ? result.no_of_chunks / (double)result.no_of_bursts : 0);
+	fprintf(f, "\t\t\t\t\"cpu_ns_per_sample\": %.3f,\n", cpu_ns_per_sample);
+	fprintf(f, "\t\t\t\t\"cpu_us_per_burst\": %.3f,\n", (result.no_of_bursts > 0) ? result.cpu_time / 1e3 / result.no_of_bursts : 0);
+	fprintf(f, "\t\t\t\t\"mb_per_cpu_second\": %.1f,\n", bytes_per_cpu_ns * 1e3);
+
+	if (tsc_hz > 0)
+		fprintf(f, "\t\t\t\t\"cycles_per_sample\": %.3f,\n", cpu_ns_per_sample * tsc_hz / 1e9);
+	else
+		fprintf(f, "\t\t\t\t\"cycles_per_sample\": null,\n");
+
+	fprintf(f, "\t\t\t\t\"allocations_per_burst\": %.3f,\n", (result.no_of_bursts > 0) ? result.no_of_allocations / (double)result.no_of_bursts : 0);
+	fprintf(f, "\t\t\t\t\"allocating_bursts\": %llu\n", (unsigned long long)result.no_of_allocating_bursts);
+	fprintf(f, "\t\t\t}%s\n", last ? "" : ",");
+}
+
+int main(int argc, char *argv[])
+{
+	setvbuf(stdout, NULL, _IONBF, 0);
+	setvbuf(stderr, NULL, _IONBF, 0);
+
+	string args;
+	string stream_format;
+	double f_clk;
+	uint16_t D;
+	double timeout;
+	double time_in_future;
+	double rx_tx_separation;
+	string burst_lengths_str;
+	string burst_periods_str;
+	string rx_modes_str;
+	string access_modes_str;
+	size_t no_of_bursts;
+	size_t no_of_warmup_bursts;
+	string output_filepath;
+	bool check_allocations;
+	bool check_failures;
+	string allowed_failures_str;
+
+	po::options_description options("Burst benchmark options");
+	options.add_options()
+		("help,h", "Prints a list of all available options.")
+		("args", po::value<string>(&args)								->default_value("driver=burst_sim,mtu=65536,direct_buffers=4"), "Device arguments.")
+		("stream_format", po::value<string>(&stream_format)				->default_value("CF32"), "Stream sample format - CF32, CS16, CS12 or native.")
+		("master_clock_rate", po::value<double>(&f_clk)					->default_value(10e6), "Master clock rate in [Hz].")
+		("clock_divider", po::value<uint16_t>(&D)						->default_value(1), "Master clock divider used to obtain sampling rate.")
+		("timeout", po::value<double>(&timeout)							->default_value(0.2), "Streaming timeout in [s].")
+		("time_in_future", po::value<double>(&time_in_future)			->default_value(0.1), "Time in future to start streaming in [s].")
+		("rx_tx_separation", po::value<double>(&rx_tx_separation)		->default_value(100e-6), "RX and TX bursts separation in [s].")
+		("burst_lengths", po::value<string>(&burst_lengths_str)			->default_value("50e-6,100e-6,1e-3"), "Comma separated list of burst lengths in [s].")
+		("burst_periods", po::value<string>(&burst_periods_str)			->default_value("10e-3,5e-3,2e-3,1e-3,500e-6,200e-6"), "Comma separated list of burst periods in [s].")
+		("rx_modes", po::value<string>(&rx_modes_str)					->default_value("burst,continuous"), "Comma separated list of RX modes (burst, continuous).")
+		("access_modes", po::value<string>(&access_modes_str)			->default_value("copy"), "Comma separated list of buffer access modes (copy, direct).")
+		("bursts", po::value<size_t>(&no_of_bursts)						->default_value(500), "Number of measured bursts per sweep point.")
+		("warmup_bursts", po::value<size_t>(&no_of_warmup_bursts)		->default_value(20), "Number of bursts run before measurements start.")
+		("output,o", po::value<string>(&output_filepath)				->default_value("bench.json"), "Path of the JSON file with results.")
+		("check_allocations", po::value<bool>(&check_allocations)		->default_value(false), "Whether to exit with 1 when any burst after warm-up has allocated on the heap.")
+		("check_failures", po::value<bool>(&check_failures)				->default_value(false), "Whether to exit with 1 when any burst after warm-up has failed for a reason not listed in allowed_failures.")
+		("allowed_failures", po::value<string>(&allowed_failures_str)	->default_value(""), "Comma separated list of burst failures tolerated by check_failures (time_error, underflow, overflow, timeout).")
+		;
+
+	po::variables_map cfg;
+
+	po::store(po::parse_command_line(argc, argv, options), cfg);
+	po::notify(cfg);
+
+	if (cfg.count("help"))
+	{
+		cout << options;
+		return 0;
+	}
+
+	vector<double> burst_lengths;
+	vector<double> burst_periods;
+	vector<bool> rx_modes;
+	vector<bool> access_modes;
+	vector<int> allowed_failures;
+
+	for (const string& s : explode(burst_lengths_str))
+		burst_lengths.push_back(stod(s));
+
+	for (const string& s : explode(burst_periods_str))
+		burst_periods.push_back(stod(s));
+
+	//longest period goes first, so the sustainable rate is the last one before the first failure
+	sort(burst_periods.begin(), burst_periods.end(), greater<double>());
+
+	for (const string& s : explode(rx_modes_str))
+	{
+		if (s == "burst")
+			rx_modes.push_back(false);
+		else if (s == "continuous")
+			rx_modes.push_back(true);
+		else
+		{
+			msg("bench: Unknown RX mode: " + s, ERROR);
+			return 1;
+		}
+	}
+
+	for (const string& s : explode(access_modes_str))
+	{
+		if (s == "copy")
+			access_modes.push_back(false);
+		else if (s == "direct")
+			access_modes.push_back(true);
+		else
+		{
+			msg("bench: Unknown access mode: " + s, ERROR);
+			return 1;
+		}
+	}
+
+	for (const string& s : explode(allowed_failures_str))
+	{
+		if (s == "time_error")
+			allowed_failures.push_back(SOAPY_SDR_TIME_ERROR);
+		else if (s == "underflow")
+			allowed_failures.push_back(SOAPY_SDR_UNDERFLOW);
+		else if (s == "overflow")
+			allowed_failures.push_back(SOAPY_SDR_OVERFLOW);
+		else if (s == "timeout")
+			allowed_failures.push_back(SOAPY_SDR_TIMEOUT);
+		else
+		{
+			msg("bench: Unknown burst failure: " + s, ERROR);
+			return 1;
+		}
+	}
+
+	//burst paths log through the asynchronous logger just like in the tester
+	async_logger.start(4096);
+
+	double tsc_hz = calibrate_tsc();
+
+	vector<Bench_Point> points;
+
+	for (double burst_length : burst_lengths)
+	{
+		for (bool rx_continuous : rx_modes)
+		{
+			for (bool direct : access_modes)
+			{
+				for (double burst_period : burst_periods)
+				{
+					if (utils::stop)
+						break;
+
+					if (burst_period < burst_length)
+						continue;
+
+					Bench_Point point;
+					point.burst_length = burst_length;
+					point.burst_period = burst_period;
+					point.rx_continuous = rx_continuous;
+					point.direct = direct;
+
+					msg("bench: burst_length=" + to_string(burst_length) + " [s], burst_period=" + to_string(burst_period) + " [s], rx_mode=" + (rx_continuous ? "continuous" : "burst") + ", access_mode=" + (direct ? "direct" : "copy"));
+
+					run_point(point, args, stream_format, f_clk, D, timeout, time_in_future, rx_tx_separation, no_of_bursts, no_of_warmup_bursts);
+
+					points.push_back(point);
+				}
+			}
+		}
+	}
+
+	FILE* f = fopen(output_filepath.c_str(), "w");
+
+	if (f == nullptr)
+	{
+		msg("bench: Unable to open " + output_filepath, ERROR);
+		async_logger.stop();
+		return 1;
+	}
+
+	fprintf(f, "{\n");
+	fprintf(f, "\t\"build\": \"%s %s\",\n", __DATE__, __TIME__);
+	fprintf(f, "\t\"args\": \"%s\",\n", args.c_str());
+	fprintf(f, "\t\"stream_format\": \"%s\",\n", stream_format.c_str());
+	fprintf(f, "\t\"sampling_rate\": %.1f,\n", f_clk / (double)D);
+	fprintf(f, "\t\"tsc_hz\": %.0f,\n", tsc_hz);
+	fprintf(f, "\t\"bursts_per_point\": %zu,\n", no_of_bursts);
+
+	//highest burst rate reached before first TIME_ERROR/UNDERFLOW (or any other failure) for every burst length, RX mode
+	//and access mode
+	fprintf(f, "\t\"max_burst_rate\": [\n");
+
+	bool first = true;
+
+	for (double burst_length : burst_lengths)
+	{
+		for (bool rx_continuous : rx_modes)
+		{
+			for (bool direct : access_modes)
+			{
+				double max_rate = 0;
+
+				for (const Bench_Point& point : points)
+				{
+					if ((point.burst_length != burst_length) || (point.rx_continuous != rx_continuous) || (point.direct != direct))
+						continue;
+
+					if (!point.clean())
+						break;
+
+					max_rate = 1.0 / point.burst_period;
+				}
+
+				fprintf
+				(
+					f,
+					"%s\t\t{\"burst_length\": %g, \"rx_mode\": \"%s\", \"access_mode\": \"%s\", \"bursts_per_second\": %.1f}",
+					first ? "" : ",\n",
+					burst_length,
+					rx_continuous ? "continuous" : "burst",
+					direct ? "direct" : "copy",
+					max_rate
+				);
+				first = false;
+			}
+		}
+	}
+
+	fprintf(f, "\n\t],\n");
+	fprintf(f, "\t\"points\": [\n");
+
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		const Bench_Point& point = points[i];
+
+		fprintf(f, "\t\t{\n");
+		fprintf(f, "\t\t\t\"burst_length\": %g,\n", point.burst_length);
+		fprintf(f, "\t\t\t\"burst_period\": %g,\n", point.burst_period);
+		fprintf(f, "\t\t\t\"rx_mode\": \"%s\",\n", point.rx_continuous ? "continuous" : "burst");
+		fprintf(f, "\t\t\t\"access_mode\": \"%s\",\n", point.direct ? "direct" : "copy");
+		write_loop_json(f, "tx", point.tx, tsc_hz, false);
+		write_loop_json(f, "rx", point.rx, tsc_hz, true);
+		fprintf(f, "\t\t}%s\n", (i + 1 < points.size()) ? "," : "");
+	}
+
+	fprintf(f, "\t]\n");
+	fprintf(f, "}\n");
+
+	fclose(f);
+
+	msg("bench: Results of " + to_string(points.size()) + " sweep points have been written to " + output_filepath);
+
+	//points without any measured burst fail the check as well, they have not shown anything
+	size_t no_of_failed_checks = 0;
+
+	if (check_allocations)
+	{
+		for (const Bench_Point& point : points)
+		{
+			for (const Loop_Result* result : {&point.tx, &point.rx})
+			{
+				if ((result->no_of_allocations == 0) && (result->no_of_bursts > 0))
+					continue;
+
+				msgf
+				(
+					ERROR,
+					"bench: %s bursts allocated %llu times in %llu of %llu bursts after warm-up (burst_length=%g [s], burst_period=%g [s], rx_mode=%s, access_mode=%s)",
+					(result == &point.tx) ? "TX" : "RX",
+					(unsigned long long)result->no_of_allocations,
+					(unsigned long long)result->no_of_allocating_bursts,
+					(unsigned long long)result->no_of_bursts,
+					point.burst_length,
+					point.burst_period,
+					point.rx_continuous ? "continuous" : "burst",
+					point.direct ? "direct" : "copy"
+				);
+
+				no_of_failed_checks++;
+			}
+		}
+
+		if (no_of_failed_checks == 0)
+			msg("bench: no heap allocation in any of " + to_string(points.size()) + " sweep points after warm-up");
+	}
+
+	if (check_failures)
+	{
+		size_t no_of_failed_allocation_checks = no_of_failed_checks;
+
+		for (const Bench_Point& point : points)
+		{
+			for (const Loop_Result* result : {&point.tx, &point.rx})
+			{
+				uint64_t no_of_unexpected_failures = result->no_of_unexpected_failures(allowed_failures);
+
+				if ((no_of_unexpected_failures == 0) && (result->no_of_bursts > 0))
+					continue;
+
+				msgf
+				(
+					ERROR,
+					"bench: %s bursts failed unexpectedly %llu times in %llu bursts after warm-up (burst_length=%g [s], burst_period=%g [s], rx_mode=%s, access_mode=%s)",
+					(result == &point.tx) ? "TX" : "RX",
+					(unsigned long long)no_of_unexpected_failures,
+					(unsigned long long)result->no_of_bursts,
+					point.burst_length,
+					point.burst_period,
+					point.rx_continuous ? "continuous" : "burst",
+					point.direct ? "direct" : "copy"
+				);
+
+				no_of_failed_checks++;
+			}
+		}
+
+		if (no_of_failed_checks == no_of_failed_allocation_checks)
+			msg("bench: no unexpected burst failure in any of " + to_string(points.size()) + " sweep points after warm-up");
+	}
+
+	msg("", INFO, false, false);
+
+	async_logger.stop();
+
+	return (no_of_failed_checks > 0) ? 1 : 0;
+}
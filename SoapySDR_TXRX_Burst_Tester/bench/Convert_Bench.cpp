@@ -0,0 +1,365 @@
+/*
+ * Convert_Bench
+ *
+ * Measures throughput of sample format conversion kernels (CF32 <-> CS16/CS12) for every instruction set supported
+ * by the CPU and a sweep of burst sizes, CF32 copies are measured as well as a baseline of the plain CF32 path.
+ * Results are written as JSON, so they can be compared between builds and machines.
+ *
+ * Before anything is measured, kernels of every instruction set are checked bit by bit against the scalar ones, for
+ * every length up to a few vector widths (i.e. all tails) and every burst size, with inputs including saturated and
+ * exactly halfway values - the benchmark exits with 1 on any mismatch ('make convert_check' runs just the check).
+ *
+ * For every format, instruction set, direction and burst size following is measured:
+ *	ns_per_burst	- average duration of converting a single burst
+ *	msps			- conversion throughput in [MSa/s]
+ *	native_gbps		- throughput in [GB/s] of the stream format side (i.e. what is moved over the host bus)
+ *
+ * Build with 'make convert_bench' in Release directory, run e.g.:
+ *	./SoapySDR_TXRX_Convert_Bench --burst_sizes 256,4096,65536 --output convert_bench.json
+ */
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include "../classes/utils/utils.h"
+#include "../classes/sdr/Sample_Format.h"
+
+namespace po = boost::program_options;
+
+using namespace std;
+using namespace utils;
+using namespace sdr;
+
+namespace utils
+{
+	void cleanup()
+	{
+		msg("convert_bench: Cleaning up...");
+	}
+}
+
+//single point of the sweep
+struct Convert_Point
+{
+	sample_format_t format = FORMAT_CF32;
+	string isa;
+	bool to_native = true;
+	size_t burst_size = 0;
+	uint64_t no_of_bursts = 0;
+	double ns_per_burst = 0;
+	double msps = 0;
+	double native_gbps = 0;
+};
+
+//keeps the compiler from optimising the conversions away
+static volatile float sink;
+
+//kernels are checked at every length up to this one, which covers tails of all vector widths several times over
+static const size_t MAX_CHECKED_LENGTH = 100;
+
+//output buffers are followed by guard bytes, so writes past the end of a burst show up as mismatches
+static const size_t GUARD_SIZE = 64;
+static const char GUARD_BYTE = 0x5a;
+
+//input value of a float kernel - in range, exactly halfway between two integers, saturated or an edge case
+static float check_value()
+{
+	static const float edge_values[] = {0.0f, -0.0f, 1.0f, -1.0f, 32767.5f / 32768, -32768.5f / 32768, 1e9f, -1e9f};
+
+	switch (rand() % 4)
+	{
+		case 0:
+			return (rand() / (float)RAND_MAX) * 2.5f - 1.25f;
+		case 1:
+			return ((rand() % 65536) - 32768 + 0.5f) / 32768;
+		case 2:
+			return edge_values[rand() % (sizeof(edge_values) / sizeof(edge_values[0]))];
+		default:
+			return ((rand() % 65536) - 32768) / 32768.0f;
+	}
+}
+
+//offset of the first byte that differs, including guard bytes, or -1
+static long first_difference(const vector<char>& expected, const vector<char>& actual)
+{
+	for (size_t i = 0; i < expected.size(); i++)
+	{
+		if (expected[i] != actual[i])
+			return i;
+	}
+
+	return -1;
+}
+
+//compares both kernels of an instruction set against the scalar ones bit by bit, returns number of mismatches
+static size_t check_converters(const sample_format_t format, const Sample_Converters& converters, const Sample_Converters& scalar, const vector<size_t>& lengths)
+{
+	const size_t sample_size = sample_format_size(format);
+	size_t no_of_mismatches = 0;
+
+	for (size_t length : lengths)
+	{
+		vector<complex<float>> samples(length + 1);
+		vector<char> native(length * sample_size + 1);
+
+		for (size_t i = 0; i < length; i++)
+			samples[i] = complex<float>(check_value(), check_value());
+
+		for (size_t i = 0; i < native.size(); i++)
+			native[i] = rand();
+
+		vector<char> expected(length * sample_size + GUARD_SIZE, GUARD_BYTE);
+		vector<char> actual(expected);
+
+		scalar.to_native(&samples[0], &expected[0], length);
+		converters.to_native(&samples[0], &actual[0], length);
+
+		long offset = first_difference(expected, actual);
+
+		if (offset >= 0)
+		{
+			msgf(ERROR, "convert_bench: %s %s to_native differs from scalar at byte %ld of a %zu sample burst", sample_format_to_str(format), converters.isa, offset, length);
+			no_of_mismatches++;
+		}
+
+		expected.assign(length * sizeof(complex<float>) + GUARD_SIZE, GUARD_BYTE);
+		actual = expected;
+
+		scalar.from_native(&native[0], reinterpret_cast<complex<float>*>(&expected[0]), length);
+		converters.from_native(&native[0], reinterpret_cast<complex<float>*>(&actual[0]), length);
+
+		offset = first_difference(expected, actual);
+
+		if (offset >= 0)
+		{
+			msgf(ERROR, "convert_bench: %s %s from_native differs from scalar at byte %ld of a %zu sample burst", sample_format_to_str(format), converters.isa, offset, length);
+			no_of_mismatches++;
+		}
+	}
+
+	return no_of_mismatches;
+}
+
+static void run_point(Convert_Point& point, const Sample_Converters& converters, const double min_time)
+{
+	vector<complex<float>> samples(point.burst_size);
+	vector<char> native(point.burst_size * sample_format_size(point.format));
+
+	for (size_t i = 0; i < samples.size(); i++)
+		samples[i] = complex<float>((rand() / (float)RAND_MAX) * 2 - 1, (rand() / (float)RAND_MAX) * 2 - 1);
+
+	converters.to_native(&samples[0], &native[0], samples.size());
+
+	//warm up caches and branch predictors first
+	for (int i = 0; i < 10; i++)
+	{
+		if (point.to_native)
+			converters.to_native(&samples[0], &native[0], samples.size());
+		else
+			converters.from_native(&native[0], &samples[0], samples.size());
+	}
+
+	int64_t start_time = monotonic_time_ns();
+	int64_t elapsed_time = 0;
+	uint64_t no_of_bursts = 0;
+
+	//bursts are timed in batches, so reading the clock does not distort short ones
+	const uint64_t batch = max((size_t)1, 65536 / point.burst_size);
+
+	while (elapsed_time < min_time * 1e9)
+	{
+		for (uint64_t i = 0; i < batch; i++)
+		{
+			if (point.to_native)
+				converters.to_native(&samples[0], &native[0], samples.size());
+			else
+				converters.from_native(&native[0], &samples[0], samples.size());
+		}
+
+		no_of_bursts += batch;
+		elapsed_time = monotonic_time_ns() - start_time;
+	}
+
+	sink = samples[0].real() + native[0];
+
+	point.no_of_bursts = no_of_bursts;
+	point.ns_per_burst = elapsed_time / (double)no_of_bursts;
+	point.msps = point.burst_size / point.ns_per_burst * 1e3;
+	point.native_gbps = native.size() / point.ns_per_burst;
+}
+
+int main(int argc, char *argv[])
+{
+	setvbuf(stdout, NULL, _IONBF, 0);
+	setvbuf(stderr, NULL, _IONBF, 0);
+
+	string formats_str;
+	string isas_str;
+	string burst_sizes_str;
+	double min_time;
+	string output_filepath;
+	bool check_only;
+
+	po::options_description options("Sample conversion benchmark options");
+	options.add_options()
+		("help,h", "Prints a list of all available options.")
+		("formats", po::value<string>(&formats_str)						->default_value("CF32,CS16,CS12"), "Comma separated list of stream formats.")
+		("isas", po::value<string>(&isas_str)							->default_value("scalar,sse,avx2,neon"), "Comma separated list of instruction sets (unsupported ones are skipped).")
+		("burst_sizes", po::value<string>(&burst_sizes_str)				->default_value("64,256,1024,4096,16384,65536,262144"), "Comma separated list of burst sizes in [Sa].")
+		("min_time", po::value<double>(&min_time)						->default_value(0.2), "Minimum time spent measuring every sweep point in [s].")
+		("output,o", po::value<string>(&output_filepath)				->default_value("convert_bench.json"), "Path of the JSON file with results.")
+		("check_only", po::value<bool>(&check_only)						->default_value(false), "Whether to only check kernels against the scalar ones, without measuring them.")
+		;
+
+	po::variables_map cfg;
+
+	po::store(po::parse_command_line(argc, argv, options), cfg);
+	po::notify(cfg);
+
+	if (cfg.count("help"))
+	{
+		cout << options;
+		return 0;
+	}
+
+	vector<Convert_Point> points;
+	size_t no_of_checked_kernels = 0;
+	size_t no_of_mismatches = 0;
+
+	try
+	{
+		vector<size_t> checked_lengths;
+
+		for (size_t length = 0; length <= MAX_CHECKED_LENGTH; length++)
+			checked_lengths.push_back(length);
+
+		for (const string& burst_size_str : explode(burst_sizes_str))
+			checked_lengths.push_back(stoul(burst_size_str));
+
+		for (const string& format_str : explode(formats_str))
+		{
+			sample_format_t format = parse_sample_format(format_str);
+			Sample_Converters scalar = get_sample_converters(format, "scalar");
+
+			for (const string& isa : explode(isas_str))
+			{
+				Sample_Converters converters;
+
+				try
+				{
+					converters = get_sample_converters(format, isa);
+				}
+				catch (const std::invalid_argument& e)
+				{
+					continue;
+				}
+
+				//CF32 is only copied, whatever the instruction set is
+				if ((format == FORMAT_CF32) && (isa != "scalar"))
+					continue;
+
+				if (strcmp(converters.isa, scalar.isa) != 0)
+				{
+					no_of_mismatches += check_converters(format, converters, scalar, checked_lengths);
+					no_of_checked_kernels += 2;
+				}
+
+				if (check_only)
+					continue;
+
+				for (const string& burst_size_str : explode(burst_sizes_str))
+				{
+					for (bool to_native : {true, false})
+					{
+						Convert_Point point;
+						point.format = format;
+						point.isa = converters.isa;
+						point.to_native = to_native;
+						point.burst_size = stoul(burst_size_str);
+
+						if (point.burst_size == 0)
+							continue;
+
+						run_point(point, converters, min_time);
+
+						printf
+						(
+							"%s %-6s %-11s %7zu [Sa]: %10.1f [ns/burst], %8.1f [MSa/s], %6.2f [GB/s]\n",
+							sample_format_to_str(format),
+							point.isa.c_str(),
+							to_native ? "to_native" : "from_native",
+							point.burst_size,
+							point.ns_per_burst,
+							point.msps,
+							point.native_gbps
+						);
+
+						points.push_back(point);
+					}
+				}
+			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		msg("convert_bench: " + string(e.what()), ERROR);
+		return 1;
+	}
+
+	if (no_of_mismatches > 0)
+	{
+		msg("convert_bench: " + to_string(no_of_mismatches) + " conversions are not bit-exact with the scalar kernels", ERROR);
+		return 1;
+	}
+
+	msg("convert_bench: " + to_string(no_of_checked_kernels) + " kernels are bit-exact with the scalar ones at every checked length");
+
+	if (check_only)
+	{
+		msg("", INFO, false, false);
+		return 0;
+	}
+
+	FILE* f = fopen(output_filepath.c_str(), "w");
+
+	if (f == nullptr)
+	{
+		msg("convert_bench: Unable to create " + output_filepath, ERROR);
+		return 1;
+	}
+
+	fprintf(f, "{\n");
+	fprintf(f, "\t\"auto_isa\": \"%s\",\n", get_sample_converters(FORMAT_CS16).isa);
+	fprintf(f, "\t\"points\": [\n");
+
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		const Convert_Point& point = points[i];
+
+		fprintf(f, "\t\t{\n");
+		fprintf(f, "\t\t\t\"format\": \"%s\",\n", sample_format_to_str(point.format));
+		fprintf(f, "\t\t\t\"isa\": \"%s\",\n", point.isa.c_str());
+		fprintf(f, "\t\t\t\"direction\": \"%s\",\n", point.to_native ? "to_native" : "from_native");
+		fprintf(f, "\t\t\t\"burst_size\": %zu,\n", point.burst_size);
+		fprintf(f, "\t\t\t\"bursts\": %llu,\n", (unsigned long long)point.no_of_bursts);
+		fprintf(f, "\t\t\t\"ns_per_burst\": %.3f,\n", point.ns_per_burst);
+		fprintf(f, "\t\t\t\"msps\": %.3f,\n", point.msps);
+		fprintf(f, "\t\t\t\"native_gbps\": %.3f\n", point.native_gbps);
+		fprintf(f, "\t\t}%s\n", (i + 1 < points.size()) ? "," : "");
+	}
+
+	fprintf(f, "\t]\n");
+	fprintf(f, "}\n");
+
+	fclose(f);
+
+	msg("convert_bench: Results of " + to_string(points.size()) + " sweep points have been written to " + output_filepath);
+	msg("", INFO, false, false);
+
+	return 0;
+}
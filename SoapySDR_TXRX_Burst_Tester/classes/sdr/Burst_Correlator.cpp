@@ -0,0 +1,355 @@
+#include "Burst_Correlator.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	//a = a * b for complex samples handled as float pairs (b holds conjugated TX spectrum)
+	VECTORISED_KERNEL static void multiply_spectra(float* a, const float* b, const size_t no_of_samples)
+	{
+		for (size_t i = 0; i < 2 * no_of_samples; i += 2)
+		{
+			float re = a[i] * b[i] - a[i + 1] * b[i + 1];
+			float im = a[i] * b[i + 1] + a[i + 1] * b[i];
+
+			a[i] = re;
+			a[i + 1] = im;
+		}
+	}
+
+	static double energy(const complex<float>* samples, const size_t no_of_samples)
+	{
+		double sum = 0;
+
+		for (size_t i = 0; i < no_of_samples; i++)
+			sum += norm(samples[i]);
+
+		return sum;
+	}
+
+	Burst_Correlator::Burst_Correlator(const TDD_Timeline& timeline, const int64_t ticks_per_sample, Waveform_Library::sptr_t waveform_library, const size_t queue_size, const size_t max_no_of_rx_samples, const double min_snr, const bool log_bursts)
+	:
+		waveform_library(waveform_library),
+		timeline(timeline),
+		min_snr(min_snr),
+		log_bursts(log_bursts),
+		end_frame(UINT64_MAX),
+		running(false)
+	{
+		references.resize(timeline.slots.size());
+
+		size_t max_fft_size = 0;
+		size_t no_of_references = 0;
+
+		for (size_t r = 0; r < timeline.slots.size(); r++)
+		{
+			const TDD_Slot& rx_slot = timeline.slots[r];
+
+			if (rx_slot.direction != SOAPY_SDR_RX)
+				continue;
+
+			//nearest TX slot starting before the end of the RX slot, within the same frame or the previous one
+			int64_t rx_end = rx_slot.offset_ticks + rx_slot.length_ticks;
+			const TDD_Slot* tx_slot = nullptr;
+			int64_t tx_offset = 0;
+
+			for (const TDD_Slot& slot : timeline.slots)
+			{
+				if (slot.direction != SOAPY_SDR_TX)
+					continue;
+
+				int64_t offset = (slot.offset_ticks < rx_end) ? slot.offset_ticks : slot.offset_ticks - timeline.frame_ticks;
+
+				if ((tx_slot == nullptr) || (offset > tx_offset))
+				{
+					tx_slot = &slot;
+					tx_offset = offset;
+				}
+			}
+
+			if (tx_slot == nullptr)
+				continue;
+
+			Reference& reference = references[r];
+
+			reference.valid = true;
+			reference.frame_delta = (tx_offset < tx_slot->offset_ticks) ? 1 : 0;
+			reference.expected_offset = (tx_offset - rx_slot.offset_ticks) / ticks_per_sample;
+			reference.no_of_tx_samples = min((size_t)(tx_slot->length_ticks / ticks_per_sample), waveform_library->get_no_of_samples());
+
+			reference.no_of_rx_samples = rx_slot.length_ticks / ticks_per_sample;
+
+			//linear (not circular) correlation over all lags at which the bursts overlap
+			reference.fft_size = fft_size(reference.no_of_rx_samples + reference.no_of_tx_samples - 1);
+
+			if (ffts.count(reference.fft_size) == 0)
+				ffts[reference.fft_size].reset(new FFT(reference.fft_size));
+
+			FFT::sptr_t fft = ffts[reference.fft_size];
+
+			for (size_t w = 0; w < waveform_library->size(); w++)
+			{
+				const complex<float>* samples = waveform_library->get(w);
+
+				vector<complex<float>> spectrum(reference.fft_size, complex<float>(0, 0));
+				copy(samples, samples + reference.no_of_tx_samples, spectrum.begin());
+
+				fft->forward(&spectrum[0], &spectrum[0]);
+
+				for (size_t i = 0; i < spectrum.size(); i++)
+					spectrum[i] = conj(spectrum[i]);
+
+				vector<double> cumulative_energy(reference.no_of_tx_samples + 1, 0);
+
+				for (int i = 0; i < reference.no_of_tx_samples; i++)
+					cumulative_energy[i + 1] = cumulative_energy[i] + norm(samples[i]);
+
+				reference.spectra.push_back(spectrum);
+				reference.cumulative_energy.push_back(cumulative_energy);
+			}
+
+			max_fft_size = max(max_fft_size, reference.fft_size);
+			no_of_references++;
+		}
+
+		if (no_of_references == 0)
+			throw std::invalid_argument("Burst correlation needs both TX and RX slots in the TDD frame");
+
+		//flat waveforms correlate equally well at many offsets
+		for (size_t w = 0; w < waveform_library->size(); w++)
+		{
+			waveform_type_t type = parse_waveform(waveform_library->get_description(w)).type;
+
+			if ((type == WAVEFORM_CONSTANT) || (type == WAVEFORM_TONE))
+				msg("sdr: Burst correlator: waveform " + waveform_library->get_description(w) + " cannot resolve timing, prefer zc, qpsk or chirp ones", WARNING);
+		}
+
+		spectrum.resize(max_fft_size);
+		correlation.resize(max_fft_size);
+
+		Correlation_Job prototype;
+		prototype.samples.resize(max_no_of_rx_samples);
+
+		ring.reset(new ring_t(queue_size, prototype));
+
+		running = true;
+		worker_thread = boost::thread(&Burst_Correlator::worker_thread_function, this);
+
+		msg("sdr: Burst correlator: " + to_string(no_of_references) + " RX slots correlated by FFTs of up to " + to_string(max_fft_size) + " samples, up to " + to_string(ring->capacity()) + " bursts queued");
+	}
+
+	Burst_Correlator::~Burst_Correlator()
+	{
+		stop();
+	}
+
+	void Burst_Correlator::submit(const Frame_Slot& slot, const std::complex<float>* samples)
+	{
+		const Reference& reference = references[slot.slot];
+
+		//nothing has been sent yet that could show up in this burst
+		if (!reference.valid || (slot.frame < timeline.first_tx_frame + reference.frame_delta) || (slot.frame >= end_frame.load(std::memory_order_relaxed)))
+			return;
+
+		Correlation_Job* job = ring->claim();
+
+		if (job == nullptr)
+		{
+			stats.no_of_dropped_bursts++;
+			return;
+		}
+
+		job->slot = slot;
+		job->slot.no_of_samples = min((size_t)slot.no_of_samples, job->samples.size());
+
+		//bursts longer than the reference has been built for would not fit into its FFT (and alias into its lags)
+		if (job->slot.no_of_samples > reference.no_of_rx_samples)
+		{
+			if (stats.no_of_truncated_bursts++ == 0)
+				msgf(WARNING, "sdr: Burst correlator: RX bursts of %d samples are longer than the %d samples their correlation has been set up for, only their beginning is correlated", job->slot.no_of_samples, reference.no_of_rx_samples);
+
+			job->slot.no_of_samples = reference.no_of_rx_samples;
+		}
+		memcpy(&job->samples[0], samples, job->slot.no_of_samples * sizeof(complex<float>));
+
+		ring->publish();
+
+		stats.no_of_queued_bursts++;
+	}
+
+	void Burst_Correlator::correlate(const Correlation_Job& job)
+	{
+		int64_t start_time = monotonic_time_ns();
+
+		const Reference& reference = references[job.slot.slot];
+		const size_t waveform = waveform_library->get_frame_waveform(job.slot.frame - reference.frame_delta);
+		const int64_t no_of_rx_samples = job.slot.no_of_samples;
+		const int64_t no_of_tx_samples = reference.no_of_tx_samples;
+		const int64_t n = reference.fft_size;
+
+		FFT::sptr_t fft = ffts[n];
+
+		copy(job.samples.begin(), job.samples.begin() + no_of_rx_samples, spectrum.begin());
+		fill(spectrum.begin() + no_of_rx_samples, spectrum.begin() + n, complex<float>(0, 0));
+
+		fft->forward(&spectrum[0], &spectrum[0]);
+		multiply_spectra(reinterpret_cast<float*>(&spectrum[0]), reinterpret_cast<const float*>(&reference.spectra[waveform][0]), n);
+		fft->inverse(&spectrum[0], &correlation[0]);
+
+		//correlation[k mod n] = sum(rx[i] * conj(tx[i - k])), lags from -(no_of_tx_samples - 1) to no_of_rx_samples - 1
+		int64_t peak_lag = 0;
+		float peak = -1;
+
+		for (int64_t k = -(no_of_tx_samples - 1); k < no_of_rx_samples; k++)
+		{
+			float power = norm(correlation[(k + n) % n]);
+
+			if (power > peak)
+			{
+				peak = power;
+				peak_lag = k;
+			}
+		}
+
+		//matched TX burst energy is its projection onto the overlapping part of the waveform,
+		//everything else in the RX burst is counted as noise
+		int64_t first = max((int64_t)0, peak_lag);
+		int64_t last = min(no_of_rx_samples, peak_lag + no_of_tx_samples);
+		double overlap_energy = reference.cumulative_energy[waveform][last - peak_lag] - reference.cumulative_energy[waveform][first - peak_lag];
+		double signal_energy = (overlap_energy > 0) ? peak / overlap_energy : 0;
+		double rx_energy = energy(&job.samples[0], no_of_rx_samples);
+
+		double signal_power = signal_energy / max((int64_t)1, last - first);
+		double noise_power = max(rx_energy - signal_energy, 0.0) / max((int64_t)1, no_of_rx_samples);
+
+		Burst_Correlation result;
+		result.frame = job.slot.frame;
+		result.slot = job.slot.slot;
+		result.offset = peak_lag;
+		result.expected_offset = reference.expected_offset;
+		result.peak_power = 10 * log10(max(signal_power, 1e-20));
+		result.snr = result.peak_power - 10 * log10(max(noise_power, 1e-20));
+		result.detected = (signal_power > 0) && (result.snr >= min_snr);
+
+		update_stats(result, monotonic_time_ns() - start_time);
+
+		if (log_bursts)
+		{
+			msgf
+			(
+				result.detected ? INFO : WARNING,
+				"sdr: [CORR] frame=%llu, slot=%zu, offset=%lld [Sa] (expected %lld, error %lld), peak_power=%.1f [dBFS], snr=%.1f [dB]%s",
+				(unsigned long long)result.frame,
+				result.slot,
+				(long long)result.offset,
+				(long long)result.expected_offset,
+				(long long)(result.offset - result.expected_offset),
+				result.peak_power,
+				result.snr,
+				result.detected ? "" : " - not detected"
+			);
+		}
+	}
+
+	void Burst_Correlator::update_stats(const Burst_Correlation& result, const int64_t correlation_time)
+	{
+		stats.no_of_correlated_bursts++;
+		stats.max_correlation_time = max(stats.max_correlation_time, correlation_time);
+		stats.sum_correlation_time += correlation_time;
+
+		if (!result.detected)
+			return;
+
+		int64_t error = result.offset - result.expected_offset;
+
+		if (stats.no_of_detected_bursts == 0)
+		{
+			stats.min_offset_error = error;
+			stats.max_offset_error = error;
+		}
+
+		stats.no_of_detected_bursts++;
+		stats.min_offset_error = min(stats.min_offset_error, error);
+		stats.max_offset_error = max(stats.max_offset_error, error);
+		stats.sum_offset_error += error;
+		stats.sum_squared_offset_error += (double)error * error;
+		stats.sum_snr += result.snr;
+	}
+
+	size_t Burst_Correlator::drain()
+	{
+		size_t no_of_jobs = 0;
+		Correlation_Job* job;
+
+		while ((job = ring->peek()) != nullptr)
+		{
+			correlate(*job);
+			ring->release();
+			no_of_jobs++;
+		}
+
+		return no_of_jobs;
+	}
+
+	void Burst_Correlator::worker_thread_function()
+	{
+		while (running)
+		{
+			if (drain() == 0)
+				usleep(1000);
+		}
+
+		//correlate whatever has been left in the ring
+		drain();
+	}
+
+	void Burst_Correlator::stop_at_frame(const uint64_t frame)
+	{
+		if (frame >= end_frame)
+			return;
+
+		end_frame = frame;
+
+		msgf(WARNING, "sdr: Burst correlator: bursts are not correlated from frame %llu on, as the TDD timeline changes there", (unsigned long long)frame);
+	}
+
+	void Burst_Correlator::stop()
+	{
+		if (!running.exchange(false))
+			return;
+
+		if (worker_thread.joinable())
+			worker_thread.join();
+	}
+
+	void Burst_Correlator::print_stats()
+	{
+		const Burst_Correlator_Stats& s = stats;
+
+		double avg_offset_error = 0;
+		double std_offset_error = 0;
+		double avg_snr = 0;
+
+		if (s.no_of_detected_bursts > 0)
+		{
+			avg_offset_error = s.sum_offset_error / (double)s.no_of_detected_bursts;
+			std_offset_error = sqrt(max(s.sum_squared_offset_error / s.no_of_detected_bursts - avg_offset_error * avg_offset_error, 0.0));
+			avg_snr = s.sum_snr / s.no_of_detected_bursts;
+		}
+
+		int64_t avg_correlation_time = (s.no_of_correlated_bursts > 0) ? s.sum_correlation_time / (int64_t)s.no_of_correlated_bursts : 0;
+
+		msg("sdr: Burst correlator: queued=" + to_string(s.no_of_queued_bursts) + ", dropped=" + to_string(s.no_of_dropped_bursts) + ", truncated=" + to_string(s.no_of_truncated_bursts) + ", correlated=" + to_string(s.no_of_correlated_bursts) + ", detected=" + to_string(s.no_of_detected_bursts));
+		msgf(INFO, "sdr: Burst correlator: offset_error min/avg/max=%lld/%.2f/%lld [Sa], std=%.2f [Sa], avg_snr=%.1f [dB]", (long long)s.min_offset_error, avg_offset_error, (long long)s.max_offset_error, std_offset_error, avg_snr);
+		msg("sdr: Burst correlator: correlation_time avg/max=" + to_string(avg_correlation_time / 1000) + "/" + to_string(s.max_correlation_time / 1000) + " [us]");
+	}
+}
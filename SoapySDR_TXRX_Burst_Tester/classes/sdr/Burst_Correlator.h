@@ -0,0 +1,133 @@
+#ifndef __BURST_CORRELATOR_H__
+#define __BURST_CORRELATOR_H__
+
+#include <atomic>
+#include <complex>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "Frame_Scheduler.h"
+#include "Waveform_Library.h"
+#include "../utils/FFT.h"
+#include "../utils/SPSC_Ring.h"
+
+namespace sdr
+{
+	//result of correlating a single RX burst against the TX burst expected in it
+	//
+	//	offset			- position of the TX burst within the RX burst in [Sa] (where the correlation peaks)
+	//	expected_offset	- position given by the TDD timeline, offset - expected_offset is the TX to RX timing error
+	//	peak_power		- power of the received TX burst in [dBFS]
+	//	snr				- ratio of peak_power to the power of everything else in the RX burst in [dB]
+	struct Burst_Correlation
+	{
+		uint64_t frame = 0;
+		size_t slot = 0;
+		int64_t offset = 0;
+		int64_t expected_offset = 0;
+		double peak_power = 0;
+		double snr = 0;
+		bool detected = false;
+	};
+
+	//statistics gathered by Burst_Correlator, offset errors in [Sa] are summed only over detected bursts
+	struct Burst_Correlator_Stats
+	{
+		uint64_t no_of_queued_bursts = 0;
+		uint64_t no_of_dropped_bursts = 0;
+		uint64_t no_of_truncated_bursts = 0;
+		uint64_t no_of_correlated_bursts = 0;
+		uint64_t no_of_detected_bursts = 0;
+		int64_t min_offset_error = 0;
+		int64_t max_offset_error = 0;
+		int64_t sum_offset_error = 0;
+		double sum_squared_offset_error = 0;
+		double sum_snr = 0;
+		int64_t max_correlation_time = 0;
+		int64_t sum_correlation_time = 0;
+	};
+
+	//analysis stage measuring where TX bursts land within RX bursts (e.g. over a loopback cable)
+	//
+	//the RX thread only copies every RX burst into a preallocated lock-free ring (bursts that do not fit into
+	//a full ring are dropped and counted), a worker thread cross-correlates it by FFT against the waveform sent
+	//in the TX slot preceding it and reports sample-accurate offset, peak power and SNR per frame
+	class Burst_Correlator
+	{
+	private:
+		//RX burst waiting for the worker thread
+		struct Correlation_Job
+		{
+			Frame_Slot slot;
+			std::vector<std::complex<float>> samples;
+		};
+
+		//TX burst expected within RX bursts of a single slot of the TDD frame, with spectra of all waveforms
+		//(conjugated and zero padded to fft_size) precomputed
+		struct Reference
+		{
+			bool valid = false;
+			uint64_t frame_delta = 0;
+			int64_t expected_offset = 0;
+			int no_of_tx_samples = 0;
+			//RX burst length fft_size is big enough for, longer bursts are truncated to it
+			int no_of_rx_samples = 0;
+			size_t fft_size = 0;
+			std::vector<std::vector<std::complex<float>>> spectra;
+			//cumulative energy of every waveform, so energy of its part overlapping the RX burst is cheap
+			std::vector<std::vector<double>> cumulative_energy;
+		};
+
+		Waveform_Library::sptr_t waveform_library;
+		TDD_Timeline timeline;
+		double min_snr = 10;
+		bool log_bursts = true;
+
+		//indexed by slot of the TDD timeline, FFTs are shared by references of the same size
+		std::vector<Reference> references;
+		std::map<size_t, utils::FFT::sptr_t> ffts;
+
+		typedef utils::SPSC_Ring<Correlation_Job> ring_t;
+		boost::shared_ptr<ring_t> ring;
+
+		//worker thread buffers, sized for the largest FFT
+		std::vector<std::complex<float>> spectrum;
+		std::vector<std::complex<float>> correlation;
+
+		//bursts of this frame and later ones are not correlated anymore
+		std::atomic<uint64_t> end_frame;
+
+		std::atomic<bool> running;
+		Burst_Correlator_Stats stats;
+
+		boost::thread worker_thread;
+
+		void worker_thread_function();
+		size_t drain();
+		void correlate(const Correlation_Job& job);
+		void update_stats(const Burst_Correlation& result, const int64_t correlation_time);
+
+	public:
+		typedef boost::shared_ptr<Burst_Correlator> sptr_t;
+
+		//every RX slot is correlated against the nearest TX slot starting before its end (in the same frame
+		//or in the previous one), throws std::invalid_argument when no RX slot has any TX slot to compare with
+		Burst_Correlator(const TDD_Timeline& timeline, const int64_t ticks_per_sample, Waveform_Library::sptr_t waveform_library, const size_t queue_size, const size_t max_no_of_rx_samples, const double min_snr, const bool log_bursts);
+		~Burst_Correlator();
+
+		//called only from the RX thread, samples are copied, so the RX buffer may be reused right away
+		void submit(const Frame_Slot& slot, const std::complex<float>* samples);
+
+		//stops correlating from given frame on, meant for timeline changes the references have not been built for
+		void stop_at_frame(const uint64_t frame);
+
+		void stop();
+		void print_stats();
+	};
+}
+
+#endif
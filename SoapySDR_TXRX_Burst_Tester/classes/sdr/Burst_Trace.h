@@ -0,0 +1,55 @@
+#ifndef __BURST_TRACE_H__
+#define __BURST_TRACE_H__
+
+#include <stdint.h>
+
+//binary burst trace file layout, shared by Burst_Trace_Recorder and the offline decoder
+//(kept free of any dependencies, so the decoder can be built without SoapySDR)
+//
+//file consists of a single Burst_Trace_Header followed by Burst_Trace_Record entries in host byte order
+
+namespace sdr
+{
+	const char BURST_TRACE_MAGIC[8] = {'B', 'R', 'S', 'T', 'T', 'R', 'C', 'E'};
+	const uint32_t BURST_TRACE_VERSION = 1;
+
+	//source of a trace record
+	enum burst_trace_source_t
+	{
+		TRACE_TX = 0,
+		TRACE_RX = 1,
+		TRACE_TX_ACK = 2,
+		NO_OF_TRACE_SOURCES = 3
+	};
+
+	struct Burst_Trace_Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t record_size;
+		double f_clk;
+	};
+
+	//single burst, all times in [ns] (host ones from monotonic clock, the rest from hardware clock)
+	struct Burst_Trace_Record
+	{
+		//consecutive per source, so gaps show dropped records
+		uint64_t seq;
+		int64_t submit_host_time;
+		int64_t return_host_time;
+		int64_t hardware_time;
+		int64_t burst_time;
+		int64_t status_time;
+		int32_t no_of_requested_samples;
+		int32_t no_of_transferred_samples;
+		int32_t stream_status;
+		int32_t flags;
+		uint32_t source;
+		uint32_t reserved;
+	};
+
+	static_assert(sizeof(Burst_Trace_Header) == 24, "unexpected Burst_Trace_Header layout");
+	static_assert(sizeof(Burst_Trace_Record) == 72, "unexpected Burst_Trace_Record layout");
+}
+
+#endif
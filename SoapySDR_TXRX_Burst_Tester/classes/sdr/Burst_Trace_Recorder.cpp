@@ -0,0 +1,112 @@
+#include "Burst_Trace_Recorder.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <stdexcept>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	Burst_Trace_Recorder::Burst_Trace_Recorder(const std::string& filepath, const size_t ring_size, const double f_clk)
+	:
+		filepath(filepath),
+		running(false),
+		no_of_dropped_records(0)
+	{
+		for (size_t i = 0; i < NO_OF_TRACE_SOURCES; i++)
+			rings[i].reset(new ring_t(ring_size));
+
+		file = fopen(filepath.c_str(), "wb");
+
+		if (file == nullptr)
+			throw std::runtime_error("Unable to create trace file " + filepath + ": " + string(strerror(errno)));
+
+		//large stdio buffer, so the writer thread issues only a few big writes
+		file_buffer.resize(1 << 20);
+		setvbuf(file, &file_buffer[0], _IOFBF, file_buffer.size());
+
+		Burst_Trace_Header header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, BURST_TRACE_MAGIC, sizeof(header.magic));
+		header.version = BURST_TRACE_VERSION;
+		header.record_size = sizeof(Burst_Trace_Record);
+		header.f_clk = f_clk;
+
+		fwrite(&header, sizeof(header), 1, file);
+
+		running = true;
+		writer_thread = boost::thread(&Burst_Trace_Recorder::writer_thread_function, this);
+
+		msg("sdr: Burst trace is being recorded into " + filepath + " (" + to_string(rings[0]->capacity()) + " records per ring)");
+	}
+
+	Burst_Trace_Recorder::~Burst_Trace_Recorder()
+	{
+		stop();
+	}
+
+	void Burst_Trace_Recorder::record(const burst_trace_source_t source, Burst_Trace_Record& record)
+	{
+		record.seq = next_seq[source]++;
+		record.source = source;
+		record.reserved = 0;
+
+		if (!rings[source]->try_push(record))
+			no_of_dropped_records.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	size_t Burst_Trace_Recorder::drain()
+	{
+		size_t no_of_records = 0;
+
+		for (size_t i = 0; i < NO_OF_TRACE_SOURCES; i++)
+		{
+			Burst_Trace_Record* record;
+
+			while ((record = rings[i]->peek()) != nullptr)
+			{
+				fwrite(record, sizeof(Burst_Trace_Record), 1, file);
+				rings[i]->release();
+				no_of_records++;
+			}
+		}
+
+		no_of_written_records += no_of_records;
+
+		return no_of_records;
+	}
+
+	void Burst_Trace_Recorder::writer_thread_function()
+	{
+		while (running)
+		{
+			if (drain() == 0)
+				usleep(1000);
+		}
+
+		//flush whatever has been left in the rings
+		drain();
+	}
+
+	void Burst_Trace_Recorder::stop()
+	{
+		if (!running.exchange(false))
+			return;
+
+		if (writer_thread.joinable())
+			writer_thread.join();
+
+		fclose(file);
+		file = nullptr;
+	}
+
+	void Burst_Trace_Recorder::print_stats()
+	{
+		msg("sdr: Burst trace: written_records=" + to_string(no_of_written_records) + ", dropped_records=" + to_string(no_of_dropped_records.load()) + ", file=" + filepath);
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef __BURST_TRACE_RECORDER_H__
+#define __BURST_TRACE_RECORDER_H__
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "Burst_Trace.h"
+#include "../utils/SPSC_Ring.h"
+
+namespace sdr
+{
+	//recorder of per-burst timing telemetry - every source (TX, RX, TX acks) owns a preallocated lock-free ring
+	//filled from its burst thread, a separate writer thread flushes the rings into a binary trace file
+	//(records that do not fit into a full ring are dropped and counted, the burst thread never blocks)
+	class Burst_Trace_Recorder
+	{
+	private:
+		typedef utils::SPSC_Ring<Burst_Trace_Record> ring_t;
+
+		boost::shared_ptr<ring_t> rings[NO_OF_TRACE_SOURCES];
+		uint64_t next_seq[NO_OF_TRACE_SOURCES] = {};
+
+		FILE* file = nullptr;
+		std::vector<char> file_buffer;
+		std::string filepath;
+
+		std::atomic<bool> running;
+		std::atomic<uint64_t> no_of_dropped_records;
+		uint64_t no_of_written_records = 0;
+
+		boost::thread writer_thread;
+
+		void writer_thread_function();
+		size_t drain();
+
+	public:
+		typedef boost::shared_ptr<Burst_Trace_Recorder> sptr_t;
+
+		//throws std::runtime_error when the trace file cannot be created
+		Burst_Trace_Recorder(const std::string& filepath, const size_t ring_size, const double f_clk);
+		~Burst_Trace_Recorder();
+
+		//called only from the thread owning given source, seq and source fields are filled in here
+		void record(const burst_trace_source_t source, Burst_Trace_Record& record);
+
+		void stop();
+		void print_stats();
+	};
+}
+
+#endif
@@ -0,0 +1,66 @@
+#include "Channel_Buffers.h"
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+
+using namespace std;
+
+namespace sdr
+{
+	static const size_t CACHE_LINE_SIZE = 64;
+
+	Channel_Buffers::Channel_Buffers(const size_t no_of_channels, const size_t no_of_samples)
+	:
+		no_of_samples(no_of_samples),
+		channels(no_of_channels, nullptr)
+	{
+		//channel stride in samples, rounded up to whole cache lines plus one extra line
+		const size_t samples_per_line = CACHE_LINE_SIZE / sizeof(complex<float>);
+		stride = (max(no_of_samples, (size_t)1) + samples_per_line - 1) / samples_per_line * samples_per_line + samples_per_line;
+
+		void* memory = nullptr;
+
+		if (posix_memalign(&memory, sysconf(_SC_PAGESIZE), get_block_size()) != 0)
+			throw std::runtime_error("Unable to allocate sample buffers of " + to_string(no_of_channels) + " channels");
+
+		memset(memory, 0, get_block_size());
+		block = static_cast<complex<float>*>(memory);
+
+		for (size_t c = 0; c < no_of_channels; c++)
+			channels[c] = block + c * stride;
+	}
+
+	Channel_Buffers::~Channel_Buffers()
+	{
+		free(block);
+	}
+
+	size_t Channel_Buffers::size() const
+	{
+		return channels.size();
+	}
+
+	size_t Channel_Buffers::get_no_of_samples() const
+	{
+		return no_of_samples;
+	}
+
+	std::complex<float>* const* Channel_Buffers::get() const
+	{
+		return &channels[0];
+	}
+
+	std::complex<float>* Channel_Buffers::get(const size_t channel) const
+	{
+		return channels[channel];
+	}
+
+	size_t Channel_Buffers::get_block_size() const
+	{
+		return channels.size() * stride * sizeof(complex<float>);
+	}
+}
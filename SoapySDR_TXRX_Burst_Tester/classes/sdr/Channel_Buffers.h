@@ -0,0 +1,44 @@
+#ifndef __CHANNEL_BUFFERS_H__
+#define __CHANNEL_BUFFERS_H__
+
+#include <complex>
+#include <vector>
+#include <stddef.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace sdr
+{
+	//sample buffers of all channels of a MIMO stream in a single page aligned allocation, laid out channel after
+	//channel, every channel starts on its own cache line and is padded by one more, so channels whose size is
+	//a multiple of a page do not alias each other in caches
+	//
+	//get() returns the array of channel pointers readStream/writeStream expect, so bursts go straight
+	//between these buffers and the device without any extra copy
+	class Channel_Buffers : private boost::noncopyable
+	{
+	private:
+		std::complex<float>* block = nullptr;
+		size_t no_of_samples = 0;
+		size_t stride = 0;
+		std::vector<std::complex<float>*> channels;
+
+	public:
+		typedef boost::shared_ptr<Channel_Buffers> sptr_t;
+
+		//throws std::runtime_error when the buffers cannot be allocated
+		Channel_Buffers(const size_t no_of_channels, const size_t no_of_samples);
+		~Channel_Buffers();
+
+		size_t size() const;
+		size_t get_no_of_samples() const;
+		std::complex<float>* const* get() const;
+		std::complex<float>* get(const size_t channel) const;
+
+		//total size of the allocation in bytes (e.g. for prefaulting)
+		size_t get_block_size() const;
+	};
+}
+
+#endif
@@ -0,0 +1,253 @@
+#include "Clock_Tracker.h"
+
+#include <unistd.h>
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	//every read of the tracker keeps the getHardwareTime call with the shortest round trip out of these
+	static const size_t NO_OF_TIME_READS = 3;
+
+	//drift is fitted only once the window holds this many reads, the model keeps the host clock rate until then
+	static const size_t MIN_NO_OF_DRIFT_READS = 4;
+
+	//reads further from the model than this (plus their round trip) mean the hardware time has been set in [ns]
+	static const int64_t STEP_THRESHOLD = 1000000;
+
+	Clock_Tracker::Clock_Tracker(SoapySDR::Device* device, const double period, const size_t window_size)
+	:
+		device(device),
+		period_ns(max((int64_t)(1e9 * period), (int64_t)1000000)),
+		window_size(max(window_size, (size_t)2)),
+		seq(0),
+		host_ref(0),
+		hw_ref(0),
+		slope(1.0),
+		running(false)
+	{
+		{
+			boost::lock_guard<boost::mutex> guard(tracker_mutex);
+			update(true);
+		}
+
+		running = true;
+		tracker_thread = boost::thread(&Clock_Tracker::tracker_thread_function, this);
+
+		msgf(INFO, "sdr: clock tracker: hardware time is read every %lld [ns], drift is fitted over the last %zu reads", (long long)period_ns, this->window_size);
+	}
+
+	Clock_Tracker::~Clock_Tracker()
+	{
+		stop();
+	}
+
+	Clock_Tracker::Clock_Sample Clock_Tracker::read_sample()
+	{
+		Clock_Sample sample;
+
+		for (size_t i = 0; i < NO_OF_TIME_READS; i++)
+		{
+			int64_t host_time_before = monotonic_time_ns();
+			long long hw_time = device->getHardwareTime();
+			int64_t host_time_after = monotonic_time_ns();
+
+			//hardware time is assumed to be sampled in the middle of the call
+			if ((i == 0) || (host_time_after - host_time_before < sample.read_time))
+			{
+				sample.host_time = (host_time_before + host_time_after) / 2;
+				sample.hw_time = hw_time;
+				sample.read_time = host_time_after - host_time_before;
+			}
+		}
+
+		return sample;
+	}
+
+	void Clock_Tracker::publish(const int64_t new_host_ref, const long long new_hw_ref, const double new_slope)
+	{
+		uint64_t s = seq.load(std::memory_order_relaxed);
+
+		seq.store(s + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		host_ref.store(new_host_ref, std::memory_order_relaxed);
+		hw_ref.store(new_hw_ref, std::memory_order_relaxed);
+		slope.store(new_slope, std::memory_order_relaxed);
+
+		seq.store(s + 2, std::memory_order_release);
+	}
+
+	void Clock_Tracker::update(const bool restart)
+	{
+		Clock_Sample sample = read_sample();
+
+		stats.no_of_reads++;
+		stats.sum_read_time += sample.read_time;
+		stats.max_read_time = max(stats.max_read_time, sample.read_time);
+
+		if (restart)
+			samples.clear();
+		else if (!samples.empty())
+		{
+			int64_t error = sample.hw_time - get_hardware_time(sample.host_time);
+
+			if (llabs(error) > STEP_THRESHOLD + sample.read_time)
+			{
+				stats.no_of_steps++;
+				msgf(WARNING, "sdr: clock tracker: hardware time stepped by %+lld [ns], model restarted", (long long)error);
+
+				samples.clear();
+			}
+			else
+			{
+				stats.no_of_checked_reads++;
+				stats.sum_squared_error += (double)error * error;
+				stats.max_error = max(stats.max_error, (int64_t)llabs(error));
+			}
+		}
+
+		samples.push_back(sample);
+
+		if (samples.size() > window_size)
+			samples.pop_front();
+
+		//least squares fit of hardware time against host time, both relative to the oldest read to keep precision
+		const int64_t host_origin = samples.front().host_time;
+		const long long hw_origin = samples.front().hw_time;
+		const double n = samples.size();
+
+		double mean_host = 0;
+		double mean_hw = 0;
+
+		for (const Clock_Sample& s : samples)
+		{
+			mean_host += (s.host_time - host_origin) / n;
+			mean_hw += (s.hw_time - hw_origin) / n;
+		}
+
+		double new_slope = 1.0;
+
+		if (samples.size() >= MIN_NO_OF_DRIFT_READS)
+		{
+			double sum_xx = 0;
+			double sum_xy = 0;
+
+			for (const Clock_Sample& s : samples)
+			{
+				double x = (s.host_time - host_origin) - mean_host;
+				double y = (s.hw_time - hw_origin) - mean_hw;
+
+				sum_xx += x * x;
+				sum_xy += x * y;
+			}
+
+			if (sum_xx > 0)
+				new_slope = sum_xy / sum_xx;
+		}
+
+		publish(host_origin + llround(mean_host), hw_origin + llround(mean_hw), new_slope);
+	}
+
+	void Clock_Tracker::tracker_thread_function()
+	{
+		int64_t next_read_time = monotonic_time_ns() + period_ns;
+
+		while (running)
+		{
+			int64_t remaining = next_read_time - monotonic_time_ns();
+
+			if (remaining > 0)
+			{
+				//sleep in short steps, so stopping the tracker does not wait for a whole period
+				usleep(min(remaining / 1000, (int64_t)100000));
+				continue;
+			}
+
+			next_read_time += period_ns;
+
+			boost::lock_guard<boost::mutex> guard(tracker_mutex);
+			update(false);
+		}
+	}
+
+	long long Clock_Tracker::get_hardware_time(const int64_t host_time)
+	{
+		uint64_t s;
+		int64_t current_host_ref;
+		long long current_hw_ref;
+		double current_slope;
+
+		do
+		{
+			s = seq.load(std::memory_order_acquire);
+
+			current_host_ref = host_ref.load(std::memory_order_relaxed);
+			current_hw_ref = hw_ref.load(std::memory_order_relaxed);
+			current_slope = slope.load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+		}
+		while ((s & 1) || (s != seq.load(std::memory_order_relaxed)));
+
+		return current_hw_ref + llround(current_slope * (host_time - current_host_ref));
+	}
+
+	long long Clock_Tracker::get_hardware_time()
+	{
+		return get_hardware_time(monotonic_time_ns());
+	}
+
+	int64_t Clock_Tracker::get_host_time(const long long hw_time)
+	{
+		//inverse of the model - the slope is so close to 1 that two correction steps are exact to a fraction of [ns]
+		int64_t host_time = monotonic_time_ns();
+
+		for (size_t i = 0; i < 2; i++)
+			host_time += hw_time - get_hardware_time(host_time);
+
+		return host_time;
+	}
+
+	void Clock_Tracker::restart()
+	{
+		boost::lock_guard<boost::mutex> guard(tracker_mutex);
+		update(true);
+	}
+
+	void Clock_Tracker::stop()
+	{
+		if (!running.exchange(false))
+			return;
+
+		if (tracker_thread.joinable())
+			tracker_thread.join();
+	}
+
+	void Clock_Tracker::print_stats()
+	{
+		boost::lock_guard<boost::mutex> guard(tracker_mutex);
+
+		double rms_error = stats.no_of_checked_reads ? sqrt(stats.sum_squared_error / stats.no_of_checked_reads) : 0;
+		double avg_read_time = stats.no_of_reads ? (double)stats.sum_read_time / stats.no_of_reads : 0;
+
+		msgf
+		(
+			INFO,
+			"sdr: clock tracker: reads=%llu, steps=%llu, drift=%+.3f [ppm], error rms/max=%.0f/%lld [ns], read_time avg/max=%.0f/%lld [ns]",
+			(unsigned long long)stats.no_of_reads,
+			(unsigned long long)stats.no_of_steps,
+			1e6 * (slope.load() - 1.0),
+			rms_error,
+			(long long)stats.max_error,
+			avg_read_time,
+			(long long)stats.max_read_time
+		);
+	}
+}
@@ -0,0 +1,100 @@
+#ifndef __CLOCK_TRACKER_H__
+#define __CLOCK_TRACKER_H__
+
+#include <atomic>
+#include <deque>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <SoapySDR/Device.hpp>
+
+namespace sdr
+{
+	//statistics gathered by Clock_Tracker, times in [ns]
+	//
+	//	no_of_reads			- hardware times read by the tracker (one per period, best of a few getHardwareTime calls)
+	//	no_of_checked_reads	- reads compared against the model fitted before them (all but the first one after a restart)
+	//	no_of_steps			- reads too far from the model to be drift, i.e. the hardware time has been set, the model restarts
+	//	max_error			- largest difference between a read and the time the model predicted for it
+	//	max_read_time		- longest getHardwareTime round trip
+	struct Clock_Tracker_Stats
+	{
+		uint64_t no_of_reads = 0;
+		uint64_t no_of_checked_reads = 0;
+		uint64_t no_of_steps = 0;
+		int64_t max_error = 0;
+		double sum_squared_error = 0;
+		int64_t max_read_time = 0;
+		int64_t sum_read_time = 0;
+	};
+
+	//model of the hardware clock of a device, so hardware time can be known without a getHardwareTime round trip
+	//(a synchronous control transaction taking hundreds of [us] on USB and Ethernet devices)
+	//
+	//a tracker thread reads hardware time every period and fits offset and drift of the hardware clock against
+	//host monotonic clock by linear regression over the last window_size reads, every read is checked against the
+	//model before it is added - hardware time is then estimated locally by any thread without locking
+	class Clock_Tracker
+	{
+	private:
+		//hardware time read at host time (the middle of the call)
+		struct Clock_Sample
+		{
+			int64_t host_time = 0;
+			long long hw_time = 0;
+			int64_t read_time = 0;
+		};
+
+		SoapySDR::Device* device;
+		int64_t period_ns;
+		size_t window_size;
+
+		//reads the model is fitted to, oldest first (guarded by tracker_mutex)
+		std::deque<Clock_Sample> samples;
+
+		//model hw_time = hw_ref + slope * (host_time - host_ref) published under a sequence counter, which is odd
+		//while the model is being written
+		std::atomic<uint64_t> seq;
+		std::atomic<int64_t> host_ref;
+		std::atomic<long long> hw_ref;
+		std::atomic<double> slope;
+
+		//serialises reads and model updates of the tracker thread and restart()
+		boost::mutex tracker_mutex;
+		Clock_Tracker_Stats stats;
+
+		std::atomic<bool> running;
+
+		boost::thread tracker_thread;
+
+		void tracker_thread_function();
+		Clock_Sample read_sample();
+		//reads hardware time, checks the model against it and refits it (restarting it on a step), under tracker_mutex
+		void update(const bool restart);
+		void publish(const int64_t new_host_ref, const long long new_hw_ref, const double new_slope);
+
+	public:
+		typedef boost::shared_ptr<Clock_Tracker> sptr_t;
+
+		//the model is fitted to a first read before the constructor returns, period in [s]
+		Clock_Tracker(SoapySDR::Device* device, const double period, const size_t window_size);
+		~Clock_Tracker();
+
+		//estimated hardware time in [ns] at given host monotonic time / now
+		long long get_hardware_time(const int64_t host_time);
+		long long get_hardware_time();
+
+		//host monotonic time in [ns] at which the hardware clock reaches given time
+		int64_t get_host_time(const long long hw_time);
+
+		//drops all reads and fits the model to a fresh one, meant to be called once hardware time has been set
+		void restart();
+
+		void stop();
+		void print_stats();
+	};
+}
+
+#endif
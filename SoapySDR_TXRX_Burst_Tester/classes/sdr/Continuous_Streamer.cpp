@@ -0,0 +1,520 @@
+#include "Continuous_Streamer.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+
+#include <SoapySDR/Errors.hpp>
+#include <SoapySDR/Time.hpp>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	//a stream started late is started again this far ahead of the hardware time in [ns], at most that many times
+	static const long long RESTART_LEAD_TIME = 100000000;
+	static const size_t MAX_NO_OF_RESTARTS = 10;
+
+	static void add(std::atomic<uint64_t>& counter, const uint64_t n)
+	{
+		counter.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	static uint64_t get(const std::atomic<uint64_t>& counter)
+	{
+		return counter.load(std::memory_order_relaxed);
+	}
+
+	//size in bytes of a single channel of a buffer, rounded up to whole cache lines
+	static size_t channel_stride(const size_t no_of_samples, const sample_format_t format)
+	{
+		return (no_of_samples * sample_format_size(format) + 63) / 64 * 64;
+	}
+
+	Continuous_Stream_Counters::Continuous_Stream_Counters()
+	:
+		no_of_samples(0),
+		no_of_dropped_samples(0),
+		no_of_overflows(0),
+		no_of_underflows(0),
+		no_of_late_starts(0),
+		no_of_timeouts(0),
+		no_of_other_errors(0)
+	{
+	}
+
+	Continuous_Streamer::Continuous_Streamer
+	(
+		SDR_Device_Wrapper::sptr_t sdr_device_wrapper,
+		const size_t device_index,
+		const std::complex<float>* waveform,
+		const size_t waveform_length,
+		const size_t buffer_size,
+		const long long start_time,
+		const double report_period
+	)
+	:
+		sdr_device_wrapper(sdr_device_wrapper),
+		device_cfg(sdr_device_wrapper->get_device_config()),
+		device(sdr_device_wrapper->get_device()),
+		metrics(sdr_device_wrapper->get_metrics()),
+		label((device_index == 0) ? "" : " " + to_string(device_index)),
+		start_time(start_time),
+		tx_start_time(start_time),
+		tx_late(false),
+		report_period_ns(report_period * 1e9),
+		running(false)
+	{
+		tx_sampling_rate = device_cfg->f_clk / (double)device_cfg->D_tx;
+		rx_sampling_rate = device_cfg->f_clk / (double)device_cfg->D_rx;
+
+		if (device_cfg->tx_active)
+		{
+			sample_format_t format = sdr_device_wrapper->get_tx_format();
+
+			tx_buffer_size = (buffer_size > 0) ? buffer_size : max(sdr_device_wrapper->get_mtu(SOAPY_SDR_TX), (size_t)1);
+			tx_stride = channel_stride(tx_buffer_size, format);
+			tx_native_samples.assign(device_cfg->channels_tx.size() * tx_stride, 0);
+			tx_buffs.assign(device_cfg->channels_tx.size(), nullptr);
+			tx_chunk_buffs.assign(device_cfg->channels_tx.size(), nullptr);
+
+			//waveform is tiled over the whole buffer (zeros when there is none) and converted just once
+			vector<complex<float>> tiled_samples(tx_buffer_size, complex<float>(0, 0));
+
+			for (size_t i = 0; (i < tx_buffer_size) && (waveform_length > 0); i++)
+				tiled_samples[i] = waveform[i % waveform_length];
+
+			Sample_Converters tx_converters = get_sample_converters(format);
+
+			for (size_t c = 0; c < tx_buffs.size(); c++)
+			{
+				tx_buffs[c] = &tx_native_samples[c * tx_stride];
+
+				if (format != FORMAT_CF32)
+					tx_converters.to_native(&tiled_samples[0], &tx_native_samples[c * tx_stride], tx_buffer_size);
+				else
+					memcpy(&tx_native_samples[c * tx_stride], &tiled_samples[0], tx_buffer_size * sizeof(complex<float>));
+			}
+		}
+
+		if (device_cfg->rx_active)
+		{
+			sample_format_t format = sdr_device_wrapper->get_rx_format();
+
+			rx_buffer_size = (buffer_size > 0) ? buffer_size : max(sdr_device_wrapper->get_mtu(SOAPY_SDR_RX), (size_t)1);
+			rx_samples.reset(new Channel_Buffers(device_cfg->channels_rx.size(), rx_buffer_size));
+			rx_converters = get_sample_converters(format);
+			rx_buffs.assign(device_cfg->channels_rx.size(), nullptr);
+
+			//samples of other formats are read into the native buffer and converted afterwards
+			if (format != FORMAT_CF32)
+			{
+				rx_stride = channel_stride(rx_buffer_size, format);
+				rx_native_samples.assign(device_cfg->channels_rx.size() * rx_stride, 0);
+			}
+
+			for (size_t c = 0; c < rx_buffs.size(); c++)
+				rx_buffs[c] = (format != FORMAT_CF32) ? (void*)&rx_native_samples[c * rx_stride] : (void*)rx_samples->get(c);
+
+			int ret = device->activateStream(sdr_device_wrapper->get_rx_stream(), SOAPY_SDR_HAS_TIME, start_time);
+
+			if (ret != 0)
+				throw std::runtime_error("Unable to activate RX stream for continuous streaming: " + string(SoapySDR::errToStr(ret)));
+		}
+
+		//host time at which the hardware clock reaches the start time
+		start_host_time = monotonic_time_ns() + (start_time - device->getHardwareTime());
+
+		running = true;
+
+		if (device_cfg->tx_active)
+		{
+			tx_thread = boost::thread(&Continuous_Streamer::tx_thread_function, this);
+			tx_status_thread = boost::thread(&Continuous_Streamer::tx_status_thread_function, this);
+		}
+
+		if (device_cfg->rx_active)
+			rx_thread = boost::thread(&Continuous_Streamer::rx_thread_function, this);
+
+		report_thread = boost::thread(&Continuous_Streamer::report_thread_function, this);
+
+		msgf
+		(
+			INFO,
+			"sdr: Continuous streaming%s at %.3f/%.3f [MS/s] (TX/RX) starts at %lld [ns], TX buffer of %zu [Sa], RX buffer of %zu [Sa]",
+			label.c_str(),
+			tx_sampling_rate / 1e6,
+			rx_sampling_rate / 1e6,
+			start_time,
+			tx_buffer_size,
+			rx_buffer_size
+		);
+	}
+
+	Continuous_Streamer::~Continuous_Streamer()
+	{
+		stop();
+	}
+
+	void Continuous_Streamer::count_error(const int direction, Continuous_Stream_Counters& counters, const int code)
+	{
+		//calls made ahead of the start may time out while waiting for it
+		if ((code == SOAPY_SDR_TIMEOUT) && (monotonic_time_ns() < start_host_time))
+			return;
+
+		if (code == SOAPY_SDR_OVERFLOW)
+			add(counters.no_of_overflows, 1);
+		else if (code == SOAPY_SDR_UNDERFLOW)
+			add(counters.no_of_underflows, 1);
+		else if (code == SOAPY_SDR_TIME_ERROR)
+			add(counters.no_of_late_starts, 1);
+		else if (code == SOAPY_SDR_TIMEOUT)
+			add(counters.no_of_timeouts, 1);
+		else
+			add(counters.no_of_other_errors, 1);
+
+		if (metrics)
+			metrics->count_code(direction, code);
+	}
+
+	void Continuous_Streamer::tx_thread_function()
+	{
+		SoapySDR::Stream* tx_stream = sdr_device_wrapper->get_tx_stream();
+		const size_t sample_size = sample_format_size(sdr_device_wrapper->get_tx_format());
+		const long timeout_us = 1e6 * device_cfg->T_timeout;
+
+		size_t offset = 0;
+		bool started = false;
+		size_t no_of_restarts = 0;
+
+		//the whole run is a single burst, only its first write carries the start time
+		while (running)
+		{
+			//a late burst is dropped by the device, so it is started anew at a time still ahead
+			if (tx_late.exchange(false))
+			{
+				if (++no_of_restarts > MAX_NO_OF_RESTARTS)
+				{
+					msgf(ERROR, "sdr: [TX%s]  stream has started late %zu times, TX is stopped", label.c_str(), no_of_restarts);
+					break;
+				}
+
+				//burst that has been started is ended first, drivers tracking start and end of bursts (e.g. UHD) expect
+				//it before the next start
+				if (started)
+				{
+					int end_flags = SOAPY_SDR_END_BURST;
+					device->writeStream(tx_stream, &tx_chunk_buffs[0], 0, end_flags, 0, timeout_us);
+				}
+
+				tx_start_time = sdr_device_wrapper->get_hardware_time() + RESTART_LEAD_TIME;
+				started = false;
+				offset = 0;
+
+				msgf(WARNING, "sdr: [TX%s]  stream has started after its start time, it starts again at %lld [ns]", label.c_str(), tx_start_time);
+			}
+
+			for (size_t c = 0; c < tx_chunk_buffs.size(); c++)
+				tx_chunk_buffs[c] = static_cast<const char*>(tx_buffs[c]) + offset * sample_size;
+
+			int flags = started ? 0 : SOAPY_SDR_HAS_TIME;
+
+			int ret = device->writeStream(tx_stream, &tx_chunk_buffs[0], tx_buffer_size - offset, flags, tx_start_time, timeout_us);
+
+			if (ret <= 0)
+			{
+				count_error(SOAPY_SDR_TX, tx_counters, (ret < 0) ? ret : SOAPY_SDR_TIMEOUT);
+
+				if (ret == SOAPY_SDR_TIME_ERROR)
+				{
+					tx_late = true;
+					continue;
+				}
+
+				//errors other than timeouts tend to repeat right away
+				if ((ret < 0) && (ret != SOAPY_SDR_TIMEOUT))
+					usleep(1000);
+
+				continue;
+			}
+
+			started = true;
+			offset = (offset + ret) % tx_buffer_size;
+
+			add(tx_counters.no_of_samples, ret);
+		}
+
+		//burst is closed, so the device does not wait for the rest of it
+		if (started)
+		{
+			int flags = SOAPY_SDR_END_BURST;
+			device->writeStream(tx_stream, &tx_chunk_buffs[0], 0, flags, 0, timeout_us);
+		}
+	}
+
+	void Continuous_Streamer::tx_status_thread_function()
+	{
+		SoapySDR::Stream* tx_stream = sdr_device_wrapper->get_tx_stream();
+
+		while (running)
+		{
+			size_t chan_mask = 0;
+			int flags = 0;
+			long long time_ns = 0;
+
+			int ret = device->readStreamStatus(tx_stream, chan_mask, flags, time_ns, 100000);
+
+			if (ret == SOAPY_SDR_NOT_SUPPORTED)
+			{
+				msg("sdr: [TX" + label + "]  readStreamStatus is not supported, underflows are not going to be counted", WARNING);
+				break;
+			}
+
+			//timeouts just mean there has been nothing to report, acks of the burst are of no interest
+			if ((ret < 0) && (ret != SOAPY_SDR_TIMEOUT))
+				count_error(SOAPY_SDR_TX, tx_counters, ret);
+
+			//devices may accept a late burst and report it only here, the TX thread starts it again
+			if (ret == SOAPY_SDR_TIME_ERROR)
+				tx_late = true;
+		}
+	}
+
+	void Continuous_Streamer::rx_thread_function()
+	{
+		SoapySDR::Stream* rx_stream = sdr_device_wrapper->get_rx_stream();
+		const bool convert = (sdr_device_wrapper->get_rx_format() != FORMAT_CF32);
+		const long timeout_us = 1e6 * device_cfg->T_timeout;
+
+		//index of the sample expected next by RX timestamps, unknown until the first read
+		long long next_index = 0;
+		bool next_index_known = false;
+		size_t no_of_restarts = 0;
+
+		while (running)
+		{
+			int flags = 0;
+			long long time_ns = 0;
+
+			int ret = device->readStream(rx_stream, &rx_buffs[0], rx_buffer_size, flags, time_ns, timeout_us);
+
+			if (ret <= 0)
+			{
+				count_error(SOAPY_SDR_RX, rx_counters, (ret < 0) ? ret : SOAPY_SDR_TIMEOUT);
+
+				//stream activated late delivers nothing, so it is activated again at a time still ahead
+				if (ret == SOAPY_SDR_TIME_ERROR)
+				{
+					if (++no_of_restarts > MAX_NO_OF_RESTARTS)
+					{
+						msgf(ERROR, "sdr: [RX%s]  stream has started late %zu times, RX is stopped", label.c_str(), no_of_restarts);
+						break;
+					}
+
+					long long rx_start_time = sdr_device_wrapper->get_hardware_time() + RESTART_LEAD_TIME;
+
+					device->deactivateStream(rx_stream);
+
+					int activate_ret = device->activateStream(rx_stream, SOAPY_SDR_HAS_TIME, rx_start_time);
+
+					if (activate_ret != 0)
+					{
+						msgf(ERROR, "sdr: [RX%s]  stream could not be activated again: %s, RX is stopped", label.c_str(), SoapySDR::errToStr(activate_ret));
+						break;
+					}
+
+					//samples skipped by the restart are not lost ones
+					next_index_known = false;
+
+					msgf(WARNING, "sdr: [RX%s]  stream has started after its start time, it starts again at %lld [ns]", label.c_str(), rx_start_time);
+					continue;
+				}
+
+				if ((ret < 0) && (ret != SOAPY_SDR_TIMEOUT) && (ret != SOAPY_SDR_OVERFLOW))
+					usleep(1000);
+
+				continue;
+			}
+
+			//whatever has not been read between the end of the previous read and the start of this one has been lost
+			if (flags & SOAPY_SDR_HAS_TIME)
+			{
+				long long index = SoapySDR::timeNsToTicks(time_ns, rx_sampling_rate);
+
+				if (next_index_known && (index > next_index))
+					add(rx_counters.no_of_dropped_samples, index - next_index);
+
+				next_index = index;
+				next_index_known = true;
+			}
+
+			next_index += ret;
+
+			if (convert)
+			{
+				for (size_t c = 0; c < rx_buffs.size(); c++)
+					rx_converters.from_native(rx_buffs[c], rx_samples->get(c), ret);
+			}
+
+			add(rx_counters.no_of_samples, ret);
+		}
+	}
+
+	void Continuous_Streamer::report_thread_function()
+	{
+		uint64_t last_tx_samples = 0;
+		uint64_t last_rx_samples = 0;
+		uint64_t last_tx_losses = 0;
+		uint64_t last_rx_losses = 0;
+		int64_t last_report_time = start_host_time;
+
+		while (running)
+		{
+			usleep(10000);
+
+			int64_t now = monotonic_time_ns();
+
+			if ((report_period_ns <= 0) || (now < last_report_time + report_period_ns))
+				continue;
+
+			double period = (now - last_report_time) / 1e9;
+
+			uint64_t tx_samples = get(tx_counters.no_of_samples);
+			uint64_t rx_samples = get(rx_counters.no_of_samples);
+			uint64_t tx_errors = get(tx_counters.no_of_late_starts) + get(tx_counters.no_of_timeouts) + get(tx_counters.no_of_other_errors);
+			uint64_t rx_errors = get(rx_counters.no_of_late_starts) + get(rx_counters.no_of_timeouts) + get(rx_counters.no_of_other_errors);
+			uint64_t tx_losses = tx_errors + get(tx_counters.no_of_underflows);
+			uint64_t rx_losses = rx_errors + get(rx_counters.no_of_overflows) + get(rx_counters.no_of_dropped_samples);
+
+			//the first period of TX also holds samples buffered by the device ahead of the start, so it is not
+			//taken into account by min/max/avg
+			for (int direction : {SOAPY_SDR_TX, SOAPY_SDR_RX})
+			{
+				bool tx = (direction == SOAPY_SDR_TX);
+
+				if (!(tx ? device_cfg->tx_active : device_cfg->rx_active))
+					continue;
+
+				Continuous_Stream_Rates& rates = tx ? tx_rates : rx_rates;
+				uint64_t samples = tx ? tx_samples - last_tx_samples : rx_samples - last_rx_samples;
+
+				const uint64_t first_rated_period = tx ? 1 : 0;
+
+				rates.last_rate = samples / period / 1e6;
+
+				if (rates.no_of_periods >= first_rated_period)
+				{
+					if (rates.no_of_periods == first_rated_period)
+						rates.min_rate = rates.max_rate = rates.last_rate;
+					else
+					{
+						rates.min_rate = min(rates.min_rate, rates.last_rate);
+						rates.max_rate = max(rates.max_rate, rates.last_rate);
+					}
+
+					rates.no_of_rated_samples += samples;
+					rates.rated_time += period;
+				}
+
+				rates.no_of_periods++;
+
+				msgf
+				(
+					(tx ? (tx_losses > last_tx_losses) : (rx_losses > last_rx_losses)) ? WARNING : INFO,
+					"sdr: [%s%s]  rate=%.3f/%.3f [MS/s], %s=%llu, dropped_samples=%llu, errors=%llu",
+					tx ? "TX" : "RX",
+					label.c_str(),
+					rates.last_rate,
+					(tx ? tx_sampling_rate : rx_sampling_rate) / 1e6,
+					tx ? "underflows" : "overflows",
+					(unsigned long long)(tx ? get(tx_counters.no_of_underflows) : get(rx_counters.no_of_overflows)),
+					(unsigned long long)(tx ? 0 : get(rx_counters.no_of_dropped_samples)),
+					(unsigned long long)(tx ? tx_errors : rx_errors)
+				);
+			}
+
+			last_tx_samples = tx_samples;
+			last_rx_samples = rx_samples;
+			last_tx_losses = tx_losses;
+			last_rx_losses = rx_losses;
+			last_report_time = now;
+		}
+	}
+
+	void Continuous_Streamer::stop()
+	{
+		if (!running.exchange(false))
+			return;
+
+		if (tx_thread.joinable())
+			tx_thread.join();
+		if (tx_status_thread.joinable())
+			tx_status_thread.join();
+		if (rx_thread.joinable())
+			rx_thread.join();
+		if (report_thread.joinable())
+			report_thread.join();
+
+		stop_host_time = monotonic_time_ns();
+
+		if (device_cfg->rx_active)
+			device->deactivateStream(sdr_device_wrapper->get_rx_stream());
+	}
+
+	bool Continuous_Streamer::has_worker(const int direction)
+	{
+		return (direction == SOAPY_SDR_TX) ? tx_thread.joinable() : rx_thread.joinable();
+	}
+
+	boost::thread::native_handle_type Continuous_Streamer::get_native_handle(const int direction)
+	{
+		return (direction == SOAPY_SDR_TX) ? tx_thread.native_handle() : rx_thread.native_handle();
+	}
+
+	void Continuous_Streamer::print_direction_stats(const char* name, const Continuous_Stream_Counters& counters, const Continuous_Stream_Rates& rates, const double sampling_rate, const int64_t duration)
+	{
+		uint64_t no_of_samples = get(counters.no_of_samples);
+		uint64_t no_of_dropped_samples = get(counters.no_of_dropped_samples);
+
+		msgf
+		(
+			INFO,
+			"sdr: [%s%s]  continuous: samples=%llu, dropped_samples=%llu (%.6f%%), rate avg/min/max=%.3f/%.3f/%.3f [MS/s] of %.3f [MS/s]",
+			name,
+			label.c_str(),
+			(unsigned long long)no_of_samples,
+			(unsigned long long)no_of_dropped_samples,
+			(no_of_samples + no_of_dropped_samples > 0) ? 100.0 * no_of_dropped_samples / (no_of_samples + no_of_dropped_samples) : 0.0,
+			(rates.rated_time > 0) ? rates.no_of_rated_samples / rates.rated_time / 1e6 : ((duration > 0) ? no_of_samples * 1e3 / duration : 0.0),
+			rates.min_rate,
+			rates.max_rate,
+			sampling_rate / 1e6
+		);
+
+		msgf
+		(
+			INFO,
+			"sdr: [%s%s]  continuous: overflows=%llu, underflows=%llu, late_starts=%llu, timeouts=%llu, other_errors=%llu",
+			name,
+			label.c_str(),
+			(unsigned long long)get(counters.no_of_overflows),
+			(unsigned long long)get(counters.no_of_underflows),
+			(unsigned long long)get(counters.no_of_late_starts),
+			(unsigned long long)get(counters.no_of_timeouts),
+			(unsigned long long)get(counters.no_of_other_errors)
+		);
+	}
+
+	void Continuous_Streamer::print_stats()
+	{
+		int64_t duration = (stop_host_time > 0 ? stop_host_time : monotonic_time_ns()) - start_host_time;
+
+		if (device_cfg->tx_active)
+			print_direction_stats("TX", tx_counters, tx_rates, tx_sampling_rate, duration);
+		if (device_cfg->rx_active)
+			print_direction_stats("RX", rx_counters, rx_rates, rx_sampling_rate, duration);
+	}
+}
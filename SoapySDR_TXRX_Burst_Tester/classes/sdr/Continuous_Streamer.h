@@ -0,0 +1,147 @@
+#ifndef __CONTINUOUS_STREAMER_H__
+#define __CONTINUOUS_STREAMER_H__
+
+#include <atomic>
+#include <complex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "SDR_Device_Wrapper.h"
+#include "Channel_Buffers.h"
+
+namespace sdr
+{
+	//counters of a single direction of Continuous_Streamer, written only by its I/O threads and read by the report
+	//thread
+	//
+	//	no_of_samples			- samples written/read
+	//	no_of_dropped_samples	- RX samples missing between timestamps of consecutive reads
+	//	no_of_overflows			- SOAPY_SDR_OVERFLOW returned by readStream
+	//	no_of_underflows		- SOAPY_SDR_UNDERFLOW reported by readStreamStatus
+	//	no_of_late_starts		- SOAPY_SDR_TIME_ERROR, i.e. the stream started after its start time
+	//	no_of_timeouts			- SOAPY_SDR_TIMEOUT returned by writeStream/readStream
+	//	no_of_other_errors		- any other error code
+	struct Continuous_Stream_Counters
+	{
+		std::atomic<uint64_t> no_of_samples;
+		std::atomic<uint64_t> no_of_dropped_samples;
+		std::atomic<uint64_t> no_of_overflows;
+		std::atomic<uint64_t> no_of_underflows;
+		std::atomic<uint64_t> no_of_late_starts;
+		std::atomic<uint64_t> no_of_timeouts;
+		std::atomic<uint64_t> no_of_other_errors;
+
+		Continuous_Stream_Counters();
+	};
+
+	//sustained rates of a direction over report periods in [MS/s], samples and time in [s] of the periods min/max
+	//are taken over, so the average printed next to them is taken over the same periods
+	struct Continuous_Stream_Rates
+	{
+		uint64_t no_of_periods = 0;
+		double min_rate = 0;
+		double max_rate = 0;
+		double last_rate = 0;
+		uint64_t no_of_rated_samples = 0;
+		double rated_time = 0;
+	};
+
+	//non-stop TX and RX streaming at master_clock_rate / clock_divider of each direction meant for finding the sample
+	//rate ceiling of a host and device - both streams start at the same hardware time and never stop until stop() is
+	//called (a stream that starts late is started again a little later)
+	//
+	//the TX thread keeps writing a reusable buffer (given waveform tiled and converted to the stream format once)
+	//as a single endless burst, a TX status thread counts underflows reported by readStreamStatus, the RX thread
+	//keeps reading a reusable buffer and converting it to CF32 and counts samples missing between timestamps of
+	//consecutive reads as dropped - I/O threads only update counters, sustained rates and losses of every report
+	//period are printed by a report thread
+	class Continuous_Streamer
+	{
+	private:
+		SDR_Device_Wrapper::sptr_t sdr_device_wrapper;
+		SDR_Device_Config::sptr_t device_cfg;
+		SoapySDR::Device* device;
+		SDR_Metrics::sptr_t metrics;
+
+		//"" for the first device, " N" for the others
+		std::string label;
+
+		//directions run at their own clock dividers
+		double tx_sampling_rate;
+		double rx_sampling_rate;
+		size_t tx_buffer_size = 0;
+		size_t rx_buffer_size = 0;
+		long long start_time;
+		//TX start time, moved further by the TX thread once the TX or TX status thread has found the stream late
+		long long tx_start_time;
+		std::atomic<bool> tx_late;
+		int64_t start_host_time = 0;
+		int64_t stop_host_time = 0;
+		int64_t report_period_ns;
+
+		//TX buffer in stream format and RX buffers in stream format (unused for CF32) and CF32, channels of native
+		//buffers are tx/rx_stride bytes apart
+		std::vector<char> tx_native_samples;
+		size_t tx_stride = 0;
+		std::vector<const void*> tx_buffs;
+		std::vector<const void*> tx_chunk_buffs;
+		std::vector<char> rx_native_samples;
+		size_t rx_stride = 0;
+		std::vector<void*> rx_buffs;
+		Channel_Buffers::sptr_t rx_samples;
+		Sample_Converters rx_converters;
+
+		Continuous_Stream_Counters tx_counters;
+		Continuous_Stream_Counters rx_counters;
+		Continuous_Stream_Rates tx_rates;
+		Continuous_Stream_Rates rx_rates;
+
+		std::atomic<bool> running;
+
+		boost::thread tx_thread;
+		boost::thread tx_status_thread;
+		boost::thread rx_thread;
+		boost::thread report_thread;
+
+		void tx_thread_function();
+		void tx_status_thread_function();
+		void rx_thread_function();
+		void report_thread_function();
+
+		//counts a SoapySDR error code returned in given direction
+		void count_error(const int direction, Continuous_Stream_Counters& counters, const int code);
+		void print_direction_stats(const char* name, const Continuous_Stream_Counters& counters, const Continuous_Stream_Rates& rates, const double sampling_rate, const int64_t duration);
+
+	public:
+		typedef boost::shared_ptr<Continuous_Streamer> sptr_t;
+
+		//streams of active directions start at start_time (hardware time in [ns]) and their threads right away,
+		//buffer_size is number of samples per writeStream/readStream call (0 - stream MTU), report_period in [s]
+		//(0 - only on exit), throws std::runtime_error when RX stream cannot be activated
+		Continuous_Streamer
+		(
+			SDR_Device_Wrapper::sptr_t sdr_device_wrapper,
+			const size_t device_index,
+			const std::complex<float>* waveform,
+			const size_t waveform_length,
+			const size_t buffer_size,
+			const long long start_time,
+			const double report_period
+		);
+		~Continuous_Streamer();
+
+		//closes the TX burst and deactivates RX stream
+		void stop();
+
+		//whether an I/O thread of given direction has been started, i.e. whether its handle is valid
+		bool has_worker(const int direction);
+		boost::thread::native_handle_type get_native_handle(const int direction);
+		void print_stats();
+	};
+}
+
+#endif
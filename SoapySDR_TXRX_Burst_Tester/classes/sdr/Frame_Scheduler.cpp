@@ -0,0 +1,520 @@
+#include "Frame_Scheduler.h"
+
+#include <unistd.h>
+#include <stdio.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include <SoapySDR/Time.hpp>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	TDD_Slot parse_tdd_slot(const std::string& description, const double f_clk)
+	{
+		vector<string> fields = explode(description, ':');
+
+		if (fields.size() != 3)
+			throw std::invalid_argument("TDD slot '" + description + "' is not in a form of DIRECTION:OFFSET:LENGTH");
+
+		TDD_Slot slot;
+
+		if ((fields[0] == "TX") || (fields[0] == "tx"))
+			slot.direction = SOAPY_SDR_TX;
+		else if ((fields[0] == "RX") || (fields[0] == "rx"))
+			slot.direction = SOAPY_SDR_RX;
+		else
+			throw std::invalid_argument("TDD slot '" + description + "' has unknown direction (expected TX or RX)");
+
+		slot.offset_ticks = SoapySDR::timeNsToTicks(stod(fields[1]) * 1e9, f_clk);
+		slot.length_ticks = SoapySDR::timeNsToTicks(stod(fields[2]) * 1e9, f_clk);
+
+		if ((slot.offset_ticks < 0) || (slot.length_ticks <= 0))
+			throw std::invalid_argument("TDD slot '" + description + "' needs non-negative offset and positive length");
+
+		return slot;
+	}
+
+	Frame_Scheduler::Frame_Scheduler(SDR_Device_Wrapper::sptr_t sdr_device_wrapper, const TDD_Timeline& timeline)
+	:
+		sdr_device_wrapper(sdr_device_wrapper),
+		timeline(timeline),
+		slot_stats(timeline.slots.size()),
+		metrics(sdr_device_wrapper->get_metrics())
+	{
+		SDR_Device_Config::sptr_t device_cfg = sdr_device_wrapper->get_device_config();
+
+		for (size_t i = 0; i < timeline.slots.size(); i++)
+			((timeline.slots[i].direction == SOAPY_SDR_TX) ? tx_slots : rx_slots).push_back(i);
+
+		Timeline_Segment segment;
+		segment.first_frame = 0;
+		segment.first_frame_tick = timeline.first_frame_tick;
+		segment.frame_ticks = timeline.frame_ticks;
+
+		for (const TDD_Slot& slot : timeline.slots)
+			segment.slot_length_ticks.push_back(slot.length_ticks);
+
+		segments.push_back(segment);
+
+		tx_next_frame = timeline.first_tx_frame;
+		rx_next_frame = timeline.first_rx_frame;
+
+		//every direction goes through its slots in order of their offsets
+		auto by_offset = [&](size_t a, size_t b) { return timeline.slots[a].offset_ticks < timeline.slots[b].offset_ticks; };
+
+		stable_sort(tx_slots.begin(), tx_slots.end(), by_offset);
+		stable_sort(rx_slots.begin(), rx_slots.end(), by_offset);
+
+		msgf
+		(
+			INFO,
+			"sdr: TDD timeline: frame=%lld [ns], no_of_slots=%zu, lead_time=%lld [ns], min_lead_time=%lld [ns]",
+			SoapySDR::ticksToTimeNs(timeline.frame_ticks, device_cfg->f_clk),
+			timeline.slots.size(),
+			(long long)(1e9 * timeline.lead_time),
+			(long long)(1e9 * timeline.min_lead_time)
+		);
+
+		for (const vector<size_t>* slots : {&tx_slots, &rx_slots})
+		{
+			for (size_t i = 0; i < slots->size(); i++)
+			{
+				const TDD_Slot& slot = timeline.slots[(*slots)[i]];
+				const char* name = (slot.direction == SOAPY_SDR_TX) ? "TX" : "RX";
+
+				msgf
+				(
+					INFO,
+					"sdr: TDD slot %zu: %s, offset=%lld [ns], length=%lld [ns]",
+					(*slots)[i],
+					name,
+					SoapySDR::ticksToTimeNs(slot.offset_ticks, device_cfg->f_clk),
+					SoapySDR::ticksToTimeNs(slot.length_ticks, device_cfg->f_clk)
+				);
+
+				if (slot.offset_ticks + slot.length_ticks > timeline.frame_ticks)
+					msgf(WARNING, "sdr: TDD slot %zu: %s slot does not fit into the frame", (*slots)[i], name);
+
+				//bursts of the same direction cannot overlap on the device
+				if ((i > 0) && (timeline.slots[(*slots)[i - 1]].offset_ticks + timeline.slots[(*slots)[i - 1]].length_ticks > slot.offset_ticks))
+					msgf(WARNING, "sdr: TDD slot %zu: %s slot overlaps previous %s slot", (*slots)[i], name, name);
+			}
+		}
+	}
+
+	Frame_Scheduler::~Frame_Scheduler()
+	{
+		stop();
+	}
+
+	void Frame_Scheduler::start(slot_handler_t tx_handler, slot_handler_t rx_handler)
+	{
+		{
+			boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+			if (running)
+				return;
+
+			running = true;
+		}
+
+		read_hardware_time();
+
+		if (rx_handler && !rx_slots.empty())
+			rx_thread = boost::thread(&Frame_Scheduler::worker_function, this, SOAPY_SDR_RX, rx_handler);
+
+		if (tx_handler && !tx_slots.empty())
+			tx_thread = boost::thread(&Frame_Scheduler::worker_function, this, SOAPY_SDR_TX, tx_handler);
+	}
+
+	void Frame_Scheduler::stop()
+	{
+		{
+			boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+			if (!running)
+				return;
+
+			running = false;
+		}
+
+		if (tx_thread.joinable())
+			tx_thread.join();
+
+		if (rx_thread.joinable())
+			rx_thread.join();
+	}
+
+	long long Frame_Scheduler::read_hardware_time()
+	{
+		int64_t host_time_before = monotonic_time_ns();
+		long long hw_time = sdr_device_wrapper->get_hardware_time();
+		int64_t host_time_after = monotonic_time_ns();
+
+		//hardware time is assumed to be sampled in the middle of the call
+		boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+		hw_to_host_offset = hw_time - (host_time_before + host_time_after) / 2;
+
+		return hw_time;
+	}
+
+	bool Frame_Scheduler::sleep_until(const int64_t host_time)
+	{
+		while (true)
+		{
+			{
+				boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+				if (!running || utils::stop)
+					return false;
+			}
+
+			int64_t remaining = host_time - monotonic_time_ns();
+
+			if (remaining <= 0)
+				return true;
+
+			//sleep in short steps, so stopping the scheduler does not wait for a whole lead time
+			usleep(min(remaining / 1000, (int64_t)100000));
+		}
+	}
+
+	void Frame_Scheduler::update_stats(Frame_Scheduler_Stats& stats, const long long lead_time)
+	{
+		size_t bucket = upper_bound(LEAD_TIME_BUCKET_EDGES, LEAD_TIME_BUCKET_EDGES + NO_OF_LEAD_TIME_BUCKETS - 1, (int64_t)lead_time) - LEAD_TIME_BUCKET_EDGES;
+
+		stats.no_of_dispatched_slots++;
+		stats.lead_time_histogram[bucket]++;
+
+		if ((stats.no_of_dispatched_slots == 1) || (lead_time < stats.min_lead_time))
+			stats.min_lead_time = lead_time;
+		if ((stats.no_of_dispatched_slots == 1) || (lead_time > stats.max_lead_time))
+			stats.max_lead_time = lead_time;
+		stats.sum_lead_time += lead_time;
+	}
+
+	bool Frame_Scheduler::wait_for_slot(const int direction, uint64_t& frame, size_t& position, Frame_Slot& slot)
+	{
+		SDR_Device_Config::sptr_t device_cfg = sdr_device_wrapper->get_device_config();
+
+		const vector<size_t>& slots = (direction == SOAPY_SDR_TX) ? tx_slots : rx_slots;
+		const uint16_t D = (direction == SOAPY_SDR_TX) ? device_cfg->D_tx : device_cfg->D_rx;
+		const long long lead_time_ns = 1e9 * timeline.lead_time;
+		const long long min_lead_time_ns = 1e9 * timeline.min_lead_time;
+
+		Frame_Scheduler_Stats& stats = (direction == SOAPY_SDR_TX) ? tx_stats : rx_stats;
+
+		while (true)
+		{
+			int64_t tick;
+			int64_t length_ticks;
+			int64_t offset;
+
+			{
+				boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+				((direction == SOAPY_SDR_TX) ? tx_next_frame : rx_next_frame) = frame;
+
+				tick = frame_start_tick(frame) + timeline.slots[slots[position]].offset_ticks;
+				length_ticks = segment_of(frame).slot_length_ticks[slots[position]];
+				offset = hw_to_host_offset;
+			}
+
+			long long time_ns = SoapySDR::ticksToTimeNs(tick, device_cfg->f_clk);
+
+			if (!sleep_until(time_ns - lead_time_ns - offset))
+				return false;
+
+			long long hw_time = read_hardware_time();
+			long long lead_time = time_ns - hw_time;
+
+			if (lead_time < min_lead_time_ns)
+			{
+				//skip at once all slots that cannot make it any more, instead of drifting behind the timeline
+				uint64_t no_of_skipped_slots = 0;
+				uint64_t missed_frame = frame;
+
+				boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+				while (SoapySDR::ticksToTimeNs(frame_start_tick(frame) + timeline.slots[slots[position]].offset_ticks, device_cfg->f_clk) - hw_time < min_lead_time_ns)
+				{
+					slot_stats[slots[position]].no_of_skipped_slots++;
+					no_of_skipped_slots++;
+
+					if (++position == slots.size())
+					{
+						position = 0;
+						frame++;
+					}
+				}
+
+				stats.no_of_skipped_slots += no_of_skipped_slots;
+
+				if (metrics)
+					((direction == SOAPY_SDR_TX) ? metrics->tx_skipped_slots : metrics->rx_skipped_slots).add(no_of_skipped_slots);
+
+				msgf
+				(
+					WARNING,
+					"sdr: [%s]  frame %llu missed its slot (lead_time=%lld [ns]), %llu slot(s) skipped",
+					(direction == SOAPY_SDR_TX) ? "TX" : "RX",
+					(unsigned long long)missed_frame,
+					lead_time,
+					(unsigned long long)no_of_skipped_slots
+				);
+
+				continue;
+			}
+
+			slot.frame = frame;
+			slot.slot = slots[position];
+			slot.tick = tick;
+			slot.time_ns = time_ns;
+			slot.lead_time_ns = lead_time;
+			slot.no_of_samples = length_ticks / D;
+
+			if (++position == slots.size())
+			{
+				position = 0;
+				frame++;
+			}
+
+			if (metrics)
+				((direction == SOAPY_SDR_TX) ? metrics->tx_lead_time : metrics->rx_lead_time).observe(lead_time);
+
+			boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+			update_stats(stats, lead_time);
+			update_stats(slot_stats[slot.slot], lead_time);
+
+			return true;
+		}
+	}
+
+	void Frame_Scheduler::worker_function(const int direction, slot_handler_t handler)
+	{
+		const char* name = (direction == SOAPY_SDR_TX) ? "TX" : "RX";
+
+		uint64_t frame = (direction == SOAPY_SDR_TX) ? timeline.first_tx_frame : timeline.first_rx_frame;
+		size_t position = 0;
+
+		try
+		{
+			msgf(INFO, "sdr: [%s]  frame worker started", name);
+
+			Frame_Slot slot;
+
+			while (wait_for_slot(direction, frame, position, slot))
+			{
+				if (!handler(slot))
+				{
+					boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+					((direction == SOAPY_SDR_TX) ? tx_stats : rx_stats).no_of_failed_slots++;
+					slot_stats[slot.slot].no_of_failed_slots++;
+				}
+			}
+		}
+		catch (const boost::thread_interrupted& e)
+		{
+			msgf(INFO, "sdr: [%s]  frame worker has been interrupted.", name);
+		}
+		catch (const std::exception& e)
+		{
+			msg("sdr: [" + string(name) + "]  frame worker: " + string(e.what()), WARNING);
+		}
+	}
+
+	const Frame_Scheduler::Timeline_Segment& Frame_Scheduler::segment_of(const uint64_t frame) const
+	{
+		size_t i = segments.size() - 1;
+
+		while ((i > 0) && (segments[i].first_frame > frame))
+			i--;
+
+		return segments[i];
+	}
+
+	int64_t Frame_Scheduler::frame_start_tick(const uint64_t frame) const
+	{
+		const Timeline_Segment& segment = segment_of(frame);
+
+		return segment.first_frame_tick + (int64_t)(frame - segment.first_frame) * segment.frame_ticks;
+	}
+
+	uint64_t Frame_Scheduler::earliest_change_frame() const
+	{
+		//a worker may be working on its next frame already, so only the one after it is safe
+		uint64_t frame = 0;
+
+		if (running && !tx_slots.empty())
+			frame = max(frame, tx_next_frame + 1);
+		if (running && !rx_slots.empty())
+			frame = max(frame, rx_next_frame + 1);
+
+		return max(frame, (uint64_t)1);
+	}
+
+	uint64_t Frame_Scheduler::get_earliest_change_frame()
+	{
+		boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+		return earliest_change_frame();
+	}
+
+	void Frame_Scheduler::validate_change(const TDD_Timeline_Change& change) const
+	{
+		if (change.frame < earliest_change_frame())
+			throw std::invalid_argument("frame " + to_string(change.frame) + " is being dispatched already, the earliest frame that can be changed is " + to_string(earliest_change_frame()));
+
+		if (change.frame < segments.back().first_frame)
+			throw std::invalid_argument("frame " + to_string(change.frame) + " is earlier than frame " + to_string(segments.back().first_frame) + " a change has been scheduled for");
+
+		if ((change.frame_ticks < 0) || (!change.slot_length_ticks.empty() && (change.slot_length_ticks.size() != timeline.slots.size())))
+			throw std::invalid_argument("timeline change needs non-negative frame length and a length for every slot");
+	}
+
+	void Frame_Scheduler::check_change(const TDD_Timeline_Change& change)
+	{
+		boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+		validate_change(change);
+	}
+
+	void Frame_Scheduler::schedule_change(const TDD_Timeline_Change& change)
+	{
+		boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+		validate_change(change);
+
+		reverted_segments = segments;
+		last_change_frame = change.frame;
+		change_revertible = true;
+
+		//the frame starts where the timeline in effect so far has placed it
+		Timeline_Segment segment = segment_of(change.frame);
+
+		segment.first_frame_tick = frame_start_tick(change.frame);
+		segment.first_frame = change.frame;
+
+		if (change.frame_ticks > 0)
+			segment.frame_ticks = change.frame_ticks;
+
+		for (size_t i = 0; i < change.slot_length_ticks.size(); i++)
+			if (change.slot_length_ticks[i] > 0)
+				segment.slot_length_ticks[i] = change.slot_length_ticks[i];
+
+		for (size_t i = 0; i < timeline.slots.size(); i++)
+			if (timeline.slots[i].offset_ticks + segment.slot_length_ticks[i] > segment.frame_ticks)
+				msgf(WARNING, "sdr: TDD slot %zu: slot does not fit into the frame from frame %llu on", i, (unsigned long long)change.frame);
+
+		if (change.frame == segments.back().first_frame)
+			segments.back() = segment;
+		else
+			segments.push_back(segment);
+	}
+
+	bool Frame_Scheduler::revert_change()
+	{
+		boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+		//workers may have prepared slots of the changed frame already
+		if (!change_revertible || (last_change_frame < earliest_change_frame()))
+			return false;
+
+		segments = reverted_segments;
+		change_revertible = false;
+
+		return true;
+	}
+
+	int64_t Frame_Scheduler::get_frame_start_tick(const uint64_t frame)
+	{
+		boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+		return frame_start_tick(frame);
+	}
+
+	void Frame_Scheduler::get_frame_gap(const uint64_t frame, int64_t& gap_start_tick, int64_t& gap_end_tick)
+	{
+		boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+		const Timeline_Segment& previous_segment = segment_of(frame - 1);
+		const int64_t previous_frame_start_tick = frame_start_tick(frame - 1);
+
+		gap_start_tick = previous_frame_start_tick;
+		gap_end_tick = frame_start_tick(frame + 1);
+
+		for (size_t i = 0; i < timeline.slots.size(); i++)
+		{
+			gap_start_tick = max(gap_start_tick, previous_frame_start_tick + timeline.slots[i].offset_ticks + previous_segment.slot_length_ticks[i]);
+			gap_end_tick = min(gap_end_tick, frame_start_tick(frame) + timeline.slots[i].offset_ticks);
+		}
+	}
+
+	Frame_Scheduler_Stats Frame_Scheduler::get_stats(const int direction)
+	{
+		boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+		return (direction == SOAPY_SDR_TX) ? tx_stats : rx_stats;
+	}
+
+	Frame_Scheduler_Stats Frame_Scheduler::get_slot_stats(const size_t slot)
+	{
+		boost::lock_guard<boost::mutex> guard(scheduler_mutex);
+
+		return slot_stats.at(slot);
+	}
+
+	bool Frame_Scheduler::has_worker(const int direction)
+	{
+		return (direction == SOAPY_SDR_TX) ? tx_thread.joinable() : rx_thread.joinable();
+	}
+
+	boost::thread::native_handle_type Frame_Scheduler::get_native_handle(const int direction)
+	{
+		return (direction == SOAPY_SDR_TX) ? tx_thread.native_handle() : rx_thread.native_handle();
+	}
+
+	void Frame_Scheduler::print_direction_stats(const char* name, const Frame_Scheduler_Stats& s)
+	{
+		int64_t avg_lead_time = (s.no_of_dispatched_slots > 0) ? s.sum_lead_time / (int64_t)s.no_of_dispatched_slots : 0;
+
+		msg(string(name) + ": dispatched=" + to_string(s.no_of_dispatched_slots) + ", skipped=" + to_string(s.no_of_skipped_slots) + ", failed=" + to_string(s.no_of_failed_slots) + ", lead_time min/avg/max=" + to_string(s.min_lead_time) + "/" + to_string(avg_lead_time) + "/" + to_string(s.max_lead_time) + " [ns]");
+	}
+
+	void Frame_Scheduler::print_stats()
+	{
+		for (int direction : {SOAPY_SDR_TX, SOAPY_SDR_RX})
+		{
+			const vector<size_t>& slots = (direction == SOAPY_SDR_TX) ? tx_slots : rx_slots;
+			string prefix = (direction == SOAPY_SDR_TX) ? "sdr: [TX]  " : "sdr: [RX]  ";
+
+			Frame_Scheduler_Stats s = get_stats(direction);
+
+			if (s.no_of_dispatched_slots + s.no_of_skipped_slots == 0)
+				continue;
+
+			print_direction_stats((prefix + "slots").c_str(), s);
+
+			string histogram = "<0: " + to_string(s.lead_time_histogram[0]);
+
+			for (size_t i = 1; i < NO_OF_LEAD_TIME_BUCKETS; i++)
+				histogram += ", " + to_string(LEAD_TIME_BUCKET_EDGES[i - 1] / 1000) + "+: " + to_string(s.lead_time_histogram[i]);
+
+			msg(prefix + "lead_time histogram [us]: " + histogram);
+
+			//breakdown per slot shows which part of the frame the device cannot keep up with
+			if (slots.size() > 1)
+			{
+				for (size_t slot : slots)
+					print_direction_stats((prefix + "slot " + to_string(slot)).c_str(), get_slot_stats(slot));
+			}
+		}
+	}
+}
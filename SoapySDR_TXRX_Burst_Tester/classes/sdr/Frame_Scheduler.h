@@ -0,0 +1,185 @@
+#ifndef __FRAME_SCHEDULER_H__
+#define __FRAME_SCHEDULER_H__
+
+#include <complex>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+
+#include "SDR_Device_Wrapper.h"
+
+namespace sdr
+{
+	//single TX or RX slot of a TDD frame, in ticks of the master clock relative to the frame start
+	struct TDD_Slot
+	{
+		int direction = SOAPY_SDR_TX;
+		int64_t offset_ticks = 0;
+		int64_t length_ticks = 0;
+	};
+
+	//parses slot description in a form of DIRECTION:OFFSET:LENGTH, e.g. TX:0:100e-6 (offset and length in [s])
+	TDD_Slot parse_tdd_slot(const std::string& description, const double f_clk);
+
+	//single TDD timeline shared by TX and RX
+	//
+	//	frame n starts at first_frame_tick + n * frame_ticks
+	//	every frame executes all slots, TX ones from frame first_tx_frame, RX ones from frame first_rx_frame
+	struct TDD_Timeline
+	{
+		int64_t first_frame_tick = 0;
+		int64_t frame_ticks = 0;
+		std::vector<TDD_Slot> slots;
+		uint64_t first_tx_frame = 0;
+		uint64_t first_rx_frame = 0;
+
+		//bursts are handed to the device lead_time ahead of their slot, slots closer than min_lead_time are skipped
+		double lead_time = 20e-3;
+		double min_lead_time = 1e-3;
+	};
+
+	//change of the timeline taking effect at the start of given frame (which starts where it would have started
+	//anyway) - frames from it on are frame_ticks long and slots get lengths given by slot_length_ticks, zeros
+	//(or empty vector) keep what has been in effect before
+	struct TDD_Timeline_Change
+	{
+		uint64_t frame = 0;
+		int64_t frame_ticks = 0;
+		std::vector<int64_t> slot_length_ticks;
+	};
+
+	//slot handed over to TX or RX work
+	struct Frame_Slot
+	{
+		uint64_t frame = 0;
+		size_t slot = 0;
+		int64_t tick = 0;
+		long long time_ns = 0;
+		long long lead_time_ns = 0;
+		int no_of_samples = 0;
+	};
+
+	//work done for a slot, returns false when the burst failed
+	typedef boost::function<bool (const Frame_Slot&)> slot_handler_t;
+
+	//number of lead time histogram buckets - first one counts negative lead times, the last one everything above 100 [ms]
+	const size_t NO_OF_LEAD_TIME_BUCKETS = 12;
+
+	//upper edges of lead time histogram buckets in [ns], shared by the printed histogram and the exported metrics
+	const int64_t LEAD_TIME_BUCKET_EDGES[NO_OF_LEAD_TIME_BUCKETS - 1] =
+	{
+		0, 100000, 200000, 500000, 1000000, 2000000, 5000000, 10000000, 20000000, 50000000, 100000000
+	};
+
+	//statistics gathered by Frame_Scheduler for a single direction or a single slot
+	struct Frame_Scheduler_Stats
+	{
+		uint64_t no_of_dispatched_slots = 0;
+		uint64_t no_of_skipped_slots = 0;
+		uint64_t no_of_failed_slots = 0;
+		int64_t min_lead_time = 0;
+		int64_t max_lead_time = 0;
+		int64_t sum_lead_time = 0;
+		uint64_t lead_time_histogram[NO_OF_LEAD_TIME_BUCKETS] = {};
+	};
+
+	//owns the TDD timeline and dispatches TX and RX work from separate threads, so that every burst is handed
+	//to the device lead_time before its slot starts, slots that cannot make it any more are skipped and counted
+	class Frame_Scheduler
+	{
+	private:
+		SDR_Device_Wrapper::sptr_t sdr_device_wrapper;
+		TDD_Timeline timeline;
+
+		//part of the timeline from given frame on, the initial one plus one per change (guarded by scheduler_mutex)
+		struct Timeline_Segment
+		{
+			uint64_t first_frame = 0;
+			int64_t first_frame_tick = 0;
+			int64_t frame_ticks = 0;
+			std::vector<int64_t> slot_length_ticks;
+		};
+
+		std::vector<Timeline_Segment> segments;
+
+		//segments before the last scheduled change, so that it can be reverted (guarded by scheduler_mutex)
+		std::vector<Timeline_Segment> reverted_segments;
+		uint64_t last_change_frame = 0;
+		bool change_revertible = false;
+
+		//frame of the next slot of every worker, changes can only be scheduled after them (guarded by scheduler_mutex)
+		uint64_t tx_next_frame = 0;
+		uint64_t rx_next_frame = 0;
+
+		//offset between hardware clock and host monotonic clock, refreshed on every dispatch (guarded by scheduler_mutex)
+		int64_t hw_to_host_offset = 0;
+
+		//indices of TX and RX slots ordered by their offset within the frame
+		std::vector<size_t> tx_slots;
+		std::vector<size_t> rx_slots;
+
+		Frame_Scheduler_Stats tx_stats;
+		Frame_Scheduler_Stats rx_stats;
+		std::vector<Frame_Scheduler_Stats> slot_stats;
+		boost::mutex scheduler_mutex;
+
+		//metric series of the device, if it has any when the scheduler is created
+		SDR_Metrics::sptr_t metrics;
+
+		bool running = false;
+
+		boost::thread tx_thread;
+		boost::thread rx_thread;
+
+		void worker_function(const int direction, slot_handler_t handler);
+		bool wait_for_slot(const int direction, uint64_t& frame, size_t& position, Frame_Slot& slot);
+		const Timeline_Segment& segment_of(const uint64_t frame) const;
+		int64_t frame_start_tick(const uint64_t frame) const;
+		uint64_t earliest_change_frame() const;
+		void validate_change(const TDD_Timeline_Change& change) const;
+		bool sleep_until(const int64_t host_time);
+		long long read_hardware_time();
+		void update_stats(Frame_Scheduler_Stats& stats, const long long lead_time);
+		void print_direction_stats(const char* name, const Frame_Scheduler_Stats& s);
+
+	public:
+		typedef boost::shared_ptr<Frame_Scheduler> sptr_t;
+
+		Frame_Scheduler(SDR_Device_Wrapper::sptr_t sdr_device_wrapper, const TDD_Timeline& timeline);
+		~Frame_Scheduler();
+
+		//empty handler means that given direction is not scheduled at all
+		void start(slot_handler_t tx_handler, slot_handler_t rx_handler);
+		void stop();
+
+		//first frame a timeline change can still be scheduled for, workers may already be preparing the ones before it
+		uint64_t get_earliest_change_frame();
+
+		//throws std::invalid_argument when the frame is earlier than get_earliest_change_frame() or than a change
+		//scheduled before (a change of the same frame is merged into it)
+		void schedule_change(const TDD_Timeline_Change& change);
+		//throws what schedule_change would throw for given change, without scheduling it
+		void check_change(const TDD_Timeline_Change& change);
+		//takes back the change scheduled last, returns false when there is none or its frame is being dispatched already
+		bool revert_change();
+
+		int64_t get_frame_start_tick(const uint64_t frame);
+
+		//end of the last slot of the frame before given one and start of its first slot in ticks, which is where
+		//device settings can change without cutting through a burst (gap_start_tick > gap_end_tick - no gap)
+		void get_frame_gap(const uint64_t frame, int64_t& gap_start_tick, int64_t& gap_end_tick);
+
+		Frame_Scheduler_Stats get_stats(const int direction);
+		Frame_Scheduler_Stats get_slot_stats(const size_t slot);
+
+		//whether a worker thread of given direction has been started, i.e. whether its handle is valid
+		bool has_worker(const int direction);
+		boost::thread::native_handle_type get_native_handle(const int direction);
+		void print_stats();
+	};
+}
+
+#endif
@@ -0,0 +1,524 @@
+#include "Live_Reconfigurator.h"
+
+#include <stdio.h>
+#include <ctype.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include <SoapySDR/Time.hpp>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	static double parse_value(const string& key, const string& value)
+	{
+		size_t end = 0;
+		double number = 0;
+
+		try
+		{
+			number = stod(value, &end);
+		}
+		catch (const std::exception& e)
+		{
+			end = 0;
+		}
+
+		if ((end == 0) || (end != value.size()))
+			throw std::invalid_argument(key + " has invalid value '" + value + "'");
+
+		return number;
+	}
+
+	static string join(const vector<string>& items)
+	{
+		string text;
+
+		for (const string& item : items)
+			text += (text.empty() ? "" : ", ") + item;
+
+		return text;
+	}
+
+	template <typename T>
+	static string list_to_str(const vector<T>& values)
+	{
+		string text;
+
+		for (const T& value : values)
+		{
+			char item[32];
+			snprintf(item, sizeof(item), "%g", (double)value);
+			text += (text.empty() ? "" : ",") + string(item);
+		}
+
+		return text;
+	}
+
+	Live_Reconfigurator::Live_Reconfigurator(boost::asio::io_context& io_context, SDR_Device_Group::sptr_t device_group, const std::vector<Frame_Scheduler::sptr_t>& frame_schedulers, const TDD_Timeline& timeline, const int64_t max_no_of_tx_samples, const int64_t max_no_of_rx_samples)
+	:
+		io_context(io_context),
+		device_group(device_group),
+		frame_schedulers(frame_schedulers),
+		slots(timeline.slots),
+		max_no_of_tx_samples(max_no_of_tx_samples),
+		max_no_of_rx_samples(max_no_of_rx_samples)
+	{
+		for (size_t d = 0; d < device_group->size(); d++)
+			live_cfgs.push_back(*device_group->get(d)->get_device_config());
+
+		live_timeline.frame_ticks = timeline.frame_ticks;
+
+		for (const TDD_Slot& slot : timeline.slots)
+			live_timeline.slot_length_ticks.push_back(slot.length_ticks);
+	}
+
+	void Live_Reconfigurator::set_burst_correlator(Burst_Correlator::sptr_t burst_correlator)
+	{
+		this->burst_correlator = burst_correlator;
+	}
+
+	std::string Live_Reconfigurator::execute(const std::string& line)
+	{
+		int64_t receive_time = monotonic_time_ns();
+
+		stats.no_of_commands++;
+
+		try
+		{
+			return apply_command(line, receive_time);
+		}
+		catch (const std::exception& e)
+		{
+			stats.no_of_rejected_commands++;
+
+			msg("sdr: live reconfiguration: '" + line + "' rejected: " + string(e.what()), WARNING);
+
+			return "ERROR " + string(e.what());
+		}
+	}
+
+	std::string Live_Reconfigurator::apply_command(const std::string& line, const int64_t receive_time)
+	{
+		vector<string> tokens;
+
+		for (const string& token : explode(line, ' '))
+			if (!token.empty())
+				tokens.push_back(token);
+
+		if ((tokens.size() == 1) && (tokens[0] == "status"))
+			return status();
+
+		if (tokens.empty())
+			throw std::invalid_argument("empty command");
+
+		const SDR_Device_Config& reference_cfg = live_cfgs[0];
+
+		vector<SDR_Device_Config> cfgs = live_cfgs;
+		TDD_Timeline_Change timeline_change = live_timeline;
+		bool timeline_changed = false;
+		vector<string> timeline_descriptions;
+		uint64_t frame = 0;
+		bool frame_given = false;
+
+		for (const string& token : tokens)
+		{
+			size_t separator = token.find('=');
+
+			if ((separator == string::npos) || (separator == 0))
+				throw std::invalid_argument("'" + token + "' is not in a form of key=value");
+
+			string key = token.substr(0, separator);
+			string value = token.substr(separator + 1);
+
+			if (key == "frame")
+			{
+				double number = parse_value(key, value);
+
+				if ((number < 1) || (number != (uint64_t)number))
+					throw std::invalid_argument("frame has to be a positive integer");
+
+				frame = number;
+				frame_given = true;
+			}
+			else if (key == "burst_period")
+			{
+				int64_t frame_ticks = SoapySDR::timeNsToTicks(parse_value(key, value) * 1e9, reference_cfg.f_clk);
+
+				if (frame_ticks <= 0)
+					throw std::invalid_argument("burst_period has to be positive");
+
+				timeline_change.frame_ticks = frame_ticks;
+				timeline_changed = true;
+				timeline_descriptions.push_back(token);
+			}
+			else if ((key == "tx_burst_length") || (key == "rx_burst_length"))
+			{
+				const int direction = (key == "tx_burst_length") ? SOAPY_SDR_TX : SOAPY_SDR_RX;
+				const uint16_t D = (direction == SOAPY_SDR_TX) ? reference_cfg.D_tx : reference_cfg.D_rx;
+				const int64_t max_no_of_samples = (direction == SOAPY_SDR_TX) ? max_no_of_tx_samples : max_no_of_rx_samples;
+
+				//rounded down to whole samples as at startup
+				int64_t no_of_samples = parse_value(key, value) * reference_cfg.f_clk / D;
+
+				if ((no_of_samples <= 0) || (no_of_samples > max_no_of_samples))
+					throw std::invalid_argument(key + " has to be between one sample and " + to_string(max_no_of_samples) + " samples buffers have been allocated for");
+
+				for (size_t i = 0; i < slots.size(); i++)
+					if (slots[i].direction == direction)
+						timeline_change.slot_length_ticks[i] = no_of_samples * D;
+
+				timeline_changed = true;
+				timeline_descriptions.push_back(token);
+			}
+			else
+			{
+				//device settings apply to all devices unless prefixed by device number
+				size_t first_device = 0;
+				size_t last_device = cfgs.size() - 1;
+				size_t dot = key.find('.');
+
+				if (dot != string::npos)
+				{
+					string device = key.substr(0, dot);
+
+					if (device.empty() || !all_of(device.begin(), device.end(), ::isdigit) || (stoul(device) >= cfgs.size()))
+						throw std::invalid_argument("'" + key + "' does not name one of " + to_string(cfgs.size()) + " devices");
+
+					first_device = last_device = stoul(device);
+					key = key.substr(dot + 1);
+				}
+
+				if ((key != "tx_gain") && (key != "rx_gain") && (key != "center_frequency"))
+					throw std::invalid_argument(key + " cannot be changed while streaming");
+
+				for (size_t d = first_device; d <= last_device; d++)
+					set_device_option(cfgs[d], key, value);
+			}
+		}
+
+		uint64_t earliest_frame = 0;
+
+		for (Frame_Scheduler::sptr_t frame_scheduler : frame_schedulers)
+			earliest_frame = max(earliest_frame, frame_scheduler->get_earliest_change_frame());
+
+		if (!frame_given)
+			frame = earliest_frame;
+		else if (frame < earliest_frame)
+			throw std::invalid_argument("frame " + to_string(frame) + " is being dispatched already, the earliest frame that can be changed is " + to_string(earliest_frame));
+
+		vector<vector<Device_Call>> device_calls(cfgs.size());
+		size_t no_of_device_calls = 0;
+
+		for (size_t d = 0; d < cfgs.size(); d++)
+		{
+			device_calls[d] = diff_settings(live_cfgs[d], cfgs[d]);
+			no_of_device_calls += device_calls[d].size();
+		}
+
+		if (!timeline_changed && (no_of_device_calls == 0))
+			return "OK nothing to change";
+
+		if (timeline_changed)
+		{
+			timeline_change.frame = frame;
+
+			//every scheduler has to accept the change before any of them takes it, so the devices keep a shared timeline
+			for (Frame_Scheduler::sptr_t frame_scheduler : frame_schedulers)
+				frame_scheduler->check_change(timeline_change);
+
+			size_t no_of_changed_schedulers = 0;
+
+			try
+			{
+				for (Frame_Scheduler::sptr_t frame_scheduler : frame_schedulers)
+				{
+					frame_scheduler->schedule_change(timeline_change);
+					no_of_changed_schedulers++;
+				}
+			}
+			catch (...)
+			{
+				revert_timeline_change(no_of_changed_schedulers);
+				throw;
+			}
+		}
+
+		//settings of a device are taken as live once its calls have been issued or scheduled, a failing device takes
+		//the timeline change of the command back (devices before it keep their new settings)
+		for (size_t d = 0; d < cfgs.size(); d++)
+		{
+			if (!device_calls[d].empty())
+			{
+				try
+				{
+					schedule_device_change(d, frame, device_calls[d], receive_time);
+				}
+				catch (...)
+				{
+					if (timeline_changed)
+						revert_timeline_change(frame_schedulers.size());
+					throw;
+				}
+			}
+
+			live_cfgs[d] = cfgs[d];
+		}
+
+		if (timeline_changed)
+		{
+			live_timeline = timeline_change;
+
+			if (burst_correlator)
+				burst_correlator->stop_at_frame(frame);
+
+			//the timeline changes right at the frame start
+			long long frame_start_time = SoapySDR::ticksToTimeNs(frame_schedulers[0]->get_frame_start_tick(frame), reference_cfg.f_clk);
+			int64_t latency = hw_time_to_host_time(0, frame_start_time) - receive_time;
+
+			record_change(latency, 0);
+
+			msgf(INFO, "sdr: live reconfiguration: timeline %s from frame %llu, latency=%.3f [ms]", join(timeline_descriptions).c_str(), (unsigned long long)frame, latency / 1e6);
+		}
+
+		return "OK frame=" + to_string(frame);
+	}
+
+	void Live_Reconfigurator::revert_timeline_change(const size_t no_of_changed_schedulers)
+	{
+		for (size_t i = 0; i < no_of_changed_schedulers; i++)
+			if (!frame_schedulers[i]->revert_change())
+				msgf(ERROR, "sdr: live reconfiguration: timeline change of device %zu could not be taken back, devices may not share a timeline any more", i);
+	}
+
+	std::vector<Live_Reconfigurator::Device_Call> Live_Reconfigurator::diff_settings(const SDR_Device_Config& from, const SDR_Device_Config& to)
+	{
+		vector<Device_Call> calls;
+
+		for (int direction : {SOAPY_SDR_TX, SOAPY_SDR_RX})
+		{
+			const bool active = (direction == SOAPY_SDR_TX) ? to.tx_active : to.rx_active;
+			const vector<size_t>& channels = (direction == SOAPY_SDR_TX) ? to.channels_tx : to.channels_rx;
+			const vector<double>& from_gains = (direction == SOAPY_SDR_TX) ? from.G_tx : from.G_rx;
+			const vector<double>& to_gains = (direction == SOAPY_SDR_TX) ? to.G_tx : to.G_rx;
+			const double from_frequency = (direction == SOAPY_SDR_TX) ? from.f_c_tx : from.f_c_rx;
+			const double to_frequency = (direction == SOAPY_SDR_TX) ? to.f_c_tx : to.f_c_rx;
+			const string name = (direction == SOAPY_SDR_TX) ? "tx" : "rx";
+
+			if (!active)
+				continue;
+
+			for (size_t c = 0; c < channels.size(); c++)
+			{
+				const size_t channel = channels[c];
+				const double gain = per_channel(to_gains, c);
+				const double frequency = to_frequency;
+
+				if (gain != per_channel(from_gains, c))
+				{
+					Device_Call gain_call;
+					gain_call.description = name + to_string(channel) + ".gain=" + list_to_str(vector<double>(1, gain));
+					gain_call.call = [direction, channel, gain](SoapySDR::Device* device) { device->setGain(direction, channel, gain); };
+					calls.push_back(gain_call);
+				}
+
+				if (frequency != from_frequency)
+				{
+					Device_Call frequency_call;
+					frequency_call.description = name + to_string(channel) + ".frequency=" + list_to_str(vector<double>(1, frequency));
+					frequency_call.call = [direction, channel, frequency](SoapySDR::Device* device) { device->setFrequency(direction, channel, frequency); };
+					calls.push_back(frequency_call);
+				}
+			}
+		}
+
+		return calls;
+	}
+
+	int64_t Live_Reconfigurator::hw_time_to_host_time(const size_t device, const long long hw_time)
+	{
+		int64_t host_time_before = monotonic_time_ns();
+		long long now = device_group->get(device)->get_hardware_time();
+		int64_t host_time_after = monotonic_time_ns();
+
+		return (host_time_before + host_time_after) / 2 + (hw_time - now);
+	}
+
+	void Live_Reconfigurator::schedule_device_change(const size_t device, const uint64_t frame, const std::vector<Device_Call>& calls, const int64_t receive_time)
+	{
+		SDR_Device_Wrapper::sptr_t sdr_device_wrapper = device_group->get(device);
+		const SDR_Device_Config& device_cfg = live_cfgs[device];
+
+		int64_t gap_start_tick;
+		int64_t gap_end_tick;
+
+		frame_schedulers[device]->get_frame_gap(frame, gap_start_tick, gap_end_tick);
+
+		long long gap_start_time = SoapySDR::ticksToTimeNs(gap_start_tick, device_cfg.f_clk);
+		long long gap_end_time = SoapySDR::ticksToTimeNs(gap_end_tick, device_cfg.f_clk);
+
+		if (gap_start_tick >= gap_end_tick)
+		{
+			msgf(WARNING, "sdr: live reconfiguration: frame %llu has no gap between bursts, device %zu changes at its first burst", (unsigned long long)frame, device);
+			gap_start_time = gap_end_time;
+		}
+
+		vector<string> descriptions;
+
+		for (const Device_Call& call : calls)
+			descriptions.push_back(call.description);
+
+		string description = join(descriptions);
+
+		if (device_cfg.command_time)
+		{
+			//the device applies the calls itself in the middle of the gap
+			SoapySDR::Device* device_handle = sdr_device_wrapper->get_device();
+			long long command_time = (gap_start_time + gap_end_time) / 2;
+
+			int64_t issue_start_time = monotonic_time_ns();
+
+			device_handle->setCommandTime(command_time);
+
+			try
+			{
+				for (const Device_Call& call : calls)
+					call.call(device_handle);
+			}
+			catch (...)
+			{
+				//following control calls must not stay timed
+				device_handle->setCommandTime(0);
+				throw;
+			}
+
+			device_handle->setCommandTime(0);
+
+			int64_t issue_time = monotonic_time_ns() - issue_start_time;
+			int64_t latency = hw_time_to_host_time(device, command_time) - receive_time;
+
+			//calls issued after their time are applied by the device right away, i.e. possibly in the middle of a burst
+			if (latency < issue_time)
+				stats.no_of_missed_gaps++;
+
+			stats.no_of_timed_changes++;
+			record_change(latency, issue_time);
+
+			msgf(INFO, "sdr: live reconfiguration: device %zu %s at frame %llu (command time), latency=%.3f [ms], issue_time=%.1f [us]", device, description.c_str(), (unsigned long long)frame, latency / 1e6, issue_time / 1e3);
+
+			return;
+		}
+
+		//the host calls the device when the gap starts, the timer runs on the io_context of the control socket
+		boost::shared_ptr<boost::asio::steady_timer> timer(new boost::asio::steady_timer(io_context));
+
+		timer->expires_after(boost::asio::chrono::nanoseconds(max(hw_time_to_host_time(device, gap_start_time) - monotonic_time_ns(), (int64_t)0)));
+
+		timer->async_wait
+		(
+			[this, timer, sdr_device_wrapper, device, frame, calls, description, gap_start_time, gap_end_time, receive_time](const boost::system::error_code& error_code)
+			{
+				if (error_code)
+					return;
+
+				SoapySDR::Device* device_handle = sdr_device_wrapper->get_device();
+
+				int64_t issue_start_time = monotonic_time_ns();
+				long long hw_time_before = sdr_device_wrapper->get_hardware_time();
+
+				try
+				{
+					for (const Device_Call& call : calls)
+						call.call(device_handle);
+				}
+				catch (const std::exception& e)
+				{
+					msgf(WARNING, "sdr: live reconfiguration: device %zu %s at frame %llu failed: %s", device, description.c_str(), (unsigned long long)frame, e.what());
+					return;
+				}
+
+				long long hw_time_after = sdr_device_wrapper->get_hardware_time();
+				int64_t issue_end_time = monotonic_time_ns();
+
+				bool in_gap = (hw_time_before >= gap_start_time) && (hw_time_after <= gap_end_time);
+
+				if (!in_gap)
+					stats.no_of_missed_gaps++;
+
+				stats.no_of_host_timed_changes++;
+				record_change(issue_end_time - receive_time, issue_end_time - issue_start_time);
+
+				msgf
+				(
+					in_gap ? INFO : WARNING,
+					"sdr: live reconfiguration: device %zu %s at frame %llu (host timed, %lld [us] into the gap of %lld [us]), latency=%.3f [ms], issue_time=%.1f [us]",
+					device,
+					description.c_str(),
+					(unsigned long long)frame,
+					(hw_time_before - gap_start_time) / 1000,
+					(gap_end_time - gap_start_time) / 1000,
+					(issue_end_time - receive_time) / 1e6,
+					(issue_end_time - issue_start_time) / 1e3
+				);
+			}
+		);
+	}
+
+	void Live_Reconfigurator::record_change(const int64_t latency, const int64_t issue_time)
+	{
+		stats.no_of_changes++;
+
+		if ((stats.no_of_changes == 1) || (latency < stats.min_latency))
+			stats.min_latency = latency;
+		if ((stats.no_of_changes == 1) || (latency > stats.max_latency))
+			stats.max_latency = latency;
+
+		stats.sum_latency += latency;
+		stats.max_issue_time = max(stats.max_issue_time, issue_time);
+		stats.sum_issue_time += issue_time;
+	}
+
+	std::string Live_Reconfigurator::status()
+	{
+		const SDR_Device_Config& reference_cfg = live_cfgs[0];
+
+		uint64_t earliest_frame = 0;
+
+		for (Frame_Scheduler::sptr_t frame_scheduler : frame_schedulers)
+			earliest_frame = max(earliest_frame, frame_scheduler->get_earliest_change_frame());
+
+		string text = "OK earliest_frame=" + to_string(earliest_frame) + " burst_period=" + list_to_str(vector<double>(1, SoapySDR::ticksToTimeNs(live_timeline.frame_ticks, reference_cfg.f_clk) / 1e9));
+
+		vector<double> tx_lengths;
+		vector<double> rx_lengths;
+
+		for (size_t i = 0; i < slots.size(); i++)
+			((slots[i].direction == SOAPY_SDR_TX) ? tx_lengths : rx_lengths).push_back(SoapySDR::ticksToTimeNs(live_timeline.slot_length_ticks[i], reference_cfg.f_clk) / 1e9);
+
+		text += " tx_burst_length=" + list_to_str(tx_lengths) + " rx_burst_length=" + list_to_str(rx_lengths);
+
+		for (size_t d = 0; d < live_cfgs.size(); d++)
+			text += " " + to_string(d) + ".tx_gain=" + list_to_str(live_cfgs[d].G_tx) + " " + to_string(d) + ".rx_gain=" + list_to_str(live_cfgs[d].G_rx) + " " + to_string(d) + ".center_frequency=" + list_to_str(vector<double>(1, live_cfgs[d].f_c_tx));
+
+		return text;
+	}
+
+	Live_Reconfig_Stats Live_Reconfigurator::get_stats() const
+	{
+		return stats;
+	}
+
+	void Live_Reconfigurator::print_stats()
+	{
+		const Live_Reconfig_Stats& s = stats;
+
+		int64_t avg_latency = (s.no_of_changes > 0) ? s.sum_latency / (int64_t)s.no_of_changes : 0;
+		int64_t avg_issue_time = (s.no_of_timed_changes + s.no_of_host_timed_changes > 0) ? s.sum_issue_time / (int64_t)(s.no_of_timed_changes + s.no_of_host_timed_changes) : 0;
+
+		msg("sdr: live reconfiguration: commands=" + to_string(s.no_of_commands) + ", rejected=" + to_string(s.no_of_rejected_commands) + ", changes=" + to_string(s.no_of_changes) + " (command timed=" + to_string(s.no_of_timed_changes) + ", host timed=" + to_string(s.no_of_host_timed_changes) + ", missed gaps=" + to_string(s.no_of_missed_gaps) + "), latency min/avg/max=" + to_string(s.min_latency / 1000) + "/" + to_string(avg_latency / 1000) + "/" + to_string(s.max_latency / 1000) + " [us], issue_time avg/max=" + to_string(avg_issue_time / 1000) + "/" + to_string(s.max_issue_time / 1000) + " [us]");
+	}
+}
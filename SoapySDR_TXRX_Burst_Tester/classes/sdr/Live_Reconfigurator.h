@@ -0,0 +1,103 @@
+#ifndef __LIVE_RECONFIGURATOR_H__
+#define __LIVE_RECONFIGURATOR_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/asio.hpp>
+
+#include "SDR_Config.h"
+#include "SDR_Device_Group.h"
+#include "Frame_Scheduler.h"
+#include "Burst_Correlator.h"
+
+namespace sdr
+{
+	//statistics of live reconfiguration, every device change and every timeline change counts as a single change
+	//
+	//	latency		- from receiving a command until its change takes effect on the device or timeline
+	//	issue_time	- how long control calls of a device change took
+	struct Live_Reconfig_Stats
+	{
+		uint64_t no_of_commands = 0;
+		uint64_t no_of_rejected_commands = 0;
+		uint64_t no_of_changes = 0;
+		uint64_t no_of_timed_changes = 0;
+		uint64_t no_of_host_timed_changes = 0;
+		uint64_t no_of_missed_gaps = 0;
+		int64_t min_latency = 0;
+		int64_t max_latency = 0;
+		int64_t sum_latency = 0;
+		int64_t max_issue_time = 0;
+		int64_t sum_issue_time = 0;
+	};
+
+	//applies changes of gains, center frequency and burst timing while streaming goes on - every command takes
+	//effect at the start of a frame (the earliest one that can still be changed unless given), the timeline of
+	//all frame schedulers changes at the frame start, device settings in the gap between the last burst of the
+	//frame before and the first burst of the frame, either at a hardware time given by setCommandTime (devices
+	//with SDR_Device_Config::command_time) or called by the host when the gap comes (io_context timer)
+	//
+	//commands are single lines of space separated key=value pairs, e.g. "tx_gain=40,45 center_frequency=2.4e9",
+	//
+	//	tx_gain, rx_gain, center_frequency			- as in [SDR], prefixed by N. for a single device (e.g. 1.rx_gain=30)
+	//	burst_period, tx_burst_length, rx_burst_length	- as in [SIGNAL], burst lengths of all slots of the direction
+	//	frame										- frame the changes take effect at
+	//
+	//or "status" - meant to be called only from the thread running the io_context
+	class Live_Reconfigurator
+	{
+	private:
+		//single control call of a device change
+		struct Device_Call
+		{
+			std::string description;
+			boost::function<void (SoapySDR::Device*)> call;
+		};
+
+		boost::asio::io_context& io_context;
+		SDR_Device_Group::sptr_t device_group;
+		std::vector<Frame_Scheduler::sptr_t> frame_schedulers;
+		Burst_Correlator::sptr_t burst_correlator;
+
+		//settings in effect after all commands accepted so far
+		std::vector<SDR_Device_Config> live_cfgs;
+		std::vector<TDD_Slot> slots;
+		TDD_Timeline_Change live_timeline;
+
+		//bursts cannot get longer than buffers allocated at startup
+		int64_t max_no_of_tx_samples = 0;
+		int64_t max_no_of_rx_samples = 0;
+
+		Live_Reconfig_Stats stats;
+
+		std::string apply_command(const std::string& line, const int64_t receive_time);
+		std::string status();
+		std::vector<Device_Call> diff_settings(const SDR_Device_Config& from, const SDR_Device_Config& to);
+		void schedule_device_change(const size_t device, const uint64_t frame, const std::vector<Device_Call>& calls, const int64_t receive_time);
+		//takes the timeline change of a failed command back from the first no_of_changed_schedulers schedulers
+		void revert_timeline_change(const size_t no_of_changed_schedulers);
+		int64_t hw_time_to_host_time(const size_t device, const long long hw_time);
+		void record_change(const int64_t latency, const int64_t issue_time);
+
+	public:
+		typedef boost::shared_ptr<Live_Reconfigurator> sptr_t;
+
+		//frame schedulers are given per device of the group, all of them share the timeline
+		Live_Reconfigurator(boost::asio::io_context& io_context, SDR_Device_Group::sptr_t device_group, const std::vector<Frame_Scheduler::sptr_t>& frame_schedulers, const TDD_Timeline& timeline, const int64_t max_no_of_tx_samples, const int64_t max_no_of_rx_samples);
+
+		//returns reply to the command - OK with the frame it takes effect at or ERROR with the reason
+		std::string execute(const std::string& line);
+
+		//correlation stops at the first frame of a changed timeline, its references are built for the startup one
+		void set_burst_correlator(Burst_Correlator::sptr_t burst_correlator);
+
+		Live_Reconfig_Stats get_stats() const;
+		void print_stats();
+	};
+}
+
+#endif
@@ -0,0 +1,316 @@
+#include "RX_Burst_Stats.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	//number of independent accumulators, so the reduction is vectorised without reassociating float sums
+	static const size_t NO_OF_LANES = 8;
+
+	//samples are reduced in float blocks which are then summed up in double precision, so long bursts
+	//do not lose precision
+	static const size_t BLOCK_SIZE = 4096;
+
+	//raw moments of a block of samples
+	struct Block_Moments
+	{
+		float sum_i[NO_OF_LANES];
+		float sum_q[NO_OF_LANES];
+		float sum_ii[NO_OF_LANES];
+		float sum_qq[NO_OF_LANES];
+		float sum_iq[NO_OF_LANES];
+		//powers are non-negative, so their bit patterns compare the same way as integers do
+		int32_t peak[NO_OF_LANES];
+	};
+
+	//no_of_samples has to be a multiple of NO_OF_LANES, accumulators are kept local, so they stay in registers
+	VECTORISED_KERNEL static void reduce_block(const float* x, const size_t no_of_samples, Block_Moments& m)
+	{
+		float sum_i[NO_OF_LANES] = {};
+		float sum_q[NO_OF_LANES] = {};
+		float sum_ii[NO_OF_LANES] = {};
+		float sum_qq[NO_OF_LANES] = {};
+		float sum_iq[NO_OF_LANES] = {};
+		int32_t peak[NO_OF_LANES] = {};
+
+		for (size_t i = 0; i < no_of_samples; i += NO_OF_LANES)
+		{
+			for (size_t j = 0; j < NO_OF_LANES; j++)
+			{
+				float re = x[2 * (i + j)];
+				float im = x[2 * (i + j) + 1];
+				float power = re * re + im * im;
+				int32_t power_bits;
+
+				memcpy(&power_bits, &power, sizeof(power_bits));
+
+				sum_i[j] += re;
+				sum_q[j] += im;
+				sum_ii[j] += re * re;
+				sum_qq[j] += im * im;
+				sum_iq[j] += re * im;
+				peak[j] = (power_bits > peak[j]) ? power_bits : peak[j];
+			}
+		}
+
+		memcpy(m.sum_i, sum_i, sizeof(sum_i));
+		memcpy(m.sum_q, sum_q, sizeof(sum_q));
+		memcpy(m.sum_ii, sum_ii, sizeof(sum_ii));
+		memcpy(m.sum_qq, sum_qq, sizeof(sum_qq));
+		memcpy(m.sum_iq, sum_iq, sizeof(sum_iq));
+		memcpy(m.peak, peak, sizeof(peak));
+	}
+
+	static double to_db(const double power)
+	{
+		return 10 * log10(max(power, 1e-20));
+	}
+
+	void compute_rx_burst_metrics(const std::complex<float>* samples, const size_t no_of_samples, RX_Burst_Metrics& metrics)
+	{
+		double sum_i = 0;
+		double sum_q = 0;
+		double sum_ii = 0;
+		double sum_qq = 0;
+		double sum_iq = 0;
+		float peak = 0;
+
+		const float* x = reinterpret_cast<const float*>(samples);
+		size_t i = 0;
+
+		while (i + NO_OF_LANES <= no_of_samples)
+		{
+			size_t n = min(BLOCK_SIZE, (no_of_samples - i) / NO_OF_LANES * NO_OF_LANES);
+
+			Block_Moments m;
+
+			reduce_block(x + 2 * i, n, m);
+
+			for (size_t j = 0; j < NO_OF_LANES; j++)
+			{
+				float lane_peak;
+
+				memcpy(&lane_peak, &m.peak[j], sizeof(lane_peak));
+
+				sum_i += m.sum_i[j];
+				sum_q += m.sum_q[j];
+				sum_ii += m.sum_ii[j];
+				sum_qq += m.sum_qq[j];
+				sum_iq += m.sum_iq[j];
+				peak = max(peak, lane_peak);
+			}
+
+			i += n;
+		}
+
+		//samples that do not fill all lanes
+		for (; i < no_of_samples; i++)
+		{
+			float re = samples[i].real();
+			float im = samples[i].imag();
+
+			sum_i += re;
+			sum_q += im;
+			sum_ii += re * re;
+			sum_qq += im * im;
+			sum_iq += re * im;
+			peak = max(peak, re * re + im * im);
+		}
+
+		double n = max(no_of_samples, (size_t)1);
+
+		metrics.power = (sum_ii + sum_qq) / n;
+		metrics.peak = peak;
+		metrics.dc = complex<double>(sum_i / n, sum_q / n);
+
+		//I and Q variances and covariance with DC removed
+		double var_i = sum_ii / n - metrics.dc.real() * metrics.dc.real();
+		double var_q = sum_qq / n - metrics.dc.imag() * metrics.dc.imag();
+		double cov_iq = sum_iq / n - metrics.dc.real() * metrics.dc.imag();
+
+		if ((var_i > 0) && (var_q > 0))
+		{
+			metrics.gain_imbalance = 10 * log10(var_i / var_q);
+			metrics.phase_imbalance = asin(max(-1.0, min(1.0, cov_iq / sqrt(var_i * var_q)))) * 180 / M_PI;
+		}
+		else
+		{
+			metrics.gain_imbalance = 0;
+			metrics.phase_imbalance = 0;
+		}
+	}
+
+	RX_Burst_Stats::RX_Burst_Stats(const size_t queue_size, const size_t max_no_of_rx_samples, const size_t window_size, const double report_period)
+	:
+		window(max(window_size, (size_t)1)),
+		report_period_ns(report_period * 1e9),
+		running(false)
+	{
+		Stats_Job prototype;
+		prototype.samples.resize(max_no_of_rx_samples);
+
+		ring.reset(new ring_t(queue_size, prototype));
+
+		next_report_time = monotonic_time_ns() + report_period_ns;
+
+		running = true;
+		worker_thread = boost::thread(&RX_Burst_Stats::worker_thread_function, this);
+
+		msg("sdr: RX burst stats: rolling window of " + to_string(window.size()) + " bursts reported every " + to_string(report_period_ns / 1000000) + " [ms], up to " + to_string(ring->capacity()) + " bursts queued");
+	}
+
+	RX_Burst_Stats::~RX_Burst_Stats()
+	{
+		stop();
+	}
+
+	void RX_Burst_Stats::submit(const Frame_Slot& slot, const std::complex<float>* samples)
+	{
+		Stats_Job* job = ring->claim();
+
+		if (job == nullptr)
+		{
+			counters.no_of_dropped_bursts++;
+			return;
+		}
+
+		job->slot = slot;
+		job->slot.no_of_samples = min((size_t)slot.no_of_samples, job->samples.size());
+		memcpy(&job->samples[0], samples, job->slot.no_of_samples * sizeof(complex<float>));
+
+		ring->publish();
+
+		counters.no_of_queued_bursts++;
+	}
+
+	void RX_Burst_Stats::analyse(const Stats_Job& job)
+	{
+		int64_t start_time = monotonic_time_ns();
+
+		RX_Burst_Metrics& metrics = window[window_head];
+
+		metrics.frame = job.slot.frame;
+		metrics.slot = job.slot.slot;
+
+		compute_rx_burst_metrics(&job.samples[0], job.slot.no_of_samples, metrics);
+
+		window_head = (window_head + 1) % window.size();
+		window_count = min(window_count + 1, window.size());
+
+		int64_t analysis_time = monotonic_time_ns() - start_time;
+
+		counters.no_of_analysed_bursts++;
+		counters.max_analysis_time = max(counters.max_analysis_time, analysis_time);
+		counters.sum_analysis_time += analysis_time;
+	}
+
+	void RX_Burst_Stats::report()
+	{
+		if (window_count == 0)
+			return;
+
+		double sum_power = 0;
+		double min_power = window[0].power;
+		double max_power = window[0].power;
+		double max_peak = 0;
+		complex<double> sum_dc;
+		double sum_gain_imbalance = 0;
+		double sum_phase_imbalance = 0;
+
+		for (size_t i = 0; i < window_count; i++)
+		{
+			const RX_Burst_Metrics& m = window[i];
+
+			sum_power += m.power;
+			min_power = min(min_power, m.power);
+			max_power = max(max_power, m.power);
+			max_peak = max(max_peak, m.peak);
+			sum_dc += m.dc;
+			sum_gain_imbalance += m.gain_imbalance;
+			sum_phase_imbalance += m.phase_imbalance;
+		}
+
+		complex<double> dc = sum_dc / (double)window_count;
+
+		msgf
+		(
+			INFO,
+			"sdr: [STATS] last %zu bursts: power avg/min/max=%.1f/%.1f/%.1f [dBFS], peak=%.1f [dBFS], dc=%.1f [dBFS] (I=%+.5f, Q=%+.5f), iq_gain=%+.3f [dB], iq_phase=%+.3f [deg]",
+			window_count,
+			to_db(sum_power / window_count),
+			to_db(min_power),
+			to_db(max_power),
+			to_db(max_peak),
+			to_db(norm(dc)),
+			dc.real(),
+			dc.imag(),
+			sum_gain_imbalance / window_count,
+			sum_phase_imbalance / window_count
+		);
+
+		counters.no_of_reports++;
+	}
+
+	size_t RX_Burst_Stats::drain()
+	{
+		size_t no_of_jobs = 0;
+		Stats_Job* job;
+
+		while ((job = ring->peek()) != nullptr)
+		{
+			analyse(*job);
+			ring->release();
+			no_of_jobs++;
+		}
+
+		return no_of_jobs;
+	}
+
+	void RX_Burst_Stats::worker_thread_function()
+	{
+		while (running)
+		{
+			size_t no_of_jobs = drain();
+
+			if ((report_period_ns > 0) && (monotonic_time_ns() >= next_report_time))
+			{
+				report();
+				next_report_time += report_period_ns;
+			}
+
+			if (no_of_jobs == 0)
+				usleep(1000);
+		}
+
+		//analyse whatever has been left in the ring
+		drain();
+	}
+
+	void RX_Burst_Stats::stop()
+	{
+		if (!running.exchange(false))
+			return;
+
+		if (worker_thread.joinable())
+			worker_thread.join();
+	}
+
+	void RX_Burst_Stats::print_stats()
+	{
+		const RX_Burst_Stats_Counters& s = counters;
+
+		int64_t avg_analysis_time = (s.no_of_analysed_bursts > 0) ? s.sum_analysis_time / (int64_t)s.no_of_analysed_bursts : 0;
+
+		report();
+
+		msg("sdr: RX burst stats: queued=" + to_string(s.no_of_queued_bursts) + ", dropped=" + to_string(s.no_of_dropped_bursts) + ", analysed=" + to_string(s.no_of_analysed_bursts) + ", reports=" + to_string(s.no_of_reports) + ", analysis_time avg/max=" + to_string(avg_analysis_time / 1000) + "/" + to_string(s.max_analysis_time / 1000) + " [us]");
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef __RX_BURST_STATS_H__
+#define __RX_BURST_STATS_H__
+
+#include <atomic>
+#include <complex>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "Frame_Scheduler.h"
+#include "../utils/SPSC_Ring.h"
+
+namespace sdr
+{
+	//signal quality of a single RX burst (powers are linear, relative to full scale 1.0)
+	//
+	//	power			- mean power |x|^2
+	//	peak			- maximum instantaneous power
+	//	dc				- mean of I and Q
+	//	gain_imbalance	- ratio of I to Q power with DC removed in [dB]
+	//	phase_imbalance	- deviation of I and Q from quadrature in [deg] (from their correlation with DC removed)
+	struct RX_Burst_Metrics
+	{
+		uint64_t frame = 0;
+		size_t slot = 0;
+		double power = 0;
+		double peak = 0;
+		std::complex<double> dc;
+		double gain_imbalance = 0;
+		double phase_imbalance = 0;
+	};
+
+	//statistics of the pipeline itself
+	struct RX_Burst_Stats_Counters
+	{
+		uint64_t no_of_queued_bursts = 0;
+		uint64_t no_of_dropped_bursts = 0;
+		uint64_t no_of_analysed_bursts = 0;
+		uint64_t no_of_reports = 0;
+		int64_t max_analysis_time = 0;
+		int64_t sum_analysis_time = 0;
+	};
+
+	//incremental RX signal quality statistics - the RX thread only copies every received burst into a preallocated
+	//lock-free ring (bursts that do not fit into a full ring are dropped and counted), a worker thread reduces it
+	//into RX_Burst_Metrics and keeps the last window_size of them, a summary of that rolling window is printed
+	//every report_period (0 - only on exit) instead of anything per burst
+	class RX_Burst_Stats
+	{
+	private:
+		//RX burst waiting for the worker thread
+		struct Stats_Job
+		{
+			Frame_Slot slot;
+			std::vector<std::complex<float>> samples;
+		};
+
+		typedef utils::SPSC_Ring<Stats_Job> ring_t;
+		boost::shared_ptr<ring_t> ring;
+
+		//rolling window of the most recent bursts, oldest one overwritten first
+		std::vector<RX_Burst_Metrics> window;
+		size_t window_head = 0;
+		size_t window_count = 0;
+
+		int64_t report_period_ns = 0;
+		int64_t next_report_time = 0;
+
+		std::atomic<bool> running;
+		RX_Burst_Stats_Counters counters;
+
+		boost::thread worker_thread;
+
+		void worker_thread_function();
+		size_t drain();
+		void analyse(const Stats_Job& job);
+		void report();
+
+	public:
+		typedef boost::shared_ptr<RX_Burst_Stats> sptr_t;
+
+		RX_Burst_Stats(const size_t queue_size, const size_t max_no_of_rx_samples, const size_t window_size, const double report_period);
+		~RX_Burst_Stats();
+
+		//called only from the RX thread, samples are copied, so the RX buffer may be reused right away
+		void submit(const Frame_Slot& slot, const std::complex<float>* samples);
+
+		void stop();
+		void print_stats();
+	};
+
+	//reduces given samples into burst metrics (frame and slot are left untouched)
+	void compute_rx_burst_metrics(const std::complex<float>* samples, const size_t no_of_samples, RX_Burst_Metrics& metrics);
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include "RX_Capture.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <stdexcept>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	static size_t round_up(const size_t n, const size_t alignment)
+	{
+		return (n + alignment - 1) / alignment * alignment;
+	}
+
+	RX_Capture::RX_Capture(const std::string& filepath, const size_t no_of_slots, const int max_samples_per_burst, const double f_clk, const double sampling_rate, const bool wrap)
+	:
+		filepath(filepath),
+		wrap(wrap)
+	{
+		const size_t page_size = sysconf(_SC_PAGESIZE);
+
+		//slots are page aligned, so a burst never shares a page with its neighbours
+		size_t slot_size = round_up(max(max_samples_per_burst, 1) * sizeof(std::complex<float>), page_size);
+		size_t samples_offset = round_up(sizeof(RX_Capture_Header) + no_of_slots * sizeof(RX_Capture_Index_Entry), page_size);
+
+		mapping_size = samples_offset + no_of_slots * slot_size;
+
+		fd = open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+		if (fd < 0)
+			throw std::runtime_error("Unable to create capture file " + filepath + ": " + string(strerror(errno)));
+
+		//blocks are allocated up front, so writing bursts never waits for the filesystem to find space
+		int ret = posix_fallocate(fd, 0, mapping_size);
+
+		if (ret != 0)
+		{
+			::close(fd);
+			throw std::runtime_error("Unable to preallocate " + to_string(mapping_size) + " bytes of capture file " + filepath + ": " + string(strerror(ret)));
+		}
+
+		//pages are populated right away, so first bursts do not page-fault
+		void* addr = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+
+		if (addr == MAP_FAILED)
+		{
+			::close(fd);
+			throw std::runtime_error("Unable to map capture file " + filepath + ": " + string(strerror(errno)));
+		}
+
+		mapping = static_cast<char*>(addr);
+		header = reinterpret_cast<RX_Capture_Header*>(mapping);
+		index = reinterpret_cast<RX_Capture_Index_Entry*>(mapping + sizeof(RX_Capture_Header));
+
+		memcpy(header->magic, RX_CAPTURE_MAGIC, sizeof(header->magic));
+		header->version = RX_CAPTURE_VERSION;
+		header->index_entry_size = sizeof(RX_Capture_Index_Entry);
+		header->f_clk = f_clk;
+		header->sampling_rate = sampling_rate;
+		header->no_of_slots = no_of_slots;
+		header->max_samples_per_burst = max_samples_per_burst;
+		header->slot_size = slot_size;
+		header->samples_offset = samples_offset;
+		header->no_of_captured_bursts = 0;
+
+		msg("sdr: RX bursts are being captured into " + filepath + " (" + to_string(no_of_slots) + " bursts, " + to_string(mapping_size >> 20) + " MB" + (wrap ? ", wrapping)" : ")"));
+	}
+
+	RX_Capture::~RX_Capture()
+	{
+		close();
+	}
+
+	std::complex<float>* RX_Capture::get_slot(const size_t slot)
+	{
+		return reinterpret_cast<std::complex<float>*>(mapping + header->samples_offset + slot * header->slot_size);
+	}
+
+	std::complex<float>* RX_Capture::next_buffer()
+	{
+		if ((mapping == nullptr) || (current_slot == header->no_of_slots))
+		{
+			no_of_dropped_bursts++;
+			return nullptr;
+		}
+
+		//a reused slot is invalidated before its samples are overwritten, so a reader of a live file never takes
+		//new samples for the burst recorded in the entry before (the fence keeps the store ahead of the samples)
+		__atomic_store_n(&index[current_slot].seq, 0, __ATOMIC_RELEASE);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+
+		return get_slot(current_slot);
+	}
+
+	void RX_Capture::commit(const SDR_Burst_Status& status)
+	{
+		//slot is reused by the next burst
+		if (status.no_of_transferred_samples <= 0)
+		{
+			no_of_failed_bursts++;
+			return;
+		}
+
+		RX_Capture_Index_Entry& entry = index[current_slot];
+
+		//seq has been cleared by next_buffer() and is written last, so an entry is never seen half-way updated by a
+		//reader of a live file
+		entry.tick = status.tick;
+		entry.hardware_time = status.current_time;
+		entry.burst_time = status.burst_time;
+		entry.status_time = status.status_time;
+		entry.no_of_samples = status.no_of_transferred_samples;
+		entry.flags = status.flags;
+		entry.stream_status = status.stream_status;
+		entry.reserved = 0;
+		__atomic_store_n(&entry.seq, ++no_of_captured_bursts, __ATOMIC_RELEASE);
+
+		current_slot++;
+
+		if (wrap && (current_slot == header->no_of_slots))
+			current_slot = 0;
+	}
+
+	void RX_Capture::close()
+	{
+		if (mapping == nullptr)
+			return;
+
+		header->no_of_captured_bursts = no_of_captured_bursts;
+
+		munmap(mapping, mapping_size);
+		::close(fd);
+
+		mapping = nullptr;
+		header = nullptr;
+		index = nullptr;
+		fd = -1;
+	}
+
+	void RX_Capture::print_stats()
+	{
+		msg("sdr: RX capture: captured_bursts=" + to_string(no_of_captured_bursts) + ", dropped_bursts=" + to_string(no_of_dropped_bursts) + ", failed_bursts=" + to_string(no_of_failed_bursts) + ", file=" + filepath);
+	}
+}
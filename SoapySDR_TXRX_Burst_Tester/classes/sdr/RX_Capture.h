@@ -0,0 +1,57 @@
+#ifndef __RX_CAPTURE_H__
+#define __RX_CAPTURE_H__
+
+#include <complex>
+#include <string>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include "RX_Capture_Format.h"
+#include "SDR_Device_Wrapper.h"
+
+namespace sdr
+{
+	//capture of RX bursts into a preallocated memory-mapped file - bursts are received straight into mapped pages,
+	//so there is no intermediate copy, and the kernel writes them back to disk in the background
+	//
+	//meant to be used from a single RX thread: next_buffer() gives the slot the next burst is to be received into,
+	//commit() records its index entry
+	class RX_Capture
+	{
+	private:
+		int fd = -1;
+		char* mapping = nullptr;
+		size_t mapping_size = 0;
+
+		RX_Capture_Header* header = nullptr;
+		RX_Capture_Index_Entry* index = nullptr;
+
+		std::string filepath;
+		bool wrap;
+
+		size_t current_slot = 0;
+		uint64_t no_of_captured_bursts = 0;
+		uint64_t no_of_dropped_bursts = 0;
+		uint64_t no_of_failed_bursts = 0;
+
+		std::complex<float>* get_slot(const size_t slot);
+
+	public:
+		typedef boost::shared_ptr<RX_Capture> sptr_t;
+
+		//throws std::runtime_error when the capture file cannot be created, preallocated or mapped
+		RX_Capture(const std::string& filepath, const size_t no_of_slots, const int max_samples_per_burst, const double f_clk, const double sampling_rate, const bool wrap);
+		~RX_Capture();
+
+		//buffer the next burst is to be received into, nullptr when the capture is full (and does not wrap)
+		std::complex<float>* next_buffer();
+		//records the burst just received into the buffer returned by next_buffer() (bursts without samples are not kept)
+		void commit(const SDR_Burst_Status& status);
+
+		void close();
+		void print_stats();
+	};
+}
+
+#endif
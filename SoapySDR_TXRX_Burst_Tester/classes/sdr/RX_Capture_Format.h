@@ -0,0 +1,56 @@
+#ifndef __RX_CAPTURE_FORMAT_H__
+#define __RX_CAPTURE_FORMAT_H__
+
+#include <stdint.h>
+
+//RX capture file layout, shared by RX_Capture and the offline reader
+//(kept free of any dependencies, so the reader can be built without SoapySDR)
+//
+//	RX_Capture_Header
+//	RX_Capture_Index_Entry[no_of_slots]
+//	padding up to samples_offset (page aligned)
+//	no_of_slots slots of slot_size bytes each, every one holding samples of a single burst as interleaved float I/Q
+//
+//slots are reused as a ring when capture wraps, so bursts are ordered by seq of their index entries, not by slot number
+//(all values in host byte order)
+
+namespace sdr
+{
+	const char RX_CAPTURE_MAGIC[8] = {'R', 'X', 'C', 'A', 'P', 'T', 'U', 'R'};
+	const uint32_t RX_CAPTURE_VERSION = 1;
+
+	struct RX_Capture_Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t index_entry_size;
+		double f_clk;
+		double sampling_rate;
+		uint32_t no_of_slots;
+		uint32_t max_samples_per_burst;
+		uint64_t slot_size;
+		uint64_t samples_offset;
+		//number of bursts written into the file, including the ones overwritten when it wraps (updated on close)
+		uint64_t no_of_captured_bursts;
+	};
+
+	//single burst, times in [ns] of the hardware clock
+	struct RX_Capture_Index_Entry
+	{
+		//starts from 1, 0 marks a slot that has never been written or is being written
+		uint64_t seq;
+		int64_t tick;
+		int64_t hardware_time;
+		int64_t burst_time;
+		int64_t status_time;
+		int32_t no_of_samples;
+		int32_t flags;
+		int32_t stream_status;
+		uint32_t reserved;
+	};
+
+	static_assert(sizeof(RX_Capture_Header) == 64, "unexpected RX_Capture_Header layout");
+	static_assert(sizeof(RX_Capture_Index_Entry) == 56, "unexpected RX_Capture_Index_Entry layout");
+}
+
+#endif
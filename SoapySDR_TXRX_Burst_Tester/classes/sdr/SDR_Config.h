@@ -2,6 +2,9 @@
 #define __SDR_DEVICE_CONFIG_H__
 
 #include <stdint.h>
+#include <string>
+#include <vector>
+#include <algorithm>
 
 namespace sdr
 {
@@ -13,16 +16,18 @@ namespace sdr
 		std::string clock_source = "";
 		std::string time_source = "";
 		double f_clk = 133.333333e6;
-		short channel_tx = 0;
-		short channel_rx = 0;
+		//channels streamed together (MIMO) with aligned timestamps
+		std::vector<size_t> channels_tx = {0};
+		std::vector<size_t> channels_rx = {0};
 		uint16_t D_tx = 8;
 		uint16_t D_rx = D_tx;
 		double B_tx = 16.666667e6;
 		double B_rx = 16.666667e6;
-		double G_tx = 52;
-		double G_rx = 20;
-		std::string antenna_tx = "BAND1";
-		std::string antenna_rx = "LNAL";
+		//gains and antennas per channel, the last value applies to all remaining channels (see per_channel)
+		std::vector<double> G_tx = {52};
+		std::vector<double> G_rx = {20};
+		std::vector<std::string> antennas_tx = {"BAND1"};
+		std::vector<std::string> antennas_rx = {"LNAL"};
 		double f_c_tx = 1457e6;
 		double f_c_rx = f_c_tx;
 		double T_timeout = 2;
@@ -31,7 +36,27 @@ namespace sdr
 		int64_t buffer_size_rx = 0;
 		bool tx_active = true;
 		bool rx_active = true;
+		bool rx_continuous = false;
+		//CF32, CS16, CS12 or native (format reported by the device), converted to/from CF32 by the wrapper
+		std::string stream_format = "CF32";
+		//whether the device applies control calls at the hardware time given by setCommandTime (e.g. UHD devices),
+		//settings changed while streaming are applied by the host between bursts otherwise
+		bool command_time = false;
+		//whether bursts are converted straight into/out of driver buffers (acquireWriteBuffer/acquireReadBuffer)
+		//instead of being copied by writeStream/readStream, falls back to the copy path for drivers without them
+		bool direct_buffers = false;
+		//period in [s] hardware time is read at by the clock tracker (see Clock_Tracker) and number of reads its model
+		//is fitted to, 0 - no tracking, hardware time is read for every burst
+		double T_clock_tracking = 0.1;
+		size_t clock_window = 32;
 	};
+
+	//value of a per channel setting for c-th channel of a stream
+	template <typename T>
+	const T& per_channel(const std::vector<T>& values, const size_t c)
+	{
+		return values[std::min(c, values.size() - 1)];
+	}
 }
 
 #endif
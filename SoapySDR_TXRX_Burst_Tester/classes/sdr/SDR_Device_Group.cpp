@@ -0,0 +1,314 @@
+#include "SDR_Device_Group.h"
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/thread.hpp>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	//hardware time is read a few times and the read taking the shortest time is used
+	static const size_t NO_OF_TIME_READS = 5;
+
+	time_sync_t parse_time_sync(const std::string& name)
+	{
+		if (name == "none")
+			return TIME_SYNC_NONE;
+		else if (name == "host")
+			return TIME_SYNC_HOST;
+		else if (name == "pps")
+			return TIME_SYNC_PPS;
+
+		throw std::invalid_argument("Unknown time synchronisation '" + name + "' (expected none, host or pps)");
+	}
+
+	static vector<string> parse_list(const string& key, const string& value)
+	{
+		vector<string> items = explode(value);
+
+		if (items.empty())
+			throw std::invalid_argument("SDR." + key + " needs at least one value");
+
+		for (const string& item : items)
+			if (item.empty())
+				throw std::invalid_argument("SDR." + key + " has an empty item in '" + value + "'");
+
+		return items;
+	}
+
+	static double parse_number(const string& key, const string& value)
+	{
+		size_t end = 0;
+		double number = 0;
+
+		try
+		{
+			number = stod(value, &end);
+		}
+		catch (const std::exception& e)
+		{
+			end = 0;
+		}
+
+		if ((end == 0) || (end != value.size()))
+			throw std::invalid_argument("SDR." + key + " has invalid value '" + value + "'");
+
+		return number;
+	}
+
+	static bool parse_flag(const string& key, const string& value)
+	{
+		if ((value == "true") || (value == "1"))
+			return true;
+		else if ((value == "false") || (value == "0"))
+			return false;
+
+		throw std::invalid_argument("SDR." + key + " has invalid value '" + value + "' (expected true or false)");
+	}
+
+	static vector<size_t> parse_channels(const string& key, const string& value)
+	{
+		vector<size_t> channels;
+
+		for (const string& item : parse_list(key, value))
+		{
+			double number = parse_number(key, item);
+
+			if ((number < 0) || (number != (size_t)number))
+				throw std::invalid_argument("SDR." + key + " has invalid channel number '" + item + "'");
+
+			channels.push_back(number);
+		}
+
+		return channels;
+	}
+
+	static vector<double> parse_numbers(const string& key, const string& value)
+	{
+		vector<double> numbers;
+
+		for (const string& item : parse_list(key, value))
+			numbers.push_back(parse_number(key, item));
+
+		return numbers;
+	}
+
+	void set_device_option(SDR_Device_Config& device_cfg, const std::string& key, const std::string& value)
+	{
+		if (key == "args")
+			device_cfg.args = value;
+		else if (key == "clock_source")
+			device_cfg.clock_source = value;
+		else if (key == "time_source")
+			device_cfg.time_source = value;
+		else if (key == "tx_channel")
+			device_cfg.channels_tx = parse_channels(key, value);
+		else if (key == "rx_channel")
+			device_cfg.channels_rx = parse_channels(key, value);
+		else if (key == "tx_antenna")
+			device_cfg.antennas_tx = parse_list(key, value);
+		else if (key == "rx_antenna")
+			device_cfg.antennas_rx = parse_list(key, value);
+		else if (key == "tx_gain")
+			device_cfg.G_tx = parse_numbers(key, value);
+		else if (key == "rx_gain")
+			device_cfg.G_rx = parse_numbers(key, value);
+		else if (key == "center_frequency")
+			device_cfg.f_c_tx = device_cfg.f_c_rx = parse_number(key, value);
+		else if (key == "tx_bandwidth")
+			device_cfg.B_tx = parse_number(key, value);
+		else if (key == "rx_bandwidth")
+			device_cfg.B_rx = parse_number(key, value);
+		else if (key == "stream_format")
+			device_cfg.stream_format = value;
+		else if (key == "command_time")
+			device_cfg.command_time = parse_flag(key, value);
+		else if (key == "direct_buffers")
+			device_cfg.direct_buffers = parse_flag(key, value);
+		else if (key == "clock_tracking")
+			device_cfg.T_clock_tracking = parse_number(key, value);
+		else if (key == "clock_window")
+			device_cfg.clock_window = parse_number(key, value);
+		else
+			throw std::invalid_argument("SDR." + key + " cannot be set per device");
+	}
+
+	SDR_Device_Group::SDR_Device_Group(const std::vector<SDR_Device_Config::sptr_t>& device_cfgs, SDR_Init_Cache::sptr_t init_cache)
+	:
+		devices(device_cfgs.size())
+	{
+		vector<string> errors(device_cfgs.size());
+		boost::thread_group init_threads;
+
+		int64_t start_time = monotonic_time_ns();
+
+		for (size_t i = 0; i < device_cfgs.size(); i++)
+		{
+			if (device_cfgs.size() > 1)
+				msg("sdr: device group: device " + to_string(i) + " is going to be initialized with args=" + device_cfgs[i]->args);
+
+			init_threads.create_thread
+			(
+				[this, &device_cfgs, &errors, init_cache, i]()
+				{
+					try
+					{
+						devices[i].reset(new SDR_Device_Wrapper(device_cfgs[i], init_cache));
+					}
+					catch (const std::exception& e)
+					{
+						errors[i] = e.what();
+					}
+				}
+			);
+		}
+
+		init_threads.join_all();
+
+		for (size_t i = 0; i < errors.size(); i++)
+			if (!errors[i].empty())
+				throw std::runtime_error("Unable to initialize device " + to_string(i) + ": " + errors[i]);
+
+		if (devices.size() > 1)
+			msg("sdr: device group: " + to_string(devices.size()) + " devices initialized in parallel in " + to_string((monotonic_time_ns() - start_time) / 1000000) + " [ms]");
+	}
+
+	size_t SDR_Device_Group::size() const
+	{
+		return devices.size();
+	}
+
+	SDR_Device_Wrapper::sptr_t SDR_Device_Group::get(const size_t device) const
+	{
+		return devices[device];
+	}
+
+	Device_Time_Skew SDR_Device_Group::read_time_offset(const size_t device)
+	{
+		Device_Time_Skew offset;
+
+		for (size_t i = 0; i < NO_OF_TIME_READS; i++)
+		{
+			int64_t host_time_before = monotonic_time_ns();
+			long long hw_time = devices[device]->get_device()->getHardwareTime();
+			int64_t host_time_after = monotonic_time_ns();
+
+			//hardware time is assumed to be sampled in the middle of the call
+			if ((i == 0) || ((host_time_after - host_time_before) / 2 < offset.uncertainty))
+			{
+				offset.skew = hw_time - (host_time_before + host_time_after) / 2;
+				offset.uncertainty = (host_time_after - host_time_before) / 2;
+			}
+		}
+
+		return offset;
+	}
+
+	void SDR_Device_Group::align_time(const time_sync_t time_sync)
+	{
+		if (time_sync == TIME_SYNC_HOST)
+		{
+			//the other devices are set to the time of the first one as estimated from the host clock, the second pass
+			//compensates whatever skew the delay of setHardwareTime calls has caused in the first one
+			vector<int64_t> corrections(devices.size(), 0);
+
+			for (size_t pass = 0; pass < 2; pass++)
+			{
+				Device_Time_Skew reference = read_time_offset(0);
+
+				for (size_t i = 1; i < devices.size(); i++)
+					devices[i]->set_hardware_time(monotonic_time_ns() + reference.skew - corrections[i]);
+
+				vector<Device_Time_Skew> skews = measure_skew();
+
+				for (size_t i = 1; i < devices.size(); i++)
+					corrections[i] += skews[i].skew;
+			}
+		}
+		else if (time_sync == TIME_SYNC_PPS)
+		{
+			SoapySDR::Device* reference = devices[0]->get_device();
+
+			//all devices have to be armed within the same PPS period, so arming starts right after an edge
+			if (reference->hasHardwareTime("PPS"))
+			{
+				long long last_pps_time = reference->getHardwareTime("PPS");
+				int64_t deadline = monotonic_time_ns() + 1100000000;
+
+				while ((reference->getHardwareTime("PPS") == last_pps_time) && (monotonic_time_ns() < deadline))
+					usleep(1000);
+
+				if (monotonic_time_ns() >= deadline)
+					msg("sdr: device group: no PPS edge seen on device 0, devices may latch their time at different edges", WARNING);
+			}
+			else
+				msg("sdr: device group: device 0 does not report time of the last PPS edge, devices may latch their time at different edges", WARNING);
+
+			long long time_before_edge = reference->getHardwareTime();
+
+			for (size_t i = 0; i < devices.size(); i++)
+				devices[i]->set_hardware_time(0, "PPS");
+
+			//the edge all devices have been armed for has passed once the time of the first one has gone back
+			//(it is at most one PPS period away, the deadline leaves some margin for a jittery PPS)
+			int64_t deadline = monotonic_time_ns() + 2200000000LL;
+			long long last_time = time_before_edge;
+
+			while (monotonic_time_ns() < deadline)
+			{
+				long long time = reference->getHardwareTime();
+
+				if (time < last_time)
+					break;
+
+				last_time = time;
+				usleep(1000);
+			}
+
+			if (monotonic_time_ns() >= deadline)
+				msg("sdr: device group: device 0 has not latched its time at a PPS edge", WARNING);
+		}
+
+		msg("sdr: device group: hardware times aligned (" + string((time_sync == TIME_SYNC_PPS) ? "pps" : (time_sync == TIME_SYNC_HOST) ? "host" : "none") + ")");
+	}
+
+	std::vector<Device_Time_Skew> SDR_Device_Group::measure_skew()
+	{
+		vector<Device_Time_Skew> skews(devices.size());
+
+		Device_Time_Skew reference = read_time_offset(0);
+
+		for (size_t i = 1; i < devices.size(); i++)
+		{
+			Device_Time_Skew offset = read_time_offset(i);
+
+			skews[i].skew = offset.skew - reference.skew;
+			skews[i].uncertainty = offset.uncertainty + reference.uncertainty;
+		}
+
+		return skews;
+	}
+
+	void SDR_Device_Group::print_skew(const std::string& label)
+	{
+		vector<Device_Time_Skew> skews = measure_skew();
+
+		int64_t max_skew = 0;
+
+		for (size_t i = 1; i < skews.size(); i++)
+		{
+			msgf(INFO, "sdr: device group (%s): device %zu skew=%+lld [ns] (+/-%lld [ns])", label.c_str(), i, (long long)skews[i].skew, (long long)skews[i].uncertainty);
+
+			max_skew = max(max_skew, (int64_t)llabs(skews[i].skew));
+		}
+
+		msgf(INFO, "sdr: device group (%s): max skew=%lld [ns] over %zu devices", label.c_str(), (long long)max_skew, skews.size());
+	}
+}
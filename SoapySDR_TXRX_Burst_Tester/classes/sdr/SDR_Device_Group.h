@@ -0,0 +1,72 @@
+#ifndef __SDR_DEVICE_GROUP_H__
+#define __SDR_DEVICE_GROUP_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include "SDR_Config.h"
+#include "SDR_Device_Wrapper.h"
+#include "SDR_Init_Cache.h"
+
+namespace sdr
+{
+	//how hardware times of devices of a group are aligned
+	//
+	//	TIME_SYNC_NONE	- left as they are (e.g. aligned by other means already), skew is only measured
+	//	TIME_SYNC_HOST	- set from the host clock one device after another, aligned up to jitter of control calls
+	//	TIME_SYNC_PPS	- latched by all devices at the same PPS edge (needs a shared PPS and SDR.time_source set accordingly)
+	enum time_sync_t
+	{
+		TIME_SYNC_NONE,
+		TIME_SYNC_HOST,
+		TIME_SYNC_PPS
+	};
+
+	//accepts none, host and pps, throws std::invalid_argument otherwise
+	time_sync_t parse_time_sync(const std::string& name);
+
+	//applies a single setting of [SDR] section given by its key (e.g. tx_gain) to device configuration, per channel
+	//settings are comma separated lists, throws std::invalid_argument for unknown key or malformed value
+	void set_device_option(SDR_Device_Config& device_cfg, const std::string& key, const std::string& value);
+
+	//hardware time of a device relative to the first device of a group in [ns], uncertainty is given by how long
+	//it took to read both hardware times
+	struct Device_Time_Skew
+	{
+		int64_t skew = 0;
+		int64_t uncertainty = 0;
+	};
+
+	//several SDR devices driven by a single process from one timeline - devices are initialised in parallel (each
+	//of them may wait seconds for its LOs to lock), their hardware times are then aligned, so that a tick of the
+	//timeline means the same instant on all of them
+	class SDR_Device_Group
+	{
+	private:
+		std::vector<SDR_Device_Wrapper::sptr_t> devices;
+
+		//hardware time minus host monotonic time of given device, taken from the shortest of a few reads
+		Device_Time_Skew read_time_offset(const size_t device);
+
+	public:
+		typedef boost::shared_ptr<SDR_Device_Group> sptr_t;
+
+		//init cache (optional) is shared by all devices
+		SDR_Device_Group(const std::vector<SDR_Device_Config::sptr_t>& device_cfgs, SDR_Init_Cache::sptr_t init_cache = SDR_Init_Cache::sptr_t());
+
+		size_t size() const;
+		SDR_Device_Wrapper::sptr_t get(const size_t device) const;
+
+		//meant to be called before streaming starts, PPS alignment blocks for up to two PPS periods
+		void align_time(const time_sync_t time_sync);
+
+		//skew of every device against the first one (so the first element is always zero)
+		std::vector<Device_Time_Skew> measure_skew();
+		void print_skew(const std::string& label);
+	};
+}
+
+#endif
@@ -1,8 +1,10 @@
 #include "SDR_Device_Wrapper.h"
 
 #include <iostream>
-
-#include <boost/format.hpp>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
 
 #include <SoapySDR/Errors.hpp>
 #include <SoapySDR/Time.hpp>
@@ -15,9 +17,78 @@ using namespace utils;
 
 namespace sdr
 {
-	SDR_Device_Wrapper::SDR_Device_Wrapper(SDR_Device_Config::sptr_t device_cfg)
+	//overflows a continuous RX window may read past before its first sample, so an overflowing stream cannot hold
+	//the RX thread forever
+	static const int MAX_NO_OF_WINDOW_OVERFLOWS = 16;
+
+	const char* code_to_str(const int code)
+	{
+		switch (code)
+		{
+			case SOAPY_SDR_TIMEOUT:
+				return "SOAPY_SDR_TIMEOUT";
+			case SOAPY_SDR_STREAM_ERROR:
+				return "SOAPY_SDR_STREAM_ERROR";
+			case SOAPY_SDR_CORRUPTION:
+				return "SOAPY_SDR_CORRUPTION";
+			case SOAPY_SDR_OVERFLOW:
+				return "SOAPY_SDR_OVERFLOW";
+			case SOAPY_SDR_NOT_SUPPORTED:
+				return "SOAPY_SDR_NOT_SUPPORTED";
+			case SOAPY_SDR_END_BURST:
+				return "SOAPY_SDR_END_BURST";
+			case SOAPY_SDR_TIME_ERROR:
+				return "SOAPY_SDR_TIME_ERROR";
+			case SOAPY_SDR_UNDERFLOW:
+				return "SOAPY_SDR_UNDERFLOW";
+			default:
+				return "NO_ERROR";
+		}
+	}
+
+	//size in bytes of a scratch buffer of given stream format for a single channel, rounded up to whole cache lines
+	//plus one, so channels do not alias each other in caches
+	static size_t native_stride(const int64_t no_of_samples, const sample_format_t format)
+	{
+		return (max(no_of_samples, (int64_t)1) * sample_format_size(format) + 63) / 64 * 64 + 64;
+	}
+
+	static string channels_to_str(const vector<size_t>& channels)
+	{
+		string res;
+
+		for (size_t channel : channels)
+			res += (res.empty() ? "" : ",") + to_string(channel);
+
+		return res;
+	}
+
+	SDR_Device_Wrapper::SDR_Device_Wrapper(SDR_Device_Config::sptr_t device_cfg, SDR_Init_Cache::sptr_t init_cache)
 	{
 		this->device_cfg = device_cfg;
+		this->init_cache = init_cache;
+
+		//per-burst scratch state is sized once here, so send_samples/receive_samples never touch the heap
+		tx_zero_samples.assign(1, std::complex<float>(0, 0));
+		rx_zero_samples.assign(1, std::complex<float>(0, 0));
+		tx_buffs.assign(device_cfg->channels_tx.size(), nullptr);
+		rx_buffs.assign(device_cfg->channels_rx.size(), nullptr);
+		rx_targets.assign(device_cfg->channels_rx.size(), nullptr);
+		tx_chunk_buffs.assign(device_cfg->channels_tx.size(), nullptr);
+		rx_chunk_buffs.assign(device_cfg->channels_rx.size(), nullptr);
+		tx_direct_buffs.assign(device_cfg->channels_tx.size(), nullptr);
+		rx_direct_buffs.assign(device_cfg->channels_rx.size(), nullptr);
+		rx_in_place_chunk.assign(device_cfg->channels_rx.size(), nullptr);
+		tx_channel_samples.assign(device_cfg->channels_tx.size(), nullptr);
+		rx_channel_samples.assign(device_cfg->channels_rx.size(), nullptr);
+
+		if (device_cfg->channels_rx.size() > 1)
+			rx_discarded_samples.reset(new Channel_Buffers(device_cfg->channels_rx.size(), max(device_cfg->buffer_size_rx, (int64_t)1)));
+		if (device_cfg->rx_active)
+			rx_in_place_samples.reset(new Channel_Buffers(device_cfg->channels_rx.size(), max(device_cfg->buffer_size_rx, (int64_t)1)));
+
+		for (size_t channel : device_cfg->channels_tx)
+			tx_chan_mask |= (1 << channel);
 
 		msg("sdr: Trying to initialize SDR Device...");
 
@@ -27,6 +98,11 @@ namespace sdr
 		{
 			try
 			{
+				//timing starts over with every attempt, so it describes the successful one
+				init_timing = SDR_Init_Timing();
+				int64_t init_start_time = monotonic_time_ns();
+				int64_t phase_start_time = init_start_time;
+
 				SoapySDR::setLogLevel(SoapySDR::LogLevel::SOAPY_SDR_INFO);
 
 				if (device_cfg->debug_settings)
@@ -40,14 +116,22 @@ namespace sdr
 				else if (device_cfg->debug_settings)
 					msg("SDR device successfully created!");
 
+				//settings applied before are looked up by serial number of the device (hardware key and args
+				//of devices without one)
+				SoapySDR::Kwargs hardware_info = device->getHardwareInfo();
+				serial = (hardware_info.count("serial") > 0) ? hardware_info["serial"] : device->getHardwareKey() + ":" + device_cfg->args;
+
+				init_timing.make_time = monotonic_time_ns() - phase_start_time;
+				phase_start_time = monotonic_time_ns();
+
 				if (device_cfg->clock_source != "")
 				{
 					//Set clock source
 					if (device_cfg->debug_settings)
 						msg("sdr: Trying to set the following clock source: " + device_cfg->clock_source);
-					device->setClockSource(device_cfg->clock_source);
+					string actual = apply_setting("clock_source", device_cfg->clock_source, [&](const string& v) { device->setClockSource(v); }, [&]() { return device->getClockSource(); });
 					if (device_cfg->debug_settings)
-						msg("sdr: Actual clock source: " + device->getClockSource());
+						msg("sdr: Actual clock source: " + actual);
 				}
 
 				if (device_cfg->time_source != "")
@@ -55,170 +139,203 @@ namespace sdr
 					//Set time source
 					if (device_cfg->debug_settings)
 						msg("sdr: Trying to set the following time source: " + device_cfg->time_source);
-					device->setTimeSource(device_cfg->time_source);
+					string actual = apply_setting("time_source", device_cfg->time_source, [&](const string& v) { device->setTimeSource(v); }, [&]() { return device->getTimeSource(); });
 					if (device_cfg->debug_settings)
-						msg("sdr: Actual time source: " + device->getTimeSource());
+						msg("sdr: Actual time source: " + actual);
 				}
 
 				//set the master clock rate
 				if (device_cfg->debug_settings)
 					msg("sdr: Trying to set the following master clock rate: " + to_string(device_cfg->f_clk/1e6) + " [MHz]");
 				msg("", INFO, false, false);
-				device->setMasterClockRate(device_cfg->f_clk);
+				double actual_f_clk = apply_setting("master_clock_rate", device_cfg->f_clk, [&](double v) { device->setMasterClockRate(v); }, [&]() { return device->getMasterClockRate(); });
 				if (device_cfg->debug_settings)
-					msg("sdr: Actual master clock rate: " + to_string(device->getMasterClockRate()/1e6) + " [MHz]");
+					msg("sdr: Actual master clock rate: " + to_string(actual_f_clk/1e6) + " [MHz]");
+
+				init_timing.clock_time = monotonic_time_ns() - phase_start_time;
+				phase_start_time = monotonic_time_ns();
 
 				if (device_cfg->tx_active)
 				{
 					//set the tx sample rate
-					if (device_cfg->debug_settings)
-						msg("sdr: Trying to set the following TX sample rate on channel " + to_string(device_cfg->channel_tx) + ": " + to_string((device_cfg->f_clk / (double)device_cfg->D_tx)/1e6) + " [MHz]");
-					device->setSampleRate(SOAPY_SDR_TX, device_cfg->channel_tx, device_cfg->f_clk / (double)device_cfg->D_tx);
-					if (device_cfg->debug_settings)
-						msg("sdr: Actual TX sample rate on channel " + to_string(device_cfg->channel_tx) + ": " + to_string(device->getSampleRate(SOAPY_SDR_TX, device_cfg->channel_tx)/1e6) + " [MHz]");
+					for (size_t c = 0; c < device_cfg->channels_tx.size(); c++)
+					{
+						const size_t channel = device_cfg->channels_tx[c];
+
+						if (device_cfg->debug_settings)
+							msg("sdr: Trying to set the following TX sample rate on channel " + to_string(channel) + ": " + to_string((device_cfg->f_clk / (double)device_cfg->D_tx)/1e6) + " [MHz]");
+						double actual = apply_setting("tx" + to_string(channel) + ".sample_rate", device_cfg->f_clk / (double)device_cfg->D_tx, [&](double v) { device->setSampleRate(SOAPY_SDR_TX, channel, v); }, [&]() { return device->getSampleRate(SOAPY_SDR_TX, channel); });
+						if (device_cfg->debug_settings)
+							msg("sdr: Actual TX sample rate on channel " + to_string(channel) + ": " + to_string(actual/1e6) + " [MHz]");
+					}
 				}
 
 				if (device_cfg->rx_active)
 				{
 					//set the rx sample rate
-					if (device_cfg->debug_settings)
-						msg("sdr: Trying to set the following RX sample rate on channel " + to_string(device_cfg->channel_rx) + ": " + to_string((device_cfg->f_clk / (double)device_cfg->D_rx)/1e6) + " [MHz]");
-					device->setSampleRate(SOAPY_SDR_RX, device_cfg->channel_rx, device_cfg->f_clk / (double)device_cfg->D_rx);
-					if (device_cfg->debug_settings)
-						msg("sdr: Actual RX sample rate on channel " + to_string(device_cfg->channel_rx) + ": " + to_string(device->getSampleRate(SOAPY_SDR_RX, device_cfg->channel_rx)/1e6) + " [MHz]");
+					for (size_t c = 0; c < device_cfg->channels_rx.size(); c++)
+					{
+						const size_t channel = device_cfg->channels_rx[c];
+
+						if (device_cfg->debug_settings)
+							msg("sdr: Trying to set the following RX sample rate on channel " + to_string(channel) + ": " + to_string((device_cfg->f_clk / (double)device_cfg->D_rx)/1e6) + " [MHz]");
+						double actual = apply_setting("rx" + to_string(channel) + ".sample_rate", device_cfg->f_clk / (double)device_cfg->D_rx, [&](double v) { device->setSampleRate(SOAPY_SDR_RX, channel, v); }, [&]() { return device->getSampleRate(SOAPY_SDR_RX, channel); });
+						if (device_cfg->debug_settings)
+							msg("sdr: Actual RX sample rate on channel " + to_string(channel) + ": " + to_string(actual/1e6) + " [MHz]");
+					}
 				}
 
 				if ((device_cfg->tx_active) && (device_cfg->B_tx > 0))
 				{
 					//set the tx bandwidth
-					if (device_cfg->debug_settings)
-						msg("sdr: Trying to set the following TX filter bandwidth on channel " + to_string(device_cfg->channel_tx) + ": " + to_string(device_cfg->B_tx / 1e6) + " [MHz]");
-					device->setBandwidth(SOAPY_SDR_TX, device_cfg->channel_tx, device_cfg->B_tx);
-					if (device_cfg->debug_settings)
-						msg("sdr: Actual TX bandwidth on channel " + to_string(device_cfg->channel_tx) + ": " + to_string(device->getBandwidth(SOAPY_SDR_TX, device_cfg->channel_tx)/1e6) + " [MHz]");
+					for (size_t c = 0; c < device_cfg->channels_tx.size(); c++)
+					{
+						const size_t channel = device_cfg->channels_tx[c];
+
+						if (device_cfg->debug_settings)
+							msg("sdr: Trying to set the following TX filter bandwidth on channel " + to_string(channel) + ": " + to_string(device_cfg->B_tx / 1e6) + " [MHz]");
+						double actual = apply_setting("tx" + to_string(channel) + ".bandwidth", device_cfg->B_tx, [&](double v) { device->setBandwidth(SOAPY_SDR_TX, channel, v); }, [&]() { return device->getBandwidth(SOAPY_SDR_TX, channel); });
+						if (device_cfg->debug_settings)
+							msg("sdr: Actual TX bandwidth on channel " + to_string(channel) + ": " + to_string(actual/1e6) + " [MHz]");
+					}
 				}
 
 				if ((device_cfg->rx_active) && (device_cfg->B_rx > 0))
 				{
 					//set the tx bandwidth
-					if (device_cfg->debug_settings)
-						msg("sdr: Trying to set the following RX filter bandwidth on channel " + to_string(device_cfg->channel_rx) + ": " + to_string(device_cfg->B_rx / 1e6) + " [MHz]");
-					device->setBandwidth(SOAPY_SDR_RX, device_cfg->channel_rx, device_cfg->B_rx);
-					if (device_cfg->debug_settings)
-						msg("sdr: Actual RX bandwidth on channel " + to_string(device_cfg->channel_rx) + ": " + to_string(device->getBandwidth(SOAPY_SDR_RX, device_cfg->channel_rx)/1e6) + " [MHz]");
+					for (size_t c = 0; c < device_cfg->channels_rx.size(); c++)
+					{
+						const size_t channel = device_cfg->channels_rx[c];
+
+						if (device_cfg->debug_settings)
+							msg("sdr: Trying to set the following RX filter bandwidth on channel " + to_string(channel) + ": " + to_string(device_cfg->B_rx / 1e6) + " [MHz]");
+						double actual = apply_setting("rx" + to_string(channel) + ".bandwidth", device_cfg->B_rx, [&](double v) { device->setBandwidth(SOAPY_SDR_RX, channel, v); }, [&]() { return device->getBandwidth(SOAPY_SDR_RX, channel); });
+						if (device_cfg->debug_settings)
+							msg("sdr: Actual RX bandwidth on channel " + to_string(channel) + ": " + to_string(actual/1e6) + " [MHz]");
+					}
 				}
 
 				if (device_cfg->tx_active)
 				{
 					//set the tx RF chain gain
-					if (device_cfg->debug_settings)
-						msg("sdr: Trying to set the following TX gain on channel " + to_string(device_cfg->channel_tx) + ": " + to_string(device_cfg->G_tx) + " [dB]");
-					device->setGain(SOAPY_SDR_TX, device_cfg->channel_tx, device_cfg->G_tx);
-					if (device_cfg->debug_settings)
-						msg("sdr: Actual TX gain on channel " + to_string(device_cfg->channel_tx) + ": " + to_string(device->getGain(SOAPY_SDR_TX, device_cfg->channel_tx)) + " [dB]");
+					for (size_t c = 0; c < device_cfg->channels_tx.size(); c++)
+					{
+						const size_t channel = device_cfg->channels_tx[c];
+
+						if (device_cfg->debug_settings)
+							msg("sdr: Trying to set the following TX gain on channel " + to_string(channel) + ": " + to_string(per_channel(device_cfg->G_tx, c)) + " [dB]");
+						double actual = apply_setting("tx" + to_string(channel) + ".gain", per_channel(device_cfg->G_tx, c), [&](double v) { device->setGain(SOAPY_SDR_TX, channel, v); }, [&]() { return device->getGain(SOAPY_SDR_TX, channel); });
+						if (device_cfg->debug_settings)
+							msg("sdr: Actual TX gain on channel " + to_string(channel) + ": " + to_string(actual) + " [dB]");
+					}
 				}
 
 				if (device_cfg->rx_active)
 				{
 					//set the rx RF chain gain
-					if (device_cfg->debug_settings)
-						msg("sdr: Trying to set the following RX gain on channel " + to_string(device_cfg->channel_rx) + ": " + to_string(device_cfg->G_rx) + " [dB]");
-					device->setGain(SOAPY_SDR_RX, device_cfg->channel_rx, device_cfg->G_rx);
-					if (device_cfg->debug_settings)
-						msg("sdr: Actual RX gain on channel " + to_string(device_cfg->channel_rx) + ": " + to_string(device->getGain(SOAPY_SDR_RX, device_cfg->channel_rx)) + " [dB]");
+					for (size_t c = 0; c < device_cfg->channels_rx.size(); c++)
+					{
+						const size_t channel = device_cfg->channels_rx[c];
+
+						if (device_cfg->debug_settings)
+							msg("sdr: Trying to set the following RX gain on channel " + to_string(channel) + ": " + to_string(per_channel(device_cfg->G_rx, c)) + " [dB]");
+						double actual = apply_setting("rx" + to_string(channel) + ".gain", per_channel(device_cfg->G_rx, c), [&](double v) { device->setGain(SOAPY_SDR_RX, channel, v); }, [&]() { return device->getGain(SOAPY_SDR_RX, channel); });
+						if (device_cfg->debug_settings)
+							msg("sdr: Actual RX gain on channel " + to_string(channel) + ": " + to_string(actual) + " [dB]");
+					}
 				}
 
 				if (device_cfg->tx_active)
 				{
 					//set the tx antenna
-					if (device_cfg->debug_settings)
-						msg("sdr: Trying to set the following TX antenna on channel " + to_string(device_cfg->channel_tx) + ": " + device_cfg->antenna_tx);
-					device->setAntenna(SOAPY_SDR_TX, device_cfg->channel_tx, device_cfg->antenna_tx);
-					if (device_cfg->debug_settings)
-						msg("sdr: Actual TX antenna on channel " + to_string(device_cfg->channel_tx) + ": " + device->getAntenna(SOAPY_SDR_TX, device_cfg->channel_tx));
+					for (size_t c = 0; c < device_cfg->channels_tx.size(); c++)
+					{
+						const size_t channel = device_cfg->channels_tx[c];
+
+						if (device_cfg->debug_settings)
+							msg("sdr: Trying to set the following TX antenna on channel " + to_string(channel) + ": " + per_channel(device_cfg->antennas_tx, c));
+						string actual = apply_setting("tx" + to_string(channel) + ".antenna", per_channel(device_cfg->antennas_tx, c), [&](const string& v) { device->setAntenna(SOAPY_SDR_TX, channel, v); }, [&]() { return device->getAntenna(SOAPY_SDR_TX, channel); });
+						if (device_cfg->debug_settings)
+							msg("sdr: Actual TX antenna on channel " + to_string(channel) + ": " + actual);
+					}
 				}
 
 				if (device_cfg->rx_active)
 				{
 					//set the rx antenna
-					if (device_cfg->debug_settings)
-						msg("sdr: Trying to set the following RX antenna on channel " + to_string(device_cfg->channel_rx) + ": " + device_cfg->antenna_rx);
-					device->setAntenna(SOAPY_SDR_RX, device_cfg->channel_rx, device_cfg->antenna_rx);
-					if (device_cfg->debug_settings)
-						msg("sdr: Actual RX antenna on channel " + to_string(device_cfg->channel_rx) + ": " + device->getAntenna(SOAPY_SDR_RX, device_cfg->channel_rx));
+					for (size_t c = 0; c < device_cfg->channels_rx.size(); c++)
+					{
+						const size_t channel = device_cfg->channels_rx[c];
+
+						if (device_cfg->debug_settings)
+							msg("sdr: Trying to set the following RX antenna on channel " + to_string(channel) + ": " + per_channel(device_cfg->antennas_rx, c));
+						string actual = apply_setting("rx" + to_string(channel) + ".antenna", per_channel(device_cfg->antennas_rx, c), [&](const string& v) { device->setAntenna(SOAPY_SDR_RX, channel, v); }, [&]() { return device->getAntenna(SOAPY_SDR_RX, channel); });
+						if (device_cfg->debug_settings)
+							msg("sdr: Actual RX antenna on channel " + to_string(channel) + ": " + actual);
+					}
 				}
 
+				init_timing.settings_time = monotonic_time_ns() - phase_start_time;
+				phase_start_time = monotonic_time_ns();
+
+				//all LOs are tuned first and then waited for together, so their lock times overlap
+				vector<pair<int, size_t>> tuned_channels;
+
 				if (device_cfg->tx_active)
 				{
 					//Set tx frequency
-					if (device_cfg->debug_settings)
-						msg("sdr: Trying to set the following TX frequency on channel " + to_string(device_cfg->channel_tx) + ": " + to_string(device_cfg->f_c_tx/1e6) + " [MHz]");
-
-					device->setFrequency(SOAPY_SDR_TX, device_cfg->channel_tx, device_cfg->f_c_tx);
-
-					//Check TX LO lock...
-					msg("sdr: Waiting for TX LO lock on channel " + to_string(device_cfg->channel_tx) + "...");
-
-					bool tx_lo_locked = false;
-
-					while (!(stop || tx_lo_locked))
+					for (size_t c = 0; c < device_cfg->channels_tx.size(); c++)
 					{
-						string tx_locked = device->readSensor(SOAPY_SDR_TX, device_cfg->channel_tx, "lo_locked");
+						const size_t channel = device_cfg->channels_tx[c];
 
-						if (tx_locked == "true")
-							tx_lo_locked = true;
+						if (device_cfg->debug_settings)
+							msg("sdr: Trying to set the following TX frequency on channel " + to_string(channel) + ": " + to_string(device_cfg->f_c_tx/1e6) + " [MHz]");
+						double actual = apply_setting("tx" + to_string(channel) + ".frequency", device_cfg->f_c_tx, [&](double v) { device->setFrequency(SOAPY_SDR_TX, channel, v); }, [&]() { return device->getFrequency(SOAPY_SDR_TX, channel); });
+						if (device_cfg->debug_settings)
+							msg("sdr: Actual TX frequency on channel " + to_string(channel) + ": " + to_string(actual/1e6) + " [MHz]");
 
-						usleep(100);
-						signal_handler.get_io_service().poll();
+						tuned_channels.push_back(make_pair(SOAPY_SDR_TX, channel));
 					}
-
-					msg("sdr: TX LO lock detected on channel " + to_string(device_cfg->channel_tx) + "!");
-
-					if (device_cfg->debug_settings)
-						msg("sdr: Actual TX frequency on channel " + to_string(device_cfg->channel_tx) + ": " + to_string(device->getFrequency(SOAPY_SDR_TX, device_cfg->channel_tx)/1e6) + " [MHz]");
 				}
 
 				if (device_cfg->rx_active)
 				{
 					//Set rx frequency
-					if (device_cfg->debug_settings)
-						msg("sdr: Trying to set the following RX frequency on channel " + to_string(device_cfg->channel_rx) + ": " + to_string(device_cfg->f_c_rx/1e6) + " [MHz]");
-
-					device->setFrequency(SOAPY_SDR_RX, device_cfg->channel_rx, device_cfg->f_c_rx);
-
-					//Check RX LO lock...
-					msg("sdr: Waiting for RX LO lock on channel " + to_string(device_cfg->channel_rx) + "...");
-
-					bool rx_lo_locked = false;
-
-					while (!(stop || rx_lo_locked))
+					for (size_t c = 0; c < device_cfg->channels_rx.size(); c++)
 					{
-						string rx_locked = device->readSensor(SOAPY_SDR_RX, device_cfg->channel_rx, "lo_locked");
+						const size_t channel = device_cfg->channels_rx[c];
 
-						if (rx_locked == "true")
-							rx_lo_locked = true;
+						if (device_cfg->debug_settings)
+							msg("sdr: Trying to set the following RX frequency on channel " + to_string(channel) + ": " + to_string(device_cfg->f_c_rx/1e6) + " [MHz]");
+						double actual = apply_setting("rx" + to_string(channel) + ".frequency", device_cfg->f_c_rx, [&](double v) { device->setFrequency(SOAPY_SDR_RX, channel, v); }, [&]() { return device->getFrequency(SOAPY_SDR_RX, channel); });
+						if (device_cfg->debug_settings)
+							msg("sdr: Actual RX frequency on channel " + to_string(channel) + ": " + to_string(actual/1e6) + " [MHz]");
 
-						usleep(100);
-						signal_handler.get_io_service().poll();
+						tuned_channels.push_back(make_pair(SOAPY_SDR_RX, channel));
 					}
+				}
 
-					msg("sdr: RX LO lock detected on channel " + to_string(device_cfg->channel_rx) + "!");
+				wait_for_lo_locks(tuned_channels);
 
-					if (device_cfg->debug_settings)
-						msg("sdr: Actual RX frequency on channel " + to_string(device_cfg->channel_rx) + ": " + to_string(device->getFrequency(SOAPY_SDR_RX, device_cfg->channel_rx)/1e6) + " [MHz]");
-				}
+				init_timing.tune_time = monotonic_time_ns() - phase_start_time;
+				phase_start_time = monotonic_time_ns();
 
 				if (device_cfg->tx_active)
 				{
 					//setup TX stream
 					if (device_cfg->debug_settings)
 						msg("sdr: Trying to setup TX stream...");
-					tx_stream = device->setupStream(SOAPY_SDR_TX, "CF32", vector<size_t>{(size_t)device_cfg->channel_tx});
+					tx_format = resolve_stream_format(SOAPY_SDR_TX, device_cfg->channels_tx[0]);
+					tx_converters = get_sample_converters(tx_format);
+					tx_native_stride = native_stride(device_cfg->buffer_size_tx, tx_format);
+					tx_native_samples.assign(device_cfg->channels_tx.size() * tx_native_stride, 0);
+
+					tx_stream = device->setupStream(SOAPY_SDR_TX, sample_format_to_str(tx_format), device_cfg->channels_tx);
 
 					if (tx_stream == nullptr)
 						throw(std::runtime_error("Unable to setup TX stream!"));
 					else if (device_cfg->debug_settings)
-						msg("sdr: TX stream has been successfully set up!");
+						msg("sdr: TX stream has been successfully set up (channels " + channels_to_str(device_cfg->channels_tx) + ", " + string(sample_format_to_str(tx_format)) + ", " + string(tx_converters.isa) + " conversion)!");
 				}
 
 				if (device_cfg->rx_active)
@@ -226,12 +343,17 @@ namespace sdr
 					//setup RX stream
 					if (device_cfg->debug_settings)
 						msg("sdr: Trying to setup RX stream...");
-					rx_stream = device->setupStream(SOAPY_SDR_RX, "CF32", vector<size_t>{(size_t)device_cfg->channel_rx});
+					rx_format = resolve_stream_format(SOAPY_SDR_RX, device_cfg->channels_rx[0]);
+					rx_converters = get_sample_converters(rx_format);
+					rx_native_stride = native_stride(device_cfg->buffer_size_rx, rx_format);
+					rx_native_samples.assign(device_cfg->channels_rx.size() * rx_native_stride, 0);
+
+					rx_stream = device->setupStream(SOAPY_SDR_RX, sample_format_to_str(rx_format), device_cfg->channels_rx);
 
 					if (rx_stream == nullptr)
 						throw(std::runtime_error("Unable to setup RX stream!"));
 					else if (device_cfg->debug_settings)
-						msg("sdr: RX stream has been successfully set up!");
+						msg("sdr: RX stream has been successfully set up (channels " + channels_to_str(device_cfg->channels_rx) + ", " + string(sample_format_to_str(rx_format)) + ", " + string(rx_converters.isa) + " conversion)!");
 				}
 
 				if (device_cfg->tx_active)
@@ -264,17 +386,68 @@ namespace sdr
 				}
 				*/
 
-				int mtu_tx = device->getStreamMTU(tx_stream);
-				int mtu_rx = device->getStreamMTU(rx_stream);
+				mtu_tx = device->getStreamMTU(tx_stream);
+				mtu_rx = device->getStreamMTU(rx_stream);
 
 				msg("sdr: mtu_tx=" + to_string(mtu_tx) + " [Sa], mtu_rx=" + to_string(mtu_rx) + " [Sa]");
 
+				if ((device_cfg->tx_active) && (mtu_tx > 0) && ((size_t)device_cfg->buffer_size_tx > mtu_tx))
+					msg("sdr: TX bursts longer than " + to_string(mtu_tx) + " [Sa] are going to be sent in chunks of MTU");
+				if ((device_cfg->rx_active) && (mtu_rx > 0) && ((size_t)device_cfg->buffer_size_rx > mtu_rx))
+					msg("sdr: RX bursts longer than " + to_string(mtu_rx) + " [Sa] are going to be received in chunks of MTU");
+
+				tx_direct = false;
+				rx_direct = false;
+
+				if (device_cfg->direct_buffers)
+				{
+					//continuously running RX flow is carved into windows by readStream, so it keeps the copy path
+					//TX holds a chunk back while it acquires the next one (see write_burst_direct), so it needs two buffers
+					tx_direct = device_cfg->tx_active && (device->getNumDirectAccessBuffers(tx_stream) > 1);
+					rx_direct = device_cfg->rx_active && !device_cfg->rx_continuous && (device->getNumDirectAccessBuffers(rx_stream) > 0);
+
+					if (device_cfg->tx_active)
+						msg(tx_direct ? "sdr: TX bursts are going to be written straight into driver buffers" : "sdr: TX stream does not support direct buffer access, falling back to copy path", tx_direct ? INFO : WARNING);
+					if (device_cfg->rx_active)
+						msg(rx_direct ? "sdr: RX bursts are going to be read straight out of driver buffers" : "sdr: RX stream does not support direct buffer access, falling back to copy path", rx_direct ? INFO : WARNING);
+				}
+
+				init_timing.stream_time = monotonic_time_ns() - phase_start_time;
+				phase_start_time = monotonic_time_ns();
+
 				init_successfull = true;
 
 				//reset hardware time
+				long long time_before_reset = device->getHardwareTime();
+
 				device->setHardwareTime(0);
 
-				usleep((int)(1e6*device_cfg->T_timeout));
+				wait_for_time_reset(time_before_reset);
+
+				init_timing.time_reset_time = monotonic_time_ns() - phase_start_time;
+
+				if ((device_cfg->rx_active) && (device_cfg->rx_continuous))
+				{
+					//activate RX stream just once, timed bursts are going to be carved out of the continuous sample flow
+					//(done after resetting hardware time, so timestamps of the flow are not going to jump)
+					if (device_cfg->debug_settings)
+						msg("sdr: Trying to activate RX stream in continuous mode...");
+
+					rx_gap_stride = native_stride(max((int64_t)mtu_rx, device_cfg->buffer_size_rx), rx_format);
+					rx_gap_samples.assign(device_cfg->channels_rx.size() * rx_gap_stride, 0);
+					rx_next_time_known = false;
+
+					int ret = device->activateStream(rx_stream);
+
+					if (ret != 0)
+						msg("sdr: Following problem occurred while activating RX stream: " + string(SoapySDR::errToStr(ret)), ERROR);
+					else if (device_cfg->debug_settings)
+						msg("sdr: RX stream has been successfully activated!");
+				}
+
+				init_timing.total_time = monotonic_time_ns() - init_start_time;
+
+				print_init_timing();
 			}
 			catch (const std::exception& e)
 			{
@@ -292,8 +465,126 @@ namespace sdr
 		while ((!stop) && (!init_successfull));
 	}
 
+	//numbers are cached with full precision, so read back values compare exactly
+	static string number_to_str(const double value)
+	{
+		char text[32];
+
+		snprintf(text, sizeof(text), "%.17g", value);
+
+		return text;
+	}
+
+	double SDR_Device_Wrapper::apply_setting(const std::string& key, const double value, const boost::function<void (double)>& set, const boost::function<double ()>& get)
+	{
+		return stod(apply_setting(key, number_to_str(value), [&](const string&) { set(value); }, [&]() { return number_to_str(get()); }));
+	}
+
+	std::string SDR_Device_Wrapper::apply_setting(const std::string& key, const std::string& value, const boost::function<void (const std::string&)>& set, const boost::function<std::string ()>& get)
+	{
+		string cached_actual;
+
+		//the device has to report the cached value, it may have been reset or reconfigured by someone else meanwhile
+		if ((init_cache) && (init_cache->lookup(serial, key, value, cached_actual)))
+		{
+			string actual = get();
+
+			if (actual == cached_actual)
+			{
+				if (device_cfg->debug_settings)
+					msg("sdr: " + key + " is already set to " + value + " (init cache), skipping it");
+
+				init_timing.no_of_skipped_settings++;
+
+				return actual;
+			}
+		}
+
+		set(value);
+
+		string actual = get();
+
+		if (init_cache)
+			init_cache->store(serial, key, value, actual);
+
+		init_timing.no_of_applied_settings++;
+
+		return actual;
+	}
+
+	void SDR_Device_Wrapper::wait_for_lo_locks(const std::vector<std::pair<int, size_t>>& tuned_channels)
+	{
+		vector<pair<int, size_t>> pending_channels;
+
+		//channels without LO lock sensor are taken as locked right away
+		for (const pair<int, size_t>& tuned_channel : tuned_channels)
+		{
+			vector<string> sensors = device->listSensors(tuned_channel.first, tuned_channel.second);
+
+			if (find(sensors.begin(), sensors.end(), "lo_locked") != sensors.end())
+				pending_channels.push_back(tuned_channel);
+			else
+				msg("sdr: " + string((tuned_channel.first == SOAPY_SDR_TX) ? "TX" : "RX") + " channel " + to_string(tuned_channel.second) + " has no LO lock sensor, not waiting for the lock", WARNING);
+		}
+
+		if (pending_channels.empty())
+			return;
+
+		msg("sdr: Waiting for LO lock on " + to_string(pending_channels.size()) + " channels...");
+
+		while ((!stop) && (!pending_channels.empty()))
+		{
+			for (vector<pair<int, size_t>>::iterator it = pending_channels.begin(); it != pending_channels.end(); )
+			{
+				if (device->readSensor(it->first, it->second, "lo_locked") == "true")
+				{
+					msg("sdr: " + string((it->first == SOAPY_SDR_TX) ? "TX" : "RX") + " LO lock detected on channel " + to_string(it->second) + "!");
+					it = pending_channels.erase(it);
+				}
+				else
+					it++;
+			}
+
+			if (!pending_channels.empty())
+			{
+				usleep(100);
+				signal_handler.get_io_service().poll();
+			}
+		}
+	}
+
+	void SDR_Device_Wrapper::wait_for_time_reset(const long long time_before_reset)
+	{
+		//the new time has been taken over once the time has gone back and it is running again, the timeout only
+		//bounds the wait for devices whose time does not behave like that
+		int64_t deadline = monotonic_time_ns() + (int64_t)(1e9 * device_cfg->T_timeout);
+		long long last_time = time_before_reset;
+		bool time_reset = false;
+
+		while ((!stop) && (monotonic_time_ns() < deadline))
+		{
+			long long time = device->getHardwareTime();
+
+			if ((time_reset) && (time > last_time))
+				return;
+
+			if ((time < time_before_reset) || (time_before_reset <= 0))
+				time_reset = true;
+
+			last_time = time;
+
+			usleep(100);
+		}
+
+		if (!stop)
+			msg("sdr: hardware time has not been seen running from 0 within " + to_string(device_cfg->T_timeout) + " [s]", WARNING);
+	}
+
 	SDR_Device_Wrapper::~SDR_Device_Wrapper()
 	{
+		if (clock_tracker)
+			clock_tracker->stop();
+
 		if (device != nullptr)
 		{
 			if ((device_cfg->tx_active) && (tx_stream != nullptr))
@@ -330,248 +621,745 @@ namespace sdr
 		}
 	}
 
-	bool SDR_Device_Wrapper::send_samples(const int64_t tick, const std::complex<float>* samples, int no_of_requested_samples, const bool ack)
+	bool SDR_Device_Wrapper::send_samples(const int64_t tick, const std::complex<float>* const* samples, int no_of_requested_samples, const bool ack)
 	{
 		bool res = false;
 
 		//this is just a little tweak for a case where we actually do not want any samples to be transmitted
 		//but still would like this call to block (i.e. wait for a given tick on a device)
 		//to achieve that we are going to request transmission of a single zero sample at given tick
-		std::vector<std::complex<float>> empty_buf(1, {0, 0});
 		if (no_of_requested_samples <= 0)
 		{
-			samples = &empty_buf[0];
-			no_of_requested_samples = empty_buf.size();
+			for (size_t c = 0; c < tx_channel_samples.size(); c++)
+				tx_channel_samples[c] = &tx_zero_samples[0];
+
+			samples = &tx_channel_samples[0];
+			no_of_requested_samples = tx_zero_samples.size();
 		}
 
-		string tx_verbose_msg = "[TX] ";
+		tx_status.submit_host_time = monotonic_time_ns();
+		tx_status.tick = tick;
+		tx_status.burst_time = SoapySDR::ticksToTimeNs(tick, device_cfg->f_clk);
+		tx_status.current_time = get_hardware_time();
+		tx_status.no_of_requested_samples = no_of_requested_samples;
+		tx_status.stream_status = 0;
 
-		long long int burst_time = SoapySDR::ticksToTimeNs(tick, device_cfg->f_clk);
-		int64_t current_time = device->getHardwareTime();
-		//int64_t current_tick = SoapySDR::timeNsToTicks(current_time, device_cfg->f_clk);
-		tx_verbose_msg += " current_time=" + to_string(current_time) + ", burst_time: " + to_string(burst_time);
+		//samples of other formats are converted into the scratch buffer first, it is sized for buffer_size_tx samples
+		//bursts that do not fit into it are failed without touching the stream, so they are traced and counted as such
+		if ((!tx_direct) && (tx_format != FORMAT_CF32) && ((size_t)no_of_requested_samples * sample_format_size(tx_format) > tx_native_stride))
+		{
+			msgf(ERROR, "sdr: [TX]  burst of %d samples exceeds TX buffer size", no_of_requested_samples);
 
-		const vector<void*> buffs(1, (void*)samples);
-		const void* const* buffs_ptr = &buffs[0];
+			tx_status.flags = 0;
+			tx_status.no_of_chunks = 0;
+			tx_status.no_of_transferred_samples = SOAPY_SDR_NOT_SUPPORTED;
+		}
+		else if (tx_direct)
+			tx_status.no_of_transferred_samples = write_burst_direct(samples, no_of_requested_samples);
+		else
+		{
+			if (tx_format != FORMAT_CF32)
+			{
+				for (size_t c = 0; c < tx_buffs.size(); c++)
+				{
+					tx_converters.to_native(samples[c], &tx_native_samples[c * tx_native_stride], no_of_requested_samples);
+					tx_buffs[c] = &tx_native_samples[c * tx_native_stride];
+				}
+			}
+			else
+			{
+				for (size_t c = 0; c < tx_buffs.size(); c++)
+					tx_buffs[c] = samples[c];
+			}
 
-		int flags = SOAPY_SDR_HAS_TIME | SOAPY_SDR_END_BURST | SOAPY_SDR_ONE_PACKET;
+			tx_status.no_of_transferred_samples = write_burst(no_of_requested_samples);
+		}
 
-		int no_of_transmitted_samples = device->writeStream
-		(
-			tx_stream,
-			buffs_ptr,
-			no_of_requested_samples,
-			flags,
-			burst_time,
-			1e6 * device_cfg->T_timeout
-		);
+		if (tx_status.no_of_transferred_samples != no_of_requested_samples)
+		{
+			msgf
+			(
+				WARNING,
+				"sdr: [TX]  current_time=%lld, burst_time: %lld, write_code: %s, no_of_transmitted_samples: %d/%d",
+				tx_status.current_time,
+				tx_status.burst_time,
+				code_to_str(tx_status.no_of_transferred_samples),
+				tx_status.no_of_transferred_samples,
+				no_of_requested_samples
+			);
+
+			if (tx_status.no_of_transferred_samples < 0)
+				tx_status.stream_status = tx_status.no_of_transferred_samples;
 
-		if (no_of_transmitted_samples != no_of_requested_samples)
+			res = false;
+		}
+		else if (!ack)
 		{
-			tx_verbose_msg += ", write_code: ";
+			msgf
+			(
+				INFO,
+				"sdr: [TX]  current_time=%lld, burst_time: %lld, no_of_transmitted_samples: %d/%d",
+				tx_status.current_time,
+				tx_status.burst_time,
+				tx_status.no_of_transferred_samples,
+				no_of_requested_samples
+			);
+			res = true;
+		}
+		else
+		{
+			size_t chan_mask = tx_chan_mask;
+			int flags = 0;
+
+			tx_status.status_time = tx_status.burst_time;
+
+			tx_status.stream_status = device->readStreamStatus
+			(
+				tx_stream,
+				chan_mask,
+				flags,
+				tx_status.status_time,
+				1e6 * device_cfg->T_timeout
+			);
+
+			tx_status.flags = flags;
+
+			res = (tx_status.stream_status == 0);
+
+			msgf
+			(
+				res ? INFO : WARNING,
+				"sdr: [TX]  current_time=%lld, burst_time: %lld, ack_code: %s, no_of_transmitted_samples: %d/%d",
+				tx_status.current_time,
+				tx_status.burst_time,
+				code_to_str(tx_status.stream_status),
+				tx_status.no_of_transferred_samples,
+				no_of_requested_samples
+			);
+		}
 
-			switch (no_of_transmitted_samples)
-			{
-				case SOAPY_SDR_TIMEOUT:
-					tx_verbose_msg += "SOAPY_SDR_TIMEOUT";
-					break;
-				case SOAPY_SDR_STREAM_ERROR:
-					tx_verbose_msg += "SOAPY_SDR_STREAM_ERROR";
-					break;
-				case SOAPY_SDR_CORRUPTION:
-					tx_verbose_msg += "SOAPY_SDR_CORRUPTION";
-					break;
-				case SOAPY_SDR_OVERFLOW:
-					tx_verbose_msg += "SOAPY_SDR_OVERFLOW";
-					break;
-				case SOAPY_SDR_NOT_SUPPORTED:
-					tx_verbose_msg += "SOAPY_SDR_NOT_SUPPORTED";
-					break;
-				case SOAPY_SDR_END_BURST:
-					tx_verbose_msg += "SOAPY_SDR_END_BURST";
-					break;
-				case SOAPY_SDR_TIME_ERROR:
-					tx_verbose_msg += "SOAPY_SDR_TIME_ERROR";
-					break;
-				case SOAPY_SDR_UNDERFLOW:
-					tx_verbose_msg += "SOAPY_SDR_UNDERFLOW";
-					break;
-			}
+		tx_status.return_host_time = monotonic_time_ns();
 
-			tx_verbose_msg += (boost::format(", no_of_transmitted_samples: %u/%u") % no_of_transmitted_samples % no_of_requested_samples).str();
-			msg("sdr: " + tx_verbose_msg, WARNING);
-			res = false;
+		if (trace_recorder)
+			trace_burst(TRACE_TX, tx_status);
+
+		if (metrics)
+		{
+			//bursts with a deferred ack are counted once, when their ack retires them (see TX_Pipeline)
+			if (ack)
+				(res ? metrics->tx_bursts : metrics->tx_failed_bursts).add();
+
+			metrics->count_code(SOAPY_SDR_TX, (tx_status.no_of_transferred_samples < 0) ? tx_status.no_of_transferred_samples : tx_status.stream_status);
+
+			//hardware time read just before writeStream maps the end of the burst onto host clock
+			if (res && ack)
+				metrics->tx_ack_latency.observe(tx_status.return_host_time - tx_status.submit_host_time - (tx_status.burst_time + SoapySDR::ticksToTimeNs((int64_t)no_of_requested_samples * device_cfg->D_tx, device_cfg->f_clk) - tx_status.current_time));
 		}
+
+		return res;
+	}
+
+	bool SDR_Device_Wrapper::send_samples(const int64_t tick, const std::complex<float>* samples, int no_of_requested_samples, const bool ack)
+	{
+		for (size_t c = 0; c < tx_channel_samples.size(); c++)
+			tx_channel_samples[c] = samples;
+
+		return send_samples(tick, &tx_channel_samples[0], no_of_requested_samples, ack);
+	}
+
+	void SDR_Device_Wrapper::send_samples_void(bool& success, const int64_t tick, const std::complex<float>* samples, int no_of_requested_samples, const bool ack)
+	{
+		success = send_samples(tick, samples, no_of_requested_samples, ack);
+	}
+
+	bool SDR_Device_Wrapper::receive_samples(const int64_t tick, std::complex<float>* const* samples, int no_of_requested_samples)
+	{
+		return receive_burst(tick, samples, no_of_requested_samples, nullptr);
+	}
+
+	bool SDR_Device_Wrapper::receive_samples_in_place(const int64_t tick, int no_of_requested_samples, const rx_chunk_handler_t& handler)
+	{
+		//burst that does not fit into the buffer is handed over without one, receive_burst fails it
+		if ((!rx_in_place_samples) || (no_of_requested_samples > (int)rx_in_place_samples->get_no_of_samples()))
+			return receive_burst(tick, nullptr, no_of_requested_samples, &handler);
+
+		return receive_burst(tick, rx_in_place_samples->get(), no_of_requested_samples, &handler);
+	}
+
+	bool SDR_Device_Wrapper::receive_burst(const int64_t tick, std::complex<float>* const* samples, int no_of_requested_samples, const rx_chunk_handler_t* handler)
+	{
+		bool res = false;
+		const bool fits = (samples != nullptr);
+
+		if (fits && (no_of_requested_samples <= 0))
+		{
+			for (size_t c = 0; c < rx_channel_samples.size(); c++)
+				rx_channel_samples[c] = &rx_zero_samples[0];
+
+			samples = &rx_channel_samples[0];
+			no_of_requested_samples = rx_zero_samples.size();
+		}
+
+		rx_status.submit_host_time = monotonic_time_ns();
+		rx_status.tick = tick;
+		rx_status.burst_time = SoapySDR::ticksToTimeNs(tick, device_cfg->f_clk);
+		rx_status.current_time = get_hardware_time();
+		rx_status.no_of_requested_samples = no_of_requested_samples;
+
+		//samples of other formats are received into the scratch buffer and converted afterwards
+		//bursts that do not fit into the buffers are failed without touching the stream, so they are traced and counted as such
+		if ((!fits) || ((!rx_direct) && (rx_format != FORMAT_CF32) && ((size_t)no_of_requested_samples * sample_format_size(rx_format) > rx_native_stride)))
+		{
+			msgf(ERROR, "sdr: [RX]  burst of %d samples exceeds RX buffer size", no_of_requested_samples);
+
+			rx_status.flags = 0;
+			rx_status.no_of_chunks = 0;
+			rx_status.no_of_transferred_samples = SOAPY_SDR_NOT_SUPPORTED;
+		}
+		else if (rx_direct)
+			rx_status.no_of_transferred_samples = read_burst_direct(samples, no_of_requested_samples, handler);
 		else
 		{
-			if (!ack)
+			if (rx_format != FORMAT_CF32)
 			{
-				tx_verbose_msg += (boost::format(", no_of_transmitted_samples: %u/%u") % no_of_transmitted_samples % no_of_requested_samples).str();
-				msg(tx_verbose_msg);
-				res = true;
+				for (size_t c = 0; c < rx_targets.size(); c++)
+					rx_targets[c] = &rx_native_samples[c * rx_native_stride];
 			}
 			else
 			{
-				tx_verbose_msg += ", ack_code: ";
+				for (size_t c = 0; c < rx_targets.size(); c++)
+					rx_targets[c] = samples[c];
+			}
 
-				size_t chan_mask = (1 << device_cfg->channel_tx);
+			if (device_cfg->rx_continuous)
+				rx_status.no_of_transferred_samples = read_continuous_window(&rx_targets[0], no_of_requested_samples);
+			else
+				rx_status.no_of_transferred_samples = read_burst(no_of_requested_samples);
 
-				int stream_status = device->readStreamStatus
-				(
-					tx_stream,
-					chan_mask,
-					flags,
-					burst_time,
-					1e6 * device_cfg->T_timeout
-				);
+			if ((rx_format != FORMAT_CF32) && (rx_status.no_of_transferred_samples > 0))
+			{
+				for (size_t c = 0; c < rx_targets.size(); c++)
+					rx_converters.from_native(rx_targets[c], samples[c], rx_status.no_of_transferred_samples);
+			}
 
-				switch(stream_status)
-				{
-					case SOAPY_SDR_TIMEOUT:
-						tx_verbose_msg += "SOAPY_SDR_TIMEOUT";
-						break;
-					case SOAPY_SDR_STREAM_ERROR:
-						tx_verbose_msg += "SOAPY_SDR_STREAM_ERROR";
-						break;
-					case SOAPY_SDR_CORRUPTION:
-						tx_verbose_msg += "SOAPY_SDR_CORRUPTION";
-						break;
-					case SOAPY_SDR_OVERFLOW:
-						tx_verbose_msg += "SOAPY_SDR_OVERFLOW";
-						break;
-					case SOAPY_SDR_NOT_SUPPORTED:
-						tx_verbose_msg += "SOAPY_SDR_NOT_SUPPORTED";
-						break;
-					case SOAPY_SDR_END_BURST:
-						tx_verbose_msg += "SOAPY_SDR_END_BURST";
-						break;
-					case SOAPY_SDR_TIME_ERROR:
-						tx_verbose_msg += "SOAPY_SDR_TIME_ERROR";
-						break;
-					case SOAPY_SDR_UNDERFLOW:
-						tx_verbose_msg += "SOAPY_SDR_UNDERFLOW";
-						break;
-					default:
-						tx_verbose_msg += "NO_ERROR";
-						break;
-				}
+			//consumer of the copy path gets the whole burst at once
+			if (handler && (rx_status.no_of_transferred_samples > 0))
+				(*handler)(samples, 0, rx_status.no_of_transferred_samples);
+		}
 
-				tx_verbose_msg += (boost::format(", no_of_transmitted_samples: %u/%u") % no_of_transmitted_samples % no_of_requested_samples).str();
+		rx_status.stream_status = (rx_status.no_of_transferred_samples < 0) ? rx_status.no_of_transferred_samples : 0;
 
-				if ((stream_status == 0) && (no_of_transmitted_samples == no_of_requested_samples))
-				{
-					msg("sdr: " + tx_verbose_msg);
-					res = true;
-				}
-				else
-				{
-					msg("sdr: " + tx_verbose_msg, WARNING);
-					res = false;
-				}
-			}
+		res = (rx_status.no_of_transferred_samples == no_of_requested_samples);
+
+		msgf
+		(
+			res ? INFO : WARNING,
+			"sdr: [RX]  current_time=%lld, burst_time: %lld, read_code: %s, no_of_received_samples: %d/%d",
+			rx_status.current_time,
+			rx_status.burst_time,
+			code_to_str(rx_status.stream_status),
+			rx_status.no_of_transferred_samples,
+			no_of_requested_samples
+		);
+
+		rx_status.return_host_time = monotonic_time_ns();
+
+		if (trace_recorder)
+			trace_burst(TRACE_RX, rx_status);
+
+		if (metrics)
+		{
+			(res ? metrics->rx_bursts : metrics->rx_failed_bursts).add();
+			metrics->count_code(SOAPY_SDR_RX, rx_status.stream_status);
 		}
 
 		return res;
 	}
 
-	void SDR_Device_Wrapper::send_samples_void(bool& success, const int64_t tick, const std::complex<float>* samples, int no_of_requested_samples, const bool ack)
+	sample_format_t SDR_Device_Wrapper::resolve_stream_format(const int direction, const size_t channel)
 	{
-		success = send_samples(tick, samples, no_of_requested_samples, ack);
+		const string name = (direction == SOAPY_SDR_TX) ? "TX" : "RX";
+		string format = device_cfg->stream_format;
+
+		if (format == "native")
+		{
+			double full_scale;
+			format = device->getNativeStreamFormat(direction, channel, full_scale);
+		}
+
+		vector<string> supported_formats = device->getStreamFormats(direction, channel);
+
+		try
+		{
+			sample_format_t res = parse_sample_format(format);
+
+			if (find(supported_formats.begin(), supported_formats.end(), format) != supported_formats.end())
+				return res;
+
+			msg("sdr: Device does not support " + format + " " + name + " stream format, CF32 is going to be used instead", WARNING);
+		}
+		catch (const std::invalid_argument& e)
+		{
+			msg("sdr: " + string(e.what()) + ", CF32 is going to be used for " + name + " stream instead", WARNING);
+		}
+
+		return FORMAT_CF32;
 	}
 
-	bool SDR_Device_Wrapper::receive_samples(const int64_t tick, std::complex<float>* samples, int no_of_requested_samples)
+	int SDR_Device_Wrapper::write_burst(const int no_of_requested_samples)
 	{
-		bool res = false;
+		const long timeout_us = 1e6 * device_cfg->T_timeout;
 
-		std::vector<std::complex<float>> buf(1, {0, 0});
+		tx_status.no_of_chunks = 1;
 
-		if (no_of_requested_samples <= 0)
+		//burst that fits into a single packet is written by a single call
+		if ((mtu_tx == 0) || ((size_t)no_of_requested_samples <= mtu_tx))
 		{
-			samples = &buf[0];
-			no_of_requested_samples = buf.size();
+			int flags = SOAPY_SDR_HAS_TIME | SOAPY_SDR_END_BURST | SOAPY_SDR_ONE_PACKET;
+
+			int ret = device->writeStream(tx_stream, &tx_buffs[0], no_of_requested_samples, flags, tx_status.burst_time, timeout_us);
+
+			tx_status.flags = flags;
+
+			return ret;
 		}
 
-		string rx_verbose_msg = "[RX] ";
+		const size_t sample_size = sample_format_size(tx_format);
+
+		int no_of_written_samples = 0;
+
+		tx_status.no_of_chunks = 0;
+
+		//chunks follow each other right away, so the device gets the whole burst without gaps - only the first one
+		//carries the burst time and only the last one ends the burst (also when the device takes less than a chunk)
+		while (no_of_written_samples < no_of_requested_samples)
+		{
+			const int no_of_samples_to_write = min((int)mtu_tx, no_of_requested_samples - no_of_written_samples);
+
+			int flags = 0;
+
+			if (no_of_written_samples == 0)
+				flags |= SOAPY_SDR_HAS_TIME;
+			if (no_of_written_samples + no_of_samples_to_write == no_of_requested_samples)
+				flags |= SOAPY_SDR_END_BURST;
+
+			for (size_t c = 0; c < tx_chunk_buffs.size(); c++)
+				tx_chunk_buffs[c] = static_cast<const char*>(tx_buffs[c]) + no_of_written_samples * sample_size;
+
+			int ret = device->writeStream(tx_stream, &tx_chunk_buffs[0], no_of_samples_to_write, flags, tx_status.burst_time, timeout_us);
+
+			tx_status.flags = flags;
+			tx_status.no_of_chunks++;
+
+			if (ret <= 0)
+			{
+				//burst that has been started is closed, so the device does not wait for the rest of it
+				if (no_of_written_samples > 0)
+				{
+					int end_flags = SOAPY_SDR_END_BURST;
+					device->writeStream(tx_stream, &tx_chunk_buffs[0], 0, end_flags, 0, timeout_us);
+				}
+
+				return (ret < 0) ? ret : SOAPY_SDR_TIMEOUT;
+			}
+
+			no_of_written_samples += ret;
+		}
 
-		int64_t burst_time = SoapySDR::ticksToTimeNs(tick, device_cfg->f_clk);
-		int64_t current_time = device->getHardwareTime();
-		//int64_t current_tick = SoapySDR::timeNsToTicks(current_time, device_cfg->f_clk);
-		rx_verbose_msg += " current_time=" + to_string(current_time) + ", burst_time: " + to_string(burst_time);
+		return no_of_written_samples;
+	}
 
-		vector<void*> buffs(1, (void*)samples);
-		void* const* buffs_ptr = &buffs[0];
+	int SDR_Device_Wrapper::read_burst(const int no_of_requested_samples)
+	{
+		const double sampling_rate = device_cfg->f_clk / (double)device_cfg->D_rx;
+		const size_t sample_size = sample_format_size(rx_format);
+		const long timeout_us = 1e6 * device_cfg->T_timeout;
+		const bool single_packet = (mtu_rx == 0) || ((size_t)no_of_requested_samples <= mtu_rx);
 
-		int ret = device->activateStream(rx_stream, SOAPY_SDR_HAS_TIME | SOAPY_SDR_END_BURST | SOAPY_SDR_ONE_PACKET, burst_time, no_of_requested_samples);
+		int ret = device->activateStream(rx_stream, SOAPY_SDR_HAS_TIME | SOAPY_SDR_END_BURST | (single_packet ? SOAPY_SDR_ONE_PACKET : 0), rx_status.burst_time, no_of_requested_samples);
 
 		if (ret != 0)
-			msg("sdr: Following problem occurred while activating RX stream: " + string(SoapySDR::errToStr(ret)), ERROR);
+			msgf(ERROR, "sdr: Following problem occurred while activating RX stream: %s", SoapySDR::errToStr(ret));
 
-		int read_flags;
-		long long int read_time;
+		int no_of_received_samples = 0;
 
-		int no_of_received_samples = device->readStream
-		(
-			rx_stream,
-			buffs_ptr,
-			no_of_requested_samples,
-			read_flags,
-			read_time,
-			1e6 * device_cfg->T_timeout
-		);
+		rx_status.no_of_chunks = 0;
+
+		//chunks are reassembled in place, every one of them has to start right where the previous one ended
+		while (no_of_received_samples < no_of_requested_samples)
+		{
+			for (size_t c = 0; c < rx_chunk_buffs.size(); c++)
+				rx_chunk_buffs[c] = static_cast<char*>(rx_targets[c]) + no_of_received_samples * sample_size;
+
+			int read_flags = 0;
+			long long read_time = 0;
+
+			ret = device->readStream
+			(
+				rx_stream,
+				&rx_chunk_buffs[0],
+				no_of_requested_samples - no_of_received_samples,
+				read_flags,
+				read_time,
+				timeout_us
+			);
+
+			rx_status.flags = read_flags;
+			rx_status.no_of_chunks++;
+
+			if (ret <= 0)
+				return (ret < 0) ? ret : SOAPY_SDR_TIMEOUT;
+
+			if (no_of_received_samples == 0)
+				rx_status.status_time = read_time;
+			else if ((read_flags & SOAPY_SDR_HAS_TIME) && (SoapySDR::timeNsToTicks(read_time - rx_status.status_time, sampling_rate) != no_of_received_samples))
+			{
+				msgf
+				(
+					WARNING,
+					"sdr: [RX]  chunk %d of burst %lld starts at %lld instead of %lld",
+					rx_status.no_of_chunks,
+					rx_status.burst_time,
+					read_time,
+					rx_status.status_time + SoapySDR::ticksToTimeNs(no_of_received_samples, sampling_rate)
+				);
+
+				return SOAPY_SDR_CORRUPTION;
+			}
 
-		rx_verbose_msg += ", read_code: ";
+			no_of_received_samples += ret;
 
-		if (no_of_received_samples == no_of_requested_samples)
+			//device ended the burst early
+			if ((read_flags & SOAPY_SDR_END_BURST) && (no_of_received_samples < no_of_requested_samples))
+				break;
+		}
+
+		return no_of_received_samples;
+	}
+
+	int SDR_Device_Wrapper::write_burst_direct(const std::complex<float>* const* samples, const int no_of_requested_samples)
+	{
+		const long timeout_us = 1e6 * device_cfg->T_timeout;
+
+		int no_of_written_samples = 0;
+
+		//chunk filled last is held back until the next driver buffer has been acquired, so a burst whose next
+		//buffer cannot be acquired is still ended through the direct access API by releasing the held one
+		size_t held_handle = 0;
+		int no_of_held_samples = 0;
+		int held_flags = 0;
+
+		tx_status.no_of_chunks = 0;
+
+		//every driver buffer is a chunk of the burst, samples are converted (or copied for CF32) right into it
+		//and handed back to the driver without passing through the scratch buffer
+		while (no_of_written_samples < no_of_requested_samples)
 		{
-			rx_verbose_msg += "NO_ERROR";
+			size_t handle = 0;
+
+			int ret = device->acquireWriteBuffer(tx_stream, handle, &tx_direct_buffs[0], timeout_us);
+
+			if (ret <= 0)
+			{
+				//burst that has been started is closed, so the device does not wait for the rest of it
+				if (no_of_held_samples > 0)
+				{
+					held_flags |= SOAPY_SDR_END_BURST;
+					device->releaseWriteBuffer(tx_stream, held_handle, no_of_held_samples, held_flags, tx_status.burst_time);
+
+					tx_status.flags = held_flags;
+					tx_status.no_of_chunks++;
+				}
+
+				return (ret < 0) ? ret : SOAPY_SDR_TIMEOUT;
+			}
+
+			if (no_of_held_samples > 0)
+			{
+				device->releaseWriteBuffer(tx_stream, held_handle, no_of_held_samples, held_flags, tx_status.burst_time);
+
+				tx_status.flags = held_flags;
+				tx_status.no_of_chunks++;
+			}
+
+			const int no_of_samples_to_write = min(ret, no_of_requested_samples - no_of_written_samples);
+
+			for (size_t c = 0; c < tx_direct_buffs.size(); c++)
+			{
+				if (tx_format != FORMAT_CF32)
+					tx_converters.to_native(samples[c] + no_of_written_samples, tx_direct_buffs[c], no_of_samples_to_write);
+				else
+					memcpy(tx_direct_buffs[c], samples[c] + no_of_written_samples, no_of_samples_to_write * sizeof(std::complex<float>));
+			}
+
+			held_handle = handle;
+			no_of_held_samples = no_of_samples_to_write;
+			held_flags = 0;
+
+			if (no_of_written_samples == 0)
+				held_flags |= SOAPY_SDR_HAS_TIME;
+
+			no_of_written_samples += no_of_samples_to_write;
 		}
-		else
+
+		//last chunk ends the burst
+		held_flags |= SOAPY_SDR_END_BURST;
+		device->releaseWriteBuffer(tx_stream, held_handle, no_of_held_samples, held_flags, tx_status.burst_time);
+
+		tx_status.flags = held_flags;
+		tx_status.no_of_chunks++;
+
+		return no_of_written_samples;
+	}
+
+	int SDR_Device_Wrapper::read_burst_direct(std::complex<float>* const* samples, const int no_of_requested_samples, const rx_chunk_handler_t* handler)
+	{
+		const double sampling_rate = device_cfg->f_clk / (double)device_cfg->D_rx;
+		const long timeout_us = 1e6 * device_cfg->T_timeout;
+		const bool single_packet = (mtu_rx == 0) || ((size_t)no_of_requested_samples <= mtu_rx);
+
+		int ret = device->activateStream(rx_stream, SOAPY_SDR_HAS_TIME | SOAPY_SDR_END_BURST | (single_packet ? SOAPY_SDR_ONE_PACKET : 0), rx_status.burst_time, no_of_requested_samples);
+
+		if (ret != 0)
+			msgf(ERROR, "sdr: Following problem occurred while activating RX stream: %s", SoapySDR::errToStr(ret));
+
+		int no_of_received_samples = 0;
+
+		rx_status.no_of_chunks = 0;
+
+		//every driver buffer is a chunk of the burst, it has to start right where the previous one ended, CF32 chunks
+		//are consumed by the handler right in the driver buffer, others are converted into samples first
+		while (no_of_received_samples < no_of_requested_samples)
 		{
-			switch (no_of_received_samples)
+			size_t handle = 0;
+			int read_flags = 0;
+			long long read_time = 0;
+
+			ret = device->acquireReadBuffer(rx_stream, handle, &rx_direct_buffs[0], read_flags, read_time, timeout_us);
+
+			rx_status.flags = read_flags;
+			rx_status.no_of_chunks++;
+
+			if (ret <= 0)
+				return (ret < 0) ? ret : SOAPY_SDR_TIMEOUT;
+
+			if (no_of_received_samples == 0)
+				rx_status.status_time = read_time;
+			else if ((read_flags & SOAPY_SDR_HAS_TIME) && (SoapySDR::timeNsToTicks(read_time - rx_status.status_time, sampling_rate) != no_of_received_samples))
 			{
-				case SOAPY_SDR_TIMEOUT:
-					rx_verbose_msg += "SOAPY_SDR_TIMEOUT";
-					break;
-				case SOAPY_SDR_STREAM_ERROR:
-					rx_verbose_msg += "SOAPY_SDR_STREAM_ERROR";
-					break;
-				case SOAPY_SDR_CORRUPTION:
-					rx_verbose_msg += "SOAPY_SDR_CORRUPTION";
-					break;
-				case SOAPY_SDR_OVERFLOW:
-					rx_verbose_msg += "SOAPY_SDR_OVERFLOW";
-					break;
-				case SOAPY_SDR_NOT_SUPPORTED:
-					rx_verbose_msg += "SOAPY_SDR_NOT_SUPPORTED";
-					break;
-				case SOAPY_SDR_END_BURST:
-					rx_verbose_msg += "SOAPY_SDR_END_BURST";
-					break;
-				case SOAPY_SDR_TIME_ERROR:
-					rx_verbose_msg += "SOAPY_SDR_TIME_ERROR";
-					break;
-				case SOAPY_SDR_UNDERFLOW:
-					rx_verbose_msg += "SOAPY_SDR_UNDERFLOW";
-					break;
-				default:
-					rx_verbose_msg += "NO_ERROR";
+				msgf
+				(
+					WARNING,
+					"sdr: [RX]  chunk %d of burst %lld starts at %lld instead of %lld",
+					rx_status.no_of_chunks,
+					rx_status.burst_time,
+					read_time,
+					rx_status.status_time + SoapySDR::ticksToTimeNs(no_of_received_samples, sampling_rate)
+				);
+
+				device->releaseReadBuffer(rx_stream, handle);
+
+				return SOAPY_SDR_CORRUPTION;
+			}
+
+			//samples past the requested ones (driver buffers are not sized by the burst) are dropped
+			const int no_of_chunk_samples = min(ret, no_of_requested_samples - no_of_received_samples);
+
+			if (handler && (rx_format == FORMAT_CF32))
+			{
+				for (size_t c = 0; c < rx_in_place_chunk.size(); c++)
+					rx_in_place_chunk[c] = static_cast<const std::complex<float>*>(rx_direct_buffs[c]);
+
+				(*handler)(&rx_in_place_chunk[0], no_of_received_samples, no_of_chunk_samples);
+			}
+			else
+			{
+				for (size_t c = 0; c < rx_direct_buffs.size(); c++)
+				{
+					if (rx_format != FORMAT_CF32)
+						rx_converters.from_native(rx_direct_buffs[c], samples[c] + no_of_received_samples, no_of_chunk_samples);
+					else
+						memcpy(samples[c] + no_of_received_samples, rx_direct_buffs[c], no_of_chunk_samples * sizeof(std::complex<float>));
+
+					rx_in_place_chunk[c] = samples[c] + no_of_received_samples;
+				}
+
+				if (handler)
+					(*handler)(&rx_in_place_chunk[0], no_of_received_samples, no_of_chunk_samples);
 			}
+
+			device->releaseReadBuffer(rx_stream, handle);
+
+			no_of_received_samples += no_of_chunk_samples;
+
+			//device ended the burst early
+			if ((read_flags & SOAPY_SDR_END_BURST) && (no_of_received_samples < no_of_requested_samples))
+				break;
 		}
 
-		rx_verbose_msg += (boost::format(", no_of_received_samples: %u/%u") % no_of_received_samples % no_of_requested_samples).str();
+		return no_of_received_samples;
+	}
+
+	int SDR_Device_Wrapper::read_continuous_window(void* const* samples, int no_of_requested_samples)
+	{
+		const double sampling_rate = device_cfg->f_clk / (double)device_cfg->D_rx;
+		const size_t sample_size = sample_format_size(rx_format);
+		const long long window_time = rx_status.burst_time;
+		const long long half_sample_time = 500000000 / sampling_rate;
+
+		//requested window time usually falls between samples of the flow, so it is moved onto their grid as soon as
+		//the flow position is known - chunk timestamps are then compared against times on the grid only
+		long long window_start_time = window_time;
+		bool window_start_on_grid = false;
 
-		if (no_of_received_samples == no_of_requested_samples)
+		int no_of_received_samples = 0;
+		int no_of_overflows = 0;
+
+		rx_status.no_of_chunks = 0;
+
+		while (no_of_received_samples < no_of_requested_samples)
 		{
-			msg("sdr: " + rx_verbose_msg);
-			res = true;
+			size_t no_of_samples_to_read;
+			bool gap = false;
+
+			//samples preceding the window are read into the gap buffer in chunks sized so that the last one
+			//ends exactly at the window start - samples of the window then land directly in the caller's buffer
+			if ((no_of_received_samples == 0) && rx_next_time_known && (rx_next_time < window_start_time))
+			{
+				if (!window_start_on_grid)
+				{
+					window_start_time = rx_next_time + SoapySDR::ticksToTimeNs(SoapySDR::timeNsToTicks(window_time - rx_next_time, sampling_rate), sampling_rate);
+					window_start_on_grid = true;
+				}
+
+				long long no_of_gap_samples = SoapySDR::timeNsToTicks(window_start_time - rx_next_time, sampling_rate);
+
+				if (no_of_gap_samples > 0)
+				{
+					gap = true;
+					no_of_samples_to_read = min((size_t)no_of_gap_samples, rx_gap_stride / sample_size);
+
+					for (size_t c = 0; c < rx_buffs.size(); c++)
+						rx_buffs[c] = &rx_gap_samples[c * rx_gap_stride];
+				}
+			}
+
+			if (!gap)
+			{
+				no_of_samples_to_read = no_of_requested_samples - no_of_received_samples;
+
+				for (size_t c = 0; c < rx_buffs.size(); c++)
+					rx_buffs[c] = static_cast<char*>(samples[c]) + no_of_received_samples * sample_size;
+			}
+
+			int read_flags = 0;
+			long long read_time = 0;
+
+			int ret = device->readStream
+			(
+				rx_stream,
+				&rx_buffs[0],
+				no_of_samples_to_read,
+				read_flags,
+				read_time,
+				1e6 * device_cfg->T_timeout
+			);
+
+			rx_status.flags = read_flags;
+			rx_status.no_of_chunks++;
+
+			if (ret < 0)
+			{
+				//position within the flow is lost after an overflow, it will be recovered from the next timestamp
+				rx_next_time_known = false;
+				window_start_time = window_time;
+				window_start_on_grid = false;
+
+				//samples of the window received so far would not be followed by the ones right after them, while
+				//overflows ahead of the window are read past, unless they keep coming
+				if ((ret == SOAPY_SDR_OVERFLOW) && (no_of_received_samples == 0) && (++no_of_overflows <= MAX_NO_OF_WINDOW_OVERFLOWS) && !utils::stop)
+					continue;
+
+				return ret;
+			}
+
+			long long chunk_time = (read_flags & SOAPY_SDR_HAS_TIME) ? read_time : rx_next_time;
+
+			if (!(read_flags & SOAPY_SDR_HAS_TIME) && !rx_next_time_known)
+				return SOAPY_SDR_TIME_ERROR;
+
+			const long long expected_chunk_time = rx_next_time;
+
+			rx_next_time = chunk_time + SoapySDR::ticksToTimeNs(ret, sampling_rate);
+			rx_next_time_known = true;
+
+			if (gap)
+				continue;
+
+			if (no_of_received_samples == 0)
+			{
+				long long offset = SoapySDR::timeNsToTicks(chunk_time - window_start_time, sampling_rate);
+
+				//window start has already been consumed from the flow
+				if (offset > 0)
+					return SOAPY_SDR_TIME_ERROR;
+
+				if (!window_start_on_grid)
+				{
+					window_start_time = chunk_time + SoapySDR::ticksToTimeNs(-offset, sampling_rate);
+					window_start_on_grid = true;
+				}
+
+				//position of the flow was not known before this read, so the part preceding the window has to be dropped
+				if (offset < 0)
+				{
+					if (-offset >= ret)
+						continue;
+
+					for (size_t c = 0; c < rx_buffs.size(); c++)
+						memmove(samples[c], static_cast<char*>(samples[c]) - offset * sample_size, (ret + offset) * sample_size);
+					ret += offset;
+				}
+
+				rx_status.status_time = window_start_time;
+			}
+			//every chunk has to start right where the previous one ended (within rounding of timestamps to [ns])
+			else if (llabs(chunk_time - expected_chunk_time) > half_sample_time)
+			{
+				msgf
+				(
+					WARNING,
+					"sdr: [RX]  chunk %d of window %lld starts at %lld instead of %lld",
+					rx_status.no_of_chunks,
+					window_start_time,
+					chunk_time,
+					expected_chunk_time
+				);
+
+				return SOAPY_SDR_CORRUPTION;
+			}
+
+			no_of_received_samples += ret;
 		}
-		else
+
+		return no_of_received_samples;
+	}
+
+	bool SDR_Device_Wrapper::receive_samples(const int64_t tick, std::complex<float>* samples, int no_of_requested_samples)
+	{
+		rx_channel_samples[0] = samples;
+
+		if (rx_discarded_samples)
 		{
-			msg("sdr: " + rx_verbose_msg, WARNING);
-			res = false;
+			//burst that does not fit into the buffer is handed over without one, receive_burst fails it
+			if (no_of_requested_samples > (int)rx_discarded_samples->get_no_of_samples())
+				return receive_burst(tick, nullptr, no_of_requested_samples, nullptr);
+
+			for (size_t c = 1; c < rx_channel_samples.size(); c++)
+				rx_channel_samples[c] = rx_discarded_samples->get(c);
 		}
 
-		return res;
+		return receive_samples(tick, &rx_channel_samples[0], no_of_requested_samples);
 	}
 
 	void SDR_Device_Wrapper::receive_samples_void(bool& success,const int64_t tick, std::complex<float>* samples, int no_of_requested_samples)
@@ -579,6 +1367,159 @@ namespace sdr
 		success = receive_samples(tick, samples, no_of_requested_samples);
 	}
 
+	void SDR_Device_Wrapper::trace_burst(const burst_trace_source_t source, const SDR_Burst_Status& status)
+	{
+		Burst_Trace_Record record;
+
+		record.submit_host_time = status.submit_host_time;
+		record.return_host_time = status.return_host_time;
+		record.hardware_time = status.current_time;
+		record.burst_time = status.burst_time;
+		record.status_time = status.status_time;
+		record.no_of_requested_samples = status.no_of_requested_samples;
+		record.no_of_transferred_samples = status.no_of_transferred_samples;
+		record.stream_status = status.stream_status;
+		record.flags = status.flags;
+
+		trace_recorder->record(source, record);
+	}
+
+	size_t SDR_Device_Wrapper::get_no_of_channels(const int direction) const
+	{
+		return (direction == SOAPY_SDR_TX) ? device_cfg->channels_tx.size() : device_cfg->channels_rx.size();
+	}
+
+	size_t SDR_Device_Wrapper::get_mtu(const int direction) const
+	{
+		return (direction == SOAPY_SDR_TX) ? mtu_tx : mtu_rx;
+	}
+
+	bool SDR_Device_Wrapper::is_direct(const int direction) const
+	{
+		return (direction == SOAPY_SDR_TX) ? tx_direct : rx_direct;
+	}
+
+	void SDR_Device_Wrapper::set_hardware_time(const long long time_ns, const std::string& what)
+	{
+		device->setHardwareTime(time_ns, what);
+
+		rx_next_time_known = false;
+
+		//a time latched at a later edge (e.g. PPS) is seen by the tracker as a step once it happens
+		if (clock_tracker)
+			clock_tracker->restart();
+	}
+
+	void SDR_Device_Wrapper::start_clock_tracking()
+	{
+		if (clock_tracker || (device_cfg->T_clock_tracking <= 0))
+			return;
+
+		clock_tracker.reset(new Clock_Tracker(device, device_cfg->T_clock_tracking, device_cfg->clock_window));
+	}
+
+	Clock_Tracker::sptr_t SDR_Device_Wrapper::get_clock_tracker()
+	{
+		return clock_tracker;
+	}
+
+	long long SDR_Device_Wrapper::get_hardware_time()
+	{
+		if (clock_tracker)
+			return clock_tracker->get_hardware_time();
+
+		return device->getHardwareTime();
+	}
+
+	int64_t SDR_Device_Wrapper::get_host_time(const long long hw_time)
+	{
+		if (clock_tracker)
+			return clock_tracker->get_host_time(hw_time);
+
+		//hardware time is assumed to be read in the middle of the call
+		int64_t host_time_before = monotonic_time_ns();
+		long long now = device->getHardwareTime();
+		int64_t host_time_after = monotonic_time_ns();
+
+		return (host_time_before + host_time_after) / 2 + (hw_time - now);
+	}
+
+	const SDR_Burst_Status& SDR_Device_Wrapper::get_tx_status() const
+	{
+		return tx_status;
+	}
+
+	const SDR_Burst_Status& SDR_Device_Wrapper::get_rx_status() const
+	{
+		return rx_status;
+	}
+
+	SoapySDR::Stream* SDR_Device_Wrapper::get_tx_stream()
+	{
+		return tx_stream;
+	}
+
+	SoapySDR::Stream* SDR_Device_Wrapper::get_rx_stream()
+	{
+		return rx_stream;
+	}
+
+	sample_format_t SDR_Device_Wrapper::get_tx_format() const
+	{
+		return tx_format;
+	}
+
+	sample_format_t SDR_Device_Wrapper::get_rx_format() const
+	{
+		return rx_format;
+	}
+
+	void SDR_Device_Wrapper::set_trace_recorder(Burst_Trace_Recorder::sptr_t trace_recorder)
+	{
+		this->trace_recorder = trace_recorder;
+	}
+
+	Burst_Trace_Recorder::sptr_t SDR_Device_Wrapper::get_trace_recorder()
+	{
+		return trace_recorder;
+	}
+
+	void SDR_Device_Wrapper::set_metrics(SDR_Metrics::sptr_t metrics)
+	{
+		this->metrics = metrics;
+	}
+
+	SDR_Metrics::sptr_t SDR_Device_Wrapper::get_metrics()
+	{
+		return metrics;
+	}
+
+	const SDR_Init_Timing& SDR_Device_Wrapper::get_init_timing() const
+	{
+		return init_timing;
+	}
+
+	void SDR_Device_Wrapper::print_init_timing()
+	{
+		const SDR_Init_Timing& t = init_timing;
+
+		msgf
+		(
+			INFO,
+			"sdr: initialization phases of %s [ms]: make=%.1f, clocks=%.1f, settings=%.1f, tune=%.1f, streams=%.1f, time=%.1f, total=%.1f (settings applied=%zu, skipped=%zu)",
+			serial.c_str(),
+			t.make_time / 1e6,
+			t.clock_time / 1e6,
+			t.settings_time / 1e6,
+			t.tune_time / 1e6,
+			t.stream_time / 1e6,
+			t.time_reset_time / 1e6,
+			t.total_time / 1e6,
+			t.no_of_applied_settings,
+			t.no_of_skipped_settings
+		);
+	}
+
 	SoapySDR::Device* SDR_Device_Wrapper::get_device()
 	{
 		return device;
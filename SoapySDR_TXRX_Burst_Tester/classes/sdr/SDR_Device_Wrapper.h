@@ -2,15 +2,69 @@
 #define __SDR_DEVICE_WRAPPER_H__
 
 #include <fstream>
+#include <vector>
+#include <complex>
 
 #include <boost/thread.hpp>
+#include <boost/function.hpp>
 
 #include <SoapySDR/Device.hpp>
 
 #include "SDR_Config.h"
+#include "Burst_Trace_Recorder.h"
+#include "Sample_Format.h"
+#include "Channel_Buffers.h"
+#include "SDR_Init_Cache.h"
+#include "SDR_Metrics.h"
+#include "Clock_Tracker.h"
 
 namespace sdr
 {
+	//returns the name of given SoapySDR return code as a static string, so it can be logged without allocating
+	const char* code_to_str(const int code);
+
+	//outcome of the most recent burst in a given direction
+	struct SDR_Burst_Status
+	{
+		int64_t tick = 0;
+		int64_t submit_host_time = 0;
+		int64_t return_host_time = 0;
+		long long burst_time = 0;
+		long long current_time = 0;
+		long long status_time = 0;
+		int no_of_requested_samples = 0;
+		int no_of_transferred_samples = 0;
+		int stream_status = 0;
+		int flags = 0;
+		int no_of_chunks = 0;
+	};
+
+	//how long the phases of the last (successful) initialization took in [ns] and how many settings have been
+	//applied or skipped thanks to the init cache
+	//
+	//	make_time		- SoapySDR::Device::make
+	//	clock_time		- clock source, time source and master clock rate
+	//	settings_time	- sample rates, bandwidths, gains and antennas of all channels
+	//	tune_time		- setting of all frequencies and waiting for all LOs to lock
+	//	stream_time		- stream setup and activation
+	//	time_reset_time	- hardware time reset until the device reports the new time
+	struct SDR_Init_Timing
+	{
+		int64_t make_time = 0;
+		int64_t clock_time = 0;
+		int64_t settings_time = 0;
+		int64_t tune_time = 0;
+		int64_t stream_time = 0;
+		int64_t time_reset_time = 0;
+		int64_t total_time = 0;
+		size_t no_of_applied_settings = 0;
+		size_t no_of_skipped_settings = 0;
+	};
+
+	//consumer of an RX burst received in place (see SDR_Device_Wrapper::receive_samples_in_place), gets CF32 samples
+	//of every channel starting offset samples into the burst, valid only until it returns
+	typedef boost::function<void (const std::complex<float>* const* samples, const int offset, const int no_of_samples)> rx_chunk_handler_t;
+
 	class SDR_Device_Wrapper
 	{
 	private:
@@ -20,18 +74,159 @@ namespace sdr
 		SoapySDR::Stream* tx_stream = nullptr;
 		SoapySDR::Stream* rx_stream = nullptr;
 
+		//per-burst scratch state owned by the wrapper and allocated once in the constructor, buffer arrays hold
+		//one pointer per channel of the stream
+		std::vector<std::complex<float>> tx_zero_samples;
+		std::vector<std::complex<float>> rx_zero_samples;
+		std::vector<const void*> tx_buffs;
+		std::vector<void*> rx_buffs;
+		std::vector<void*> rx_targets;
+		SDR_Burst_Status tx_status;
+		SDR_Burst_Status rx_status;
+		size_t tx_chan_mask = 0;
+
+		//bursts longer than stream MTUs are written and read in chunks of at most MTU samples (0 - unknown MTU,
+		//bursts are never split), chunk arrays point into the burst buffers at the current chunk
+		size_t mtu_tx = 0;
+		size_t mtu_rx = 0;
+		std::vector<const void*> tx_chunk_buffs;
+		std::vector<void*> rx_chunk_buffs;
+
+		//direct access to driver buffers (see SDR_Device_Config::direct_buffers), buffer arrays hold the driver
+		//buffers of the chunk currently acquired, rx_in_place_samples receives bursts handed over to
+		//receive_samples_in_place that cannot be consumed in place and rx_in_place_chunk points into it
+		bool tx_direct = false;
+		bool rx_direct = false;
+		std::vector<void*> tx_direct_buffs;
+		std::vector<const void*> rx_direct_buffs;
+		Channel_Buffers::sptr_t rx_in_place_samples;
+		std::vector<const std::complex<float>*> rx_in_place_chunk;
+
+		//channel arrays used by single buffer variants of send_samples/receive_samples, RX channels other
+		//than the first one are received into rx_discarded_samples then
+		std::vector<const std::complex<float>*> tx_channel_samples;
+		std::vector<std::complex<float>*> rx_channel_samples;
+		Channel_Buffers::sptr_t rx_discarded_samples;
+
+		//stream formats and conversion scratch buffers sized for buffer_size_tx/rx samples of every channel
+		//(unused for CF32), channels are tx/rx_native_stride bytes apart
+		sample_format_t tx_format = FORMAT_CF32;
+		sample_format_t rx_format = FORMAT_CF32;
+		Sample_Converters tx_converters;
+		Sample_Converters rx_converters;
+		std::vector<char> tx_native_samples;
+		std::vector<char> rx_native_samples;
+		size_t tx_native_stride = 0;
+		size_t rx_native_stride = 0;
+
+		//state of continuously running RX stream (see SDR_Device_Config::rx_continuous), gap samples in RX stream format
+		std::vector<char> rx_gap_samples;
+		size_t rx_gap_stride = 0;
+		long long rx_next_time = 0;
+		bool rx_next_time_known = false;
+
+		//optional per-burst telemetry (see set_trace_recorder)
+		Burst_Trace_Recorder::sptr_t trace_recorder;
+
+		//optional metric series of the device (see set_metrics)
+		SDR_Metrics::sptr_t metrics;
+
+		//model of the hardware clock (see start_clock_tracking)
+		Clock_Tracker::sptr_t clock_tracker;
+
+		//serial number settings are cached under (see SDR_Init_Cache) and timing of the initialization
+		std::string serial;
+		SDR_Init_Cache::sptr_t init_cache;
+		SDR_Init_Timing init_timing;
+
+		//applies a setting unless the init cache holds the same requested value and the device still reports the
+		//value cached with it, returns the value reported by the device
+		double apply_setting(const std::string& key, const double value, const boost::function<void (double)>& set, const boost::function<double ()>& get);
+		std::string apply_setting(const std::string& key, const std::string& value, const boost::function<void (const std::string&)>& set, const boost::function<std::string ()>& get);
+
+		//given (direction, channel) pairs have been tuned, waits until all of them report their LO locked
+		void wait_for_lo_locks(const std::vector<std::pair<int, size_t>>& tuned_channels);
+		//hardware time has been set to 0, waits until the device reports a time below time_before_reset that is running
+		void wait_for_time_reset(const long long time_before_reset);
+
+		sample_format_t resolve_stream_format(const int direction, const size_t channel);
+
+		//write/read a whole timed burst of tx_buffs/rx_targets, split into chunks when it does not fit into the MTU,
+		//return number of samples transferred or an error code
+		int write_burst(const int no_of_requested_samples);
+		int read_burst(const int no_of_requested_samples);
+		//same as write_burst/read_burst, but every chunk is converted straight into/out of a driver buffer, RX chunks
+		//are passed to handler (if any) before their buffer is released
+		int write_burst_direct(const std::complex<float>* const* samples, const int no_of_requested_samples);
+		int read_burst_direct(std::complex<float>* const* samples, const int no_of_requested_samples, const rx_chunk_handler_t* handler);
+		//null samples stand for a burst that does not fit into the receive buffers, it is failed as SOAPY_SDR_NOT_SUPPORTED
+		bool receive_burst(const int64_t tick, std::complex<float>* const* samples, int no_of_requested_samples, const rx_chunk_handler_t* handler);
+		int read_continuous_window(void* const* samples, int no_of_requested_samples);
+		void trace_burst(const burst_trace_source_t source, const SDR_Burst_Status& status);
+
 	public:
 		typedef boost::shared_ptr<SDR_Device_Wrapper> sptr_t;
 
-		SDR_Device_Wrapper(SDR_Device_Config::sptr_t device_cfg);
+		SDR_Device_Wrapper(SDR_Device_Config::sptr_t device_cfg, SDR_Init_Cache::sptr_t init_cache = SDR_Init_Cache::sptr_t());
 		~SDR_Device_Wrapper();
 
+		//samples hold one buffer per channel of the stream (in order of SDR_Device_Config::channels_tx/rx),
+		//all channels share the burst timestamp
+		bool send_samples(const int64_t tick, const std::complex<float>* const* samples, int no_of_requested_samples, const bool ack = true);
+		bool receive_samples(const int64_t tick, std::complex<float>* const* samples, int no_of_requested_samples);
+
+		//single buffer variants - TX sends the same samples on every channel, RX keeps only the first channel
 		bool send_samples(const int64_t tick, const std::complex<float>* samples, int no_of_requested_samples, const bool ack = true);
 		void send_samples_void(bool& success, const int64_t tick, const std::complex<float>* samples, int no_of_requested_samples, const bool ack = true);
 
 		bool receive_samples(const int64_t tick, std::complex<float>* samples, int no_of_requested_samples);
 		void receive_samples_void(bool& success, const int64_t tick, std::complex<float>* samples, int no_of_requested_samples);
 
+		//receives a burst chunk by chunk and passes every chunk to handler, chunks of CF32 streams with direct buffers
+		//are read straight out of driver buffers, otherwise the burst is received into a wrapper buffer first (it
+		//exceeding buffer_size_rx fails the burst)
+		bool receive_samples_in_place(const int64_t tick, int no_of_requested_samples, const rx_chunk_handler_t& handler);
+
+		//whether bursts of given direction go through driver buffers (direct_buffers requested and supported)
+		bool is_direct(const int direction) const;
+
+		size_t get_no_of_channels(const int direction) const;
+		size_t get_mtu(const int direction) const;
+
+		//sets hardware time of the device (what as in SoapySDR::Device::setHardwareTime, e.g. "PPS" to latch it at
+		//the next PPS edge), position of continuous RX flow is found out again by the next burst
+		void set_hardware_time(const long long time_ns, const std::string& what = "");
+
+		//starts tracking hardware time by a model (SDR_Device_Config::T_clock_tracking, meant to be called once
+		//hardware times have been aligned), bursts and get_hardware_time use the model from then on
+		void start_clock_tracking();
+		Clock_Tracker::sptr_t get_clock_tracker();
+
+		//hardware time in [ns], estimated by the clock model while it is tracked, read from the device otherwise
+		long long get_hardware_time();
+		//host monotonic time in [ns] at which the hardware clock reaches given time, by the same means
+		int64_t get_host_time(const long long hw_time);
+
+		const SDR_Burst_Status& get_tx_status() const;
+		const SDR_Burst_Status& get_rx_status() const;
+
+		SoapySDR::Stream* get_tx_stream();
+		SoapySDR::Stream* get_rx_stream();
+		sample_format_t get_tx_format() const;
+		sample_format_t get_rx_format() const;
+
+		//attaches a recorder all following bursts are traced into (meant to be called before streaming starts)
+		void set_trace_recorder(Burst_Trace_Recorder::sptr_t trace_recorder);
+		Burst_Trace_Recorder::sptr_t get_trace_recorder();
+
+		//attaches metric series bursts are counted into, TX_Pipeline and Frame_Scheduler of the device pick them up
+		//when they are created (meant to be called before streaming starts)
+		void set_metrics(SDR_Metrics::sptr_t metrics);
+		SDR_Metrics::sptr_t get_metrics();
+
+		const SDR_Init_Timing& get_init_timing() const;
+		void print_init_timing();
+
 		SoapySDR::Device* get_device();
 		SDR_Device_Config::sptr_t get_device_config();
 	};
@@ -0,0 +1,141 @@
+#include "SDR_Init_Cache.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fstream>
+#include <vector>
+#include <stdexcept>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	SDR_Init_Cache::SDR_Init_Cache(const std::string& filepath)
+	:
+		filepath(filepath)
+	{
+		ifstream file(filepath.c_str());
+
+		if (!file.is_open())
+		{
+			if (errno != ENOENT)
+				throw std::runtime_error("Unable to open init cache " + filepath + ": " + string(strerror(errno)));
+
+			msg("sdr: init cache " + filepath + " does not exist yet, all settings are going to be applied");
+			return;
+		}
+
+		string line;
+		size_t line_no = 0;
+		size_t no_of_settings = 0;
+
+		while (getline(file, line))
+		{
+			line_no++;
+
+			if (line.empty())
+				continue;
+
+			vector<string> fields = explode(line, '\t');
+
+			//explode drops the empty field after a trailing delimiter (device reporting an empty value)
+			if (line.back() == '\t')
+				fields.push_back("");
+
+			if (fields.size() != 4)
+				throw std::runtime_error("Malformed line " + to_string(line_no) + " of init cache " + filepath);
+
+			settings[fields[0]][fields[1]] = make_pair(fields[2], fields[3]);
+			no_of_settings++;
+		}
+
+		if (file.bad())
+			throw std::runtime_error("Unable to read init cache " + filepath);
+
+		msg("sdr: init cache " + filepath + " holds " + to_string(no_of_settings) + " settings of " + to_string(settings.size()) + " devices");
+	}
+
+	bool SDR_Init_Cache::lookup(const std::string& serial, const std::string& key, const std::string& requested, std::string& actual) const
+	{
+		boost::lock_guard<boost::mutex> guard(cache_mutex);
+
+		auto device = settings.find(serial);
+
+		if (device == settings.end())
+			return false;
+
+		auto setting = device->second.find(key);
+
+		if ((setting == device->second.end()) || (setting->second.first != requested))
+			return false;
+
+		actual = setting->second.second;
+
+		return true;
+	}
+
+	void SDR_Init_Cache::store(const std::string& serial, const std::string& key, const std::string& requested, const std::string& actual)
+	{
+		boost::lock_guard<boost::mutex> guard(cache_mutex);
+
+		pair<string, string>& setting = settings[serial][key];
+
+		if ((setting.first != requested) || (setting.second != actual))
+		{
+			setting = make_pair(requested, actual);
+			modified = true;
+		}
+	}
+
+	void SDR_Init_Cache::save()
+	{
+		boost::lock_guard<boost::mutex> guard(cache_mutex);
+
+		if (!modified)
+			return;
+
+		string tmp_filepath = filepath + ".tmp";
+
+		{
+			ofstream file(tmp_filepath.c_str(), ios::trunc);
+
+			if (!file.is_open())
+				throw std::runtime_error("Unable to create init cache " + tmp_filepath + ": " + string(strerror(errno)));
+
+			for (const auto& device : settings)
+				for (const auto& setting : device.second)
+					file << device.first << '\t' << setting.first << '\t' << setting.second.first << '\t' << setting.second.second << '\n';
+
+			file.flush();
+
+			if (!file.good())
+				throw std::runtime_error("Unable to write init cache " + tmp_filepath);
+		}
+
+		if (rename(tmp_filepath.c_str(), filepath.c_str()) != 0)
+			throw std::runtime_error("Unable to replace init cache " + filepath + ": " + string(strerror(errno)));
+
+		modified = false;
+	}
+
+	size_t SDR_Init_Cache::size() const
+	{
+		boost::lock_guard<boost::mutex> guard(cache_mutex);
+
+		size_t no_of_settings = 0;
+
+		for (const auto& device : settings)
+			no_of_settings += device.second.size();
+
+		return no_of_settings;
+	}
+
+	const std::string& SDR_Init_Cache::get_filepath() const
+	{
+		return filepath;
+	}
+}
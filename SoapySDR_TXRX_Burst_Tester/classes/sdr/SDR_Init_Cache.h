@@ -0,0 +1,47 @@
+#ifndef __SDR_INIT_CACHE_H__
+#define __SDR_INIT_CACHE_H__
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+namespace sdr
+{
+	//settings last applied to devices, keyed by device serial and setting key (e.g. rx0.gain), each holding the
+	//requested value together with what the device has reported back after applying it - a setting may be skipped
+	//during the next initialization only if it is requested again and the device still reports the same value
+	//
+	//kept in a text file of tab separated lines: serial, key, requested value, actual value (file that does not
+	//exist is an empty cache), shared by all devices of a group, so it is guarded by a mutex
+	class SDR_Init_Cache
+	{
+	private:
+		std::string filepath;
+		std::map<std::string, std::map<std::string, std::pair<std::string, std::string>>> settings;
+		bool modified = false;
+
+		mutable boost::mutex cache_mutex;
+
+	public:
+		typedef boost::shared_ptr<SDR_Init_Cache> sptr_t;
+
+		//throws std::runtime_error when the file exists but cannot be read or is malformed
+		SDR_Init_Cache(const std::string& filepath);
+
+		//returns true and the actual value when the setting has been applied with the same requested value before
+		bool lookup(const std::string& serial, const std::string& key, const std::string& requested, std::string& actual) const;
+		void store(const std::string& serial, const std::string& key, const std::string& requested, const std::string& actual);
+
+		//rewrites the file through a temporary one (so it is never left half written), does nothing when nothing
+		//has changed, throws std::runtime_error on failure
+		void save();
+
+		size_t size() const;
+		const std::string& get_filepath() const;
+	};
+}
+
+#endif
@@ -0,0 +1,92 @@
+#include "SDR_Metrics.h"
+
+#include <vector>
+
+#include <SoapySDR/Constants.h>
+#include <SoapySDR/Errors.hpp>
+
+#include "Frame_Scheduler.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	//error codes of the switch in code_to_str (SOAPY_SDR_END_BURST is a flag rather than an error), OTHER goes last
+	static const int stream_codes[NO_OF_STREAM_CODES - 1] =
+	{
+		SOAPY_SDR_TIMEOUT,
+		SOAPY_SDR_STREAM_ERROR,
+		SOAPY_SDR_CORRUPTION,
+		SOAPY_SDR_OVERFLOW,
+		SOAPY_SDR_NOT_SUPPORTED,
+		SOAPY_SDR_TIME_ERROR,
+		SOAPY_SDR_UNDERFLOW
+	};
+
+	static const char* stream_code_names[NO_OF_STREAM_CODES] =
+	{
+		"TIMEOUT",
+		"STREAM_ERROR",
+		"CORRUPTION",
+		"OVERFLOW",
+		"NOT_SUPPORTED",
+		"TIME_ERROR",
+		"UNDERFLOW",
+		"OTHER"
+	};
+
+	static const vector<int64_t> lead_time_bucket_edges(LEAD_TIME_BUCKET_EDGES, LEAD_TIME_BUCKET_EDGES + NO_OF_LEAD_TIME_BUCKETS - 1);
+
+	//upper edges of ack latency buckets in [ns]
+	static const vector<int64_t> ack_latency_bucket_edges =
+	{
+		0, 50000, 100000, 200000, 500000, 1000000, 2000000, 5000000, 10000000, 20000000, 50000000, 100000000
+	};
+
+	SDR_Metrics::SDR_Metrics(utils::Metrics_Registry::sptr_t registry, const size_t device)
+	:
+		registry(registry)
+	{
+		const string labels = "device=\"" + to_string(device) + "\"";
+		const string tx_labels = labels + ",direction=\"tx\"";
+		const string rx_labels = labels + ",direction=\"rx\"";
+
+		tx_bursts = registry->add_counter("burst_tester_bursts_total", "Bursts sent or received in full.", tx_labels);
+		rx_bursts = registry->add_counter("burst_tester_bursts_total", "Bursts sent or received in full.", rx_labels);
+		tx_failed_bursts = registry->add_counter("burst_tester_failed_bursts_total", "Bursts that failed for any reason.", tx_labels);
+		rx_failed_bursts = registry->add_counter("burst_tester_failed_bursts_total", "Bursts that failed for any reason.", rx_labels);
+
+		for (size_t i = 0; i < NO_OF_STREAM_CODES; i++)
+		{
+			const string code_label = ",code=\"" + string(stream_code_names[i]) + "\"";
+
+			tx_codes[i] = registry->add_counter("burst_tester_stream_errors_total", "SoapySDR error codes returned by writeStream, readStreamStatus and readStream.", tx_labels + code_label);
+			rx_codes[i] = registry->add_counter("burst_tester_stream_errors_total", "SoapySDR error codes returned by writeStream, readStreamStatus and readStream.", rx_labels + code_label);
+		}
+
+		tx_ack_latency = registry->add_histogram("burst_tester_tx_ack_latency_seconds", "Time from the end of a TX burst until its acknowledgement.", labels, ack_latency_bucket_edges, 1e-9);
+		tx_lead_time = registry->add_histogram("burst_tester_lead_time_seconds", "Time ahead of its slot a burst has been handed over to the device.", tx_labels, lead_time_bucket_edges, 1e-9);
+		rx_lead_time = registry->add_histogram("burst_tester_lead_time_seconds", "Time ahead of its slot a burst has been handed over to the device.", rx_labels, lead_time_bucket_edges, 1e-9);
+		tx_skipped_slots = registry->add_counter("burst_tester_skipped_slots_total", "Slots skipped for missing the minimum lead time.", tx_labels);
+		rx_skipped_slots = registry->add_counter("burst_tester_skipped_slots_total", "Slots skipped for missing the minimum lead time.", rx_labels);
+	}
+
+	void SDR_Metrics::count_code(const int direction, const int code) const
+	{
+		if (code >= 0)
+			return;
+
+		size_t i = 0;
+
+		while ((i < NO_OF_STREAM_CODES - 1) && (stream_codes[i] != code))
+			i++;
+
+		((direction == SOAPY_SDR_TX) ? tx_codes : rx_codes)[i].add();
+	}
+
+	utils::Metrics_Registry::sptr_t SDR_Metrics::get_registry()
+	{
+		return registry;
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef __SDR_METRICS_H__
+#define __SDR_METRICS_H__
+
+#include <string>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include "../utils/Metrics_Registry.h"
+
+namespace sdr
+{
+	//number of SoapySDR error codes counted separately (see code_to_str), any other negative code is counted as OTHER
+	const size_t NO_OF_STREAM_CODES = 8;
+
+	//metric series of a single device (labelled device="N") updated by SDR_Device_Wrapper, TX_Pipeline and Frame_Scheduler
+	//driving it, every update is wait-free (see utils::Metrics_Registry)
+	//
+	//	burst_tester_bursts_total					- bursts sent or received in full
+	//	burst_tester_failed_bursts_total			- bursts that failed for any reason
+	//	burst_tester_stream_errors_total			- error codes of writeStream, readStreamStatus and readStream
+	//	burst_tester_tx_ack_latency_seconds			- time from the end of a TX burst until its acknowledgement
+	//	burst_tester_lead_time_seconds				- time ahead of its slot a burst has been handed over to the device
+	//	burst_tester_skipped_slots_total			- slots skipped for missing min_lead_time
+	class SDR_Metrics
+	{
+	private:
+		utils::Metrics_Registry::sptr_t registry;
+
+		utils::Metrics_Counter tx_codes[NO_OF_STREAM_CODES];
+		utils::Metrics_Counter rx_codes[NO_OF_STREAM_CODES];
+
+	public:
+		typedef boost::shared_ptr<SDR_Metrics> sptr_t;
+
+		utils::Metrics_Counter tx_bursts;
+		utils::Metrics_Counter rx_bursts;
+		utils::Metrics_Counter tx_failed_bursts;
+		utils::Metrics_Counter rx_failed_bursts;
+		utils::Metrics_Histogram tx_ack_latency;
+		utils::Metrics_Histogram tx_lead_time;
+		utils::Metrics_Histogram rx_lead_time;
+		utils::Metrics_Counter tx_skipped_slots;
+		utils::Metrics_Counter rx_skipped_slots;
+
+		//throws std::invalid_argument when the series of the device have been registered already
+		SDR_Metrics(utils::Metrics_Registry::sptr_t registry, const size_t device);
+
+		//counts a SoapySDR return code of given direction, codes that are not negative are ignored
+		void count_code(const int direction, const int code) const;
+
+		utils::Metrics_Registry::sptr_t get_registry();
+	};
+}
+
+#endif
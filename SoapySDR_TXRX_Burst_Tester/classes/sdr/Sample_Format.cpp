@@ -0,0 +1,543 @@
+#include "Sample_Format.h"
+
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SAMPLE_FORMAT_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SAMPLE_FORMAT_NEON
+#endif
+
+using namespace std;
+
+namespace sdr
+{
+	//full scale of integer formats, CS12 samples are CS16 ones without their lowest 4 bits
+	static const float INT16_SCALE = 32768.0f;
+	static const float INT16_INV_SCALE = 1.0f / 32768.0f;
+
+	sample_format_t parse_sample_format(const std::string& format)
+	{
+		if (format == "CF32")
+			return FORMAT_CF32;
+		if (format == "CS16")
+			return FORMAT_CS16;
+		if (format == "CS12")
+			return FORMAT_CS12;
+
+		throw std::invalid_argument("Unsupported sample format " + format + " (expected CF32, CS16 or CS12)");
+	}
+
+	const char* sample_format_to_str(const sample_format_t format)
+	{
+		switch (format)
+		{
+			case FORMAT_CS16:
+				return "CS16";
+			case FORMAT_CS12:
+				return "CS12";
+			default:
+				return "CF32";
+		}
+	}
+
+	size_t sample_format_size(const sample_format_t format)
+	{
+		switch (format)
+		{
+			case FORMAT_CS16:
+				return 2 * sizeof(int16_t);
+			case FORMAT_CS12:
+				return 3;
+			default:
+				return sizeof(std::complex<float>);
+		}
+	}
+
+	/*********************************************************************************************************/
+	//scalar kernels - used for tails of SIMD ones and on CPUs without any supported instruction set
+
+	static inline int16_t float_to_int16(const float x)
+	{
+		float scaled = x * INT16_SCALE;
+
+		if (scaled > 32767.0f)
+			scaled = 32767.0f;
+		else if (scaled < -32768.0f)
+			scaled = -32768.0f;
+
+		return (int16_t)lrintf(scaled);
+	}
+
+	static void cf32_to_cf32(const std::complex<float>* in, void* out, const size_t no_of_samples)
+	{
+		memcpy(out, in, no_of_samples * sizeof(std::complex<float>));
+	}
+
+	static void cf32_from_cf32(const void* in, std::complex<float>* out, const size_t no_of_samples)
+	{
+		memcpy(out, in, no_of_samples * sizeof(std::complex<float>));
+	}
+
+	static void cs16_to_native_scalar(const std::complex<float>* in, void* out, const size_t no_of_samples)
+	{
+		const float* f = reinterpret_cast<const float*>(in);
+		int16_t* o = static_cast<int16_t*>(out);
+
+		for (size_t i = 0; i < 2 * no_of_samples; i++)
+			o[i] = float_to_int16(f[i]);
+	}
+
+	static void cs16_from_native_scalar(const void* in, std::complex<float>* out, const size_t no_of_samples)
+	{
+		const int16_t* s = static_cast<const int16_t*>(in);
+		float* o = reinterpret_cast<float*>(out);
+
+		for (size_t i = 0; i < 2 * no_of_samples; i++)
+			o[i] = s[i] * INT16_INV_SCALE;
+	}
+
+	//every sample takes 3 bytes: I[11:4], Q[3:0] << 4 | I[15:12], Q[15:8] (of their 16-bit counterparts)
+	static void cs12_to_native_scalar(const std::complex<float>* in, void* out, const size_t no_of_samples)
+	{
+		const float* f = reinterpret_cast<const float*>(in);
+		uint8_t* o = static_cast<uint8_t*>(out);
+
+		for (size_t i = 0; i < no_of_samples; i++)
+		{
+			uint16_t sample_i = (uint16_t)float_to_int16(f[2 * i]);
+			uint16_t sample_q = (uint16_t)float_to_int16(f[2 * i + 1]);
+
+			o[3 * i] = (uint8_t)(sample_i >> 4);
+			o[3 * i + 1] = (uint8_t)((sample_i >> 12) | (sample_q & 0xf0));
+			o[3 * i + 2] = (uint8_t)(sample_q >> 8);
+		}
+	}
+
+	static void cs12_from_native_scalar(const void* in, std::complex<float>* out, const size_t no_of_samples)
+	{
+		const uint8_t* s = static_cast<const uint8_t*>(in);
+		float* o = reinterpret_cast<float*>(out);
+
+		for (size_t i = 0; i < no_of_samples; i++)
+		{
+			uint16_t b0 = s[3 * i];
+			uint16_t b1 = s[3 * i + 1];
+			uint16_t b2 = s[3 * i + 2];
+
+			o[2 * i] = (int16_t)((b1 << 12) | (b0 << 4)) * INT16_INV_SCALE;
+			o[2 * i + 1] = (int16_t)((b2 << 8) | (b1 & 0xf0)) * INT16_INV_SCALE;
+		}
+	}
+
+#ifdef SAMPLE_FORMAT_X86
+	/*********************************************************************************************************/
+	//SSE kernels (SSSE3 is needed for byte shuffles of CS12), 4 samples per iteration
+
+	//CS12 <-> CS16 within 32-bit lanes of {I, Q} 16-bit pairs:
+	//	unpacking - shuffle bytes into {b0 b1, b1 b2} words, then I = word << 4 and Q = word & 0xfff0
+	//	packing - I >> 4 gives b0 and I[15:12], Q & 0xfff0 gives Q[7:4] and b2, I[15:12] | Q[7:4] gives b1
+	#define CS12_UNPACK_SHUFFLE _mm_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11)
+	#define CS12_PACK_SHUFFLE _mm_setr_epi8(0, 1, 3, 4, 5, 7, 8, 9, 11, 12, 13, 15, -1, -1, -1, -1)
+
+	__attribute__((target("ssse3"))) static inline __m128i cs12_unpack_sse(const __m128i v)
+	{
+		__m128i words = _mm_shuffle_epi8(v, CS12_UNPACK_SHUFFLE);
+
+		return _mm_or_si128
+		(
+			_mm_and_si128(_mm_slli_epi16(words, 4), _mm_set1_epi32(0x0000ffff)),
+			_mm_and_si128(words, _mm_set1_epi32(0xfff00000))
+		);
+	}
+
+	__attribute__((target("ssse3"))) static inline void cs12_pack_sse(const __m128i v, uint8_t* out)
+	{
+		__m128i x = _mm_or_si128
+		(
+			_mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi32(0x0000ffff)),
+			_mm_and_si128(v, _mm_set1_epi32(0xfff00000))
+		);
+
+		x = _mm_or_si128(x, _mm_and_si128(_mm_srli_epi32(x, 8), _mm_set1_epi32(0x0000ff00)));
+		x = _mm_shuffle_epi8(x, CS12_PACK_SHUFFLE);
+
+		uint32_t tail = _mm_cvtsi128_si32(_mm_srli_si128(x, 8));
+
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out), x);
+		memcpy(out + 8, &tail, sizeof(tail));
+	}
+
+	//8 floats (4 samples) into 8 saturated 16-bit integers
+	__attribute__((target("ssse3"))) static inline __m128i float_to_int16_sse(const float* f)
+	{
+		const __m128 scale = _mm_set1_ps(INT16_SCALE);
+		const __m128 max = _mm_set1_ps(32767.0f);
+		const __m128 min = _mm_set1_ps(-32768.0f);
+
+		__m128i a = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(f), scale), max), min));
+		__m128i b = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(f + 4), scale), max), min));
+
+		return _mm_packs_epi32(a, b);
+	}
+
+	//8 16-bit integers (4 samples) into 8 floats
+	__attribute__((target("ssse3"))) static inline void int16_to_float_sse(const __m128i v, float* f)
+	{
+		const __m128 inv_scale = _mm_set1_ps(INT16_INV_SCALE);
+
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+		_mm_storeu_ps(f, _mm_mul_ps(_mm_cvtepi32_ps(lo), inv_scale));
+		_mm_storeu_ps(f + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), inv_scale));
+	}
+
+	__attribute__((target("ssse3"))) static void cs16_to_native_sse(const std::complex<float>* in, void* out, const size_t no_of_samples)
+	{
+		const float* f = reinterpret_cast<const float*>(in);
+		int16_t* o = static_cast<int16_t*>(out);
+
+		size_t i = 0;
+
+		for (; i + 4 <= no_of_samples; i += 4)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(o + 2 * i), float_to_int16_sse(f + 2 * i));
+
+		cs16_to_native_scalar(in + i, o + 2 * i, no_of_samples - i);
+	}
+
+	__attribute__((target("ssse3"))) static void cs16_from_native_sse(const void* in, std::complex<float>* out, const size_t no_of_samples)
+	{
+		const int16_t* s = static_cast<const int16_t*>(in);
+		float* o = reinterpret_cast<float*>(out);
+
+		size_t i = 0;
+
+		for (; i + 4 <= no_of_samples; i += 4)
+			int16_to_float_sse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 2 * i)), o + 2 * i);
+
+		cs16_from_native_scalar(s + 2 * i, out + i, no_of_samples - i);
+	}
+
+	__attribute__((target("ssse3"))) static void cs12_to_native_sse(const std::complex<float>* in, void* out, const size_t no_of_samples)
+	{
+		const float* f = reinterpret_cast<const float*>(in);
+		uint8_t* o = static_cast<uint8_t*>(out);
+
+		size_t i = 0;
+
+		for (; i + 4 <= no_of_samples; i += 4)
+			cs12_pack_sse(float_to_int16_sse(f + 2 * i), o + 3 * i);
+
+		cs12_to_native_scalar(in + i, o + 3 * i, no_of_samples - i);
+	}
+
+	__attribute__((target("ssse3"))) static void cs12_from_native_sse(const void* in, std::complex<float>* out, const size_t no_of_samples)
+	{
+		const uint8_t* s = static_cast<const uint8_t*>(in);
+		float* o = reinterpret_cast<float*>(out);
+
+		size_t i = 0;
+
+		//16 bytes are loaded for 12 used ones, so the last 2 samples are always left for the scalar tail
+		for (; i + 6 <= no_of_samples; i += 4)
+			int16_to_float_sse(cs12_unpack_sse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 3 * i))), o + 2 * i);
+
+		cs12_from_native_scalar(s + 3 * i, out + i, no_of_samples - i);
+	}
+
+	/*********************************************************************************************************/
+	//AVX2 kernels, 8 samples per iteration (CS12 byte shuffles stay 128-bit wide)
+
+	//16 floats (8 samples) into 16 saturated 16-bit integers
+	__attribute__((target("avx2"))) static inline __m256i float_to_int16_avx2(const float* f)
+	{
+		const __m256 scale = _mm256_set1_ps(INT16_SCALE);
+		const __m256 max = _mm256_set1_ps(32767.0f);
+		const __m256 min = _mm256_set1_ps(-32768.0f);
+
+		__m256i a = _mm256_cvtps_epi32(_mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(f), scale), max), min));
+		__m256i b = _mm256_cvtps_epi32(_mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(f + 8), scale), max), min));
+
+		//packing works within 128-bit lanes, so its 64-bit quarters have to be put back in order
+		return _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xd8);
+	}
+
+	//8 16-bit integers (4 samples) into 8 floats
+	__attribute__((target("avx2"))) static inline void int16_to_float_avx2(const __m128i v, float* f)
+	{
+		_mm256_storeu_ps(f, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v)), _mm256_set1_ps(INT16_INV_SCALE)));
+	}
+
+	__attribute__((target("avx2"))) static void cs16_to_native_avx2(const std::complex<float>* in, void* out, const size_t no_of_samples)
+	{
+		const float* f = reinterpret_cast<const float*>(in);
+		int16_t* o = static_cast<int16_t*>(out);
+
+		size_t i = 0;
+
+		for (; i + 8 <= no_of_samples; i += 8)
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(o + 2 * i), float_to_int16_avx2(f + 2 * i));
+
+		cs16_to_native_scalar(in + i, o + 2 * i, no_of_samples - i);
+	}
+
+	__attribute__((target("avx2"))) static void cs16_from_native_avx2(const void* in, std::complex<float>* out, const size_t no_of_samples)
+	{
+		const int16_t* s = static_cast<const int16_t*>(in);
+		float* o = reinterpret_cast<float*>(out);
+
+		size_t i = 0;
+
+		for (; i + 8 <= no_of_samples; i += 8)
+		{
+			int16_to_float_avx2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 2 * i)), o + 2 * i);
+			int16_to_float_avx2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 2 * i + 8)), o + 2 * i + 8);
+		}
+
+		cs16_from_native_scalar(s + 2 * i, out + i, no_of_samples - i);
+	}
+
+	__attribute__((target("avx2"))) static void cs12_to_native_avx2(const std::complex<float>* in, void* out, const size_t no_of_samples)
+	{
+		const float* f = reinterpret_cast<const float*>(in);
+		uint8_t* o = static_cast<uint8_t*>(out);
+
+		size_t i = 0;
+
+		for (; i + 8 <= no_of_samples; i += 8)
+		{
+			__m256i v = float_to_int16_avx2(f + 2 * i);
+
+			cs12_pack_sse(_mm256_castsi256_si128(v), o + 3 * i);
+			cs12_pack_sse(_mm256_extracti128_si256(v, 1), o + 3 * i + 12);
+		}
+
+		cs12_to_native_scalar(in + i, o + 3 * i, no_of_samples - i);
+	}
+
+	__attribute__((target("avx2"))) static void cs12_from_native_avx2(const void* in, std::complex<float>* out, const size_t no_of_samples)
+	{
+		const uint8_t* s = static_cast<const uint8_t*>(in);
+		float* o = reinterpret_cast<float*>(out);
+
+		size_t i = 0;
+
+		//second 16-byte load ends 4 bytes past the 8 samples converted, so 2 more samples have to follow
+		for (; i + 10 <= no_of_samples; i += 8)
+		{
+			int16_to_float_avx2(cs12_unpack_sse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 3 * i))), o + 2 * i);
+			int16_to_float_avx2(cs12_unpack_sse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 3 * i + 12))), o + 2 * i + 8);
+		}
+
+		cs12_from_native_scalar(s + 3 * i, out + i, no_of_samples - i);
+	}
+#endif
+
+#ifdef SAMPLE_FORMAT_NEON
+	/*********************************************************************************************************/
+	//NEON kernels, 8 samples per iteration (conversions to integers saturate, so no clamping is needed)
+
+	//8 samples into 8 saturated 16-bit I and Q values
+	static inline int16x8x2_t float_to_int16_neon(const float* f)
+	{
+		float32x4x2_t lo = vld2q_f32(f);
+		float32x4x2_t hi = vld2q_f32(f + 8);
+
+		int16x8x2_t res;
+		res.val[0] = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(lo.val[0], INT16_SCALE))), vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(hi.val[0], INT16_SCALE))));
+		res.val[1] = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(lo.val[1], INT16_SCALE))), vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(hi.val[1], INT16_SCALE))));
+
+		return res;
+	}
+
+	//8 16-bit I and Q values into 8 interleaved samples
+	static inline void int16_to_float_neon(const int16x8_t i, const int16x8_t q, float* f)
+	{
+		float32x4x2_t lo;
+		lo.val[0] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(i))), INT16_INV_SCALE);
+		lo.val[1] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(q))), INT16_INV_SCALE);
+
+		float32x4x2_t hi;
+		hi.val[0] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(i))), INT16_INV_SCALE);
+		hi.val[1] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(q))), INT16_INV_SCALE);
+
+		vst2q_f32(f, lo);
+		vst2q_f32(f + 8, hi);
+	}
+
+	static void cs16_to_native_neon(const std::complex<float>* in, void* out, const size_t no_of_samples)
+	{
+		const float* f = reinterpret_cast<const float*>(in);
+		int16_t* o = static_cast<int16_t*>(out);
+
+		size_t i = 0;
+
+		for (; i + 8 <= no_of_samples; i += 8)
+			vst2q_s16(o + 2 * i, float_to_int16_neon(f + 2 * i));
+
+		cs16_to_native_scalar(in + i, o + 2 * i, no_of_samples - i);
+	}
+
+	static void cs16_from_native_neon(const void* in, std::complex<float>* out, const size_t no_of_samples)
+	{
+		const int16_t* s = static_cast<const int16_t*>(in);
+		float* o = reinterpret_cast<float*>(out);
+
+		size_t i = 0;
+
+		for (; i + 8 <= no_of_samples; i += 8)
+		{
+			int16x8x2_t v = vld2q_s16(s + 2 * i);
+			int16_to_float_neon(v.val[0], v.val[1], o + 2 * i);
+		}
+
+		cs16_from_native_scalar(s + 2 * i, out + i, no_of_samples - i);
+	}
+
+	static void cs12_to_native_neon(const std::complex<float>* in, void* out, const size_t no_of_samples)
+	{
+		const float* f = reinterpret_cast<const float*>(in);
+		uint8_t* o = static_cast<uint8_t*>(out);
+
+		size_t i = 0;
+
+		for (; i + 8 <= no_of_samples; i += 8)
+		{
+			int16x8x2_t v = float_to_int16_neon(f + 2 * i);
+			uint16x8_t sample_i = vreinterpretq_u16_s16(v.val[0]);
+			uint16x8_t sample_q = vreinterpretq_u16_s16(v.val[1]);
+
+			uint8x8x3_t bytes;
+			bytes.val[0] = vmovn_u16(vshrq_n_u16(sample_i, 4));
+			bytes.val[1] = vmovn_u16(vorrq_u16(vshrq_n_u16(sample_i, 12), vandq_u16(sample_q, vdupq_n_u16(0xf0))));
+			bytes.val[2] = vmovn_u16(vshrq_n_u16(sample_q, 8));
+
+			vst3_u8(o + 3 * i, bytes);
+		}
+
+		cs12_to_native_scalar(in + i, o + 3 * i, no_of_samples - i);
+	}
+
+	static void cs12_from_native_neon(const void* in, std::complex<float>* out, const size_t no_of_samples)
+	{
+		const uint8_t* s = static_cast<const uint8_t*>(in);
+		float* o = reinterpret_cast<float*>(out);
+
+		size_t i = 0;
+
+		for (; i + 8 <= no_of_samples; i += 8)
+		{
+			uint8x8x3_t bytes = vld3_u8(s + 3 * i);
+			uint16x8_t b0 = vmovl_u8(bytes.val[0]);
+			uint16x8_t b1 = vmovl_u8(bytes.val[1]);
+			uint16x8_t b2 = vmovl_u8(bytes.val[2]);
+
+			int16x8_t sample_i = vreinterpretq_s16_u16(vorrq_u16(vshlq_n_u16(b1, 12), vshlq_n_u16(b0, 4)));
+			int16x8_t sample_q = vreinterpretq_s16_u16(vorrq_u16(vshlq_n_u16(b2, 8), vandq_u16(b1, vdupq_n_u16(0xf0))));
+
+			int16_to_float_neon(sample_i, sample_q, o + 2 * i);
+		}
+
+		cs12_from_native_scalar(s + 3 * i, out + i, no_of_samples - i);
+	}
+#endif
+
+	/*********************************************************************************************************/
+
+	static bool isa_supported(const std::string& isa)
+	{
+		if (isa == "scalar")
+			return true;
+
+#ifdef SAMPLE_FORMAT_X86
+		if (isa == "sse")
+			return __builtin_cpu_supports("ssse3");
+		if (isa == "avx2")
+			return __builtin_cpu_supports("avx2");
+#endif
+
+#ifdef SAMPLE_FORMAT_NEON
+		if (isa == "neon")
+			return true;
+#endif
+
+		return false;
+	}
+
+	Sample_Converters get_sample_converters(const sample_format_t format, const std::string& isa)
+	{
+		Sample_Converters converters;
+
+		if (format == FORMAT_CF32)
+		{
+			converters.to_native = cf32_to_cf32;
+			converters.from_native = cf32_from_cf32;
+			converters.isa = "copy";
+
+			return converters;
+		}
+
+		string selected = isa;
+
+		if (isa == "auto")
+		{
+			const char* preferred[] = {"avx2", "sse", "neon", "scalar"};
+
+			for (const char* candidate : preferred)
+			{
+				if (isa_supported(candidate))
+				{
+					selected = candidate;
+					break;
+				}
+			}
+		}
+		else if (!isa_supported(isa))
+			throw std::invalid_argument("Instruction set " + isa + " is not supported by this CPU");
+
+		const bool cs16 = (format == FORMAT_CS16);
+
+#ifdef SAMPLE_FORMAT_X86
+		if (selected == "avx2")
+		{
+			converters.to_native = cs16 ? cs16_to_native_avx2 : cs12_to_native_avx2;
+			converters.from_native = cs16 ? cs16_from_native_avx2 : cs12_from_native_avx2;
+			converters.isa = "avx2";
+
+			return converters;
+		}
+
+		if (selected == "sse")
+		{
+			converters.to_native = cs16 ? cs16_to_native_sse : cs12_to_native_sse;
+			converters.from_native = cs16 ? cs16_from_native_sse : cs12_from_native_sse;
+			converters.isa = "sse";
+
+			return converters;
+		}
+#endif
+
+#ifdef SAMPLE_FORMAT_NEON
+		if (selected == "neon")
+		{
+			converters.to_native = cs16 ? cs16_to_native_neon : cs12_to_native_neon;
+			converters.from_native = cs16 ? cs16_from_native_neon : cs12_from_native_neon;
+			converters.isa = "neon";
+
+			return converters;
+		}
+#endif
+
+		converters.to_native = cs16 ? cs16_to_native_scalar : cs12_to_native_scalar;
+		converters.from_native = cs16 ? cs16_from_native_scalar : cs12_from_native_scalar;
+		converters.isa = "scalar";
+
+		return converters;
+	}
+}
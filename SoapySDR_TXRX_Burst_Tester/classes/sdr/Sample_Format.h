@@ -0,0 +1,47 @@
+#ifndef __SAMPLE_FORMAT_H__
+#define __SAMPLE_FORMAT_H__
+
+#include <complex>
+#include <string>
+#include <stddef.h>
+
+namespace sdr
+{
+	//stream sample formats supported by the tester, samples are always handed over as CF32 and converted
+	//to/from the stream format by the tester itself
+	//
+	//	CF32 - interleaved 32-bit float I/Q
+	//	CS16 - interleaved 16-bit signed integer I/Q (full scale 32768)
+	//	CS12 - 12-bit signed integer I/Q packed into 3 bytes (same full scale, lowest 4 bits dropped)
+	enum sample_format_t
+	{
+		FORMAT_CF32 = 0,
+		FORMAT_CS16 = 1,
+		FORMAT_CS12 = 2
+	};
+
+	//throws std::invalid_argument for formats other than CF32, CS16 and CS12
+	sample_format_t parse_sample_format(const std::string& format);
+	const char* sample_format_to_str(const sample_format_t format);
+
+	//number of bytes taken by a single complex sample
+	size_t sample_format_size(const sample_format_t format);
+
+	typedef void (*to_native_t)(const std::complex<float>* in, void* out, const size_t no_of_samples);
+	typedef void (*from_native_t)(const void* in, std::complex<float>* out, const size_t no_of_samples);
+
+	//conversion kernels of a single format, picked for the instruction set of the CPU the tester runs on
+	struct Sample_Converters
+	{
+		to_native_t to_native = nullptr;
+		from_native_t from_native = nullptr;
+		//instruction set the kernels use: scalar, sse, avx2 or neon (copy for CF32)
+		const char* isa = "scalar";
+	};
+
+	//isa may force given instruction set (e.g. for benchmarks), "auto" picks the best one supported,
+	//throws std::invalid_argument when forced instruction set is not supported by the CPU
+	Sample_Converters get_sample_converters(const sample_format_t format, const std::string& isa = "auto");
+}
+
+#endif
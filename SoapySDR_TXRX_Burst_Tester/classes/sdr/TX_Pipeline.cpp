@@ -0,0 +1,333 @@
+#include "TX_Pipeline.h"
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include <SoapySDR/Errors.hpp>
+#include <SoapySDR/Time.hpp>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	TX_Pipeline::TX_Pipeline(SDR_Device_Wrapper::sptr_t sdr_device_wrapper, const size_t pipeline_depth)
+	:
+		sdr_device_wrapper(sdr_device_wrapper),
+		trace_recorder(sdr_device_wrapper->get_trace_recorder()),
+		metrics(sdr_device_wrapper->get_metrics()),
+		in_flight(pipeline_depth > 0 ? pipeline_depth : 1)
+	{
+		running = true;
+		status_thread = boost::thread(&TX_Pipeline::status_thread_function, this);
+
+		msg("sdr: TX pipeline started with depth of " + to_string(in_flight.size()) + " bursts");
+	}
+
+	TX_Pipeline::~TX_Pipeline()
+	{
+		stop();
+	}
+
+	bool TX_Pipeline::submit(const int64_t tick, const std::complex<float>* const* samples, int no_of_requested_samples)
+	{
+		SDR_Device_Config::sptr_t device_cfg = sdr_device_wrapper->get_device_config();
+
+		const long long burst_time = SoapySDR::ticksToTimeNs(tick, device_cfg->f_clk);
+		const long long end_time = burst_time + SoapySDR::ticksToTimeNs((int64_t)max(no_of_requested_samples, 1) * device_cfg->D_tx, device_cfg->f_clk);
+
+		//end of the burst on host clock is known before it is registered, as its ack may come before writeStream
+		//returns (reading hardware time takes a control call when the clock is not tracked, so it is done unlocked)
+		const int64_t expected_end_host_time = sdr_device_wrapper->get_host_time(end_time);
+
+		In_Flight_Burst* burst;
+
+		{
+			boost::unique_lock<boost::mutex> lock(in_flight_mutex);
+
+			//wait for a free pipeline slot, but never forever - lost acknowledgements are expired by the status thread
+			while ((in_flight_count == in_flight.size()) && running && !utils::stop)
+				in_flight_cond.timed_wait(lock, boost::posix_time::milliseconds(100));
+
+			if (!running || utils::stop)
+				return false;
+
+			//burst is registered before it is written, as a late burst may be reported before writeStream returns
+			burst = &in_flight[(in_flight_head + in_flight_count) % in_flight.size()];
+
+			burst->seq = next_seq++;
+			burst->burst_time = burst_time;
+			burst->end_time = end_time;
+			burst->no_of_samples = no_of_requested_samples;
+			burst->submit_host_time = monotonic_time_ns();
+			burst->expected_end_host_time = expected_end_host_time;
+			burst->underflow = false;
+			burst->done = false;
+
+			in_flight_count++;
+		}
+
+		bool res = sdr_device_wrapper->send_samples(tick, samples, no_of_requested_samples, false);
+
+		boost::lock_guard<boost::mutex> guard(in_flight_mutex);
+
+		if (!res)
+		{
+			//a late burst may have been retired by the status thread already, it is accounted for there
+			if (!burst->done)
+			{
+				stats.no_of_failed_submissions++;
+
+				if (metrics)
+					metrics->tx_failed_bursts.add();
+
+				//nothing is going to be reported for this burst
+				burst->done = true;
+			}
+
+			release_retired();
+
+			return false;
+		}
+
+		stats.no_of_submitted_bursts++;
+
+		return true;
+	}
+
+	TX_Pipeline::In_Flight_Burst* TX_Pipeline::match_event(const int flags, const long long time_ns)
+	{
+		In_Flight_Burst* candidate = nullptr;
+		long long candidate_distance = 0;
+
+		for (size_t i = 0; i < in_flight_count; i++)
+		{
+			In_Flight_Burst& burst = in_flight[(in_flight_head + i) % in_flight.size()];
+
+			if (burst.done)
+				continue;
+
+			//events without a timestamp belong to the oldest burst still in flight
+			if (!(flags & SOAPY_SDR_HAS_TIME))
+				return &burst;
+
+			//burst acks are stamped with (roughly) the end of the burst, other events with a time within the burst,
+			//so back-to-back bursts are told apart by the closest end or the latest start respectively
+			long long distance;
+
+			if (flags & SOAPY_SDR_END_BURST)
+				distance = llabs(time_ns - burst.end_time);
+			else if (time_ns >= burst.burst_time)
+				distance = time_ns - burst.burst_time;
+			else
+				continue;
+
+			if ((candidate == nullptr) || (distance < candidate_distance))
+			{
+				candidate = &burst;
+				candidate_distance = distance;
+			}
+		}
+
+		//event older than any burst in flight, e.g. a late burst reported with its original time
+		if ((candidate == nullptr) && (in_flight_count > 0) && !in_flight[in_flight_head].done)
+			candidate = &in_flight[in_flight_head];
+
+		return candidate;
+	}
+
+	void TX_Pipeline::retire(In_Flight_Burst& burst, const int code, const int flags, const long long time_ns, const int64_t ack_host_time)
+	{
+		burst.done = true;
+
+		int64_t ack_latency = ack_host_time - burst.expected_end_host_time;
+
+		if (code == 0)
+		{
+			stats.no_of_acked_bursts++;
+
+			if ((stats.no_of_acked_bursts == 1) || (ack_latency < stats.min_ack_latency))
+				stats.min_ack_latency = ack_latency;
+			if ((stats.no_of_acked_bursts == 1) || (ack_latency > stats.max_ack_latency))
+				stats.max_ack_latency = ack_latency;
+			stats.sum_ack_latency += ack_latency;
+		}
+		else if (code == SOAPY_SDR_TIME_ERROR)
+			stats.no_of_late_bursts++;
+		else if (code == SOAPY_SDR_TIMEOUT)
+			stats.no_of_lost_acks++;
+		else
+			stats.no_of_other_errors++;
+
+		msgf
+		(
+			((code == 0) && !burst.underflow) ? INFO : WARNING,
+			"sdr: [TX ACK]  seq=%llu, burst_time: %lld, ack_code: %s%s, ack_latency=%lld [ns], submit_to_ack=%lld [ns]",
+			(unsigned long long)burst.seq,
+			burst.burst_time,
+			code_to_str(code),
+			burst.underflow ? " (SOAPY_SDR_UNDERFLOW)" : "",
+			(long long)ack_latency,
+			(long long)(ack_host_time - burst.submit_host_time)
+		);
+
+		if (trace_recorder)
+		{
+			Burst_Trace_Record record;
+
+			record.submit_host_time = burst.submit_host_time;
+			record.return_host_time = ack_host_time;
+			record.hardware_time = 0;
+			record.burst_time = burst.burst_time;
+			record.status_time = time_ns;
+			record.no_of_requested_samples = burst.no_of_samples;
+			record.no_of_transferred_samples = burst.no_of_samples;
+			record.stream_status = burst.underflow && (code == 0) ? SOAPY_SDR_UNDERFLOW : code;
+			record.flags = flags;
+
+			trace_recorder->record(TRACE_TX_ACK, record);
+		}
+
+		if (metrics)
+		{
+			metrics->count_code(SOAPY_SDR_TX, code);
+
+			if (code == 0)
+			{
+				metrics->tx_bursts.add();
+				metrics->tx_ack_latency.observe(ack_latency);
+			}
+			else
+				metrics->tx_failed_bursts.add();
+		}
+	}
+
+	void TX_Pipeline::release_retired()
+	{
+		//free all leading slots that have already been retired
+		while ((in_flight_count > 0) && in_flight[in_flight_head].done)
+		{
+			in_flight_head = (in_flight_head + 1) % in_flight.size();
+			in_flight_count--;
+		}
+
+		in_flight_cond.notify_all();
+	}
+
+	void TX_Pipeline::expire_lost_acks(const int64_t host_time)
+	{
+		int64_t timeout = 1e9 * sdr_device_wrapper->get_device_config()->T_timeout;
+
+		for (size_t i = 0; i < in_flight_count; i++)
+		{
+			In_Flight_Burst& burst = in_flight[(in_flight_head + i) % in_flight.size()];
+
+			if (!burst.done && (host_time > burst.expected_end_host_time + timeout))
+				retire(burst, SOAPY_SDR_TIMEOUT, 0, 0, host_time);
+		}
+
+		release_retired();
+	}
+
+	void TX_Pipeline::status_thread_function()
+	{
+		SoapySDR::Device* device = sdr_device_wrapper->get_device();
+		SoapySDR::Stream* tx_stream = sdr_device_wrapper->get_tx_stream();
+
+		try
+		{
+			while (running)
+			{
+				size_t chan_mask = 0;
+				int flags = 0;
+				long long time_ns = 0;
+
+				//short timeout, so stopping the pipeline and expiring lost acks do not wait for T_timeout
+				int ret = device->readStreamStatus(tx_stream, chan_mask, flags, time_ns, 100000);
+
+				int64_t host_time = monotonic_time_ns();
+
+				boost::lock_guard<boost::mutex> guard(in_flight_mutex);
+
+				if ((ret == SOAPY_SDR_TIMEOUT) || (ret == SOAPY_SDR_NOT_SUPPORTED))
+				{
+					expire_lost_acks(host_time);
+
+					if (ret == SOAPY_SDR_NOT_SUPPORTED)
+						usleep(1000);
+
+					continue;
+				}
+
+				In_Flight_Burst* burst = match_event(flags, time_ns);
+
+				if (burst == nullptr)
+				{
+					stats.no_of_unmatched_events++;
+					msgf(WARNING, "sdr: [TX ACK]  unmatched status event: %s, time_ns: %lld", code_to_str(ret), time_ns);
+					continue;
+				}
+
+				//underflow may be reported in the middle of a burst, which is still acknowledged afterwards
+				if (ret == SOAPY_SDR_UNDERFLOW)
+				{
+					burst->underflow = true;
+					stats.no_of_underflows++;
+
+					if (metrics)
+						metrics->count_code(SOAPY_SDR_TX, ret);
+
+					continue;
+				}
+
+				retire(*burst, ret, flags, time_ns, host_time);
+				release_retired();
+			}
+		}
+		catch (const std::exception& e)
+		{
+			msg("sdr: TX pipeline status thread: " + string(e.what()), WARNING);
+		}
+	}
+
+	void TX_Pipeline::stop()
+	{
+		{
+			boost::lock_guard<boost::mutex> guard(in_flight_mutex);
+
+			if (!running)
+				return;
+
+			running = false;
+			in_flight_cond.notify_all();
+		}
+
+		if (status_thread.joinable())
+			status_thread.join();
+	}
+
+	TX_Pipeline_Stats TX_Pipeline::get_stats()
+	{
+		boost::lock_guard<boost::mutex> guard(in_flight_mutex);
+
+		return stats;
+	}
+
+	boost::thread::native_handle_type TX_Pipeline::get_native_handle()
+	{
+		return status_thread.native_handle();
+	}
+
+	void TX_Pipeline::print_stats()
+	{
+		TX_Pipeline_Stats s = get_stats();
+
+		int64_t avg_ack_latency = (s.no_of_acked_bursts > 0) ? s.sum_ack_latency / (int64_t)s.no_of_acked_bursts : 0;
+
+		msg("sdr: TX pipeline: submitted=" + to_string(s.no_of_submitted_bursts) + ", failed_submissions=" + to_string(s.no_of_failed_submissions) + ", acked=" + to_string(s.no_of_acked_bursts) + ", late=" + to_string(s.no_of_late_bursts) + ", underflows=" + to_string(s.no_of_underflows) + ", lost_acks=" + to_string(s.no_of_lost_acks) + ", other_errors=" + to_string(s.no_of_other_errors) + ", unmatched_events=" + to_string(s.no_of_unmatched_events));
+		msg("sdr: TX pipeline: ack_latency min/avg/max=" + to_string(s.min_ack_latency) + "/" + to_string(avg_ack_latency) + "/" + to_string(s.max_ack_latency) + " [ns]");
+	}
+}
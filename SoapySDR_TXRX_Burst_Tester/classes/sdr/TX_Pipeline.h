@@ -0,0 +1,89 @@
+#ifndef __TX_PIPELINE_H__
+#define __TX_PIPELINE_H__
+
+#include <vector>
+#include <complex>
+#include <stdint.h>
+
+#include <boost/thread.hpp>
+
+#include "SDR_Device_Wrapper.h"
+
+namespace sdr
+{
+	//statistics gathered by TX_Pipeline
+	struct TX_Pipeline_Stats
+	{
+		uint64_t no_of_submitted_bursts = 0;
+		uint64_t no_of_failed_submissions = 0;
+		uint64_t no_of_acked_bursts = 0;
+		uint64_t no_of_late_bursts = 0;
+		uint64_t no_of_underflows = 0;
+		uint64_t no_of_lost_acks = 0;
+		uint64_t no_of_other_errors = 0;
+		uint64_t no_of_unmatched_events = 0;
+		int64_t min_ack_latency = 0;
+		int64_t max_ack_latency = 0;
+		int64_t sum_ack_latency = 0;
+	};
+
+	//TX engine that keeps up to pipeline_depth timed bursts queued on the device, while a separate
+	//status thread drains readStreamStatus events and matches them back to the bursts by their timeNs
+	class TX_Pipeline
+	{
+	private:
+		//burst that has been written to the device but not acknowledged yet
+		struct In_Flight_Burst
+		{
+			uint64_t seq = 0;
+			long long burst_time = 0;
+			long long end_time = 0;
+			int no_of_samples = 0;
+			int64_t submit_host_time = 0;
+			int64_t expected_end_host_time = 0;
+			bool underflow = false;
+			bool done = false;
+		};
+
+		SDR_Device_Wrapper::sptr_t sdr_device_wrapper;
+		Burst_Trace_Recorder::sptr_t trace_recorder;
+		SDR_Metrics::sptr_t metrics;
+
+		//preallocated ring of in-flight bursts, guarded by in_flight_mutex
+		std::vector<In_Flight_Burst> in_flight;
+		size_t in_flight_head = 0;
+		size_t in_flight_count = 0;
+		boost::mutex in_flight_mutex;
+		boost::condition_variable in_flight_cond;
+
+		uint64_t next_seq = 0;
+		bool running = false;
+
+		TX_Pipeline_Stats stats;
+
+		boost::thread status_thread;
+
+		void status_thread_function();
+		In_Flight_Burst* match_event(const int flags, const long long time_ns);
+		void retire(In_Flight_Burst& burst, const int code, const int flags, const long long time_ns, const int64_t ack_host_time);
+		void release_retired();
+		void expire_lost_acks(const int64_t host_time);
+
+	public:
+		typedef boost::shared_ptr<TX_Pipeline> sptr_t;
+
+		TX_Pipeline(SDR_Device_Wrapper::sptr_t sdr_device_wrapper, const size_t pipeline_depth);
+		~TX_Pipeline();
+
+		//blocks only while pipeline_depth bursts are still waiting for their acknowledgement, samples hold a buffer per TX channel
+		bool submit(const int64_t tick, const std::complex<float>* const* samples, int no_of_requested_samples);
+
+		void stop();
+
+		TX_Pipeline_Stats get_stats();
+		boost::thread::native_handle_type get_native_handle();
+		void print_stats();
+	};
+}
+
+#endif
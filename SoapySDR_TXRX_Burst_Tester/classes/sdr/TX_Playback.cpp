@@ -0,0 +1,266 @@
+#include "TX_Playback.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdexcept>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	//smallest read-ahead window, large enough for the kernel to issue big sequential reads
+	static const uint64_t MIN_WINDOW_SIZE = 8 << 20;
+
+	TX_Playback::TX_Playback(const std::string& filepath, const std::string& format, const size_t slice_length, const size_t no_of_buffers, const bool loop)
+	:
+		filepath(filepath),
+		format(parse_sample_format(format)),
+		sample_size(sample_format_size(this->format)),
+		from_native(get_sample_converters(this->format).from_native),
+		no_of_file_samples(0),
+		slice_length(max(slice_length, (size_t)1)),
+		loop(loop),
+		zero_samples(this->slice_length),
+		end_reached(false),
+		running(false)
+	{
+		fd = open(filepath.c_str(), O_RDONLY);
+
+		if (fd < 0)
+			throw std::runtime_error("Unable to open playback file " + filepath + ": " + string(strerror(errno)));
+
+		struct stat file_stat;
+
+		if (fstat(fd, &file_stat) != 0)
+		{
+			::close(fd);
+			throw std::runtime_error("Unable to stat playback file " + filepath + ": " + string(strerror(errno)));
+		}
+
+		//a trailing partial sample is ignored
+		no_of_file_samples = file_stat.st_size / sample_size;
+
+		if (no_of_file_samples == 0)
+		{
+			::close(fd);
+			throw std::runtime_error("Playback file " + filepath + " holds no " + string(sample_format_to_str(this->format)) + " samples");
+		}
+
+		mapping_size = no_of_file_samples * sample_size;
+
+		//pages are not populated, the file may be far larger than RAM - the prefetch thread pages it in ahead of the TX thread
+		void* addr = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+
+		if (addr == MAP_FAILED)
+		{
+			::close(fd);
+			throw std::runtime_error("Unable to map playback file " + filepath + ": " + string(strerror(errno)));
+		}
+
+		mapping = static_cast<char*>(addr);
+
+		//pages of the file are not kept locked by RT.mlockall (see lock_memory), the prefetch window decides what stays
+		//resident and MADV_DONTNEED would fail on locked pages
+		if (munlock(mapping, mapping_size) != 0)
+			msg("sdr: Unable to unlock playback file mapping: " + string(strerror(errno)), WARNING);
+
+		if (madvise(mapping, mapping_size, MADV_SEQUENTIAL) != 0)
+			msg("sdr: Unable to advise sequential access to playback file: " + string(strerror(errno)), WARNING);
+
+		const size_t page_size = sysconf(_SC_PAGESIZE);
+
+		window_size = max(MIN_WINDOW_SIZE, (uint64_t)(4 * no_of_buffers * this->slice_length * sample_size));
+		window_size = (window_size + page_size - 1) / page_size * page_size;
+
+		Slice prototype;
+		prototype.samples.resize(this->slice_length);
+
+		ring.reset(new ring_t(no_of_buffers, prototype));
+
+		//first bursts are sent from slices converted here, so they do not stall while the prefetch thread starts
+		fill();
+
+		running = true;
+		prefetch_thread = boost::thread(&TX_Playback::prefetch_thread_function, this);
+
+		msg("sdr: TX bursts are played from " + filepath + " (" + to_string(no_of_file_samples) + " " + sample_format_to_str(this->format) + " samples, " + to_string(mapping_size >> 20) + " MB, " + to_string(ring->capacity()) + " buffers of " + to_string(this->slice_length) + " samples" + (loop ? ", looping)" : ")"));
+	}
+
+	TX_Playback::~TX_Playback()
+	{
+		stop();
+	}
+
+	void TX_Playback::advise(const uint64_t from, const uint64_t to, const int advice)
+	{
+		const uint64_t page_mask = ~(uint64_t)(sysconf(_SC_PAGESIZE) - 1);
+
+		uint64_t current = from;
+
+		while (current < to)
+		{
+			uint64_t offset = current % mapping_size;
+			uint64_t length = min(to - current, mapping_size - offset);
+			uint64_t begin = offset & page_mask;
+			uint64_t end = offset + length;
+
+			//pages are dropped only once every byte of them has been played
+			if ((advice == MADV_DONTNEED) && (end != mapping_size))
+				end &= page_mask;
+
+			if ((end > begin) && (madvise(mapping + begin, end - begin, advice) != 0))
+			{
+				//reported once, failing advice does not stop the playback, it only loses read-ahead or bounded memory
+				if (stats.no_of_advise_failures++ == 0)
+					msg("sdr: Unable to advise playback file pages (" + string((advice == MADV_DONTNEED) ? "MADV_DONTNEED" : "MADV_WILLNEED") + "): " + string(strerror(errno)), WARNING);
+			}
+
+			current += length;
+		}
+	}
+
+	size_t TX_Playback::fill()
+	{
+		size_t no_of_slices = 0;
+
+		while (!end_reached)
+		{
+			Slice* slice = ring->claim();
+
+			if (slice == nullptr)
+				break;
+
+			int64_t start_time = monotonic_time_ns();
+
+			//pages ahead are requested in steps of half the window, so the kernel reads them while earlier slices are converted
+			uint64_t advise_limit = loop ? position + window_size : min(position + window_size, (uint64_t)mapping_size);
+
+			if (advised_position < min(position + window_size / 2, advise_limit))
+			{
+				advise(max(advised_position, position), advise_limit, MADV_WILLNEED);
+				advised_position = advise_limit;
+			}
+
+			size_t n = 0;
+
+			while (n < slice_length)
+			{
+				//a file without loop is padded with zeros past its end
+				if (!loop && (position >= mapping_size))
+				{
+					std::fill(slice->samples.begin() + n, slice->samples.end(), std::complex<float>(0, 0));
+					break;
+				}
+
+				uint64_t offset = position % mapping_size;
+				size_t count = min((uint64_t)(slice_length - n), (mapping_size - offset) / sample_size);
+
+				from_native(mapping + offset, &slice->samples[n], count);
+
+				n += count;
+				position += count * sample_size;
+				stats.no_of_read_bytes += count * sample_size;
+
+				if (loop && (offset + count * sample_size == mapping_size))
+					stats.no_of_loops++;
+			}
+
+			//played pages of files that do not fit into the window twice are dropped, smaller ones stay resident
+			if ((mapping_size > 2 * window_size) && (position - dropped_position >= window_size / 2))
+			{
+				advise(dropped_position, position, MADV_DONTNEED);
+				dropped_position = position;
+			}
+
+			ring->publish();
+			no_of_slices++;
+
+			int64_t fill_time = monotonic_time_ns() - start_time;
+
+			stats.no_of_filled_slices++;
+			stats.sum_fill_time += fill_time;
+			stats.max_fill_time = max(stats.max_fill_time, fill_time);
+
+			//set only after the last slice has been published, so the TX thread never takes it for the end
+			if (!loop && (position >= mapping_size))
+				end_reached = true;
+		}
+
+		return no_of_slices;
+	}
+
+	void TX_Playback::prefetch_thread_function()
+	{
+		while (running)
+		{
+			if (fill() == 0)
+				usleep(100);
+		}
+	}
+
+	const std::complex<float>* TX_Playback::next()
+	{
+		//read before the ring, so an empty ring after the end has been reached means all slices have been played
+		bool end = end_reached;
+
+		Slice* slice = ring->peek();
+
+		holding_slice = (slice != nullptr);
+
+		if (slice != nullptr)
+		{
+			stats.no_of_played_bursts++;
+			return &slice->samples[0];
+		}
+
+		if (!end)
+			stats.no_of_stalls++;
+		else if (!end_reported)
+		{
+			msg("sdr: Playback of " + filepath + " finished, TX bursts carry zeros from now on");
+			end_reported = true;
+		}
+
+		return &zero_samples[0];
+	}
+
+	void TX_Playback::release()
+	{
+		if (holding_slice)
+			ring->release();
+
+		holding_slice = false;
+	}
+
+	void TX_Playback::stop()
+	{
+		if (!running.exchange(false) && (mapping == nullptr))
+			return;
+
+		if (prefetch_thread.joinable())
+			prefetch_thread.join();
+
+		if (mapping != nullptr)
+		{
+			munmap(mapping, mapping_size);
+			::close(fd);
+
+			mapping = nullptr;
+			fd = -1;
+		}
+	}
+
+	void TX_Playback::print_stats()
+	{
+		double avg_fill_time = stats.no_of_filled_slices ? (double)stats.sum_fill_time / stats.no_of_filled_slices : 0;
+
+		msg("sdr: TX playback: played_bursts=" + to_string(stats.no_of_played_bursts) + ", stalls=" + to_string(stats.no_of_stalls) + ", loops=" + to_string(stats.no_of_loops) + ", advise_failures=" + to_string(stats.no_of_advise_failures) + ", read=" + to_string(stats.no_of_read_bytes >> 20) + " MB, fill_time avg/max=" + to_string(avg_fill_time / 1e3) + "/" + to_string(stats.max_fill_time / 1e3) + " [us], file=" + filepath);
+	}
+}
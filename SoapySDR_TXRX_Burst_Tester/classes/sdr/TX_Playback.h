@@ -0,0 +1,116 @@
+#ifndef __TX_PLAYBACK_H__
+#define __TX_PLAYBACK_H__
+
+#include <atomic>
+#include <complex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "Sample_Format.h"
+#include "../utils/SPSC_Ring.h"
+
+namespace sdr
+{
+	//statistics gathered by TX_Playback, fill times in [ns]
+	//
+	//	no_of_played_bursts	- bursts taken by the TX thread from the ring
+	//	no_of_stalls		- bursts the TX thread found no prefetched slice for (zeros were sent instead)
+	//	no_of_loops			- times the file has been played to its end and started over
+	//	no_of_read_bytes	- bytes of the file converted by the prefetch thread
+	//	no_of_advise_failures	- madvise calls of the prefetch window that have failed
+	struct TX_Playback_Stats
+	{
+		uint64_t no_of_played_bursts = 0;
+		uint64_t no_of_stalls = 0;
+		uint64_t no_of_loops = 0;
+		uint64_t no_of_read_bytes = 0;
+		uint64_t no_of_advise_failures = 0;
+		uint64_t no_of_filled_slices = 0;
+		int64_t max_fill_time = 0;
+		int64_t sum_fill_time = 0;
+	};
+
+	//TX payloads played from a raw IQ file (interleaved samples in CF32, CS16 or CS12) instead of the waveform
+	//library - the file is sliced into consecutive bursts of slice_length samples, shorter TX slots send only the
+	//beginning of their slice
+	//
+	//the file is memory-mapped read-only, a prefetch thread converts the following slices into a lock-free ring of
+	//preallocated CF32 buffers, asks the kernel to read ahead of it (MADV_WILLNEED) and to drop pages played long
+	//ago (MADV_DONTNEED), so neither page faults nor conversion ever happen on the TX thread and files far larger
+	//than RAM stream through a bounded window of memory
+	//
+	//meant to be used from a single TX thread: next() gives the slice to be sent, release() hands its buffer back
+	//to the prefetch thread once it has been sent
+	class TX_Playback
+	{
+	private:
+		//slice converted by the prefetch thread
+		struct Slice
+		{
+			std::vector<std::complex<float>> samples;
+		};
+
+		int fd = -1;
+		char* mapping = nullptr;
+		size_t mapping_size = 0;
+
+		std::string filepath;
+		sample_format_t format;
+		size_t sample_size;
+		from_native_t from_native;
+		uint64_t no_of_file_samples;
+		size_t slice_length;
+		bool loop;
+
+		//bytes kept advised ahead of and resident behind the prefetch position
+		uint64_t window_size;
+
+		typedef utils::SPSC_Ring<Slice> ring_t;
+		boost::shared_ptr<ring_t> ring;
+
+		//prefetch thread state, positions of the stream of bytes played so far (they keep growing across loops)
+		uint64_t position = 0;
+		uint64_t advised_position = 0;
+		uint64_t dropped_position = 0;
+
+		//TX thread state, zero_samples are sent by stalled bursts and once a file without loop has been played
+		std::vector<std::complex<float>> zero_samples;
+		bool holding_slice = false;
+		bool end_reported = false;
+
+		std::atomic<bool> end_reached;
+		std::atomic<bool> running;
+		TX_Playback_Stats stats;
+
+		boost::thread prefetch_thread;
+
+		void prefetch_thread_function();
+		//converts slices into the ring until it is full or the end of the file is reached, returns number of slices
+		size_t fill();
+		//applies advice to bytes [from, to) of the played stream, i.e. to the file pages they wrap onto
+		void advise(const uint64_t from, const uint64_t to, const int advice);
+
+	public:
+		typedef boost::shared_ptr<TX_Playback> sptr_t;
+
+		//no_of_buffers slices are prefetched ahead of the TX thread (the ring is filled before the constructor
+		//returns), throws std::invalid_argument for an unsupported format and std::runtime_error when the file
+		//cannot be opened or mapped or holds no samples
+		TX_Playback(const std::string& filepath, const std::string& format, const size_t slice_length, const size_t no_of_buffers, const bool loop);
+		~TX_Playback();
+
+		//slice_length samples of the following slice, never blocks
+		const std::complex<float>* next();
+		//called once the slice returned by next() has been sent
+		void release();
+
+		void stop();
+		void print_stats();
+	};
+}
+
+#endif
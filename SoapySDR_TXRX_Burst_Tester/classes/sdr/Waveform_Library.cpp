@@ -0,0 +1,384 @@
+#include "Waveform_Library.h"
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <stdexcept>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sdr
+{
+	//phases are kept as 32-bit integers where the whole range maps onto [-pi, pi)
+	static const double PHASE_SCALE = 4294967295.0;
+	static const float PHASE_TO_RADIANS = M_PI / 2147483648.0;
+
+	//number of samples generated at once, so phases fit into a stack buffer
+	static const size_t CHUNK_SIZE = 1024;
+
+	//rounds to the nearest integer for |x| < 2^51 by plain additions, so the loops below vectorise on any SSE2 CPU
+	static inline double round_to_integer(const double x)
+	{
+		const double magic = 6755399441055744.0;
+
+		return (x + magic) - magic;
+	}
+
+	//sin() of a phase folded into [-pi/2, pi/2] (by integer arithmetic, so the loop below stays branch free)
+	//and evaluated by a minimax polynomial
+	static inline float fast_sin(int32_t phase)
+	{
+		int32_t folded = (int32_t)(0x80000000u - (uint32_t)phase);
+
+		phase = ((phase > 0x40000000) | (phase < -0x40000000)) ? folded : phase;
+
+		float x = phase * PHASE_TO_RADIANS;
+		float x2 = x * x;
+
+		return x * (1.0f + x2 * (-0.16666667f + x2 * (0.0083333310f + x2 * (-0.00019840874f + x2 * 2.7525562e-6f))));
+	}
+
+	//phase of a linear chirp (a tone when rate is 0) in cycles: start * n + rate * n^2 / 2,
+	//only its fractional part is kept
+	VECTORISED_KERNEL static void chirp_phase(int32_t* phase, const size_t first, const size_t no_of_samples, const double start, const double rate)
+	{
+		double n = first;
+
+		for (size_t i = 0; i < no_of_samples; i++)
+		{
+			double cycles = start * n + 0.5 * rate * n * n;
+
+			phase[i] = (int32_t)((cycles - round_to_integer(cycles)) * PHASE_SCALE);
+			n += 1.0;
+		}
+	}
+
+	//numerically controlled oscillator output for given phases, cos() is evaluated as sin() of the phase shifted by pi/2
+	VECTORISED_KERNEL static void phase_to_iq(const int32_t* phase, std::complex<float>* samples, const size_t no_of_samples, const float amplitude)
+	{
+		float* out = reinterpret_cast<float*>(samples);
+
+		for (size_t i = 0; i < no_of_samples; i++)
+		{
+			out[2 * i] = amplitude * fast_sin((int32_t)((uint32_t)phase[i] + 0x40000000u));
+			out[2 * i + 1] = amplitude * fast_sin(phase[i]);
+		}
+	}
+
+	static void generate_chirp(std::complex<float>* samples, const size_t no_of_samples, const double start, const double rate, const float amplitude)
+	{
+		int32_t phase[CHUNK_SIZE];
+
+		for (size_t first = 0; first < no_of_samples; first += CHUNK_SIZE)
+		{
+			size_t n = min(CHUNK_SIZE, no_of_samples - first);
+
+			chirp_phase(phase, first, n, start, rate);
+			phase_to_iq(phase, samples + first, n, amplitude);
+		}
+	}
+
+	static void generate_zadoff_chu(std::complex<float>* samples, const size_t no_of_samples, const int64_t root, const int64_t length, const float amplitude)
+	{
+		int32_t phase[CHUNK_SIZE];
+
+		size_t no_of_sequence_samples = min(no_of_samples, (size_t)length);
+
+		//x[n] = exp(-j * pi * root * n * (n + 1) / length), the exponent is reduced modulo length exactly
+		for (size_t first = 0; first < no_of_sequence_samples; first += CHUNK_SIZE)
+		{
+			size_t n = min(CHUNK_SIZE, no_of_sequence_samples - first);
+
+			for (size_t i = 0; i < n; i++)
+			{
+				int64_t k = first + i;
+				int64_t exponent = (root * ((k * (k + 1) / 2) % length)) % length;
+				double cycles = -(double)exponent / (double)length;
+
+				phase[i] = (int32_t)((cycles - round_to_integer(cycles)) * PHASE_SCALE);
+			}
+
+			phase_to_iq(phase, samples + first, n, amplitude);
+		}
+
+		for (size_t i = no_of_sequence_samples; i < no_of_samples; i++)
+			samples[i] = std::complex<float>(0, 0);
+	}
+
+	static void generate_qpsk(std::complex<float>* samples, const size_t no_of_samples, const int prbs_order, const int samples_per_symbol, const float amplitude)
+	{
+		//feedback taps of ITU-T O.150 sequences
+		int tap;
+
+		switch (prbs_order)
+		{
+			case 7: tap = 6; break;
+			case 9: tap = 5; break;
+			case 15: tap = 14; break;
+			case 23: tap = 18; break;
+			default: tap = 28; break;
+		}
+
+		const uint32_t mask = (uint32_t)((1ull << prbs_order) - 1);
+		const float level = amplitude * (float)M_SQRT1_2;
+
+		uint32_t state = mask;
+
+		for (size_t i = 0; i < no_of_samples; i += samples_per_symbol)
+		{
+			int bits[2];
+
+			for (int k = 0; k < 2; k++)
+			{
+				bits[k] = ((state >> (prbs_order - 1)) ^ (state >> (tap - 1))) & 1;
+				state = ((state << 1) | bits[k]) & mask;
+			}
+
+			std::complex<float> symbol(bits[0] ? -level : level, bits[1] ? -level : level);
+
+			for (size_t j = i; j < min(no_of_samples, i + samples_per_symbol); j++)
+				samples[j] = symbol;
+		}
+	}
+
+	static void load_waveform(std::complex<float>* samples, const size_t no_of_samples, const string& filepath)
+	{
+		FILE* file = fopen(filepath.c_str(), "rb");
+
+		if (file == nullptr)
+			throw std::runtime_error("Unable to open waveform file " + filepath + ": " + string(strerror(errno)));
+
+		size_t no_of_read_samples = fread(samples, sizeof(std::complex<float>), no_of_samples, file);
+
+		fclose(file);
+
+		if (no_of_read_samples < no_of_samples)
+		{
+			msg("sdr: Waveform file " + filepath + " holds only " + to_string(no_of_read_samples) + " of " + to_string(no_of_samples) + " samples, the rest is zero padded", WARNING);
+
+			for (size_t i = no_of_read_samples; i < no_of_samples; i++)
+				samples[i] = std::complex<float>(0, 0);
+		}
+	}
+
+	//stod() that reports failures together with the whole description
+	static double parse_number(const string& description, const string& field)
+	{
+		try
+		{
+			return stod(field);
+		}
+		catch (const std::exception& e)
+		{
+			throw std::invalid_argument("Waveform '" + description + "' has an invalid number " + field);
+		}
+	}
+
+	Waveform_Description parse_waveform(const std::string& description)
+	{
+		vector<string> fields = explode(description, ':');
+
+		if (fields.empty())
+			throw std::invalid_argument("Waveform description is empty");
+
+		Waveform_Description waveform;
+
+		//optional trailing amplitude following given number of mandatory fields
+		auto parse_amplitude = [&](const size_t position)
+		{
+			if (fields.size() > position + 1)
+				throw std::invalid_argument("Waveform '" + description + "' has too many fields");
+
+			if (fields.size() == position + 1)
+				waveform.amplitude = parse_number(description, fields[position]);
+		};
+
+		if (fields[0] == "constant")
+		{
+			waveform.type = WAVEFORM_CONSTANT;
+			parse_amplitude(1);
+		}
+		else if ((fields[0] == "tone") && (fields.size() >= 2))
+		{
+			waveform.type = WAVEFORM_TONE;
+			waveform.start_frequency = parse_number(description, fields[1]);
+			waveform.stop_frequency = waveform.start_frequency;
+			parse_amplitude(2);
+		}
+		else if ((fields[0] == "chirp") && (fields.size() >= 3))
+		{
+			waveform.type = WAVEFORM_CHIRP;
+			waveform.start_frequency = parse_number(description, fields[1]);
+			waveform.stop_frequency = parse_number(description, fields[2]);
+			parse_amplitude(3);
+		}
+		else if ((fields[0] == "zc") && (fields.size() >= 3))
+		{
+			waveform.type = WAVEFORM_ZADOFF_CHU;
+			waveform.root = parse_number(description, fields[1]);
+			waveform.length = parse_number(description, fields[2]);
+			parse_amplitude(3);
+
+			if ((waveform.length <= 0) || (waveform.length % 2 == 0) || (waveform.root <= 0) || (waveform.root >= waveform.length))
+				throw std::invalid_argument("Waveform '" + description + "' needs odd length and root within (0, length)");
+		}
+		else if ((fields[0] == "qpsk") && (fields.size() >= 2))
+		{
+			waveform.type = WAVEFORM_QPSK;
+			waveform.prbs_order = parse_number(description, fields[1]);
+
+			if (fields.size() >= 3)
+				waveform.samples_per_symbol = parse_number(description, fields[2]);
+
+			parse_amplitude(3);
+
+			if ((waveform.prbs_order != 7) && (waveform.prbs_order != 9) && (waveform.prbs_order != 15) && (waveform.prbs_order != 23) && (waveform.prbs_order != 31))
+				throw std::invalid_argument("Waveform '" + description + "' has unsupported PRBS order (expected 7, 9, 15, 23 or 31)");
+
+			if (waveform.samples_per_symbol <= 0)
+				throw std::invalid_argument("Waveform '" + description + "' needs positive number of samples per symbol");
+		}
+		else if ((fields[0] == "file") && (fields.size() >= 2))
+		{
+			waveform.type = WAVEFORM_FILE;
+			//path may contain colons itself
+			waveform.filepath = description.substr(description.find(':') + 1);
+		}
+		else
+			throw std::invalid_argument("Waveform '" + description + "' is not one of constant, tone, chirp, zc, qpsk or file (or lacks some of its fields)");
+
+		return waveform;
+	}
+
+	Waveform_Library::Waveform_Library(const std::vector<std::string>& descriptions, const size_t no_of_samples, const double sampling_rate)
+	:
+		no_of_samples(no_of_samples),
+		descriptions(descriptions)
+	{
+		if (descriptions.empty())
+			throw std::invalid_argument("Waveform library needs at least one waveform");
+
+		int64_t start_time = monotonic_time_ns();
+
+		//every waveform starts on a cache line boundary, the whole arena on a page boundary
+		const size_t page_size = sysconf(_SC_PAGESIZE);
+		const size_t waveform_size = (max(no_of_samples, (size_t)1) * sizeof(std::complex<float>) + 63) / 64 * 64;
+
+		arena_size = (descriptions.size() * waveform_size + page_size - 1) / page_size * page_size;
+
+		void* ptr = nullptr;
+
+		if (posix_memalign(&ptr, page_size, arena_size) != 0)
+			throw std::runtime_error("Unable to allocate " + to_string(arena_size) + " bytes of waveform library");
+
+		arena = static_cast<char*>(ptr);
+
+		try
+		{
+			for (size_t i = 0; i < descriptions.size(); i++)
+			{
+				std::complex<float>* samples = reinterpret_cast<std::complex<float>*>(arena + i * waveform_size);
+
+				generate(parse_waveform(descriptions[i]), samples, sampling_rate);
+				waveforms.push_back(samples);
+			}
+		}
+		catch (...)
+		{
+			free(arena);
+			arena = nullptr;
+			throw;
+		}
+
+		//generating has touched every page already, locking keeps them resident
+		locked = (mlock(arena, arena_size) == 0);
+
+		if (!locked)
+			msg("sdr: Waveform library could not be page-locked: " + string(strerror(errno)), WARNING);
+
+		msgf
+		(
+			INFO,
+			"sdr: Waveform library: %zu waveforms of %zu samples generated in %.3f [ms]%s",
+			waveforms.size(),
+			no_of_samples,
+			(monotonic_time_ns() - start_time) / 1e6,
+			locked ? " (page-locked)" : ""
+		);
+	}
+
+	Waveform_Library::~Waveform_Library()
+	{
+		if (locked)
+			munlock(arena, arena_size);
+
+		free(arena);
+	}
+
+	void Waveform_Library::generate(const Waveform_Description& description, std::complex<float>* samples, const double sampling_rate)
+	{
+		const float amplitude = description.amplitude;
+
+		switch (description.type)
+		{
+			case WAVEFORM_TONE:
+			case WAVEFORM_CHIRP:
+			{
+				if ((fabs(description.start_frequency) > sampling_rate / 2) || (fabs(description.stop_frequency) > sampling_rate / 2))
+					msg("sdr: Waveform frequencies exceed +/- half of the sampling rate (" + to_string(sampling_rate / 2) + " [Hz]), they will be aliased", WARNING);
+
+				//frequency sweeps linearly from start to stop over the whole burst
+				double start = description.start_frequency / sampling_rate;
+				double rate = (no_of_samples > 1) ? (description.stop_frequency - description.start_frequency) / sampling_rate / (no_of_samples - 1) : 0;
+
+				generate_chirp(samples, no_of_samples, start, rate, amplitude);
+				break;
+			}
+			case WAVEFORM_ZADOFF_CHU:
+				generate_zadoff_chu(samples, no_of_samples, description.root, description.length, amplitude);
+				break;
+			case WAVEFORM_QPSK:
+				generate_qpsk(samples, no_of_samples, description.prbs_order, description.samples_per_symbol, amplitude);
+				break;
+			case WAVEFORM_FILE:
+				load_waveform(samples, no_of_samples, description.filepath);
+				break;
+			default:
+				for (size_t i = 0; i < no_of_samples; i++)
+					samples[i] = std::complex<float>(amplitude, 0);
+				break;
+		}
+	}
+
+	size_t Waveform_Library::size() const
+	{
+		return waveforms.size();
+	}
+
+	size_t Waveform_Library::get_no_of_samples() const
+	{
+		return no_of_samples;
+	}
+
+	const std::complex<float>* Waveform_Library::get(const size_t waveform) const
+	{
+		return waveforms[waveform];
+	}
+
+	size_t Waveform_Library::get_frame_waveform(const uint64_t frame) const
+	{
+		return frame % waveforms.size();
+	}
+
+	const std::string& Waveform_Library::get_description(const size_t waveform) const
+	{
+		return descriptions[waveform];
+	}
+}
@@ -0,0 +1,84 @@
+#ifndef __WAVEFORM_LIBRARY_H__
+#define __WAVEFORM_LIBRARY_H__
+
+#include <complex>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+
+namespace sdr
+{
+	enum waveform_type_t
+	{
+		WAVEFORM_CONSTANT,
+		WAVEFORM_TONE,
+		WAVEFORM_CHIRP,
+		WAVEFORM_ZADOFF_CHU,
+		WAVEFORM_QPSK,
+		WAVEFORM_FILE
+	};
+
+	//single TX burst payload, frequencies in [Hz] relative to the center frequency
+	struct Waveform_Description
+	{
+		waveform_type_t type = WAVEFORM_CONSTANT;
+		double amplitude = 1.0;
+		double start_frequency = 0;
+		double stop_frequency = 0;
+		//Zadoff-Chu root and (odd) length
+		int64_t root = 1;
+		int64_t length = 139;
+		//PRBS order (7, 9, 15, 23 or 31) and number of samples every QPSK symbol is held for
+		int prbs_order = 9;
+		int samples_per_symbol = 1;
+		//raw interleaved float I/Q (cf32) file
+		std::string filepath;
+	};
+
+	//parses waveform description in one of following forms (throws std::invalid_argument when it is not valid):
+	//
+	//	constant[:AMPLITUDE]
+	//	tone:FREQUENCY[:AMPLITUDE]
+	//	chirp:START_FREQUENCY:STOP_FREQUENCY[:AMPLITUDE]
+	//	zc:ROOT:LENGTH[:AMPLITUDE]							- Zadoff-Chu preamble at the burst start, zeros afterwards
+	//	qpsk:PRBS_ORDER[:SAMPLES_PER_SYMBOL[:AMPLITUDE]]	- PRBS modulated QPSK
+	//	file:PATH											- raw cf32 samples, zero padded or cut to the burst length
+	Waveform_Description parse_waveform(const std::string& description);
+
+	//TX burst payloads precomputed once at startup into a single aligned, page-locked arena, so TX bursts only
+	//pick a pointer and never generate anything
+	class Waveform_Library
+	{
+	private:
+		char* arena = nullptr;
+		size_t arena_size = 0;
+		bool locked = false;
+
+		size_t no_of_samples = 0;
+		std::vector<std::complex<float>*> waveforms;
+		std::vector<std::string> descriptions;
+
+		void generate(const Waveform_Description& description, std::complex<float>* samples, const double sampling_rate);
+
+	public:
+		typedef boost::shared_ptr<Waveform_Library> sptr_t;
+
+		//every waveform is no_of_samples long, throws std::invalid_argument or std::runtime_error when a waveform
+		//cannot be parsed or loaded
+		Waveform_Library(const std::vector<std::string>& descriptions, const size_t no_of_samples, const double sampling_rate);
+		~Waveform_Library();
+
+		size_t size() const;
+		size_t get_no_of_samples() const;
+		const std::complex<float>* get(const size_t waveform) const;
+		const std::string& get_description(const size_t waveform) const;
+
+		//waveform sent in all TX slots of given frame - frames rotate through the waveforms, so RX analysis knows
+		//which one has been sent without asking the TX thread
+		size_t get_frame_waveform(const uint64_t frame) const;
+	};
+}
+
+#endif
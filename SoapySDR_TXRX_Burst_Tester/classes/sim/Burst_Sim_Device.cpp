@@ -0,0 +1,933 @@
+#include "Burst_Sim_Device.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <SoapySDR/Registry.hpp>
+#include <SoapySDR/Version.h>
+#include <SoapySDR/Time.hpp>
+
+#include "../utils/utils.h"
+
+using namespace std;
+using namespace utils;
+
+namespace sim
+{
+	static const size_t MAX_NO_OF_EVENTS = 1024;
+
+	static string get_arg(const SoapySDR::Kwargs& args, const string& key, const string& default_value)
+	{
+		SoapySDR::Kwargs::const_iterator it = args.find(key);
+
+		return (it == args.end()) ? default_value : it->second;
+	}
+
+	Burst_Sim_Device::Burst_Sim_Device(const SoapySDR::Kwargs& args)
+	{
+		mtu = strtoul(get_arg(args, "mtu", "4096").c_str(), nullptr, 10);
+		no_of_channels = strtoul(get_arg(args, "channels", "2").c_str(), nullptr, 10);
+		control_latency_us = strtol(get_arg(args, "control_latency_us", "0").c_str(), nullptr, 10);
+		stream_latency_us = strtol(get_arg(args, "stream_latency_us", "0").c_str(), nullptr, 10);
+		loopback_delay_ns = 1e3 * strtod(get_arg(args, "loopback_delay_us", "0").c_str(), nullptr);
+		noise_level = strtod(get_arg(args, "noise_level", "0").c_str(), nullptr);
+		time_scale = strtod(get_arg(args, "time_scale", "1").c_str(), nullptr);
+		native_format = get_arg(args, "native_format", "CF32");
+		lo_lock_time_ns = 1e3 * strtod(get_arg(args, "lo_lock_time_us", "0").c_str(), nullptr);
+		serial = get_arg(args, "serial", "burst_sim-" + to_string(no_of_channels) + "ch");
+		no_of_direct_buffers = strtoul(get_arg(args, "direct_buffers", "0").c_str(), nullptr, 10);
+		tx_acquire_timeout_every = strtoul(get_arg(args, "tx_acquire_timeout_every", "0").c_str(), nullptr, 10);
+
+		size_t air_size = 1;
+		size_t requested_air_size = strtoul(get_arg(args, "air_buffer", "1048576").c_str(), nullptr, 10);
+
+		while (air_size < requested_air_size)
+			air_size <<= 1;
+
+		if ((mtu == 0) || (no_of_channels == 0) || (time_scale <= 0))
+			throw std::runtime_error("burst_sim: mtu, channels and time_scale have to be positive");
+
+		sdr::parse_sample_format(native_format);
+
+		air_mask = air_size - 1;
+		air.resize(no_of_channels);
+
+		for (size_t i = 0; i < no_of_channels; i++)
+		{
+			air[i].samples.assign(air_size, std::complex<float>(0, 0));
+			air[i].tags.assign(air_size, -1);
+		}
+
+		events.resize(MAX_NO_OF_EVENTS);
+
+		host_epoch_ns = monotonic_time_ns();
+		hw_epoch_ns = 0;
+	}
+
+	Burst_Sim_Device::~Burst_Sim_Device()
+	{
+	}
+
+	long long Burst_Sim_Device::hw_time_ns() const
+	{
+		return hw_time_at(monotonic_time_ns());
+	}
+
+	long long Burst_Sim_Device::hw_time_at(const int64_t host_time) const
+	{
+		//time set for the next PPS edge takes over once the edge has passed
+		if (pps_time_pending && (host_time >= pps_host_ns))
+			return pps_time_ns + (long long)((host_time - pps_host_ns) * time_scale);
+
+		return hw_epoch_ns + (long long)((host_time - host_epoch_ns) * time_scale);
+	}
+
+	long long Burst_Sim_Device::host_wait_ns(const long long hw_target_ns) const
+	{
+		return (long long)((hw_target_ns - hw_time_ns()) / time_scale);
+	}
+
+	double Burst_Sim_Device::rate(const int direction) const
+	{
+		map<pair<int, size_t>, double>::const_iterator it = sample_rates.find(make_pair(direction, (size_t)0));
+
+		return (it == sample_rates.end()) ? 1e6 : it->second;
+	}
+
+	long long Burst_Sim_Device::time_to_index(const long long time_ns, const int direction) const
+	{
+		return SoapySDR::timeNsToTicks(time_ns, rate(direction));
+	}
+
+	long long Burst_Sim_Device::index_to_time(const long long index, const int direction) const
+	{
+		return SoapySDR::ticksToTimeNs(index, rate(direction));
+	}
+
+	void Burst_Sim_Device::push_event(const int code, const int flags, const long long time_ns, const size_t chan_mask)
+	{
+		//the oldest event is overwritten when nobody reads them
+		if (events_count == events.size())
+		{
+			events_head = (events_head + 1) % events.size();
+			events_count--;
+		}
+
+		Sim_Event& event = events[(events_head + events_count) % events.size()];
+
+		event.code = code;
+		event.flags = flags;
+		event.time_ns = time_ns;
+		event.chan_mask = chan_mask;
+
+		events_count++;
+
+		device_cond.notify_all();
+	}
+
+	bool Burst_Sim_Device::wait_for_hw_time(boost::unique_lock<boost::mutex>& lock, const long long hw_target_ns, const int64_t host_deadline_ns)
+	{
+		while (true)
+		{
+			long long wait_ns = host_wait_ns(hw_target_ns);
+
+			if (wait_ns <= 0)
+				return true;
+
+			int64_t remaining_ns = host_deadline_ns - monotonic_time_ns();
+
+			if (remaining_ns <= 0)
+				return false;
+
+			device_cond.timed_wait(lock, boost::posix_time::microseconds((min((int64_t)wait_ns, remaining_ns) + 999) / 1000));
+		}
+	}
+
+	void Burst_Sim_Device::simulate_latency(const long latency_us) const
+	{
+		if (latency_us <= 0)
+			return;
+
+		struct timespec ts;
+		ts.tv_sec = latency_us / 1000000;
+		ts.tv_nsec = (latency_us % 1000000) * 1000;
+
+		nanosleep(&ts, nullptr);
+	}
+
+	string Burst_Sim_Device::getDriverKey() const
+	{
+		return "burst_sim";
+	}
+
+	string Burst_Sim_Device::getHardwareKey() const
+	{
+		return "burst_sim";
+	}
+
+	SoapySDR::Kwargs Burst_Sim_Device::getHardwareInfo() const
+	{
+		SoapySDR::Kwargs info;
+
+		info["serial"] = serial;
+
+		return info;
+	}
+
+	size_t Burst_Sim_Device::getNumChannels(const int direction) const
+	{
+		return no_of_channels;
+	}
+
+	vector<string> Burst_Sim_Device::getStreamFormats(const int direction, const size_t channel) const
+	{
+		return vector<string>{"CF32", "CS16", "CS12"};
+	}
+
+	string Burst_Sim_Device::getNativeStreamFormat(const int direction, const size_t channel, double& full_scale) const
+	{
+		full_scale = (native_format == "CF32") ? 1.0 : 32768.0;
+
+		return native_format;
+	}
+
+	SoapySDR::Stream* Burst_Sim_Device::setupStream(const int direction, const string& format, const vector<size_t>& channels, const SoapySDR::Kwargs& args)
+	{
+		sdr::sample_format_t sample_format;
+
+		try
+		{
+			sample_format = sdr::parse_sample_format(format);
+		}
+		catch (const std::invalid_argument& e)
+		{
+			throw std::runtime_error("burst_sim: unsupported stream format " + format);
+		}
+
+		Sim_Stream* stream = new Sim_Stream();
+
+		stream->direction = direction;
+		stream->format = format;
+		stream->sample_format = sample_format;
+		stream->converters = sdr::get_sample_converters(sample_format);
+
+		if (sample_format != sdr::FORMAT_CF32)
+			stream->scratch.resize(mtu);
+		stream->channels = channels.empty() ? vector<size_t>(1, 0) : channels;
+
+		for (size_t i = 0; i < stream->channels.size(); i++)
+			if (stream->channels[i] >= no_of_channels)
+			{
+				delete stream;
+				throw std::runtime_error("burst_sim: channel " + to_string(channels[i]) + " does not exist");
+			}
+
+		const size_t channel_size = mtu * sdr::sample_format_size(sample_format);
+
+		stream->dma_buffers.resize(no_of_direct_buffers);
+		stream->dma_addrs.resize(no_of_direct_buffers);
+		stream->dma_acquired.assign(no_of_direct_buffers, false);
+
+		for (size_t handle = 0; handle < no_of_direct_buffers; handle++)
+		{
+			stream->dma_buffers[handle].assign(stream->channels.size() * channel_size, 0);
+
+			for (size_t c = 0; c < stream->channels.size(); c++)
+				stream->dma_addrs[handle].push_back(&stream->dma_buffers[handle][c * channel_size]);
+		}
+
+		return reinterpret_cast<SoapySDR::Stream*>(stream);
+	}
+
+	void Burst_Sim_Device::closeStream(SoapySDR::Stream* stream)
+	{
+		delete reinterpret_cast<Sim_Stream*>(stream);
+	}
+
+	size_t Burst_Sim_Device::getStreamMTU(SoapySDR::Stream* stream) const
+	{
+		return mtu;
+	}
+
+	int Burst_Sim_Device::activateStream(SoapySDR::Stream* stream, const int flags, const long long time_ns, const size_t no_of_elements)
+	{
+		simulate_latency(control_latency_us);
+
+		Sim_Stream* s = reinterpret_cast<Sim_Stream*>(stream);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		s->active = true;
+
+		if (s->direction == SOAPY_SDR_RX)
+		{
+			long long start_time = (flags & SOAPY_SDR_HAS_TIME) ? time_ns : hw_time_ns();
+
+			s->rx_late = (flags & SOAPY_SDR_HAS_TIME) && (time_ns < hw_time_ns());
+			s->rx_next_index = time_to_index(start_time, SOAPY_SDR_RX);
+			s->rx_remaining = ((flags & SOAPY_SDR_END_BURST) && (no_of_elements > 0)) ? (long long)no_of_elements : -1;
+		}
+		else
+		{
+			s->tx_in_burst = false;
+			s->tx_dropping = false;
+		}
+
+		device_cond.notify_all();
+
+		return 0;
+	}
+
+	int Burst_Sim_Device::deactivateStream(SoapySDR::Stream* stream, const int flags, const long long time_ns)
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		reinterpret_cast<Sim_Stream*>(stream)->active = false;
+
+		device_cond.notify_all();
+
+		return 0;
+	}
+
+	int Burst_Sim_Device::writeStream(SoapySDR::Stream* stream, const void* const* buffs, const size_t no_of_elements, int& flags, const long long time_ns, const long timeout_us)
+	{
+		simulate_latency(stream_latency_us);
+
+		Sim_Stream* s = reinterpret_cast<Sim_Stream*>(stream);
+
+		if (s->dma_write_used)
+			return SOAPY_SDR_NOT_SUPPORTED;
+
+		return write_samples(s, buffs, no_of_elements, flags, time_ns, timeout_us);
+	}
+
+	int Burst_Sim_Device::write_samples(Sim_Stream* s, const void* const* buffs, const size_t no_of_elements, int& flags, const long long time_ns, const long timeout_us)
+	{
+		int64_t host_deadline_ns = monotonic_time_ns() + 1000 * (int64_t)timeout_us;
+
+		boost::unique_lock<boost::mutex> lock(device_mutex);
+
+		if (!s->active || (s->direction != SOAPY_SDR_TX))
+			return SOAPY_SDR_STREAM_ERROR;
+
+		size_t n = min(no_of_elements, mtu);
+
+		size_t chan_mask = 0;
+		for (size_t c = 0; c < s->channels.size(); c++)
+			chan_mask |= (1 << s->channels[c]);
+
+		long long now_index = time_to_index(hw_time_ns(), SOAPY_SDR_TX);
+		long long start_index;
+
+		if (flags & SOAPY_SDR_HAS_TIME)
+		{
+			start_index = time_to_index(time_ns, SOAPY_SDR_TX);
+
+			//late bursts are dropped and reported through readStreamStatus
+			if (start_index < now_index)
+			{
+				push_event(SOAPY_SDR_TIME_ERROR, SOAPY_SDR_HAS_TIME, time_ns, chan_mask);
+				s->tx_in_burst = false;
+				s->tx_dropping = !(flags & SOAPY_SDR_END_BURST) || (n < no_of_elements);
+				return n;
+			}
+
+			//previous burst has not been ended, the new one is taken as its end and start of another one
+			if (s->tx_in_burst)
+				push_event(SOAPY_SDR_STREAM_ERROR, SOAPY_SDR_HAS_TIME, time_ns, chan_mask);
+
+			s->tx_dropping = false;
+		}
+		else if (s->tx_dropping)
+		{
+			//further packets of a late burst are dropped as well, like with the next burst policy of UHD
+			if ((flags & SOAPY_SDR_END_BURST) && (n == no_of_elements))
+				s->tx_dropping = false;
+
+			return n;
+		}
+		else if (s->tx_in_burst)
+		{
+			start_index = s->tx_next_index;
+
+			//continuation of a burst came too late, so there was a gap on the air
+			if (start_index < now_index)
+			{
+				push_event(SOAPY_SDR_UNDERFLOW, SOAPY_SDR_HAS_TIME, index_to_time(start_index, SOAPY_SDR_TX), chan_mask);
+				start_index = now_index;
+			}
+		}
+		else
+			start_index = now_index;
+
+		//untimed stream running too far ahead does not fit into device buffers yet, so wait like real hardware would
+		long long horizon = air_mask / 2;
+
+		if (!(flags & SOAPY_SDR_HAS_TIME) && (start_index + (long long)n - now_index > horizon))
+		{
+			if (!wait_for_hw_time(lock, index_to_time(start_index + n - horizon, SOAPY_SDR_TX), host_deadline_ns))
+				return SOAPY_SDR_TIMEOUT;
+		}
+
+		long long air_index = start_index + time_to_index(loopback_delay_ns, SOAPY_SDR_TX);
+
+		for (size_t c = 0; c < s->channels.size(); c++)
+		{
+			const std::complex<float>* samples = (const std::complex<float>*)buffs[c];
+			Air_Channel& air_channel = air[s->channels[c]];
+
+			if (s->sample_format != sdr::FORMAT_CF32)
+			{
+				s->converters.from_native(buffs[c], &s->scratch[0], n);
+				samples = &s->scratch[0];
+			}
+
+			for (size_t i = 0; i < n; i++)
+			{
+				size_t slot = (air_index + i) & air_mask;
+
+				air_channel.samples[slot] = samples[i];
+				air_channel.tags[slot] = air_index + i;
+			}
+		}
+
+		s->tx_next_index = start_index + n;
+		s->tx_in_burst = true;
+
+		//burst is acknowledged once its last sample has been sent
+		if ((flags & SOAPY_SDR_END_BURST) && (n == no_of_elements))
+		{
+			push_event(0, SOAPY_SDR_END_BURST | SOAPY_SDR_HAS_TIME, index_to_time(start_index + n, SOAPY_SDR_TX), chan_mask);
+			s->tx_in_burst = false;
+		}
+
+		return n;
+	}
+
+	int Burst_Sim_Device::readStream(SoapySDR::Stream* stream, void* const* buffs, const size_t no_of_elements, int& flags, long long& time_ns, const long timeout_us)
+	{
+		simulate_latency(stream_latency_us);
+
+		Sim_Stream* s = reinterpret_cast<Sim_Stream*>(stream);
+
+		int64_t host_deadline_ns = monotonic_time_ns() + 1000 * (int64_t)timeout_us;
+
+		boost::unique_lock<boost::mutex> lock(device_mutex);
+
+		flags = 0;
+
+		while (!s->active || (s->rx_remaining == 0))
+		{
+			if (monotonic_time_ns() >= host_deadline_ns)
+				return SOAPY_SDR_TIMEOUT;
+
+			device_cond.timed_wait(lock, boost::posix_time::microseconds((host_deadline_ns - monotonic_time_ns() + 999) / 1000));
+		}
+
+		if (s->direction != SOAPY_SDR_RX)
+			return SOAPY_SDR_STREAM_ERROR;
+
+		//timed RX command arrived after its time
+		if (s->rx_late)
+		{
+			s->rx_late = false;
+			s->rx_remaining = 0;
+			return SOAPY_SDR_TIME_ERROR;
+		}
+
+		long long now_index = time_to_index(hw_time_ns(), SOAPY_SDR_RX);
+
+		//continuous flow that has not been read for too long has overwritten itself
+		if ((s->rx_remaining < 0) && (now_index - s->rx_next_index > (long long)(air_mask / 2)))
+		{
+			s->rx_next_index = now_index;
+			return SOAPY_SDR_OVERFLOW;
+		}
+
+		size_t n = min(no_of_elements, mtu);
+
+		if (s->rx_remaining > 0)
+			n = min(n, (size_t)s->rx_remaining);
+
+		long long start_index = s->rx_next_index;
+
+		//samples are available only after they have been received
+		if (!wait_for_hw_time(lock, index_to_time(start_index + n, SOAPY_SDR_RX), host_deadline_ns))
+			return SOAPY_SDR_TIMEOUT;
+
+		for (size_t c = 0; c < s->channels.size(); c++)
+		{
+			std::complex<float>* samples = (s->sample_format != sdr::FORMAT_CF32) ? &s->scratch[0] : (std::complex<float>*)buffs[c];
+			const Air_Channel& air_channel = air[s->channels[c]];
+
+			for (size_t i = 0; i < n; i++)
+			{
+				size_t slot = (start_index + i) & air_mask;
+
+				samples[i] = (air_channel.tags[slot] == start_index + (long long)i) ? air_channel.samples[slot] : std::complex<float>(0, 0);
+			}
+
+			//noise of both I and Q has half of the power
+			if (noise_level > 0)
+			{
+				for (size_t i = 0; i < n; i++)
+					samples[i] += std::complex<float>(noise_distribution(noise_generator), noise_distribution(noise_generator)) * (noise_level * (float)M_SQRT1_2);
+			}
+
+			if (s->sample_format != sdr::FORMAT_CF32)
+				s->converters.to_native(samples, buffs[c], n);
+		}
+
+		s->rx_next_index = start_index + n;
+
+		flags = SOAPY_SDR_HAS_TIME;
+		time_ns = index_to_time(start_index, SOAPY_SDR_RX);
+
+		if (s->rx_remaining > 0)
+		{
+			s->rx_remaining -= n;
+
+			if (s->rx_remaining == 0)
+				flags |= SOAPY_SDR_END_BURST;
+		}
+
+		return n;
+	}
+
+	int Burst_Sim_Device::readStreamStatus(SoapySDR::Stream* stream, size_t& chan_mask, int& flags, long long& time_ns, const long timeout_us)
+	{
+		Sim_Stream* s = reinterpret_cast<Sim_Stream*>(stream);
+
+		if (s->direction != SOAPY_SDR_TX)
+			return SOAPY_SDR_NOT_SUPPORTED;
+
+		int64_t host_deadline_ns = monotonic_time_ns() + 1000 * (int64_t)timeout_us;
+
+		boost::unique_lock<boost::mutex> lock(device_mutex);
+
+		while (true)
+		{
+			if (events_count > 0)
+			{
+				Sim_Event event = events[events_head];
+
+				//events become visible only once hardware clock reaches them
+				if (wait_for_hw_time(lock, event.time_ns, host_deadline_ns))
+				{
+					//the queue might have changed while waiting
+					if ((events_count > 0) && (events[events_head].time_ns == event.time_ns))
+					{
+						events_head = (events_head + 1) % events.size();
+						events_count--;
+
+						chan_mask = event.chan_mask;
+						flags = event.flags;
+						time_ns = event.time_ns;
+
+						return event.code;
+					}
+
+					continue;
+				}
+
+				return SOAPY_SDR_TIMEOUT;
+			}
+
+			if (monotonic_time_ns() >= host_deadline_ns)
+				return SOAPY_SDR_TIMEOUT;
+
+			device_cond.timed_wait(lock, boost::posix_time::microseconds((host_deadline_ns - monotonic_time_ns() + 999) / 1000));
+		}
+	}
+
+	size_t Burst_Sim_Device::getNumDirectAccessBuffers(SoapySDR::Stream* stream)
+	{
+		return reinterpret_cast<Sim_Stream*>(stream)->dma_buffers.size();
+	}
+
+	int Burst_Sim_Device::getDirectAccessBufferAddrs(SoapySDR::Stream* stream, const size_t handle, void** buffs)
+	{
+		Sim_Stream* s = reinterpret_cast<Sim_Stream*>(stream);
+
+		if (handle >= s->dma_buffers.size())
+			return SOAPY_SDR_NOT_SUPPORTED;
+
+		for (size_t c = 0; c < s->channels.size(); c++)
+			buffs[c] = s->dma_addrs[handle][c];
+
+		return 0;
+	}
+
+	int Burst_Sim_Device::acquireReadBuffer(SoapySDR::Stream* stream, size_t& handle, const void** buffs, int& flags, long long& time_ns, const long timeout_us)
+	{
+		Sim_Stream* s = reinterpret_cast<Sim_Stream*>(stream);
+
+		if ((s->direction != SOAPY_SDR_RX) || s->dma_buffers.empty())
+			return SOAPY_SDR_NOT_SUPPORTED;
+		if (s->dma_acquired[s->dma_next])
+			return SOAPY_SDR_TIMEOUT;
+
+		handle = s->dma_next;
+
+		int ret = readStream(stream, &s->dma_addrs[handle][0], mtu, flags, time_ns, timeout_us);
+
+		if (ret <= 0)
+			return ret;
+
+		s->dma_acquired[handle] = true;
+		s->dma_next = (handle + 1) % s->dma_buffers.size();
+
+		for (size_t c = 0; c < s->channels.size(); c++)
+			buffs[c] = s->dma_addrs[handle][c];
+
+		return ret;
+	}
+
+	void Burst_Sim_Device::releaseReadBuffer(SoapySDR::Stream* stream, const size_t handle)
+	{
+		Sim_Stream* s = reinterpret_cast<Sim_Stream*>(stream);
+
+		if (handle < s->dma_acquired.size())
+			s->dma_acquired[handle] = false;
+	}
+
+	int Burst_Sim_Device::acquireWriteBuffer(SoapySDR::Stream* stream, size_t& handle, void** buffs, const long timeout_us)
+	{
+		Sim_Stream* s = reinterpret_cast<Sim_Stream*>(stream);
+
+		if ((s->direction != SOAPY_SDR_TX) || s->dma_buffers.empty())
+			return SOAPY_SDR_NOT_SUPPORTED;
+
+		s->dma_write_used = true;
+
+		if (s->dma_acquired[s->dma_next])
+			return SOAPY_SDR_TIMEOUT;
+		if ((tx_acquire_timeout_every > 0) && (++s->no_of_write_acquires % tx_acquire_timeout_every == 0))
+			return SOAPY_SDR_TIMEOUT;
+
+		handle = s->dma_next;
+
+		s->dma_acquired[handle] = true;
+		s->dma_next = (handle + 1) % s->dma_buffers.size();
+
+		for (size_t c = 0; c < s->channels.size(); c++)
+			buffs[c] = s->dma_addrs[handle][c];
+
+		return mtu;
+	}
+
+	void Burst_Sim_Device::releaseWriteBuffer(SoapySDR::Stream* stream, const size_t handle, const size_t no_of_elements, int& flags, const long long time_ns)
+	{
+		Sim_Stream* s = reinterpret_cast<Sim_Stream*>(stream);
+
+		if ((handle >= s->dma_acquired.size()) || !s->dma_acquired[handle])
+			return;
+
+		s->dma_acquired[handle] = false;
+
+		simulate_latency(stream_latency_us);
+
+		//samples of the buffer are committed to the air the same way writeStream would do it
+		const void* const* buffs = &s->dma_addrs[handle][0];
+
+		write_samples(s, buffs, no_of_elements, flags, time_ns, 100000);
+	}
+
+	vector<string> Burst_Sim_Device::listAntennas(const int direction, const size_t channel) const
+	{
+		return vector<string>(1, direction == SOAPY_SDR_TX ? "TX" : "RX");
+	}
+
+	void Burst_Sim_Device::setAntenna(const int direction, const size_t channel, const string& name)
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		antennas[make_pair(direction, channel)] = name;
+	}
+
+	string Burst_Sim_Device::getAntenna(const int direction, const size_t channel) const
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		map<pair<int, size_t>, string>::const_iterator it = antennas.find(make_pair(direction, channel));
+
+		return (it == antennas.end()) ? listAntennas(direction, channel).front() : it->second;
+	}
+
+	void Burst_Sim_Device::setGain(const int direction, const size_t channel, const double value)
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		set_timed(gains, make_pair(direction, channel), value);
+	}
+
+	double Burst_Sim_Device::getGain(const int direction, const size_t channel) const
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		return get_timed(gains, make_pair(direction, channel), 0);
+	}
+
+	void Burst_Sim_Device::setFrequency(const int direction, const size_t channel, const double frequency, const SoapySDR::Kwargs& args)
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		set_timed(frequencies, make_pair(direction, channel), frequency);
+		tune_times[make_pair(direction, channel)] = monotonic_time_ns();
+	}
+
+	double Burst_Sim_Device::getFrequency(const int direction, const size_t channel) const
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		return get_timed(frequencies, make_pair(direction, channel), 0);
+	}
+
+	void Burst_Sim_Device::setSampleRate(const int direction, const size_t channel, const double rate)
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		sample_rates[make_pair(direction, channel)] = rate;
+	}
+
+	double Burst_Sim_Device::getSampleRate(const int direction, const size_t channel) const
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		map<pair<int, size_t>, double>::const_iterator it = sample_rates.find(make_pair(direction, channel));
+
+		return (it == sample_rates.end()) ? 1e6 : it->second;
+	}
+
+	void Burst_Sim_Device::setBandwidth(const int direction, const size_t channel, const double bandwidth)
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		bandwidths[make_pair(direction, channel)] = bandwidth;
+	}
+
+	double Burst_Sim_Device::getBandwidth(const int direction, const size_t channel) const
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		map<pair<int, size_t>, double>::const_iterator it = bandwidths.find(make_pair(direction, channel));
+
+		return (it == bandwidths.end()) ? 0 : it->second;
+	}
+
+	void Burst_Sim_Device::setMasterClockRate(const double rate)
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		master_clock_rate = rate;
+	}
+
+	double Burst_Sim_Device::getMasterClockRate() const
+	{
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		return master_clock_rate;
+	}
+
+	void Burst_Sim_Device::setClockSource(const string& source)
+	{
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		clock_source = source;
+	}
+
+	string Burst_Sim_Device::getClockSource() const
+	{
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		return clock_source;
+	}
+
+	void Burst_Sim_Device::setTimeSource(const string& source)
+	{
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		time_source = source;
+	}
+
+	string Burst_Sim_Device::getTimeSource() const
+	{
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		return time_source;
+	}
+
+	bool Burst_Sim_Device::hasHardwareTime(const string& what) const
+	{
+		return what.empty() || (what == "PPS");
+	}
+
+	long long Burst_Sim_Device::getHardwareTime(const string& what) const
+	{
+		//on real devices this is a control transaction over USB/Ethernet
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		if (what == "PPS")
+		{
+			//hardware time latched at the last PPS edge
+			int64_t host_time = monotonic_time_ns();
+
+			return hw_time_at(host_time - host_time % 1000000000);
+		}
+
+		return hw_time_ns();
+	}
+
+	void Burst_Sim_Device::setHardwareTime(const long long time_ns, const string& what)
+	{
+		simulate_latency(control_latency_us);
+
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		if (what == "PPS")
+		{
+			//keep the current time running until the next edge
+			int64_t host_time = monotonic_time_ns();
+
+			hw_epoch_ns = hw_time_at(host_time);
+			host_epoch_ns = host_time;
+
+			pps_time_pending = true;
+			pps_host_ns = (host_time / 1000000000 + 1) * 1000000000;
+			pps_time_ns = time_ns;
+		}
+		else
+		{
+			pps_time_pending = false;
+			host_epoch_ns = monotonic_time_ns();
+			hw_epoch_ns = time_ns;
+		}
+
+		device_cond.notify_all();
+	}
+
+	void Burst_Sim_Device::set_timed(std::map<std::pair<int, size_t>, double>& target, const std::pair<int, size_t>& key, const double value)
+	{
+		long long now = hw_time_ns();
+
+		//settings whose time has come are folded in first, so the list does not grow
+		size_t i = 0;
+
+		for (const Timed_Setting& timed_setting : timed_settings)
+		{
+			if (timed_setting.time_ns <= now)
+				(*timed_setting.target)[timed_setting.key] = timed_setting.value;
+			else
+				timed_settings[i++] = timed_setting;
+		}
+
+		timed_settings.resize(i);
+
+		if (command_time_ns > now)
+		{
+			Timed_Setting timed_setting;
+			timed_setting.time_ns = command_time_ns;
+			timed_setting.target = &target;
+			timed_setting.key = key;
+			timed_setting.value = value;
+
+			timed_settings.push_back(timed_setting);
+		}
+		else
+			target[key] = value;
+	}
+
+	double Burst_Sim_Device::get_timed(const std::map<std::pair<int, size_t>, double>& target, const std::pair<int, size_t>& key, const double default_value) const
+	{
+		map<pair<int, size_t>, double>::const_iterator it = target.find(key);
+		double value = (it == target.end()) ? default_value : it->second;
+		long long now = hw_time_ns();
+
+		for (const Timed_Setting& timed_setting : timed_settings)
+			if ((timed_setting.target == &target) && (timed_setting.key == key) && (timed_setting.time_ns <= now))
+				value = timed_setting.value;
+
+		return value;
+	}
+
+	void Burst_Sim_Device::setCommandTime(const long long time_ns, const string& what)
+	{
+		boost::lock_guard<boost::mutex> guard(device_mutex);
+
+		command_time_ns = time_ns;
+	}
+
+	vector<string> Burst_Sim_Device::listSensors(const int direction, const size_t channel) const
+	{
+		return vector<string>(1, "lo_locked");
+	}
+
+	string Burst_Sim_Device::readSensor(const int direction, const size_t channel, const string& key) const
+	{
+		simulate_latency(control_latency_us);
+
+		if (key == "lo_locked")
+		{
+			boost::lock_guard<boost::mutex> guard(device_mutex);
+
+			map<pair<int, size_t>, int64_t>::const_iterator it = tune_times.find(make_pair(direction, channel));
+
+			return ((it == tune_times.end()) || (monotonic_time_ns() - it->second >= lo_lock_time_ns)) ? "true" : "false";
+		}
+
+		throw std::runtime_error("burst_sim: unknown sensor " + key);
+	}
+
+	static SoapySDR::KwargsList find_burst_sim(const SoapySDR::Kwargs& args)
+	{
+		SoapySDR::KwargsList results;
+
+		//simulated device is only ever returned when it has been asked for explicitly
+		if (get_arg(args, "driver", "") != "burst_sim")
+			return results;
+
+		SoapySDR::Kwargs result;
+		result["driver"] = "burst_sim";
+		result["label"] = "SoapySDR_TXRX_Burst_Tester simulated device";
+		results.push_back(result);
+
+		return results;
+	}
+
+	static SoapySDR::Device* make_burst_sim(const SoapySDR::Kwargs& args)
+	{
+		return new Burst_Sim_Device(args);
+	}
+
+	static SoapySDR::Registry register_burst_sim("burst_sim", &find_burst_sim, &make_burst_sim, SOAPY_SDR_ABI_VERSION);
+}
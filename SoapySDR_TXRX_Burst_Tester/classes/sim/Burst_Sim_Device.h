@@ -0,0 +1,229 @@
+#ifndef __BURST_SIM_DEVICE_H__
+#define __BURST_SIM_DEVICE_H__
+
+#include <map>
+#include <vector>
+#include <complex>
+#include <string>
+#include <random>
+#include <stdint.h>
+
+#include <boost/thread.hpp>
+
+#include <SoapySDR/Device.hpp>
+
+#include "../sdr/Sample_Format.h"
+
+namespace sim
+{
+	//software SoapySDR device (args: driver=burst_sim) meant for hardware-free benchmarking of the burst loops
+	//
+	//supported args:
+	//	mtu						- stream MTU in [Sa] (default 4096)
+	//	channels				- number of TX and RX channels (default 2)
+	//	control_latency_us		- delay added to every control call, e.g. getHardwareTime or setGain (default 0)
+	//	stream_latency_us		- delay added to every readStream/writeStream call (default 0)
+	//	loopback_delay_us		- delay after which TX samples show up on RX of the same channel (default 0)
+	//	noise_level				- RMS amplitude of complex white Gaussian noise added to every received sample (default 0)
+	//	air_buffer				- number of samples kept per channel for the TX to RX loopback (default 1048576)
+	//	time_scale				- speed of the simulated hardware clock relative to host clock (default 1)
+	//	native_format			- stream format reported by getNativeStreamFormat, CF32, CS16 or CS12 (default CF32)
+	//	lo_lock_time_us			- time after setFrequency before lo_locked sensor reports true (default 0)
+	//	serial					- serial number reported by getHardwareInfo (default burst_sim-<channels>ch)
+	//	direct_buffers			- number of driver buffers of direct buffer access per stream (default 0 - not supported)
+	//	tx_acquire_timeout_every	- every n-th acquireWriteBuffer call times out (default 0 - never)
+	//
+	//gains and frequencies set while a command time is set (setCommandTime) take effect once the hardware clock
+	//reaches it, other settings are applied right away
+	//
+	//PPS edges are simulated at whole seconds of the host monotonic clock, so every simulated device of a process
+	//sees the same PPS (setHardwareTime/getHardwareTime with what = "PPS")
+	//
+	//driver buffers of direct buffer access hold mtu samples of every channel in stream format, releaseWriteBuffer
+	//and acquireReadBuffer pass them through writeStream/readStream, so both access paths behave the same - once
+	//a write buffer has been acquired on a TX stream, writeStream of the stream is refused (both APIs are not mixed)
+	//
+	//timed TX burst started before the previous one has been ended is reported as SOAPY_SDR_STREAM_ERROR through
+	//readStreamStatus, just like a burst sequence error of hardware tracking start and end of bursts
+	class Burst_Sim_Device : public SoapySDR::Device
+	{
+	private:
+		//simulated stream, also used as an opaque SoapySDR::Stream handle
+		struct Sim_Stream
+		{
+			int direction = SOAPY_SDR_TX;
+			std::string format;
+			//streams of CS16/CS12 format convert samples through the scratch buffer of mtu samples
+			sdr::sample_format_t sample_format = sdr::FORMAT_CF32;
+			sdr::Sample_Converters converters;
+			std::vector<std::complex<float>> scratch;
+			std::vector<size_t> channels;
+			bool active = false;
+
+			//TX: index of the next sample of an unfinished burst, the rest of a late burst is dropped up to its end
+			bool tx_in_burst = false;
+			bool tx_dropping = false;
+			long long tx_next_index = 0;
+
+			//RX: position of the flow, number of samples left in a finite burst (-1 - continuous)
+			long long rx_next_index = 0;
+			long long rx_remaining = -1;
+			bool rx_late = false;
+
+			//driver buffers handed out round robin (a buffer still acquired makes acquire time out), addresses of
+			//their channels
+			std::vector<std::vector<char>> dma_buffers;
+			std::vector<std::vector<void*>> dma_addrs;
+			std::vector<bool> dma_acquired;
+			size_t dma_next = 0;
+			bool dma_write_used = false;
+			size_t no_of_write_acquires = 0;
+		};
+
+		//event reported through readStreamStatus once the hardware clock reaches its time
+		struct Sim_Event
+		{
+			int code = 0;
+			int flags = 0;
+			long long time_ns = 0;
+			size_t chan_mask = 0;
+		};
+
+		//samples "in the air", tags tell which absolute sample index a slot currently holds
+		struct Air_Channel
+		{
+			std::vector<std::complex<float>> samples;
+			std::vector<long long> tags;
+		};
+
+		mutable boost::mutex device_mutex;
+		boost::condition_variable device_cond;
+
+		size_t mtu = 4096;
+		size_t no_of_direct_buffers = 0;
+		size_t tx_acquire_timeout_every = 0;
+		std::string native_format = "CF32";
+		size_t no_of_channels = 2;
+		long control_latency_us = 0;
+		long stream_latency_us = 0;
+		long long loopback_delay_ns = 0;
+		float noise_level = 0;
+		std::minstd_rand noise_generator;
+		std::normal_distribution<float> noise_distribution;
+		double time_scale = 1.0;
+		int64_t lo_lock_time_ns = 0;
+		std::string serial;
+
+		int64_t host_epoch_ns = 0;
+		long long hw_epoch_ns = 0;
+
+		//time to be latched at the next PPS edge (see setHardwareTime)
+		bool pps_time_pending = false;
+		int64_t pps_host_ns = 0;
+		long long pps_time_ns = 0;
+
+		double master_clock_rate = 100e6;
+		std::map<std::pair<int, size_t>, double> sample_rates;
+		std::map<std::pair<int, size_t>, double> bandwidths;
+		std::map<std::pair<int, size_t>, double> gains;
+		std::map<std::pair<int, size_t>, double> frequencies;
+		//host time of the last setFrequency call
+		std::map<std::pair<int, size_t>, int64_t> tune_times;
+		std::map<std::pair<int, size_t>, std::string> antennas;
+		std::string clock_source = "internal";
+		std::string time_source = "internal";
+		long long command_time_ns = 0;
+
+		//gain or frequency waiting for its command time, in order of setting
+		struct Timed_Setting
+		{
+			long long time_ns = 0;
+			std::map<std::pair<int, size_t>, double>* target = nullptr;
+			std::pair<int, size_t> key;
+			double value = 0;
+		};
+
+		std::vector<Timed_Setting> timed_settings;
+
+		std::vector<Air_Channel> air;
+		size_t air_mask = 0;
+
+		std::vector<Sim_Event> events;
+		size_t events_head = 0;
+		size_t events_count = 0;
+
+		long long hw_time_ns() const;
+		long long hw_time_at(const int64_t host_time) const;
+		long long host_wait_ns(const long long hw_target_ns) const;
+		double rate(const int direction) const;
+		long long time_to_index(const long long time_ns, const int direction) const;
+		long long index_to_time(const long long index, const int direction) const;
+		void push_event(const int code, const int flags, const long long time_ns, const size_t chan_mask);
+		bool wait_for_hw_time(boost::unique_lock<boost::mutex>& lock, const long long hw_target_ns, const int64_t host_deadline_ns);
+		void simulate_latency(const long latency_us) const;
+		int write_samples(Sim_Stream* s, const void* const* buffs, const size_t no_of_elements, int& flags, const long long time_ns, const long timeout_us);
+		void set_timed(std::map<std::pair<int, size_t>, double>& target, const std::pair<int, size_t>& key, const double value);
+		double get_timed(const std::map<std::pair<int, size_t>, double>& target, const std::pair<int, size_t>& key, const double default_value) const;
+
+	public:
+		Burst_Sim_Device(const SoapySDR::Kwargs& args);
+		~Burst_Sim_Device();
+
+		std::string getDriverKey() const;
+		std::string getHardwareKey() const;
+		SoapySDR::Kwargs getHardwareInfo() const;
+		size_t getNumChannels(const int direction) const;
+
+		std::vector<std::string> getStreamFormats(const int direction, const size_t channel) const;
+		std::string getNativeStreamFormat(const int direction, const size_t channel, double& full_scale) const;
+		SoapySDR::Stream* setupStream(const int direction, const std::string& format, const std::vector<size_t>& channels = std::vector<size_t>(), const SoapySDR::Kwargs& args = SoapySDR::Kwargs());
+		void closeStream(SoapySDR::Stream* stream);
+		size_t getStreamMTU(SoapySDR::Stream* stream) const;
+		int activateStream(SoapySDR::Stream* stream, const int flags = 0, const long long time_ns = 0, const size_t no_of_elements = 0);
+		int deactivateStream(SoapySDR::Stream* stream, const int flags = 0, const long long time_ns = 0);
+		int readStream(SoapySDR::Stream* stream, void* const* buffs, const size_t no_of_elements, int& flags, long long& time_ns, const long timeout_us = 100000);
+		int writeStream(SoapySDR::Stream* stream, const void* const* buffs, const size_t no_of_elements, int& flags, const long long time_ns = 0, const long timeout_us = 100000);
+		int readStreamStatus(SoapySDR::Stream* stream, size_t& chan_mask, int& flags, long long& time_ns, const long timeout_us = 100000);
+
+		size_t getNumDirectAccessBuffers(SoapySDR::Stream* stream);
+		int getDirectAccessBufferAddrs(SoapySDR::Stream* stream, const size_t handle, void** buffs);
+		int acquireReadBuffer(SoapySDR::Stream* stream, size_t& handle, const void** buffs, int& flags, long long& time_ns, const long timeout_us = 100000);
+		void releaseReadBuffer(SoapySDR::Stream* stream, const size_t handle);
+		int acquireWriteBuffer(SoapySDR::Stream* stream, size_t& handle, void** buffs, const long timeout_us = 100000);
+		void releaseWriteBuffer(SoapySDR::Stream* stream, const size_t handle, const size_t no_of_elements, int& flags, const long long time_ns = 0);
+
+		std::vector<std::string> listAntennas(const int direction, const size_t channel) const;
+		void setAntenna(const int direction, const size_t channel, const std::string& name);
+		std::string getAntenna(const int direction, const size_t channel) const;
+
+		void setGain(const int direction, const size_t channel, const double value);
+		double getGain(const int direction, const size_t channel) const;
+
+		void setFrequency(const int direction, const size_t channel, const double frequency, const SoapySDR::Kwargs& args = SoapySDR::Kwargs());
+		double getFrequency(const int direction, const size_t channel) const;
+
+		void setSampleRate(const int direction, const size_t channel, const double rate);
+		double getSampleRate(const int direction, const size_t channel) const;
+
+		void setBandwidth(const int direction, const size_t channel, const double bandwidth);
+		double getBandwidth(const int direction, const size_t channel) const;
+
+		void setMasterClockRate(const double rate);
+		double getMasterClockRate() const;
+
+		void setClockSource(const std::string& source);
+		std::string getClockSource() const;
+		void setTimeSource(const std::string& source);
+		std::string getTimeSource() const;
+
+		bool hasHardwareTime(const std::string& what = "") const;
+		long long getHardwareTime(const std::string& what = "") const;
+		void setHardwareTime(const long long time_ns, const std::string& what = "");
+		void setCommandTime(const long long time_ns, const std::string& what = "");
+
+		std::vector<std::string> listSensors(const int direction, const size_t channel) const;
+		std::string readSensor(const int direction, const size_t channel, const std::string& key) const;
+	};
+}
+
+#endif
@@ -0,0 +1,305 @@
+#include "Async_Logger.h"
+
+#include <algorithm>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace utils
+{
+	static bool compare_log_records(const Log_Record& a, const Log_Record& b)
+	{
+		return a.timestamp_us < b.timestamp_us;
+	}
+
+	//formats timestamp the same way as ptime_to_str() does, but without creating any locale objects
+	static void append_timestamp(string& text, const int64_t timestamp_us)
+	{
+		time_t seconds = timestamp_us / 1000000;
+		struct tm tm_utc;
+		gmtime_r(&seconds, &tm_utc);
+
+		char buf[32];
+		int length = snprintf
+		(
+			buf,
+			sizeof(buf),
+			"%04d-%02d-%02d %02d:%02d:%02d.%06d ",
+			tm_utc.tm_year + 1900,
+			tm_utc.tm_mon + 1,
+			tm_utc.tm_mday,
+			tm_utc.tm_hour,
+			tm_utc.tm_min,
+			tm_utc.tm_sec,
+			(int)(timestamp_us % 1000000)
+		);
+
+		text.append(buf, length);
+	}
+
+	static void append_msg_type_prefix(string& text, const msg_type_t msg_type)
+	{
+		if (msg_type == INFO)
+			text += "INFO -     ";
+		else if (msg_type == WARNING)
+			text += "WARNING -  ";
+		else if (msg_type == ERROR)
+			text += "ERROR -    ";
+	}
+
+	Async_Logger::Async_Logger()
+	:
+		running(false),
+		no_of_pushing_producers(0),
+		generation(0),
+		no_of_dropped_records(0)
+	{
+	}
+
+	Async_Logger::~Async_Logger()
+	{
+		stop();
+	}
+
+	void Async_Logger::start(const size_t ring_size)
+	{
+		if (running)
+			return;
+
+		{
+			boost::lock_guard<boost::mutex> guard(rings_mutex);
+
+			//rings are only released here, i.e. before any producer thread is expected to log
+			rings.clear();
+			this->ring_size = ring_size;
+			generation++;
+		}
+
+		running = true;
+		drain_thread = boost::thread(&Async_Logger::drain_thread_function, this);
+	}
+
+	void Async_Logger::stop()
+	{
+		if (!running)
+			return;
+
+		running = false;
+
+		if (drain_thread.joinable())
+			drain_thread.join();
+
+		//producers that have seen the logger running may still be publishing, their records land after the last
+		//pass of the drain thread and are written here
+		while (no_of_pushing_producers.load() > 0)
+			boost::this_thread::yield();
+
+		vector<Log_Record> batch;
+		string out_text;
+		string err_text;
+
+		drain(batch, out_text, err_text);
+	}
+
+	bool Async_Logger::is_running() const
+	{
+		return running.load(std::memory_order_relaxed);
+	}
+
+	Async_Logger::ring_t* Async_Logger::get_thread_ring()
+	{
+		static thread_local ring_t* ring = nullptr;
+		static thread_local uint64_t ring_generation = 0;
+
+		const uint64_t current_generation = generation.load(std::memory_order_acquire);
+
+		if ((ring == nullptr) || (ring_generation != current_generation))
+		{
+			//first message of this thread - the only place where producer takes a lock
+			boost::lock_guard<boost::mutex> guard(rings_mutex);
+
+			rings.push_back(boost::shared_ptr<ring_t>(new ring_t(ring_size)));
+			ring = rings.back().get();
+			ring_generation = current_generation;
+		}
+
+		return ring;
+	}
+
+	log_push_result_t Async_Logger::push(const char* text, size_t length, msg_type_t msg_type, const bool& add_timestamp, const bool& add_msg_type_prefix)
+	{
+		//announced before running is checked, so stop() either sees this producer or the producer sees it stopped
+		no_of_pushing_producers.fetch_add(1);
+
+		if (!running.load())
+		{
+			no_of_pushing_producers.fetch_sub(1);
+			return LOG_STOPPED;
+		}
+
+		ring_t* ring = get_thread_ring();
+
+		Log_Record* record = ring->claim();
+
+		if (record == nullptr)
+		{
+			no_of_dropped_records.fetch_add(1, std::memory_order_relaxed);
+			no_of_pushing_producers.fetch_sub(1);
+			return LOG_DROPPED;
+		}
+
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+
+		if (length > LOG_RECORD_TEXT_SIZE)
+			length = LOG_RECORD_TEXT_SIZE;
+
+		record->timestamp_us = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+		record->msg_type = msg_type;
+		record->add_timestamp = add_timestamp;
+		record->add_msg_type_prefix = add_msg_type_prefix;
+		record->length = length;
+		memcpy(record->text, text, length);
+
+		ring->publish();
+
+		no_of_pushing_producers.fetch_sub(1);
+
+		return LOG_QUEUED;
+	}
+
+	log_push_result_t Async_Logger::push_format(msg_type_t msg_type, const char* format, va_list args)
+	{
+		no_of_pushing_producers.fetch_add(1);
+
+		if (!running.load())
+		{
+			no_of_pushing_producers.fetch_sub(1);
+			return LOG_STOPPED;
+		}
+
+		ring_t* ring = get_thread_ring();
+
+		Log_Record* record = ring->claim();
+
+		if (record == nullptr)
+		{
+			no_of_dropped_records.fetch_add(1, std::memory_order_relaxed);
+			no_of_pushing_producers.fetch_sub(1);
+			return LOG_DROPPED;
+		}
+
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+
+		int length = vsnprintf(record->text, LOG_RECORD_TEXT_SIZE, format, args);
+
+		if (length < 0)
+			length = 0;
+		else if (length > (int)LOG_RECORD_TEXT_SIZE - 1)
+			length = LOG_RECORD_TEXT_SIZE - 1;
+
+		record->timestamp_us = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+		record->msg_type = msg_type;
+		record->add_timestamp = true;
+		record->add_msg_type_prefix = true;
+		record->length = length;
+
+		ring->publish();
+
+		no_of_pushing_producers.fetch_sub(1);
+
+		return LOG_QUEUED;
+	}
+
+	uint64_t Async_Logger::get_no_of_dropped_records() const
+	{
+		return no_of_dropped_records.load(std::memory_order_relaxed);
+	}
+
+	boost::thread::native_handle_type Async_Logger::get_native_handle()
+	{
+		return drain_thread.native_handle();
+	}
+
+	size_t Async_Logger::drain(vector<Log_Record>& batch, string& out_text, string& err_text)
+	{
+		batch.clear();
+		out_text.clear();
+		err_text.clear();
+
+		{
+			boost::lock_guard<boost::mutex> guard(rings_mutex);
+
+			for (size_t i = 0; i < rings.size(); i++)
+			{
+				Log_Record* record;
+
+				while ((record = rings[i]->peek()) != nullptr)
+				{
+					batch.push_back(*record);
+					rings[i]->release();
+				}
+			}
+		}
+
+		//records from different threads are merged back into chronological order
+		stable_sort(batch.begin(), batch.end(), compare_log_records);
+
+		for (size_t i = 0; i < batch.size(); i++)
+		{
+			const Log_Record& record = batch[i];
+			string& text = (record.msg_type == INFO) ? out_text : err_text;
+
+			text += '\n';
+
+			if (record.add_timestamp)
+				append_timestamp(text, record.timestamp_us);
+
+			if (record.add_msg_type_prefix)
+				append_msg_type_prefix(text, record.msg_type);
+
+			text.append(record.text, record.length);
+		}
+
+		uint64_t no_of_dropped = get_no_of_dropped_records();
+
+		if (no_of_dropped != no_of_reported_dropped_records)
+		{
+			err_text += "\n" + to_msg("utils: " + to_string(no_of_dropped - no_of_reported_dropped_records) + " log records have been dropped (" + to_string(no_of_dropped) + " in total)", WARNING);
+			no_of_reported_dropped_records = no_of_dropped;
+		}
+
+		//one write per stream and batch instead of one per message
+		if (!out_text.empty())
+			fwrite(out_text.data(), 1, out_text.size(), stdout);
+
+		if (!err_text.empty())
+			fwrite(err_text.data(), 1, err_text.size(), stderr);
+
+		return batch.size();
+	}
+
+	void Async_Logger::drain_thread_function()
+	{
+		vector<Log_Record> batch;
+		string out_text;
+		string err_text;
+
+		batch.reserve(4096);
+
+		while (running)
+		{
+			if (drain(batch, out_text, err_text) == 0)
+				usleep(1000);
+		}
+
+		//flush whatever has been left in the rings
+		drain(batch, out_text, err_text);
+	}
+
+	Async_Logger async_logger;
+}
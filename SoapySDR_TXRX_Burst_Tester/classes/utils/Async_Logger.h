@@ -0,0 +1,90 @@
+#ifndef __ASYNC_LOGGER_H__
+#define __ASYNC_LOGGER_H__
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdarg.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "utils.h"
+#include "SPSC_Ring.h"
+
+namespace utils
+{
+	//maximum length of a single message text, longer messages are truncated
+	const size_t LOG_RECORD_TEXT_SIZE = 224;
+
+	//pre-sized binary log record passed from producer threads to the drain thread
+	struct Log_Record
+	{
+		int64_t timestamp_us;
+		msg_type_t msg_type;
+		bool add_timestamp;
+		bool add_msg_type_prefix;
+		uint16_t length;
+		char text[LOG_RECORD_TEXT_SIZE];
+	};
+
+	//outcome of handing a record over to Async_Logger - a record refused because the logger has been stopped
+	//is meant to be printed by the producer itself
+	enum log_push_result_t
+	{
+		LOG_QUEUED,
+		LOG_DROPPED,
+		LOG_STOPPED
+	};
+
+	//logger where every producer thread owns a lock-free SPSC ring of log records
+	//and a dedicated drain thread formats them and writes them to cout/cerr in batches,
+	//records that do not fit into a full ring are dropped and counted instead of blocking the producer
+	class Async_Logger
+	{
+	private:
+		typedef SPSC_Ring<Log_Record> ring_t;
+
+		std::vector<boost::shared_ptr<ring_t>> rings;
+		boost::mutex rings_mutex;
+
+		boost::thread drain_thread;
+
+		std::atomic<bool> running;
+		//producers between checking running and publishing their record, stop() waits for them
+		std::atomic<int> no_of_pushing_producers;
+		std::atomic<uint64_t> generation;
+		std::atomic<uint64_t> no_of_dropped_records;
+		uint64_t no_of_reported_dropped_records = 0;
+
+		size_t ring_size = 1024;
+
+		ring_t* get_thread_ring();
+		void drain_thread_function();
+		size_t drain(std::vector<Log_Record>& batch, std::string& out_text, std::string& err_text);
+
+	public:
+		Async_Logger();
+		~Async_Logger();
+
+		void start(const size_t ring_size);
+		void stop();
+		bool is_running() const;
+
+		log_push_result_t push(const char* text, size_t length, msg_type_t msg_type, const bool& add_timestamp, const bool& add_msg_type_prefix);
+
+		//same as push(), but the text is printed straight into the ring slot so no temporary string is needed
+		//(args are not used when the record is refused with LOG_STOPPED)
+		log_push_result_t push_format(msg_type_t msg_type, const char* format, va_list args);
+
+		uint64_t get_no_of_dropped_records() const;
+
+		boost::thread::native_handle_type get_native_handle();
+	};
+
+	//logger used by msg() whenever it has been started
+	extern Async_Logger async_logger;
+}
+
+#endif
@@ -0,0 +1,147 @@
+#include "Control_Socket.h"
+
+#include <unistd.h>
+#include <stdexcept>
+
+#include <boost/enable_shared_from_this.hpp>
+
+#include "utils.h"
+
+using namespace std;
+
+namespace utils
+{
+	//longest command accepted, longer lines close the connection
+	static const size_t MAX_LINE_LENGTH = 4096;
+
+	class Control_Socket::Session : public boost::enable_shared_from_this<Control_Socket::Session>
+	{
+	private:
+		boost::asio::local::stream_protocol::socket socket;
+		boost::asio::streambuf input;
+		string reply;
+		command_handler_t handler;
+
+	public:
+		Session(boost::asio::io_context& io_context, command_handler_t handler)
+		:
+			socket(io_context),
+			input(MAX_LINE_LENGTH),
+			handler(handler)
+		{
+		}
+
+		boost::asio::local::stream_protocol::socket& get_socket()
+		{
+			return socket;
+		}
+
+		void read()
+		{
+			boost::shared_ptr<Session> self = shared_from_this();
+
+			boost::asio::async_read_until
+			(
+				socket,
+				input,
+				'\n',
+				[self](const boost::system::error_code& error_code, size_t)
+				{
+					if (error_code)
+						return;
+
+					istream stream(&self->input);
+					string line;
+
+					getline(stream, line);
+					remove_nonprintable_chars(line);
+
+					if (line.empty())
+					{
+						self->read();
+						return;
+					}
+
+					self->reply = self->handler(line) + "\n";
+					self->write();
+				}
+			);
+		}
+
+		void write()
+		{
+			boost::shared_ptr<Session> self = shared_from_this();
+
+			boost::asio::async_write
+			(
+				socket,
+				boost::asio::buffer(reply),
+				[self](const boost::system::error_code& error_code, size_t)
+				{
+					if (!error_code)
+						self->read();
+				}
+			);
+		}
+	};
+
+	Control_Socket::Control_Socket(boost::asio::io_context& io_context, const std::string& path, command_handler_t handler)
+	:
+		io_context(io_context),
+		path(path),
+		handler(handler),
+		acceptor(io_context)
+	{
+		unlink(path.c_str());
+
+		try
+		{
+			boost::asio::local::stream_protocol::endpoint endpoint(path);
+
+			acceptor.open(endpoint.protocol());
+			acceptor.bind(endpoint);
+			acceptor.listen();
+		}
+		catch (const boost::system::system_error& e)
+		{
+			throw std::runtime_error("Unable to create control socket " + path + ": " + string(e.what()));
+		}
+
+		accept();
+
+		msg("utils: control socket is listening at " + path);
+	}
+
+	Control_Socket::~Control_Socket()
+	{
+		boost::system::error_code error_code;
+
+		acceptor.close(error_code);
+		unlink(path.c_str());
+	}
+
+	void Control_Socket::accept()
+	{
+		boost::shared_ptr<Session> session(new Session(io_context, handler));
+
+		acceptor.async_accept
+		(
+			session->get_socket(),
+			[this, session](const boost::system::error_code& error_code)
+			{
+				if (error_code == boost::asio::error::operation_aborted)
+					return;
+
+				if (!error_code)
+					session->read();
+
+				accept();
+			}
+		);
+	}
+
+	const std::string& Control_Socket::get_path() const
+	{
+		return path;
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef __CONTROL_SOCKET_H__
+#define __CONTROL_SOCKET_H__
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/asio.hpp>
+
+namespace utils
+{
+	//line based command channel on a local (UNIX) stream socket served by given io_context, so commands are
+	//handled by whatever thread runs it (the main thread next to Signal_Handler), every received line is passed
+	//to the handler and its reply is written back followed by a newline, e.g.
+	//
+	//	echo "tx_gain=40" | socat - UNIX-CONNECT:/tmp/burst_tester.sock
+	class Control_Socket
+	{
+	public:
+		typedef boost::function<std::string (const std::string&)> command_handler_t;
+
+	private:
+		//single client connection, kept alive by its pending asynchronous operations
+		class Session;
+
+		boost::asio::io_context& io_context;
+		std::string path;
+		command_handler_t handler;
+		boost::asio::local::stream_protocol::acceptor acceptor;
+
+		void accept();
+
+	public:
+		typedef boost::shared_ptr<Control_Socket> sptr_t;
+
+		//stale socket file left by a previous run is replaced, throws std::runtime_error when the socket cannot be created
+		Control_Socket(boost::asio::io_context& io_context, const std::string& path, command_handler_t handler);
+		~Control_Socket();
+
+		const std::string& get_path() const;
+	};
+}
+
+#endif
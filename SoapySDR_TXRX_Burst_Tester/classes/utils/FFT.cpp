@@ -0,0 +1,143 @@
+#include "FFT.h"
+
+#include <string.h>
+#include <math.h>
+#include <stdexcept>
+#include <string>
+
+#include "utils.h"
+
+using namespace std;
+
+namespace utils
+{
+	//single Stockham stage of sub-transforms of length 2 * m interleaved with stride s, samples are handled
+	//as float pairs, so complex multiplications are not routed through NaN checking library calls
+	//
+	//	y[q + s * 2p] = a + b, y[q + s * (2p + 1)] = (a - b) * w[p * s], where a = x[q + s * p], b = x[q + s * (p + m)]
+	//
+	//the first stage (s == 1) loops over p inside, all the others over contiguous q (looping over p with stride s
+	//would be cache hostile for long transforms)
+	VECTORISED_KERNEL static void stage_inner_p(const float* x, float* y, const float* w, const size_t m, const size_t s)
+	{
+		for (size_t q = 0; q < s; q++)
+		{
+			for (size_t p = 0; p < m; p++)
+			{
+				const float* a = x + 2 * (q + s * p);
+				const float* b = x + 2 * (q + s * (p + m));
+				const float* wp = w + 2 * (p * s);
+				float* y0 = y + 2 * (q + s * 2 * p);
+				float* y1 = y + 2 * (q + s * (2 * p + 1));
+
+				float dr = a[0] - b[0];
+				float di = a[1] - b[1];
+
+				y0[0] = a[0] + b[0];
+				y0[1] = a[1] + b[1];
+				y1[0] = dr * wp[0] - di * wp[1];
+				y1[1] = dr * wp[1] + di * wp[0];
+			}
+		}
+	}
+
+	VECTORISED_KERNEL static void stage_inner_q(const float* x, float* y, const float* w, const size_t m, const size_t s)
+	{
+		for (size_t p = 0; p < m; p++)
+		{
+			const float wr = w[2 * (p * s)];
+			const float wi = w[2 * (p * s) + 1];
+			const float* a = x + 2 * (s * p);
+			const float* b = x + 2 * (s * (p + m));
+			float* y0 = y + 2 * (s * 2 * p);
+			float* y1 = y + 2 * (s * (2 * p + 1));
+
+			for (size_t q = 0; q < 2 * s; q += 2)
+			{
+				float dr = a[q] - b[q];
+				float di = a[q + 1] - b[q + 1];
+
+				y0[q] = a[q] + b[q];
+				y0[q + 1] = a[q + 1] + b[q + 1];
+				y1[q] = dr * wr - di * wi;
+				y1[q + 1] = dr * wi + di * wr;
+			}
+		}
+	}
+
+	size_t fft_size(const size_t n)
+	{
+		size_t size = 1;
+
+		while (size < n)
+			size <<= 1;
+
+		return size;
+	}
+
+	FFT::FFT(const size_t size)
+	:
+		size(size)
+	{
+		if ((size == 0) || ((size & (size - 1)) != 0))
+			throw std::invalid_argument("FFT size " + to_string(size) + " is not a power of two");
+
+		twiddles.resize(size / 2 + 1);
+		inverse_twiddles.resize(size / 2 + 1);
+		work.resize(size);
+
+		//computed in double precision, so long transforms do not accumulate twiddle errors
+		for (size_t k = 0; k < twiddles.size(); k++)
+		{
+			double angle = -2 * M_PI * k / size;
+
+			twiddles[k] = complex<float>(cos(angle), sin(angle));
+			inverse_twiddles[k] = conj(twiddles[k]);
+		}
+	}
+
+	size_t FFT::get_size() const
+	{
+		return size;
+	}
+
+	void FFT::transform(const std::complex<float>* in, std::complex<float>* out, const std::complex<float>* w)
+	{
+		if (in != out)
+			memcpy(out, in, size * sizeof(complex<float>));
+
+		float* x = reinterpret_cast<float*>(out);
+		float* y = reinterpret_cast<float*>(&work[0]);
+		const float* wf = reinterpret_cast<const float*>(w);
+
+		for (size_t s = 1, m = size / 2; m >= 1; s <<= 1, m >>= 1)
+		{
+			if (s == 1)
+				stage_inner_p(x, y, wf, m, s);
+			else
+				stage_inner_q(x, y, wf, m, s);
+
+			std::swap(x, y);
+		}
+
+		//after an odd number of stages the result is left in the work buffer
+		if (x != reinterpret_cast<float*>(out))
+			memcpy(reinterpret_cast<float*>(out), x, size * sizeof(complex<float>));
+	}
+
+	void FFT::forward(const std::complex<float>* in, std::complex<float>* out)
+	{
+		transform(in, out, &twiddles[0]);
+	}
+
+	void FFT::inverse(const std::complex<float>* in, std::complex<float>* out)
+	{
+		transform(in, out, &inverse_twiddles[0]);
+
+		const float scale = 1.0f / size;
+		float* f = reinterpret_cast<float*>(out);
+
+		for (size_t i = 0; i < 2 * size; i++)
+			f[i] *= scale;
+	}
+}
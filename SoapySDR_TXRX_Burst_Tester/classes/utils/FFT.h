@@ -0,0 +1,44 @@
+#ifndef __FFT_H__
+#define __FFT_H__
+
+#include <complex>
+#include <vector>
+#include <stddef.h>
+
+#include <boost/shared_ptr.hpp>
+
+namespace utils
+{
+	//radix-2 Stockham FFT of a fixed power of two size, twiddles are precomputed and stages are plain loops
+	//over contiguous samples, so they are vectorised by the compiler (no external FFT library is needed)
+	//
+	//a single instance owns its work buffer, so it may be used only by one thread at a time
+	class FFT
+	{
+	private:
+		size_t size = 0;
+		std::vector<std::complex<float>> twiddles;
+		std::vector<std::complex<float>> inverse_twiddles;
+		std::vector<std::complex<float>> work;
+
+		void transform(const std::complex<float>* in, std::complex<float>* out, const std::complex<float>* w);
+
+	public:
+		typedef boost::shared_ptr<FFT> sptr_t;
+
+		//throws std::invalid_argument when size is not a power of two
+		FFT(const size_t size);
+
+		size_t get_size() const;
+
+		//in and out may be the same buffer
+		void forward(const std::complex<float>* in, std::complex<float>* out);
+		//scaled by 1/size, so inverse(forward(x)) == x
+		void inverse(const std::complex<float>* in, std::complex<float>* out);
+	};
+
+	//smallest power of two not less than n
+	size_t fft_size(const size_t n);
+}
+
+#endif
@@ -0,0 +1,145 @@
+#include "Metrics_Endpoint.h"
+
+#include <stdexcept>
+
+#include <boost/enable_shared_from_this.hpp>
+
+#include "utils.h"
+
+using namespace std;
+
+namespace utils
+{
+	//longest request header accepted, longer ones close the connection
+	static const size_t MAX_REQUEST_LENGTH = 8192;
+
+	class Metrics_Endpoint::Session : public boost::enable_shared_from_this<Metrics_Endpoint::Session>
+	{
+	private:
+		boost::asio::ip::tcp::socket socket;
+		boost::asio::streambuf input;
+		string reply;
+		Metrics_Registry::sptr_t registry;
+
+		static string response(const string& status, const string& content_type, const string& body)
+		{
+			return "HTTP/1.0 " + status + "\r\nContent-Type: " + content_type + "\r\nContent-Length: " + to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+		}
+
+	public:
+		Session(boost::asio::io_context& io_context, Metrics_Registry::sptr_t registry)
+		:
+			socket(io_context),
+			input(MAX_REQUEST_LENGTH),
+			registry(registry)
+		{
+		}
+
+		boost::asio::ip::tcp::socket& get_socket()
+		{
+			return socket;
+		}
+
+		void read()
+		{
+			boost::shared_ptr<Session> self = shared_from_this();
+
+			boost::asio::async_read_until
+			(
+				socket,
+				input,
+				"\r\n\r\n",
+				[self](const boost::system::error_code& error_code, size_t)
+				{
+					if (error_code)
+						return;
+
+					istream stream(&self->input);
+					string method, target;
+
+					//only the request line matters, headers are ignored
+					stream >> method >> target;
+
+					if (method != "GET")
+						self->reply = response("405 Method Not Allowed", "text/plain", "Only GET is supported\n");
+					else if ((target != "/metrics") && (target != "/"))
+						self->reply = response("404 Not Found", "text/plain", "Metrics are at /metrics\n");
+					else
+						self->reply = response("200 OK", "text/plain; version=0.0.4", self->registry->expose());
+
+					self->write();
+				}
+			);
+		}
+
+		void write()
+		{
+			boost::shared_ptr<Session> self = shared_from_this();
+
+			boost::asio::async_write
+			(
+				socket,
+				boost::asio::buffer(reply),
+				[self](const boost::system::error_code&, size_t)
+				{
+					boost::system::error_code error_code;
+
+					self->socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error_code);
+					self->socket.close(error_code);
+				}
+			);
+		}
+	};
+
+	Metrics_Endpoint::Metrics_Endpoint(boost::asio::io_context& io_context, Metrics_Registry::sptr_t registry, const std::string& address, const uint16_t port)
+	:
+		io_context(io_context),
+		registry(registry),
+		acceptor(io_context)
+	{
+		try
+		{
+			boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::make_address(address), port);
+
+			acceptor.open(endpoint.protocol());
+			acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+			acceptor.bind(endpoint);
+			acceptor.listen();
+		}
+		catch (const boost::system::system_error& e)
+		{
+			throw std::runtime_error("Unable to listen for metrics scrapes at " + address + ":" + to_string(port) + ": " + string(e.what()));
+		}
+
+		accept();
+
+		msg("utils: metrics are exposed at http://" + address + ":" + to_string(port) + "/metrics");
+	}
+
+	Metrics_Endpoint::~Metrics_Endpoint()
+	{
+		boost::system::error_code error_code;
+
+		acceptor.close(error_code);
+	}
+
+	void Metrics_Endpoint::accept()
+	{
+		boost::shared_ptr<Session> session(new Session(io_context, registry));
+
+		acceptor.async_accept
+		(
+			session->get_socket(),
+			[this, session](const boost::system::error_code& error_code)
+			{
+				if (error_code == boost::asio::error::operation_aborted)
+					return;
+
+				if (!error_code)
+					session->read();
+
+				accept();
+			}
+		);
+	}
+}
@@ -0,0 +1,40 @@
+#ifndef __METRICS_ENDPOINT_H__
+#define __METRICS_ENDPOINT_H__
+
+#include <string>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/asio.hpp>
+
+#include "Metrics_Registry.h"
+
+namespace utils
+{
+	//minimal HTTP/1.0 server exposing given registry at /metrics for a Prometheus scraper, served by given io_context
+	//(the main thread next to Signal_Handler and Control_Socket), so scrapes only read the cells of streaming threads,
+	//every connection answers a single GET request and is closed afterwards, e.g.
+	//
+	//	curl http://127.0.0.1:9464/metrics
+	class Metrics_Endpoint
+	{
+	private:
+		//single client connection, kept alive by its pending asynchronous operations
+		class Session;
+
+		boost::asio::io_context& io_context;
+		Metrics_Registry::sptr_t registry;
+		boost::asio::ip::tcp::acceptor acceptor;
+
+		void accept();
+
+	public:
+		typedef boost::shared_ptr<Metrics_Endpoint> sptr_t;
+
+		//address is meant to be a local one (e.g. 127.0.0.1), throws std::runtime_error when it cannot be listened at
+		Metrics_Endpoint(boost::asio::io_context& io_context, Metrics_Registry::sptr_t registry, const std::string& address, const uint16_t port);
+		~Metrics_Endpoint();
+	};
+}
+
+#endif
@@ -0,0 +1,205 @@
+#include "Metrics_Registry.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <new>
+#include <stdexcept>
+
+using namespace std;
+
+namespace utils
+{
+	static const size_t CACHE_LINE_SIZE = 64;
+
+	static atomic<uint64_t> next_instance_id(1);
+
+	Metrics_Registry::Metrics_Registry(const size_t max_no_of_cells)
+	:
+		instance_id(next_instance_id.fetch_add(1)),
+		max_no_of_cells(max_no_of_cells)
+	{
+	}
+
+	Metrics_Registry::~Metrics_Registry()
+	{
+		for (atomic<uint64_t>* cells : thread_cells)
+			free(cells);
+	}
+
+	std::atomic<uint64_t>* Metrics_Registry::get_thread_cells()
+	{
+		static thread_local atomic<uint64_t>* cells = nullptr;
+		static thread_local uint64_t cells_instance_id = 0;
+
+		if (cells_instance_id == instance_id)
+			return cells;
+
+		//first update of this thread - its cells are whole cache lines, so they are not shared with other threads
+		const size_t size = (max_no_of_cells * sizeof(atomic<uint64_t>) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+		void* memory = nullptr;
+
+		if (posix_memalign(&memory, CACHE_LINE_SIZE, size) != 0)
+			throw std::runtime_error("Unable to allocate metrics cells");
+
+		cells = static_cast<atomic<uint64_t>*>(memory);
+
+		for (size_t i = 0; i < max_no_of_cells; i++)
+			new (&cells[i]) atomic<uint64_t>(0);
+
+		cells_instance_id = instance_id;
+
+		boost::lock_guard<boost::mutex> guard(metrics_mutex);
+
+		thread_cells.push_back(cells);
+
+		return cells;
+	}
+
+	size_t Metrics_Registry::register_metric(const Metric& metric, const size_t no_of_metric_cells)
+	{
+		boost::lock_guard<boost::mutex> guard(metrics_mutex);
+
+		for (const Metric& m : metrics)
+		{
+			if ((m.name == metric.name) && (m.histogram != metric.histogram))
+				throw std::invalid_argument("Metric " + metric.name + " has been registered with another type");
+			if ((m.name == metric.name) && (m.labels == metric.labels))
+				throw std::invalid_argument("Metric " + metric.name + "{" + metric.labels + "} has been registered already");
+		}
+
+		if (no_of_cells + no_of_metric_cells > max_no_of_cells)
+			throw std::invalid_argument("Metric " + metric.name + " does not fit into the registry of " + to_string(max_no_of_cells) + " cells");
+
+		metrics.push_back(metric);
+		metrics.back().first_cell = no_of_cells;
+		no_of_cells += no_of_metric_cells;
+
+		return metrics.back().first_cell;
+	}
+
+	Metrics_Counter Metrics_Registry::add_counter(const std::string& name, const std::string& help, const std::string& labels)
+	{
+		Metric metric;
+
+		metric.name = name;
+		metric.help = help;
+		metric.labels = labels;
+
+		Metrics_Counter res;
+
+		res.cell = register_metric(metric, 1);
+		res.registry = this;
+
+		return res;
+	}
+
+	Metrics_Histogram Metrics_Registry::add_histogram(const std::string& name, const std::string& help, const std::string& labels, const std::vector<int64_t>& bucket_edges, const double scale)
+	{
+		if (!is_sorted(bucket_edges.begin(), bucket_edges.end()))
+			throw std::invalid_argument("Bucket edges of metric " + name + " are not ascending");
+
+		Metric metric;
+
+		metric.name = name;
+		metric.help = help;
+		metric.labels = labels;
+		metric.histogram = true;
+		metric.bucket_edges = bucket_edges;
+		metric.scale = scale;
+
+		Metrics_Histogram res;
+
+		//one cell per bucket, the one above the last edge and the sum
+		res.first_cell = register_metric(metric, bucket_edges.size() + 2);
+		res.bucket_edges = bucket_edges;
+		res.registry = this;
+
+		return res;
+	}
+
+	uint64_t Metrics_Registry::sum_cell(const size_t cell) const
+	{
+		uint64_t res = 0;
+
+		for (const atomic<uint64_t>* cells : thread_cells)
+			res += cells[cell].load(std::memory_order_relaxed);
+
+		return res;
+	}
+
+	std::string Metrics_Registry::expose() const
+	{
+		boost::lock_guard<boost::mutex> guard(metrics_mutex);
+
+		string res;
+		char line[512];
+		vector<bool> exposed(metrics.size(), false);
+
+		//all series of a name have to be listed together, right after its HELP and TYPE lines
+		for (size_t i = 0; i < metrics.size(); i++)
+		{
+			if (exposed[i])
+				continue;
+
+			res += "# HELP " + metrics[i].name + " " + metrics[i].help + "\n";
+			res += "# TYPE " + metrics[i].name + (metrics[i].histogram ? " histogram\n" : " counter\n");
+
+			for (size_t j = i; j < metrics.size(); j++)
+			{
+				const Metric& m = metrics[j];
+
+				if (m.name != metrics[i].name)
+					continue;
+
+				exposed[j] = true;
+
+				const string labels = m.labels.empty() ? "" : "{" + m.labels + "}";
+
+				if (!m.histogram)
+				{
+					snprintf(line, sizeof(line), "%s%s %llu\n", m.name.c_str(), labels.c_str(), (unsigned long long)sum_cell(m.first_cell));
+					res += line;
+					continue;
+				}
+
+				const string separator = m.labels.empty() ? "" : ",";
+				uint64_t count = 0;
+
+				for (size_t b = 0; b <= m.bucket_edges.size(); b++)
+				{
+					count += sum_cell(m.first_cell + b);
+
+					if (b < m.bucket_edges.size())
+						snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"%.9g\"} %llu\n", m.name.c_str(), m.labels.c_str(), separator.c_str(), m.scale * m.bucket_edges[b], (unsigned long long)count);
+					else
+						snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"+Inf\"} %llu\n", m.name.c_str(), m.labels.c_str(), separator.c_str(), (unsigned long long)count);
+
+					res += line;
+				}
+
+				//sum cells wrap around, so negative values add up as well
+				int64_t sum = (int64_t)sum_cell(m.first_cell + m.bucket_edges.size() + 1);
+
+				snprintf(line, sizeof(line), "%s_sum%s %.9g\n%s_count%s %llu\n", m.name.c_str(), labels.c_str(), m.scale * sum, m.name.c_str(), labels.c_str(), (unsigned long long)count);
+				res += line;
+			}
+		}
+
+		return res;
+	}
+
+	size_t Metrics_Registry::get_no_of_series() const
+	{
+		boost::lock_guard<boost::mutex> guard(metrics_mutex);
+
+		return metrics.size();
+	}
+
+	size_t Metrics_Registry::get_no_of_threads() const
+	{
+		boost::lock_guard<boost::mutex> guard(metrics_mutex);
+
+		return thread_cells.size();
+	}
+}
@@ -0,0 +1,130 @@
+#ifndef __METRICS_REGISTRY_H__
+#define __METRICS_REGISTRY_H__
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+namespace utils
+{
+	class Metrics_Registry;
+
+	//handle of a single counter series, a default constructed one is not registered and ignores updates
+	class Metrics_Counter
+	{
+	private:
+		friend class Metrics_Registry;
+
+		Metrics_Registry* registry = nullptr;
+		size_t cell = 0;
+
+	public:
+		inline void add(const uint64_t value = 1) const;
+	};
+
+	//handle of a single histogram series, values are given in integer units (e.g. [ns]) and bucket i counts values
+	//not above edge i (the last one all the remaining ones), a default constructed one ignores observations
+	class Metrics_Histogram
+	{
+	private:
+		friend class Metrics_Registry;
+
+		Metrics_Registry* registry = nullptr;
+		size_t first_cell = 0;
+		std::vector<int64_t> bucket_edges;
+
+	public:
+		inline void observe(const int64_t value) const;
+	};
+
+	//registry of counters and histograms exposed in Prometheus text format - every thread updating them owns its
+	//own preallocated (cache line aligned) array of cells, so an update is a plain load and store of a relaxed
+	//atomic that never waits for anybody, expose() sums cells of all threads
+	//
+	//series are meant to be registered before streaming starts, the first update of every thread allocates its
+	//cells (the only place where an updating thread takes a lock), a thread is meant to update series of a single
+	//registry only
+	class Metrics_Registry
+	{
+	private:
+		friend class Metrics_Counter;
+		friend class Metrics_Histogram;
+
+		struct Metric
+		{
+			std::string name;
+			std::string help;
+			std::string labels;
+			bool histogram = false;
+			size_t first_cell = 0;
+			std::vector<int64_t> bucket_edges;
+			double scale = 1;
+		};
+
+		//tells registries apart in per-thread caches, even if a new one gets the address of a destroyed one
+		uint64_t instance_id = 0;
+
+		std::vector<Metric> metrics;
+		size_t no_of_cells = 0;
+		size_t max_no_of_cells = 0;
+
+		std::vector<std::atomic<uint64_t>*> thread_cells;
+		mutable boost::mutex metrics_mutex;
+
+		std::atomic<uint64_t>* get_thread_cells();
+		size_t register_metric(const Metric& metric, const size_t no_of_metric_cells);
+		uint64_t sum_cell(const size_t cell) const;
+
+		inline void add(const size_t cell, const uint64_t value)
+		{
+			std::atomic<uint64_t>& c = get_thread_cells()[cell];
+
+			c.store(c.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+	public:
+		typedef boost::shared_ptr<Metrics_Registry> sptr_t;
+
+		//max_no_of_cells - counters take one cell, histograms one per bucket plus one for the sum
+		Metrics_Registry(const size_t max_no_of_cells = 4096);
+		~Metrics_Registry();
+
+		//labels are given as in the exposition format, e.g. device="0",direction="tx" (may be empty), series of the same
+		//name have to be of the same type, throws std::invalid_argument otherwise or when the registry is full
+		Metrics_Counter add_counter(const std::string& name, const std::string& help, const std::string& labels);
+
+		//bucket edges have to be ascending, observed values and edges are multiplied by scale when exposed
+		//(e.g. 1e-9 for values in [ns] exposed in [s])
+		Metrics_Histogram add_histogram(const std::string& name, const std::string& help, const std::string& labels, const std::vector<int64_t>& bucket_edges, const double scale = 1);
+
+		//current values of all series in Prometheus text exposition format (version 0.0.4)
+		std::string expose() const;
+
+		size_t get_no_of_series() const;
+		size_t get_no_of_threads() const;
+	};
+
+	inline void Metrics_Counter::add(const uint64_t value) const
+	{
+		if (registry)
+			registry->add(cell, value);
+	}
+
+	inline void Metrics_Histogram::observe(const int64_t value) const
+	{
+		if (!registry)
+			return;
+
+		size_t bucket = std::lower_bound(bucket_edges.begin(), bucket_edges.end(), value) - bucket_edges.begin();
+
+		registry->add(first_cell + bucket, 1);
+		registry->add(first_cell + bucket_edges.size() + 1, (uint64_t)value);
+	}
+}
+
+#endif
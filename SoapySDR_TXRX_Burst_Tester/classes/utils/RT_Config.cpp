@@ -0,0 +1,126 @@
+#include "RT_Config.h"
+
+#include <sched.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <malloc.h>
+#include <sys/mman.h>
+
+#include "utils.h"
+
+using namespace std;
+
+namespace utils
+{
+	string apply_rt_thread_config(pthread_t thread, const string& name, const RT_Thread_Config& cfg)
+	{
+		//CPU_SET is undefined past the end of the set, such cpu is rejected like an invalid priority is
+		if (cfg.cpu >= CPU_SETSIZE)
+			msg("rt: Unable to pin " + name + " thread to cpu " + to_string(cfg.cpu) + ": " + string(strerror(EINVAL)) + " (cpu has to be lower than " + to_string(CPU_SETSIZE) + ")", WARNING);
+		else if (cfg.cpu >= 0)
+		{
+			cpu_set_t cpu_set;
+			CPU_ZERO(&cpu_set);
+			CPU_SET(cfg.cpu, &cpu_set);
+
+			int ret = pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set);
+
+			if (ret != 0)
+				msg("rt: Unable to pin " + name + " thread to cpu " + to_string(cfg.cpu) + ": " + string(strerror(ret)), WARNING);
+		}
+
+		if (cfg.priority > 0)
+		{
+			struct sched_param param;
+			param.sched_priority = cfg.priority;
+
+			int ret = pthread_setschedparam(thread, SCHED_FIFO, &param);
+
+			if (ret != 0)
+				msg("rt: Unable to set SCHED_FIFO priority " + to_string(cfg.priority) + " of " + name + " thread: " + string(strerror(ret)), WARNING);
+		}
+
+		//report what the thread actually ended up with
+		string applied;
+
+		int policy;
+		struct sched_param param;
+
+		if (pthread_getschedparam(thread, &policy, &param) == 0)
+		{
+			if (policy == SCHED_FIFO)
+				applied = "SCHED_FIFO/" + to_string(param.sched_priority);
+			else if (policy == SCHED_RR)
+				applied = "SCHED_RR/" + to_string(param.sched_priority);
+			else
+				applied = "SCHED_OTHER";
+		}
+
+		cpu_set_t cpu_set;
+		CPU_ZERO(&cpu_set);
+
+		if (pthread_getaffinity_np(thread, sizeof(cpu_set), &cpu_set) == 0)
+		{
+			if (CPU_COUNT(&cpu_set) == sysconf(_SC_NPROCESSORS_ONLN))
+				applied += ", any cpu";
+			else
+			{
+				string cpus;
+
+				for (int i = 0; i < CPU_SETSIZE; i++)
+				{
+					if (CPU_ISSET(i, &cpu_set))
+						cpus += (cpus.empty() ? "" : ",") + to_string(i);
+				}
+
+				applied += ", cpu " + cpus;
+			}
+		}
+
+		msg("rt: " + name + " thread: " + applied);
+
+		return applied;
+	}
+
+	bool lock_memory(const bool on_fault)
+	{
+		int flags = MCL_CURRENT | MCL_FUTURE;
+
+		if (on_fault)
+		{
+#ifdef MCL_ONFAULT
+			flags |= MCL_ONFAULT;
+#else
+			msg("rt: Locking memory on fault is not supported by this system", WARNING);
+			return false;
+#endif
+		}
+
+		if (mlockall(flags) != 0)
+		{
+			msg("rt: Unable to lock memory: " + string(strerror(errno)), WARNING);
+			return false;
+		}
+
+		//freed heap memory stays mapped (and locked), so later allocations do not fault new pages in
+		mallopt(M_TRIM_THRESHOLD, -1);
+		mallopt(M_MMAP_MAX, 0);
+
+		msg(on_fault ? "rt: Memory locked (future pages once touched)" : "rt: Memory locked");
+
+		return true;
+	}
+
+	void prefault(void* data, const size_t size)
+	{
+		volatile char* bytes = (volatile char*)data;
+		const size_t page_size = sysconf(_SC_PAGESIZE);
+
+		for (size_t i = 0; i < size; i += page_size)
+			bytes[i] = bytes[i];
+
+		if (size > 0)
+			bytes[size - 1] = bytes[size - 1];
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef __RT_CONFIG_H__
+#define __RT_CONFIG_H__
+
+#include <string>
+#include <pthread.h>
+
+namespace utils
+{
+	//real-time settings of a single thread
+	struct RT_Thread_Config
+	{
+		//CPU core the thread is pinned to (-1 - not pinned)
+		int cpu = -1;
+		//SCHED_FIFO priority (0 - default scheduling policy is kept)
+		int priority = 0;
+	};
+
+	//applies given settings to a thread and returns what is actually in effect afterwards, e.g. "SCHED_FIFO/80, cpu 2"
+	//(settings that could not be applied, e.g. because of missing CAP_SYS_NICE, are reported as warnings)
+	std::string apply_rt_thread_config(pthread_t thread, const std::string& name, const RT_Thread_Config& cfg);
+
+	//locks current and future pages of the process in RAM and keeps freed heap memory mapped,
+	//returns false when it is not permitted
+	//
+	//with on_fault future pages are locked once they are first touched rather than populated when they are mapped,
+	//so a memory-mapped file larger than RAM can still be mapped (and unlocked right away, see TX_Playback)
+	bool lock_memory(const bool on_fault = false);
+
+	//touches every page of given memory (without changing its content), so first bursts do not page-fault
+	void prefault(void* data, const size_t size);
+}
+
+#endif
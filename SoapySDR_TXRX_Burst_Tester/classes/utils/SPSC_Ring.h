@@ -0,0 +1,131 @@
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+
+namespace utils
+{
+	//bounded single-producer/single-consumer lock-free ring
+	//exactly one thread may push and exactly one (other) thread may pop, neither of them ever blocks
+	template <typename T>
+	class SPSC_Ring
+	{
+	private:
+		//indexes are padded to separate cache lines so producer and consumer do not share them
+		std::atomic<size_t> head;
+		char head_padding[64 - sizeof(std::atomic<size_t>)];
+		std::atomic<size_t> tail;
+		char tail_padding[64 - sizeof(std::atomic<size_t>)];
+		size_t mask;
+		std::vector<T> slots;
+
+		static size_t round_up_to_power_of_two(size_t n)
+		{
+			size_t result = 1;
+
+			while (result < n)
+				result <<= 1;
+
+			return result;
+		}
+
+	public:
+		SPSC_Ring(const size_t capacity)
+		:
+			head(0),
+			tail(0),
+			mask(round_up_to_power_of_two(capacity < 2 ? 2 : capacity) - 1),
+			slots(mask + 1)
+		{
+		}
+
+		//every slot starts as a copy of prototype, e.g. with its buffers already allocated
+		SPSC_Ring(const size_t capacity, const T& prototype)
+		:
+			head(0),
+			tail(0),
+			mask(round_up_to_power_of_two(capacity < 2 ? 2 : capacity) - 1),
+			slots(mask + 1, prototype)
+		{
+		}
+
+		size_t capacity() const
+		{
+			return mask + 1;
+		}
+
+		size_t size() const
+		{
+			return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+		}
+
+		bool empty() const
+		{
+			return size() == 0;
+		}
+
+		//producer side: returns a slot to be filled in place or nullptr when the ring is full
+		T* claim()
+		{
+			const size_t h = head.load(std::memory_order_relaxed);
+
+			if (h - tail.load(std::memory_order_acquire) > mask)
+				return nullptr;
+
+			return &slots[h & mask];
+		}
+
+		//producer side: makes the slot returned by claim() visible to the consumer
+		void publish()
+		{
+			head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		bool try_push(const T& item)
+		{
+			T* slot = claim();
+
+			if (slot == nullptr)
+				return false;
+
+			*slot = item;
+			publish();
+
+			return true;
+		}
+
+		//consumer side: returns the oldest item without removing it or nullptr when the ring is empty
+		T* peek()
+		{
+			const size_t t = tail.load(std::memory_order_relaxed);
+
+			if (t == head.load(std::memory_order_acquire))
+				return nullptr;
+
+			return &slots[t & mask];
+		}
+
+		//consumer side: gives the slot returned by peek() back to the producer
+		void release()
+		{
+			tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		bool try_pop(T& item)
+		{
+			T* slot = peek();
+
+			if (slot == nullptr)
+				return false;
+
+			item = *slot;
+			release();
+
+			return true;
+		}
+	};
+}
+
+#endif
@@ -1,4 +1,12 @@
 #include "utils.h"
+#include "Async_Logger.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <boost/bind/bind.hpp>
+#include <boost/asio/placeholders.hpp>
 
 namespace pt = boost::posix_time;
 using namespace std;
@@ -13,6 +21,14 @@ namespace utils
 		return pt::ptime(pt::microsec_clock::universal_time());
 	}
 
+	int64_t monotonic_time_ns()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+
+		return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	}
+
 	string ptime_to_str
 	(
 		const pt::ptime & given_ptime,
@@ -82,6 +98,11 @@ namespace utils
 		const bool& add_msg_type_prefix
 	)
 	{
+		//hand the message over to the drain thread whenever asynchronous logging is running, a message that comes
+		//right after the logger has been stopped is printed here
+		if (async_logger.is_running() && (async_logger.push(text.data(), text.size(), msg_type, add_timestamp, add_msg_type_prefix) != LOG_STOPPED))
+			return text;
+
 		boost::lock_guard<boost::mutex> guard(msg_mutex);
 
 		string msg_text = to_msg(text, msg_type, add_timestamp, add_msg_type_prefix);
@@ -94,6 +115,38 @@ namespace utils
 		return msg_text;
 	}
 
+	void msgf
+	(
+		msg_type_t msg_type,
+		const char* format,
+		...
+	)
+	{
+		va_list args;
+		va_start(args, format);
+
+		bool queued = false;
+
+		if (async_logger.is_running())
+		{
+			va_list async_args;
+			va_copy(async_args, args);
+
+			queued = (async_logger.push_format(msg_type, format, async_args) != LOG_STOPPED);
+
+			va_end(async_args);
+		}
+
+		if (!queued)
+		{
+			char text[LOG_RECORD_TEXT_SIZE];
+			vsnprintf(text, sizeof(text), format, args);
+			msg(text, msg_type);
+		}
+
+		va_end(args);
+	}
+
 	vector<string> explode
 	(
 		string const & line,
@@ -128,8 +181,8 @@ namespace utils
 			(
 				&Signal_Handler::handle_signal,
 				this,
-				_1,
-				_2,
+				boost::asio::placeholders::error,
+				boost::asio::placeholders::signal_number,
 				boost::ref(stop)
 			)
 		);
@@ -4,11 +4,20 @@
 #include <iostream>
 #include <vector>
 #include <sstream>
+#include <stdint.h>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/thread.hpp>
 #include <boost/asio/signal_set.hpp>
 
+//DSP kernels (waveform generation, FFT, correlation) are plain loops written for auto-vectorisation, on x86 they are
+//additionally cloned for AVX2 and the clone matching the CPU is picked when the tester is loaded
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define VECTORISED_KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#define VECTORISED_KERNEL
+#endif
+
 namespace utils
 {
 	//mutex meant to be blocked while displaying cout and cerr messages from different threads scope
@@ -20,6 +29,9 @@ namespace utils
 	//function that will return current time as ptime object
 	boost::posix_time::ptime current_time();
 
+	//function that will return host monotonic clock in [ns] (cheap enough to be used on burst paths)
+	int64_t monotonic_time_ns();
+
 	//function that will convert given ptime object into string
 	std::string ptime_to_str
 	(
@@ -46,6 +58,7 @@ namespace utils
 	);
 
 	//function that will print given text on cout/cerr depending on message type
+	//(when async_logger is running the text is only queued and returned unformatted)
 	std::string msg
 	(
 		const std::string text,
@@ -54,6 +67,14 @@ namespace utils
 		const bool& add_msg_type_prefix = true
 	);
 
+	//printf-like variant of msg() that does not allocate any memory while asynchronous logging is running
+	void msgf
+	(
+		msg_type_t msg_type,
+		const char* format,
+		...
+	) __attribute__((format(printf, 2, 3)));
+
 	//function that will return a set of "words" separated by a given delimiter in an input line
 	std::vector<std::string> explode
 	(
@@ -1,5 +1,5 @@
 /*
- * SoapySDR_TXTX_Burst_Tester v1.03
+ * SoapySDR_TXTX_Burst_Tester v1.27
  *
  *  Created on: 2017-09-08
  *      Author: ccsh
@@ -19,11 +19,77 @@
  *			Other minor fixes
  * v1.03 (2017-09-08)
  *			Making sure that TX loop will fire after RX loop, also making sure that first TX burst timestamp will be later than RX one
+ * v1.04 (2026-10-17)
+ *			Messages are queued into per-thread lock-free rings and written by a separate logging thread ([LOG] section)
+ * v1.05 (2026-10-17)
+ *			TX and RX bursts no longer allocate any memory - scratch buffers and burst status are owned by SDR_Device_Wrapper
+ * v1.06 (2026-10-17)
+ *			TX bursts may be pipelined (SIGNAL.tx_pipeline_depth), their acks are matched by a separate status thread
+ * v1.07 (2026-10-17)
+ *			RX stream may be activated just once and RX bursts carved out of continuous sample flow (SDR.rx_continuous)
+ * v1.08 (2026-10-17)
+ *			Simulated burst_sim device (SDR.args = driver=burst_sim) for runs and benchmarks without hardware
+ *			TX pipeline registers bursts before writing them, so late bursts reported right away are matched
+ * v1.09 (2026-10-17)
+ *			Burst benchmark (make bench in Release) sweeping burst length, period and RX mode, results written as JSON
+ * v1.10 (2026-10-17)
+ *			TX and RX bursts are dispatched by a frame scheduler from a single TDD timeline, lead_time ahead of their slots
+ *			Frames that cannot make it any more are skipped and counted (SIGNAL.min_lead_time), lead time histograms are printed on exit
+ * v1.11 (2026-10-17)
+ *			TDD frames may consist of any number of TX and RX slots (repeated SIGNAL.slot = TX:offset:length), with per slot stats
+ * v1.12 (2026-10-17)
+ *			TX, RX and logging threads may be pinned to cores and run with SCHED_FIFO priorities, memory may be locked and buffers prefaulted ([RT] section)
+ *			Late bursts and skipped slots are summarised on exit together with real-time settings actually applied
+ * v1.13 (2026-10-17)
+ *			Per-burst timing telemetry may be recorded into a binary trace file (LOG.trace_file), tools/Burst_Trace_Decoder converts it to CSV
+ * v1.14 (2026-10-17)
+ *			RX bursts may be captured straight into a preallocated memory-mapped file with per-burst index ([CAPTURE] section),
+ *			tools/RX_Capture_Reader lists and extracts them
+ * v1.15 (2026-10-17)
+ *			Stream format may be CF32, CS16, CS12 or the native one of the device (SDR.stream_format), integer formats are converted
+ *			by SIMD kernels picked for the CPU (AVX2, SSE or NEON), make convert_bench in Release compares their throughput
+ * v1.16 (2026-10-17)
+ *			TX burst payloads may be tones, chirps, Zadoff-Chu preambles, PRBS modulated QPSK or cf32 files (repeated SIGNAL.waveform),
+ *			they are precomputed at startup into page-locked buffers and bursts rotate through them
+ * v1.17 (2026-10-17)
+ *			RX bursts may be cross-correlated against the TX waveform by a separate worker thread ([CORRELATION] section),
+ *			TX to RX offset, peak power and SNR are reported per frame and summarised on exit
+ * v1.18 (2026-10-17)
+ *			RX power, peak, DC offset and IQ imbalance may be computed by a separate worker thread ([STATS] section),
+ *			rolling window summaries are printed periodically instead of per burst
+ * v1.19 (2026-10-17)
+ *			Several TX and RX channels may be streamed together (MIMO) - SDR.tx/rx_channel, tx/rx_antenna and tx/rx_gain
+ *			take comma separated per channel lists, every channel has its own cache line aligned buffer
+ * v1.20 (2026-10-17)
+ *			Several devices may be driven by one process ([SDR.1], [SDR.2], ... sections override settings of [SDR]),
+ *			they are initialized in parallel, their hardware times aligned (SDR.time_sync) and skew between them reported
+ * v1.21 (2026-10-17)
+ *			Device initialization waits for all LO locks together and for conditions instead of fixed sleeps, prints
+ *			how long its phases took and skips settings the device still holds from the last run (SDR.init_cache)
+ * v1.22 (2026-10-17)
+ *			Gains, center frequency and burst timing may be changed while streaming through a control socket
+ *			(CONTROL.socket), changes take effect at a frame boundary, timed by the device where it supports it
+ * v1.23 (2026-10-17)
+ *			Burst counts, SoapySDR error codes, TX ack latency and lead time histograms of every device are exposed
+ *			for a Prometheus scraper over HTTP on localhost ([METRICS] section), counters are updated wait-free
+ * v1.24 (2026-10-17)
+ *			Bursts can be converted straight into/out of driver buffers (SDR.direct_buffers) of drivers supporting
+ *			direct buffer access, copy path is used otherwise
+ * v1.25 (2026-10-17)
+ *			Continuous full-duplex streaming mode ([CONTINUOUS] section) reporting sustained rates, overflows,
+ *			underflows and dropped samples of both directions for finding the sample rate ceiling of a host and device
+ * v1.26 (2026-10-17)
+ *			TX bursts may be played from a large raw IQ file ([PLAYBACK] section) sliced into consecutive bursts,
+ *			a prefetch thread keeps the following bursts converted ahead of the TX thread
+ * v1.27 (2026-10-17)
+ *			Hardware time of bursts, logs and the frame scheduler is estimated by a model of the hardware clock
+ *			(offset and drift fitted to periodic reads, SDR.clock_tracking) instead of being read for every burst
  */
 #include <iostream>
 #include <stdio.h>
 #include <vector>
 #include <fstream>
+#include <map>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/thread.hpp>
@@ -31,7 +97,24 @@
 #include <boost/asio/signal_set.hpp>
 
 #include "classes/utils/utils.h"
+#include "classes/utils/Async_Logger.h"
+#include "classes/utils/RT_Config.h"
+#include "classes/utils/Control_Socket.h"
+#include "classes/utils/Metrics_Registry.h"
+#include "classes/utils/Metrics_Endpoint.h"
 #include "classes/sdr/SDR_Device_Wrapper.h"
+#include "classes/sdr/SDR_Device_Group.h"
+#include "classes/sdr/SDR_Init_Cache.h"
+#include "classes/sdr/TX_Pipeline.h"
+#include "classes/sdr/Frame_Scheduler.h"
+#include "classes/sdr/RX_Capture.h"
+#include "classes/sdr/TX_Playback.h"
+#include "classes/sdr/Waveform_Library.h"
+#include "classes/sdr/Burst_Correlator.h"
+#include "classes/sdr/RX_Burst_Stats.h"
+#include "classes/sdr/Live_Reconfigurator.h"
+#include "classes/sdr/SDR_Metrics.h"
+#include "classes/sdr/Continuous_Streamer.h"
 
 #include <SoapySDR/Time.hpp>
 
@@ -50,50 +133,6 @@ namespace utils
 	}
 }
 
-void rx_thread_function
-(
-	SDR_Device_Wrapper::sptr_t sdr_device_wrapper,
-	vector<complex<float>>& rx_buffer,
-	int64_t rx_start_tick,
-	int64_t no_of_ticks_per_bursts_period,
-	bool rx_active
-)
-{
-	try
-	{
-		int64_t tick = rx_start_tick;
-
-		if (rx_active)
-			msg("rx_thread: RX streaming started!");
-
-		while (!stop)
-		{
-			if (rx_active)
-			{
-				sdr_device_wrapper->receive_samples(tick, &rx_buffer[0], rx_buffer.size());
-				tick += no_of_ticks_per_bursts_period;
-			}
-			else
-				sleep(1);
-
-			signal_handler.get_io_service().poll();
-		}
-	}
-	catch (const boost::thread_interrupted& e)
-	{
-		msg("rx_thread: thread has been interrupted.");
-	}
-	catch (const std::exception& e)
-	{
-		msg("rx_thread: " + string(e.what()), WARNING);
-	}
-	catch (...)
-	{
-		msg("rx_thread: Unexpected exception occurred.", ERROR);
-	}
-}
-
-
 int main(int argc, char *argv[])
 {
 	//disable cout and cerr buffering
@@ -106,12 +145,78 @@ int main(int argc, char *argv[])
 	//prepare usrp_cfg structure on the basis of given configuration
 	SDR_Device_Config::sptr_t device_cfg(new SDR_Device_Config);
 
+	//[SDR] per channel lists
+	string tx_channels;
+	string rx_channels;
+	string tx_antennas;
+	string rx_antennas;
+	string tx_gains;
+	string rx_gains;
+
+	//[SDR.1], [SDR.2], ... - settings of additional devices overriding these of [SDR], by section number
+	map<unsigned long, vector<pair<string, string>>> extra_device_options;
+	string time_sync_name;
+	time_sync_t time_sync = TIME_SYNC_HOST;
+	string init_cache_filepath;
+
 	//[SIGNAL]
 	double burst_period;
+	size_t tx_pipeline_depth;
 	double tx_burst_length;
 	double rx_burst_length;
 	double rx_tx_separation;
 	double time_in_future;
+	vector<string> slot_descriptions;
+	vector<string> waveform_descriptions;
+	TDD_Timeline timeline;
+
+	//[LOG]
+	bool async_logging;
+	size_t log_ring_size;
+	string trace_filepath;
+	size_t trace_ring_size;
+
+	//[CAPTURE]
+	string capture_filepath;
+	size_t capture_no_of_bursts;
+	bool capture_wrap;
+
+	//[PLAYBACK]
+	string playback_filepath;
+	string playback_format;
+	size_t playback_no_of_buffers;
+	bool playback_loop;
+
+	//[CORRELATION]
+	bool correlation_enabled;
+	size_t correlation_queue_size;
+	double correlation_min_snr;
+	bool correlation_log_bursts;
+
+	//[STATS]
+	bool stats_enabled;
+	size_t stats_queue_size;
+	size_t stats_window;
+	double stats_report_period;
+
+	//[CONTINUOUS]
+	bool continuous_enabled;
+	size_t continuous_buffer_size;
+	double continuous_period;
+
+	//[CONTROL]
+	string control_socket_path;
+
+	//[METRICS]
+	uint16_t metrics_port;
+	string metrics_address;
+
+	//[RT]
+	bool rt_mlockall;
+	bool rt_prefault;
+	RT_Thread_Config rt_tx;
+	RT_Thread_Config rt_rx;
+	RT_Thread_Config rt_log;
 
 	/*********************************************************************************************************/
 	//following code will read the content of a cfg file and command line arguments, print help messages etc.
@@ -148,12 +253,12 @@ int main(int argc, char *argv[])
 			("SDR.args,d", po::value<string>(&device_cfg->args)						->default_value(""), "Device arguments (e.g. addr=192.168.10.1,type=usrp2)")
 			("SDR.clock_source,e", po::value<string>(&device_cfg->clock_source)		->default_value(""), "Device clock source.")
 			("SDR.time_source,x", po::value<string>(&device_cfg->time_source)		->default_value(""), "Device time source.")
-			("SDR.tx_channel,o", po::value<short>(&device_cfg->channel_tx)			->default_value(0), "Transmitting channel number.")
-			("SDR.rx_channel,p", po::value<short>(&device_cfg->channel_rx)			->default_value(0), "Receiving channel number.")
-			("SDR.tx_antenna,n", po::value<string>(&device_cfg->antenna_tx)			->default_value("BAND1"), "Transmitting antenna name.")
-			("SDR.rx_antenna,a", po::value<string>(&device_cfg->antenna_rx)			->default_value("LNAL"), "Receiving antenna name.")
-			("SDR.tx_gain,q", po::value<double>(&device_cfg->G_tx)					->default_value(52), "TX chain gain in [dB].")
-			("SDR.rx_gain,w", po::value<double>(&device_cfg->G_rx)					->default_value(20), "RX chain gain in [dB].")
+			("SDR.tx_channel,o", po::value<string>(&tx_channels)					->default_value("0"), "Transmitting channel numbers as a comma separated list (e.g. 0,1 for MIMO).")
+			("SDR.rx_channel,p", po::value<string>(&rx_channels)					->default_value("0"), "Receiving channel numbers as a comma separated list (e.g. 0,1 for MIMO).")
+			("SDR.tx_antenna,n", po::value<string>(&tx_antennas)					->default_value("BAND1"), "Transmitting antenna names per channel as a comma separated list (the last one applies to all remaining channels).")
+			("SDR.rx_antenna,a", po::value<string>(&rx_antennas)					->default_value("LNAL"), "Receiving antenna names per channel as a comma separated list (the last one applies to all remaining channels).")
+			("SDR.tx_gain,q", po::value<string>(&tx_gains)							->default_value("52"), "TX chain gains per channel in [dB] as a comma separated list (the last one applies to all remaining channels).")
+			("SDR.rx_gain,w", po::value<string>(&rx_gains)							->default_value("20"), "RX chain gains per channel in [dB] as a comma separated list (the last one applies to all remaining channels).")
 			("SDR.center_frequency,f", po::value<double>(&device_cfg->f_c_tx)		->default_value(1457e6), "Center frequency in [Hz].")
 			("SDR.master_clock_rate,m", po::value<double>(&device_cfg->f_clk)		->default_value(133.333333e6), "Master clock rate in [Hz].")
 			("SDR.clock_divider,d", po::value<uint16_t>(&device_cfg->D_tx)			->default_value(8), "Master clock divider used to obtain sampling rate in [Hz].")
@@ -162,12 +267,67 @@ int main(int argc, char *argv[])
 			("SDR.timeout,j", po::value<double>(&device_cfg->T_timeout)				->default_value(2), "Streaming timeout in [s].")
 			("SDR.tx_thread_active,t", po::value<bool>(&device_cfg->tx_active)		->default_value(true), "Whether to start TX thread or not.")
 			("SDR.rx_thread_active,r", po::value<bool>(&device_cfg->rx_active)		->default_value(true), "Whether to start RX thread or not.")
+			("SDR.rx_continuous", po::value<bool>(&device_cfg->rx_continuous)		->default_value(false), "Whether to activate RX stream once and carve RX bursts out of continuous sample flow or to activate it for every burst.")
+			("SDR.stream_format", po::value<string>(&device_cfg->stream_format)		->default_value("CF32"), "Stream sample format - CF32, CS16, CS12 or native (the one reported by the device).")
+			("SDR.command_time", po::value<bool>(&device_cfg->command_time)			->default_value(false), "Whether the device applies settings at a given hardware time (setCommandTime), otherwise settings changed while streaming are applied by the host between bursts.")
+			("SDR.direct_buffers", po::value<bool>(&device_cfg->direct_buffers)		->default_value(false), "Whether bursts are converted straight into/out of driver buffers (acquireWriteBuffer/acquireReadBuffer), drivers without direct buffer access fall back to the copy path.")
+			("SDR.clock_tracking", po::value<double>(&device_cfg->T_clock_tracking)	->default_value(0.1), "Period of reading hardware time for the clock model bursts and the frame scheduler estimate it from in [s] (0 - hardware time is read for every burst).")
+			("SDR.clock_window", po::value<size_t>(&device_cfg->clock_window)		->default_value(32), "Number of most recent hardware time reads offset and drift of the clock model are fitted to.")
+			("SDR.time_sync", po::value<string>(&time_sync_name)					->default_value("host"), "How hardware times of several devices ([SDR.1], [SDR.2], ... sections overriding settings of [SDR]) are aligned - none, host or pps.")
+			("SDR.init_cache", po::value<string>(&init_cache_filepath)				->default_value(""), "File settings applied to devices are cached in, so settings a device still holds are not applied again during the next run (empty - no caching).")
 
 			("SIGNAL.burst_period,u", po::value<double>(&burst_period)				->default_value(100e-3), "TX/RX bursts cycle period in [s].")
+			("SIGNAL.tx_pipeline_depth", po::value<size_t>(&tx_pipeline_depth)		->default_value(0), "Number of TX bursts queued ahead while their acks are collected by a separate thread (0 - wait for every ack).")
 			("SIGNAL.tx_burst_length,k", po::value<double>(&tx_burst_length)		->default_value(5e-3), "Length of TX bursts in [s].")
 			("SIGNAL.rx_burst_length,l", po::value<double>(&rx_burst_length)		->default_value(5e-3), "Length of RX bursts in [s].")
 			("SIGNAL.rx_tx_separation,s", po::value<double>(&rx_tx_separation)		->default_value(1e-3), "RX and TX bursts separation in [s].")
 			("SIGNAL.time_in_future,y", po::value<double>(&time_in_future)			->default_value(1), "Time in future to start streaming in [s].")
+			("SIGNAL.lead_time", po::value<double>(&timeline.lead_time)				->default_value(20e-3), "Time ahead of its slot in which a burst is handed over to the device in [s].")
+			("SIGNAL.min_lead_time", po::value<double>(&timeline.min_lead_time)		->default_value(1e-3), "Minimum time ahead of its slot below which the slot is skipped in [s].")
+			("SIGNAL.slot", po::value<vector<string>>(&slot_descriptions)			->composing(), "TDD slot as TX:offset:length or RX:offset:length in [s] relative to the frame start, may be repeated (replaces tx/rx_burst_length and rx_tx_separation).")
+			("SIGNAL.waveform", po::value<vector<string>>(&waveform_descriptions)	->composing(), "TX burst payload as constant[:amplitude], tone:f[:amplitude], chirp:f_start:f_stop[:amplitude], zc:root:length[:amplitude], qpsk:prbs_order[:samples_per_symbol[:amplitude]] or file:path (raw cf32), may be repeated (bursts rotate through them).")
+
+			("LOG.async", po::value<bool>(&async_logging)							->default_value(true), "Whether messages should be written by a separate logging thread or not.")
+			("LOG.ring_size", po::value<size_t>(&log_ring_size)						->default_value(1024), "Number of log records buffered per thread before new ones are dropped.")
+			("LOG.trace_file", po::value<string>(&trace_filepath)					->default_value(""), "Path of the binary per-burst trace file (empty - no trace is recorded).")
+			("LOG.trace_ring_size", po::value<size_t>(&trace_ring_size)				->default_value(65536), "Number of trace records buffered per TX, RX and TX ack source before new ones are dropped.")
+
+			("CAPTURE.file", po::value<string>(&capture_filepath)					->default_value(""), "Path of the file RX bursts are captured into (empty - no capture).")
+			("CAPTURE.no_of_bursts", po::value<size_t>(&capture_no_of_bursts)		->default_value(1000), "Number of RX bursts preallocated in the capture file.")
+			("CAPTURE.wrap", po::value<bool>(&capture_wrap)							->default_value(false), "Whether to overwrite the oldest bursts once the capture file is full or to stop capturing.")
+
+			("PLAYBACK.file", po::value<string>(&playback_filepath)					->default_value(""), "Path of a raw IQ file TX bursts are played from (empty - TX bursts carry waveforms of SIGNAL.waveform).")
+			("PLAYBACK.format", po::value<string>(&playback_format)					->default_value("CF32"), "Sample format of the playback file: CF32, CS16 or CS12.")
+			("PLAYBACK.no_of_buffers", po::value<size_t>(&playback_no_of_buffers)	->default_value(3), "Number of TX bursts prefetched from the playback file ahead of the TX thread.")
+			("PLAYBACK.loop", po::value<bool>(&playback_loop)						->default_value(true), "Whether to start the playback file over once played to its end or to send zeros from then on.")
+
+			("CORRELATION.enabled", po::value<bool>(&correlation_enabled)			->default_value(false), "Whether RX bursts should be correlated against the TX waveform sent before them or not.")
+			("CORRELATION.queue_size", po::value<size_t>(&correlation_queue_size)	->default_value(64), "Number of RX bursts waiting for correlation before new ones are dropped.")
+			("CORRELATION.min_snr", po::value<double>(&correlation_min_snr)			->default_value(10), "Minimum SNR in [dB] at which the TX burst is considered detected.")
+			("CORRELATION.log_bursts", po::value<bool>(&correlation_log_bursts)		->default_value(true), "Whether offset, peak power and SNR should be printed for every correlated burst or not.")
+
+			("STATS.enabled", po::value<bool>(&stats_enabled)						->default_value(false), "Whether RX power, peak, DC offset and IQ imbalance should be computed or not.")
+			("STATS.queue_size", po::value<size_t>(&stats_queue_size)				->default_value(64), "Number of RX bursts waiting for analysis before new ones are dropped.")
+			("STATS.window", po::value<size_t>(&stats_window)						->default_value(1000), "Number of most recent RX bursts summarised by every report.")
+			("STATS.report_period", po::value<double>(&stats_report_period)			->default_value(1), "Period of printing summaries in [s] (0 - only on exit).")
+
+			("CONTINUOUS.enabled", po::value<bool>(&continuous_enabled)				->default_value(false), "Whether TX and RX streams should run non-stop at the configured sample rate (throughput test) instead of in TDD frames.")
+			("CONTINUOUS.buffer_size", po::value<size_t>(&continuous_buffer_size)	->default_value(65536), "Number of samples per writeStream/readStream call of continuous streaming (0 - stream MTU).")
+			("CONTINUOUS.report_period", po::value<double>(&continuous_period)		->default_value(1), "Period of printing sustained rates and losses of continuous streaming in [s] (0 - only on exit).")
+
+			("CONTROL.socket", po::value<string>(&control_socket_path)				->default_value(""), "Path of a local socket accepting commands that change settings while streaming (empty - disabled).")
+
+			("METRICS.port", po::value<uint16_t>(&metrics_port)						->default_value(0), "TCP port metrics are exposed at for a Prometheus scraper (0 - disabled).")
+			("METRICS.address", po::value<string>(&metrics_address)					->default_value("127.0.0.1"), "Address metrics are exposed at, meant to be a local one.")
+
+			("RT.mlockall", po::value<bool>(&rt_mlockall)							->default_value(false), "Whether to lock all memory of the process in RAM or not.")
+			("RT.prefault", po::value<bool>(&rt_prefault)							->default_value(false), "Whether to touch all sample buffers before streaming starts or not.")
+			("RT.tx_cpu", po::value<int>(&rt_tx.cpu)								->default_value(-1), "CPU core TX threads are pinned to (-1 - not pinned).")
+			("RT.tx_priority", po::value<int>(&rt_tx.priority)						->default_value(0), "SCHED_FIFO priority of TX threads (0 - default scheduling).")
+			("RT.rx_cpu", po::value<int>(&rt_rx.cpu)								->default_value(-1), "CPU core RX thread is pinned to (-1 - not pinned).")
+			("RT.rx_priority", po::value<int>(&rt_rx.priority)						->default_value(0), "SCHED_FIFO priority of RX thread (0 - default scheduling).")
+			("RT.log_cpu", po::value<int>(&rt_log.cpu)								->default_value(-1), "CPU core logging thread is pinned to (-1 - not pinned).")
+			("RT.log_priority", po::value<int>(&rt_log.priority)					->default_value(0), "SCHED_FIFO priority of logging thread (0 - default scheduling).")
 			;
 
 		cmdline_options.add(config);
@@ -180,9 +340,40 @@ int main(int argc, char *argv[])
 
 		ifstream config_stream(cfg["cfg"].as<string>().c_str());
 
-		po::store(po::parse_command_line(argc, argv, cmdline_options), cfg);
-		po::store(po::parse_config_file(config_stream, config_file_options), cfg);
+		//settings of additional devices are not registered options, they are picked up from unregistered ones
+		po::parsed_options cmdline_parsed = po::command_line_parser(argc, argv).options(cmdline_options).allow_unregistered().run();
+		po::parsed_options config_file_parsed = po::parse_config_file(config_stream, config_file_options, true);
+
+		po::store(cmdline_parsed, cfg);
+		po::store(config_file_parsed, cfg);
 		po::notify(cfg);
+
+		//command line settings go last, so they override cfg file ones
+		for (const po::parsed_options* parsed : {&config_file_parsed, &cmdline_parsed})
+		{
+			for (const po::option& option : parsed->options)
+			{
+				if (!option.unregistered)
+					continue;
+
+				vector<string> fields = explode(option.string_key, '.');
+
+				if ((fields.size() != 3) || (fields[0] != "SDR") || fields[1].empty() || (fields[1].find_first_not_of("0123456789") != string::npos) || (stoul(fields[1]) == 0))
+				{
+					msg("main: Unknown option " + option.string_key, ERROR);
+					return 1;
+				}
+
+				//values of unregistered options are not picked up from the next command line argument
+				if (option.value.empty())
+				{
+					msg("main: Option " + option.string_key + " needs a value (given as --" + option.string_key + "=value on command line)", ERROR);
+					return 1;
+				}
+
+				extra_device_options[stoul(fields[1])].push_back(make_pair(fields[2], option.value[0]));
+			}
+		}
 	}
 	else
 	{
@@ -204,85 +395,649 @@ int main(int argc, char *argv[])
 
 	/*********************************************************************************************************/
 
+	//all channels of a direction are streamed together, gains and antennas are given per channel
+	try
+	{
+		set_device_option(*device_cfg, "tx_channel", tx_channels);
+		set_device_option(*device_cfg, "rx_channel", rx_channels);
+		set_device_option(*device_cfg, "tx_antenna", tx_antennas);
+		set_device_option(*device_cfg, "rx_antenna", rx_antennas);
+		set_device_option(*device_cfg, "tx_gain", tx_gains);
+		set_device_option(*device_cfg, "rx_gain", rx_gains);
+
+		time_sync = parse_time_sync(time_sync_name);
+	}
+	catch (const std::exception& e)
+	{
+		msg("main: " + string(e.what()), ERROR);
+		return 1;
+	}
+
+	//settings actually applied are summarised next to late bursts on exit
+	string rt_summary = "mlockall=" + string(rt_mlockall ? "on" : "off") + ", prefault=" + string(rt_prefault ? "on" : "off");
+
+	//locked before the device is created, so its buffers are covered as well - a playback file mapped later on
+	//would be read into RAM as a whole by MCL_FUTURE, so its pages are locked only on fault (and it unlocks them)
+	if (rt_mlockall && !lock_memory(!playback_filepath.empty()))
+		rt_summary = "mlockall=failed, prefault=" + string(rt_prefault ? "on" : "off");
+
+	//from now on burst threads only queue their messages
+	if (async_logging)
+	{
+		async_logger.start(log_ring_size);
+		rt_summary += ", LOG: " + apply_rt_thread_config(async_logger.get_native_handle(), "LOG", rt_log);
+	}
+
 	device_cfg->D_rx = device_cfg->D_tx;
 	device_cfg->f_c_rx = device_cfg->f_c_tx;
 
+	//continuous streaming activates RX stream on its own
+	if (continuous_enabled)
+		device_cfg->rx_continuous = false;
+
 	float sampling_rate = device_cfg->f_clk / (double)device_cfg->D_tx;
 
-	device_cfg->buffer_size_tx = tx_burst_length * sampling_rate;
-	device_cfg->buffer_size_rx = rx_burst_length * sampling_rate;
+	//TDD frame pattern - either given list of slots or single TX burst at the frame start and single RX burst
+	//rx_tx_separation after it
+	if (slot_descriptions.empty())
+	{
+		TDD_Slot tx_slot;
+		tx_slot.direction = SOAPY_SDR_TX;
+		tx_slot.offset_ticks = 0;
+		tx_slot.length_ticks = (int64_t)(tx_burst_length * sampling_rate) * device_cfg->D_tx;
+
+		TDD_Slot rx_slot;
+		rx_slot.direction = SOAPY_SDR_RX;
+		rx_slot.offset_ticks = SoapySDR::timeNsToTicks(rx_tx_separation * 1e9, device_cfg->f_clk);
+		rx_slot.length_ticks = (int64_t)(rx_burst_length * sampling_rate) * device_cfg->D_rx;
+
+		timeline.slots.push_back(tx_slot);
+		timeline.slots.push_back(rx_slot);
+	}
+	else
+	{
+		try
+		{
+			for (const string& slot_description : slot_descriptions)
+				timeline.slots.push_back(parse_tdd_slot(slot_description, device_cfg->f_clk));
+		}
+		catch (const std::exception& e)
+		{
+			msg("main: " + string(e.what()), ERROR);
+			async_logger.stop();
+			return 1;
+		}
+	}
 
-	//initialize SDR device with given configuration
-	SDR_Device_Wrapper::sptr_t sdr_device_wrapper(new SDR_Device_Wrapper(device_cfg));
+	//buffers are sized for the longest slot of each direction
+	int64_t no_of_tx_samples = 0;
+	int64_t no_of_rx_samples = 0;
+
+	for (const TDD_Slot& slot : timeline.slots)
+	{
+		if (slot.direction == SOAPY_SDR_TX)
+			no_of_tx_samples = max(no_of_tx_samples, slot.length_ticks / device_cfg->D_tx);
+		else
+			no_of_rx_samples = max(no_of_rx_samples, slot.length_ticks / device_cfg->D_rx);
+	}
+
+	device_cfg->buffer_size_tx = no_of_tx_samples;
+	device_cfg->buffer_size_rx = no_of_rx_samples;
+
+	//[SDR] is the first device, every [SDR.N] section adds another one with its settings on top of [SDR] ones
+	vector<SDR_Device_Config::sptr_t> device_cfgs(1, device_cfg);
+
+	try
+	{
+		for (const auto& options : extra_device_options)
+		{
+			SDR_Device_Config::sptr_t extra_device_cfg(new SDR_Device_Config(*device_cfg));
+
+			for (const pair<string, string>& option : options.second)
+				set_device_option(*extra_device_cfg, option.first, option.second);
+
+			device_cfgs.push_back(extra_device_cfg);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		msg("main: " + string(e.what()), ERROR);
+		async_logger.stop();
+		return 1;
+	}
+
+	//initialize SDR devices with given configuration (in parallel when there are more of them), the first one
+	//gets all the analysis, the others only stream against the same timeline
+	SDR_Device_Group::sptr_t device_group;
+	SDR_Init_Cache::sptr_t init_cache;
+
+	try
+	{
+		if (init_cache_filepath != "")
+			init_cache.reset(new SDR_Init_Cache(init_cache_filepath));
+
+		device_group.reset(new SDR_Device_Group(device_cfgs, init_cache));
+	}
+	catch (const std::exception& e)
+	{
+		msg("main: " + string(e.what()), ERROR);
+		async_logger.stop();
+		return 1;
+	}
+
+	if (init_cache)
+	{
+		try
+		{
+			init_cache->save();
+		}
+		catch (const std::exception& e)
+		{
+			msg("main: " + string(e.what()), WARNING);
+		}
+	}
+
+	SDR_Device_Wrapper::sptr_t sdr_device_wrapper = device_group->get(0);
+
+	if (device_group->size() > 1)
+	{
+		device_group->align_time(time_sync);
+		device_group->print_skew("start");
+	}
+
+	//hardware times are not going to be set any more, so models of their clocks can be fitted from now on
+	for (size_t d = 0; d < device_group->size(); d++)
+		device_group->get(d)->start_clock_tracking();
+
+	Burst_Trace_Recorder::sptr_t trace_recorder;
+
+	if (!trace_filepath.empty())
+	{
+		try
+		{
+			trace_recorder.reset(new Burst_Trace_Recorder(trace_filepath, trace_ring_size, device_cfg->f_clk));
+			sdr_device_wrapper->set_trace_recorder(trace_recorder);
+		}
+		catch (const std::exception& e)
+		{
+			msg("main: " + string(e.what()), ERROR);
+		}
+	}
+
+	//metric series have to be attached before TX pipeline and frame schedulers of the devices are created
+	Metrics_Registry::sptr_t metrics_registry;
+	Metrics_Endpoint::sptr_t metrics_endpoint;
+
+	if (metrics_port != 0)
+	{
+		try
+		{
+			metrics_registry.reset(new Metrics_Registry());
+
+			for (size_t d = 0; d < device_group->size(); d++)
+				device_group->get(d)->set_metrics(SDR_Metrics::sptr_t(new SDR_Metrics(metrics_registry, d)));
+
+			metrics_endpoint.reset(new Metrics_Endpoint(signal_handler.get_io_service(), metrics_registry, metrics_address, metrics_port));
+		}
+		catch (const std::exception& e)
+		{
+			msg("main: " + string(e.what()), ERROR);
+		}
+	}
+
+	RX_Capture::sptr_t rx_capture;
+
+	if (!capture_filepath.empty() && device_cfg->rx_active && !continuous_enabled)
+	{
+		try
+		{
+			rx_capture.reset(new RX_Capture(capture_filepath, capture_no_of_bursts, no_of_rx_samples, device_cfg->f_clk, sampling_rate, capture_wrap));
+		}
+		catch (const std::exception& e)
+		{
+			msg("main: " + string(e.what()), ERROR);
+		}
+	}
 
 	int64_t no_of_ticks_per_bursts_period = device_cfg->D_tx * burst_period * sampling_rate;
-	int64_t no_of_tx_samples = tx_burst_length * sampling_rate;
-	int64_t no_of_rx_samples = rx_burst_length * sampling_rate;
 
-	vector<complex<float>> tx_buffer(no_of_tx_samples, complex<float>(1.0f, 0.0f));
-	vector<complex<float>> rx_buffer(no_of_rx_samples);
+	//TX payloads are generated only once here, a constant one (as in older versions) unless given otherwise
+	if (waveform_descriptions.empty())
+		waveform_descriptions.push_back("constant");
+
+	Waveform_Library::sptr_t waveform_library;
+
+	try
+	{
+		waveform_library.reset(new Waveform_Library(waveform_descriptions, no_of_tx_samples, sampling_rate));
+	}
+	catch (const std::exception& e)
+	{
+		msg("main: " + string(e.what()), ERROR);
+		async_logger.stop();
+		return 1;
+	}
+
+	//continuous mode streams every device non-stop from its own threads instead of TDD frames, all of them start
+	//time_in_future from now
+	if (continuous_enabled)
+	{
+		long long start_time = sdr_device_wrapper->get_device()->getHardwareTime() + (long long)(time_in_future * 1e9);
+
+		vector<Continuous_Streamer::sptr_t> continuous_streamers;
+
+		try
+		{
+			for (size_t d = 0; d < device_group->size(); d++)
+			{
+				Continuous_Streamer::sptr_t continuous_streamer(new Continuous_Streamer(device_group->get(d), d, waveform_library->get(0), waveform_library->get_no_of_samples(), continuous_buffer_size, start_time, continuous_period));
+
+				string name = (d == 0) ? "" : " " + to_string(d);
+
+				if (continuous_streamer->has_worker(SOAPY_SDR_TX))
+					rt_summary += ", TX" + name + ": " + apply_rt_thread_config(continuous_streamer->get_native_handle(SOAPY_SDR_TX), "TX" + name, rt_tx);
+
+				if (continuous_streamer->has_worker(SOAPY_SDR_RX))
+					rt_summary += ", RX" + name + ": " + apply_rt_thread_config(continuous_streamer->get_native_handle(SOAPY_SDR_RX), "RX" + name, rt_rx);
+
+				continuous_streamers.push_back(continuous_streamer);
+			}
+		}
+		catch (const std::exception& e)
+		{
+			msg("main: " + string(e.what()), ERROR);
+			continuous_streamers.clear();
+			async_logger.stop();
+			return 1;
+		}
+
+		msg("main: Continuous streaming started!");
+
+		try
+		{
+			while (!stop)
+				signal_handler.get_io_service().run_for(boost::asio::chrono::milliseconds(10));
+		}
+		catch (const std::exception& e)
+		{
+			msg("main: " + string(e.what()), WARNING);
+		}
+
+		metrics_endpoint.reset();
+
+		for (Continuous_Streamer::sptr_t continuous_streamer : continuous_streamers)
+			continuous_streamer->stop();
+
+		for (Continuous_Streamer::sptr_t continuous_streamer : continuous_streamers)
+			continuous_streamer->print_stats();
+
+		for (size_t d = 0; d < device_group->size(); d++)
+		{
+			if (device_group->get(d)->get_clock_tracker())
+				device_group->get(d)->get_clock_tracker()->print_stats();
+		}
 
-	int64_t current_hardware_time = sdr_device_wrapper->get_device()->getHardwareTime();
+		msg("main: continuous streaming (" + rt_summary + ")");
+
+		if (device_group->size() > 1)
+			device_group->print_skew("exit");
+
+		msg("All done!\n");
+		msg("", INFO, false, false);
+
+		async_logger.stop();
+
+		return 0;
+	}
+
+	//TX bursts of the first device are played from a file instead of the waveform library when one is given
+	TX_Playback::sptr_t tx_playback;
+
+	if (!playback_filepath.empty() && device_cfg->tx_active)
+	{
+		try
+		{
+			tx_playback.reset(new TX_Playback(playback_filepath, playback_format, no_of_tx_samples, playback_no_of_buffers, playback_loop));
+		}
+		catch (const std::exception& e)
+		{
+			msg("main: " + string(e.what()), ERROR);
+			async_logger.stop();
+			return 1;
+		}
+	}
+
+	//every RX channel gets its own buffer (only the first one is captured and analysed)
+	Channel_Buffers rx_buffers(device_cfg->channels_rx.size(), no_of_rx_samples);
+
+	//waveform library buffers are already page-locked (and so faulted in)
+	if (rt_prefault)
+		prefault(rx_buffers.get(0), rx_buffers.get_block_size());
+
+	//per channel sample pointers handed to the device, filled by the handlers without allocating
+	vector<const complex<float>*> tx_samples(device_cfg->channels_tx.size());
+	vector<complex<float>*> rx_samples(rx_buffers.get(), rx_buffers.get() + rx_buffers.size());
+
+	int64_t current_hardware_time = sdr_device_wrapper->get_hardware_time();
 
 	int64_t now_tick = SoapySDR::timeNsToTicks(current_hardware_time, device_cfg->f_clk);
 
-	//make sure that first TX timestamp will be later than first RX timestamp
+	//first TX burst goes one frame after first RX burst, so its timestamp is later than RX one
 	//(fix for LimeSDR)
-	int64_t rx_start_tick = now_tick + SoapySDR::timeNsToTicks((time_in_future + burst_period + rx_tx_separation) * 1e9, device_cfg->f_clk);
-	int64_t tx_start_tick = now_tick + SoapySDR::timeNsToTicks((time_in_future + 2 * burst_period) * 1e9, device_cfg->f_clk);
-
-	boost::thread rx_thread = boost::thread
-	(
-		&rx_thread_function,
-		sdr_device_wrapper,
-		boost::ref(rx_buffer),
-		rx_start_tick,
-		no_of_ticks_per_bursts_period,
-		device_cfg->rx_active
-	);
+	timeline.first_frame_tick = now_tick + SoapySDR::timeNsToTicks((time_in_future + burst_period) * 1e9, device_cfg->f_clk);
+	timeline.frame_ticks = no_of_ticks_per_bursts_period;
+	timeline.first_tx_frame = 1;
+	timeline.first_rx_frame = 0;
 
-	try
+	//TX acknowledgements are collected in the background when bursts are pipelined
+	TX_Pipeline::sptr_t tx_pipeline;
+
+	if ((device_cfg->tx_active) && (tx_pipeline_depth > 0))
+		tx_pipeline.reset(new TX_Pipeline(sdr_device_wrapper, tx_pipeline_depth));
+
+	//RX bursts are analysed off the RX path
+	Burst_Correlator::sptr_t burst_correlator;
+
+	if (correlation_enabled && device_cfg->tx_active && device_cfg->rx_active && !tx_playback)
 	{
-		int64_t tick = tx_start_tick;
+		try
+		{
+			burst_correlator.reset(new Burst_Correlator(timeline, device_cfg->D_rx, waveform_library, correlation_queue_size, no_of_rx_samples, correlation_min_snr, correlation_log_bursts));
+		}
+		catch (const std::exception& e)
+		{
+			msg("main: " + string(e.what()), ERROR);
+		}
+	}
+	else if (correlation_enabled && tx_playback)
+		msg("main: Burst correlation needs TX bursts of the waveform library, it is not available with a playback file", WARNING);
+	else if (correlation_enabled)
+		msg("main: Burst correlation needs both TX and RX threads active", WARNING);
 
-		//make sure that RX loop will start first
-		//(fix for LimeSDR)
-		usleep((int)(1e6*0.5*device_cfg->T_timeout));
+	RX_Burst_Stats::sptr_t rx_burst_stats;
 
-		if (device_cfg->tx_active)
-			msg("tx_thread: TX streaming started!");
+	if (stats_enabled && device_cfg->rx_active)
+		rx_burst_stats.reset(new RX_Burst_Stats(stats_queue_size, no_of_rx_samples, stats_window, stats_report_period));
 
-		while (!stop)
+	slot_handler_t tx_handler;
+	slot_handler_t rx_handler;
+
+	//late bursts are counted by the handlers themselves (pipelined ones by TX_Pipeline)
+	uint64_t no_of_late_tx_bursts = 0;
+	uint64_t no_of_late_rx_bursts = 0;
+
+	if (device_cfg->tx_active)
+	{
+		tx_handler = [&](const Frame_Slot& slot)
 		{
-			if (device_cfg->tx_active)
+			if (tx_playback)
+			{
+				//every channel sends the same slice of the playback file, its buffer is handed back once
+				//the burst has been written
+				const complex<float>* playback_samples = tx_playback->next();
+
+				for (size_t c = 0; c < tx_samples.size(); c++)
+					tx_samples[c] = playback_samples;
+			}
+			else
 			{
-				sdr_device_wrapper->send_samples(tick, &tx_buffer[0], tx_buffer.size());
-				tick += no_of_ticks_per_bursts_period;
+				//channels send consecutive waveforms of the library, so they can be told apart
+				size_t frame_waveform = waveform_library->get_frame_waveform(slot.frame);
+
+				for (size_t c = 0; c < tx_samples.size(); c++)
+					tx_samples[c] = waveform_library->get((frame_waveform + c) % waveform_library->size());
 			}
+
+			bool res;
+
+			if (tx_pipeline)
+				res = tx_pipeline->submit(slot.tick, &tx_samples[0], slot.no_of_samples);
 			else
-				sleep(1);
+				res = sdr_device_wrapper->send_samples(slot.tick, &tx_samples[0], slot.no_of_samples);
+
+			if (tx_playback)
+				tx_playback->release();
+
+			if (tx_pipeline)
+				return res;
+
+			if (!res && (sdr_device_wrapper->get_tx_status().stream_status == SOAPY_SDR_TIME_ERROR))
+				no_of_late_tx_bursts++;
+
+			return res;
+		};
+	}
+
+	if (device_cfg->rx_active)
+	{
+		rx_handler = [&](const Frame_Slot& slot)
+		{
+			//bursts of the first channel are received straight into the capture file, once it is full into rx_buffers
+			complex<float>* capture_buffer = rx_capture ? rx_capture->next_buffer() : nullptr;
+
+			complex<float>* buffer = capture_buffer ? capture_buffer : rx_buffers.get(0);
+
+			rx_samples[0] = buffer;
+
+			bool res = sdr_device_wrapper->receive_samples(slot.tick, &rx_samples[0], slot.no_of_samples);
+
+			if (capture_buffer)
+				rx_capture->commit(sdr_device_wrapper->get_rx_status());
+
+			if (res && burst_correlator)
+				burst_correlator->submit(slot, buffer);
+
+			if (res && rx_burst_stats)
+				rx_burst_stats->submit(slot, buffer);
+
+			if (!res && (sdr_device_wrapper->get_rx_status().stream_status == SOAPY_SDR_TIME_ERROR))
+				no_of_late_rx_bursts++;
+
+			return res;
+		};
+	}
+
+	Frame_Scheduler::sptr_t frame_scheduler(new Frame_Scheduler(sdr_device_wrapper, timeline));
+
+	frame_scheduler->start(tx_handler, rx_handler);
 
-			signal_handler.get_io_service().poll();
+	if (frame_scheduler->has_worker(SOAPY_SDR_TX))
+	{
+		rt_summary += ", TX: " + apply_rt_thread_config(frame_scheduler->get_native_handle(SOAPY_SDR_TX), "TX", rt_tx);
+
+		if (tx_pipeline)
+			apply_rt_thread_config(tx_pipeline->get_native_handle(), "TX status", rt_tx);
+	}
+
+	if (frame_scheduler->has_worker(SOAPY_SDR_RX))
+		rt_summary += ", RX: " + apply_rt_thread_config(frame_scheduler->get_native_handle(SOAPY_SDR_RX), "RX", rt_rx);
+
+	//additional devices stream the same frames from their own TX and RX workers, bursts are neither pipelined nor analysed
+	vector<Frame_Scheduler::sptr_t> extra_frame_schedulers;
+	vector<uint64_t> no_of_late_extra_tx_bursts(device_group->size(), 0);
+	vector<uint64_t> no_of_late_extra_rx_bursts(device_group->size(), 0);
+
+	for (size_t d = 1; d < device_group->size(); d++)
+	{
+		SDR_Device_Wrapper::sptr_t extra_device = device_group->get(d);
+		SDR_Device_Config::sptr_t extra_device_cfg = extra_device->get_device_config();
+
+		slot_handler_t extra_tx_handler;
+		slot_handler_t extra_rx_handler;
+
+		//extra devices keep sending waveforms of the library (a playback file is played by the first device only)
+		if (device_cfg->tx_active)
+		{
+			boost::shared_ptr<vector<const complex<float>*>> extra_tx_samples(new vector<const complex<float>*>(extra_device_cfg->channels_tx.size()));
+			uint64_t* no_of_late_bursts = &no_of_late_extra_tx_bursts[d];
+
+			extra_tx_handler = [=](const Frame_Slot& slot)
+			{
+				size_t frame_waveform = waveform_library->get_frame_waveform(slot.frame);
+
+				for (size_t c = 0; c < extra_tx_samples->size(); c++)
+					(*extra_tx_samples)[c] = waveform_library->get((frame_waveform + c) % waveform_library->size());
+
+				bool res = extra_device->send_samples(slot.tick, &(*extra_tx_samples)[0], slot.no_of_samples);
+
+				if (!res && (extra_device->get_tx_status().stream_status == SOAPY_SDR_TIME_ERROR))
+					(*no_of_late_bursts)++;
+
+				return res;
+			};
 		}
+
+		if (device_cfg->rx_active)
+		{
+			Channel_Buffers::sptr_t extra_rx_buffers(new Channel_Buffers(extra_device_cfg->channels_rx.size(), no_of_rx_samples));
+			uint64_t* no_of_late_bursts = &no_of_late_extra_rx_bursts[d];
+
+			if (rt_prefault)
+				prefault(extra_rx_buffers->get(0), extra_rx_buffers->get_block_size());
+
+			extra_rx_handler = [=](const Frame_Slot& slot)
+			{
+				bool res = extra_device->receive_samples(slot.tick, extra_rx_buffers->get(), slot.no_of_samples);
+
+				if (!res && (extra_device->get_rx_status().stream_status == SOAPY_SDR_TIME_ERROR))
+					(*no_of_late_bursts)++;
+
+				return res;
+			};
+		}
+
+		Frame_Scheduler::sptr_t extra_frame_scheduler(new Frame_Scheduler(extra_device, timeline));
+
+		extra_frame_scheduler->start(extra_tx_handler, extra_rx_handler);
+
+		if (extra_frame_scheduler->has_worker(SOAPY_SDR_TX))
+			apply_rt_thread_config(extra_frame_scheduler->get_native_handle(SOAPY_SDR_TX), "TX " + to_string(d), rt_tx);
+
+		if (extra_frame_scheduler->has_worker(SOAPY_SDR_RX))
+			apply_rt_thread_config(extra_frame_scheduler->get_native_handle(SOAPY_SDR_RX), "RX " + to_string(d), rt_rx);
+
+		extra_frame_schedulers.push_back(extra_frame_scheduler);
 	}
-	catch (const boost::thread_interrupted& e)
+
+	//commands of the control socket are handled by this thread next to signals, so are the changes timed by the host
+	Live_Reconfigurator::sptr_t live_reconfigurator;
+	Control_Socket::sptr_t control_socket;
+
+	if (!control_socket_path.empty())
 	{
-		msg("tx_thread: thread has been interrupted.");
+		vector<Frame_Scheduler::sptr_t> frame_schedulers(1, frame_scheduler);
+		frame_schedulers.insert(frame_schedulers.end(), extra_frame_schedulers.begin(), extra_frame_schedulers.end());
+
+		live_reconfigurator.reset(new Live_Reconfigurator(signal_handler.get_io_service(), device_group, frame_schedulers, timeline, no_of_tx_samples, no_of_rx_samples));
+
+		if (burst_correlator)
+			live_reconfigurator->set_burst_correlator(burst_correlator);
+
+		try
+		{
+			control_socket.reset(new Control_Socket(signal_handler.get_io_service(), control_socket_path, [live_reconfigurator](const string& line) { return live_reconfigurator->execute(line); }));
+		}
+		catch (const std::exception& e)
+		{
+			msg("main: " + string(e.what()), ERROR);
+		}
 	}
-	catch (const std::exception& e)
+
+	if (device_cfg->tx_active)
+		msg("main: TX streaming started!");
+	if (device_cfg->rx_active)
+		msg("main: RX streaming started!");
+
+	try
 	{
-		msg("tx_thread: " + string(e.what()), WARNING);
+		//handlers run as soon as they are due (rather than on the next poll), so host timed changes hit their gaps
+		while (!stop)
+			signal_handler.get_io_service().run_for(boost::asio::chrono::milliseconds(10));
 	}
-	catch (...)
+	catch (const std::exception& e)
 	{
-		msg("tx_thread: Unexpected exception occurred.", ERROR);
+		msg("main: " + string(e.what()), WARNING);
 	}
 
+	control_socket.reset();
+	metrics_endpoint.reset();
+
+	frame_scheduler->stop();
+
+	for (Frame_Scheduler::sptr_t extra_frame_scheduler : extra_frame_schedulers)
+		extra_frame_scheduler->stop();
+
 	usleep((int)1e6*device_cfg->T_timeout);
 
+	if (tx_pipeline)
+	{
+		tx_pipeline->stop();
+		tx_pipeline->print_stats();
+	}
+
+	frame_scheduler->print_stats();
+
+	if (sdr_device_wrapper->get_clock_tracker())
+		sdr_device_wrapper->get_clock_tracker()->print_stats();
+
+	for (size_t d = 1; d < device_group->size(); d++)
+	{
+		msg("main: device " + to_string(d) + ":");
+		extra_frame_schedulers[d - 1]->print_stats();
+
+		if (device_group->get(d)->get_clock_tracker())
+			device_group->get(d)->get_clock_tracker()->print_stats();
+	}
+
+	if (live_reconfigurator)
+		live_reconfigurator->print_stats();
+
+	if (burst_correlator)
+	{
+		burst_correlator->stop();
+		burst_correlator->print_stats();
+	}
+
+	if (rx_burst_stats)
+	{
+		rx_burst_stats->stop();
+		rx_burst_stats->print_stats();
+	}
+
+	if (rx_capture)
+	{
+		rx_capture->close();
+		rx_capture->print_stats();
+	}
+
+	if (tx_playback)
+	{
+		tx_playback->stop();
+		tx_playback->print_stats();
+	}
+
+	if (trace_recorder)
+	{
+		trace_recorder->stop();
+		trace_recorder->print_stats();
+	}
+
+	if (tx_pipeline)
+		no_of_late_tx_bursts = tx_pipeline->get_stats().no_of_late_bursts;
+
+	msg("main: late bursts: TX=" + to_string(no_of_late_tx_bursts) + ", RX=" + to_string(no_of_late_rx_bursts) + ", skipped slots: TX=" + to_string(frame_scheduler->get_stats(SOAPY_SDR_TX).no_of_skipped_slots) + ", RX=" + to_string(frame_scheduler->get_stats(SOAPY_SDR_RX).no_of_skipped_slots) + " (" + rt_summary + ")");
+
+	for (size_t d = 1; d < device_group->size(); d++)
+		msg("main: device " + to_string(d) + " late bursts: TX=" + to_string(no_of_late_extra_tx_bursts[d]) + ", RX=" + to_string(no_of_late_extra_rx_bursts[d]) + ", skipped slots: TX=" + to_string(extra_frame_schedulers[d - 1]->get_stats(SOAPY_SDR_TX).no_of_skipped_slots) + ", RX=" + to_string(extra_frame_schedulers[d - 1]->get_stats(SOAPY_SDR_RX).no_of_skipped_slots));
+
+	//hardware clocks of the devices may drift apart while streaming unless they share a reference
+	if (device_group->size() > 1)
+		device_group->print_skew("exit");
 
 	msg("All done!\n");
 	msg("", INFO, false, false);
+
+	async_logger.stop();
 	/*********************************************************************************************************/
 
 	return 0;
@@ -0,0 +1,118 @@
+/*
+ * Burst_Trace_Decoder
+ *
+ * Converts a binary burst trace (recorded with LOG.trace_file) into CSV
+ *
+ * Usage: Burst_Trace_Decoder TRACE_FILE [CSV_FILE]
+ *			CSV is written to the standard output when CSV_FILE is not given
+ */
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "../classes/sdr/Burst_Trace.h"
+
+using namespace sdr;
+
+static const char* source_to_str(const uint32_t source)
+{
+	switch (source)
+	{
+		case TRACE_TX:
+			return "TX";
+		case TRACE_RX:
+			return "RX";
+		case TRACE_TX_ACK:
+			return "TX_ACK";
+		default:
+			return "UNKNOWN";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if ((argc < 2) || (argc > 3))
+	{
+		fprintf(stderr, "Usage: %s TRACE_FILE [CSV_FILE]\n", argv[0]);
+		return 1;
+	}
+
+	FILE* input = fopen(argv[1], "rb");
+
+	if (input == nullptr)
+	{
+		fprintf(stderr, "Unable to open %s\n", argv[1]);
+		return 1;
+	}
+
+	Burst_Trace_Header header;
+
+	if ((fread(&header, sizeof(header), 1, input) != 1) || (memcmp(header.magic, BURST_TRACE_MAGIC, sizeof(header.magic)) != 0))
+	{
+		fprintf(stderr, "%s is not a burst trace file\n", argv[1]);
+		fclose(input);
+		return 1;
+	}
+
+	if ((header.version != BURST_TRACE_VERSION) || (header.record_size != sizeof(Burst_Trace_Record)))
+	{
+		fprintf(stderr, "Unsupported burst trace version %u (record size %u)\n", header.version, header.record_size);
+		fclose(input);
+		return 1;
+	}
+
+	FILE* output = stdout;
+
+	if (argc == 3)
+	{
+		output = fopen(argv[2], "w");
+
+		if (output == nullptr)
+		{
+			fprintf(stderr, "Unable to create %s\n", argv[2]);
+			fclose(input);
+			return 1;
+		}
+	}
+
+	fprintf(output, "source,seq,submit_host_time,return_host_time,hardware_time,burst_time,status_time,requested,transferred,stream_status,flags,lead_time,call_duration\n");
+
+	Burst_Trace_Record record;
+	uint64_t no_of_records = 0;
+
+	while (fread(&record, sizeof(record), 1, input) == 1)
+	{
+		//lead time is only known for records carrying hardware time read before the call (not for acks)
+		int64_t lead_time = (record.hardware_time != 0) ? record.burst_time - record.hardware_time : 0;
+
+		fprintf
+		(
+			output,
+			"%s,%" PRIu64 ",%" PRId64 ",%" PRId64 ",%" PRId64 ",%" PRId64 ",%" PRId64 ",%d,%d,%d,%d,%" PRId64 ",%" PRId64 "\n",
+			source_to_str(record.source),
+			record.seq,
+			record.submit_host_time,
+			record.return_host_time,
+			record.hardware_time,
+			record.burst_time,
+			record.status_time,
+			record.no_of_requested_samples,
+			record.no_of_transferred_samples,
+			record.stream_status,
+			record.flags,
+			lead_time,
+			record.return_host_time - record.submit_host_time
+		);
+
+		no_of_records++;
+	}
+
+	fprintf(stderr, "%" PRIu64 " records decoded (f_clk = %.6f [Hz])\n", no_of_records, header.f_clk);
+
+	fclose(input);
+
+	if (output != stdout)
+		fclose(output);
+
+	return 0;
+}
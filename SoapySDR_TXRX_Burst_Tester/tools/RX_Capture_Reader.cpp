@@ -0,0 +1,155 @@
+/*
+ * RX_Capture_Reader
+ *
+ * Lists bursts of an RX capture file (recorded with CAPTURE.file) or extracts samples of one of them
+ *
+ * Usage: RX_Capture_Reader CAPTURE_FILE
+ *			index of all captured bursts is written to the standard output as CSV, ordered by seq
+ *        RX_Capture_Reader CAPTURE_FILE SEQ OUTPUT_FILE
+ *			samples of burst SEQ are written to OUTPUT_FILE as raw interleaved float I/Q (cf32)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <vector>
+#include <algorithm>
+
+#include "../classes/sdr/RX_Capture_Format.h"
+
+using namespace std;
+using namespace sdr;
+
+static int extract_burst(FILE* input, const RX_Capture_Header& header, const RX_Capture_Index_Entry& entry, const size_t slot, const char* output_filepath)
+{
+	FILE* output = fopen(output_filepath, "wb");
+
+	if (output == nullptr)
+	{
+		fprintf(stderr, "Unable to create %s\n", output_filepath);
+		return 1;
+	}
+
+	vector<char> samples(entry.no_of_samples * 2 * sizeof(float));
+
+	if ((fseek(input, header.samples_offset + slot * header.slot_size, SEEK_SET) != 0) || (fread(&samples[0], samples.size(), 1, input) != 1))
+	{
+		fprintf(stderr, "Capture file is truncated\n");
+		fclose(output);
+		return 1;
+	}
+
+	fwrite(&samples[0], samples.size(), 1, output);
+	fclose(output);
+
+	fprintf(stderr, "%d samples of burst %" PRIu64 " written into %s\n", entry.no_of_samples, entry.seq, output_filepath);
+
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if ((argc != 2) && (argc != 4))
+	{
+		fprintf(stderr, "Usage: %s CAPTURE_FILE [SEQ OUTPUT_FILE]\n", argv[0]);
+		return 1;
+	}
+
+	FILE* input = fopen(argv[1], "rb");
+
+	if (input == nullptr)
+	{
+		fprintf(stderr, "Unable to open %s\n", argv[1]);
+		return 1;
+	}
+
+	RX_Capture_Header header;
+
+	if ((fread(&header, sizeof(header), 1, input) != 1) || (memcmp(header.magic, RX_CAPTURE_MAGIC, sizeof(header.magic)) != 0))
+	{
+		fprintf(stderr, "%s is not an RX capture file\n", argv[1]);
+		fclose(input);
+		return 1;
+	}
+
+	if ((header.version != RX_CAPTURE_VERSION) || (header.index_entry_size != sizeof(RX_Capture_Index_Entry)))
+	{
+		fprintf(stderr, "Unsupported RX capture version %u (index entry size %u)\n", header.version, header.index_entry_size);
+		fclose(input);
+		return 1;
+	}
+
+	vector<RX_Capture_Index_Entry> index(header.no_of_slots);
+
+	if ((header.no_of_slots > 0) && (fread(&index[0], sizeof(RX_Capture_Index_Entry), index.size(), input) != index.size()))
+	{
+		fprintf(stderr, "Capture file is truncated\n");
+		fclose(input);
+		return 1;
+	}
+
+	//slots ordered by seq of their bursts, never written ones are left out
+	vector<size_t> slots;
+
+	for (size_t i = 0; i < index.size(); i++)
+	{
+		if (index[i].seq != 0)
+			slots.push_back(i);
+	}
+
+	sort(slots.begin(), slots.end(), [&](size_t a, size_t b) { return index[a].seq < index[b].seq; });
+
+	int res = 0;
+
+	if (argc == 4)
+	{
+		uint64_t seq = strtoull(argv[2], nullptr, 10);
+
+		vector<size_t>::iterator it = find_if(slots.begin(), slots.end(), [&](size_t slot) { return index[slot].seq == seq; });
+
+		if (it == slots.end())
+		{
+			fprintf(stderr, "Burst %" PRIu64 " is not in the capture file\n", seq);
+			res = 1;
+		}
+		else
+			res = extract_burst(input, header, index[*it], *it, argv[3]);
+	}
+	else
+	{
+		printf("seq,slot,tick,hardware_time,burst_time,status_time,no_of_samples,flags,stream_status\n");
+
+		for (size_t slot : slots)
+		{
+			const RX_Capture_Index_Entry& entry = index[slot];
+
+			printf
+			(
+				"%" PRIu64 ",%zu,%" PRId64 ",%" PRId64 ",%" PRId64 ",%" PRId64 ",%d,%d,%d\n",
+				entry.seq,
+				slot,
+				entry.tick,
+				entry.hardware_time,
+				entry.burst_time,
+				entry.status_time,
+				entry.no_of_samples,
+				entry.flags,
+				entry.stream_status
+			);
+		}
+
+		fprintf
+		(
+			stderr,
+			"%zu bursts listed, %" PRIu64 " captured in total (sampling rate = %.6f [Hz], f_clk = %.6f [Hz])\n",
+			slots.size(),
+			header.no_of_captured_bursts,
+			header.sampling_rate,
+			header.f_clk
+		);
+	}
+
+	fclose(input);
+
+	return res;
+}